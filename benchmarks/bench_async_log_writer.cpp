@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+// Compares the cost to a logging thread of writing a log file synchronously (the way the platform
+// log handlers used to, with a flush after every message) against pushing into AsyncLogWriter.
+
+#include <cstdio>
+#include "async_log_writer.h"
+#include "benchmark/benchmark.h"
+
+static constexpr char kTestMessage[] =
+    "2022-06-01 12:34:56.789-05:00 [INFO] Client 6574:12345678 connected from 192.168.1.100:52345";
+
+class FileLogOutput : public AsyncLogWriter::Output
+{
+public:
+  explicit FileLogOutput(FILE* file) : file_(file) {}
+
+  void WriteLogData(const char* data, size_t size) override { fwrite(data, 1, size, file_); }
+  void FlushLogData() override { fflush(file_); }
+  void RotateLogFile() override {}
+
+private:
+  FILE* file_;
+};
+
+static void BM_SyncFileLogging(benchmark::State& state)
+{
+  FILE* file = std::tmpfile();
+  if (!file)
+  {
+    state.SkipWithError("Couldn't open temporary file");
+    return;
+  }
+
+  for (auto _ : state)
+  {
+    fprintf(file, "%s\n", kTestMessage);
+    fflush(file);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+  fclose(file);
+}
+BENCHMARK(BM_SyncFileLogging)->Threads(1)->Threads(4)->UseRealTime();
+
+static void BM_AsyncFileLogging(benchmark::State& state)
+{
+  static FILE*           file = nullptr;
+  static FileLogOutput*  output = nullptr;
+  static AsyncLogWriter* writer = nullptr;
+
+  if (state.thread_index() == 0)
+  {
+    file = std::tmpfile();
+    output = new FileLogOutput(file);
+    writer = new AsyncLogWriter;
+
+    AsyncLogWriter::Settings settings;
+    settings.overflow_policy = AsyncLogWriter::OverflowPolicy::kBlock;
+    settings.max_file_size = 0;
+    writer->Startup(*output, settings);
+  }
+
+  for (auto _ : state)
+    writer->Push(kTestMessage);
+
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index() == 0)
+  {
+    writer->Shutdown();
+    delete writer;
+    delete output;
+    fclose(file);
+  }
+}
+BENCHMARK(BM_AsyncFileLogging)->Threads(1)->Threads(4)->UseRealTime();
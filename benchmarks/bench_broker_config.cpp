@@ -0,0 +1,309 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+// Measures how long it takes to parse a configuration file and work out what changed from the
+// running configuration, for the broker's own settings and for a synthetic schema ten times the
+// size, to show how the cost grows with the number of settings. BrokerConfig::Read() is also
+// measured on its own for configuration files of different shapes, along with SetDefaults().
+
+#include <array>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include "broker_config.h"
+#include "config_schema.h"
+#include "benchmark/benchmark.h"
+
+static const std::string kFullConfig = R"({
+  "cid": "4958ac8f-cd5e-42cd-ab7e-9797b0efd3ac",
+  "uid": {
+    "type": "dynamic",
+    "manufacturer_id": 25972
+  },
+  "dns_sd": {
+    "service_instance_name": "My ETC RDMnet Broker",
+    "manufacturer": "ETC",
+    "model": "RDMnet Broker"
+  },
+  "scope": "default",
+  "listen_port": 8888,
+  "listen_interfaces": [
+    "eth0",
+    "wlan0"
+  ],
+  "log_level": "info",
+  "log_flush_interval_ms": 1000,
+  "log_overflow_policy": "drop",
+  "log_format": "text",
+  "log_max_size": 10485760,
+  "log_max_files": 5,
+  "log_max_total_size": 0,
+  "log_compress": true,
+  "flight_recorder_size": 1000,
+  "max_connections": 20000,
+  "max_controllers": 1000,
+  "max_controller_messages": 500,
+  "max_devices": 20000,
+  "max_device_messages": 500,
+  "max_reject_connections": 1000,
+  "enable_broker": true,
+  "restart_mode": "overlapped",
+  "restart_drain_ms": 5000
+})";
+
+static void BM_ReadAndCompareBrokerConfig(benchmark::State& state)
+{
+  BrokerConfig running;
+  running.SetDefaults();
+
+  for (auto _ : state)
+  {
+    std::istringstream stream(kFullConfig);
+    BrokerConfig       config;
+    benchmark::DoNotOptimize(config.Read(stream));
+    benchmark::DoNotOptimize(BrokerConfig::Compare(running, config));
+  }
+}
+BENCHMARK(BM_ReadAndCompareBrokerConfig);
+
+// Parsing the same file into a document, for reference.
+static void BM_ParseBrokerConfigJson(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    std::istringstream stream(kFullConfig);
+    json               parsed;
+    stream >> parsed;
+    benchmark::DoNotOptimize(parsed);
+  }
+}
+BENCHMARK(BM_ParseBrokerConfigJson);
+
+// Every setting has a value of the wrong type or out of range, so each one is rejected and
+// replaced by its default.
+static const std::string kInvalidConfig = R"({
+  "cid": "not a uuid",
+  "uid": { "type": "static", "manufacturer_id": 25972 },
+  "dns_sd": { "service_instance_name": "", "manufacturer": 42, "model": false },
+  "scope": "a scope name that is much, much longer than the sixty-two characters a scope may have",
+  "listen_port": 80,
+  "listen_interfaces": [ "eth0", 1 ],
+  "log_level": "verbose",
+  "log_flush_interval_ms": 600000,
+  "log_overflow_policy": "wait",
+  "log_format": "xml",
+  "log_max_size": -1,
+  "log_max_files": 0,
+  "log_max_total_size": "large",
+  "log_compress": "yes",
+  "flight_recorder_size": 1000000,
+  "max_connections": -20000,
+  "max_controllers": 1.5,
+  "max_controller_messages": "500",
+  "max_devices": [],
+  "max_device_messages": {},
+  "max_reject_connections": true,
+  "enable_broker": 1,
+  "restart_mode": "sometimes",
+  "restart_drain_ms": -5000
+})";
+
+// The typical configuration, preceded by a large amount of data the broker doesn't know about
+// (as a tool that generates configuration files might leave behind) and with a long interface
+// list and overlong DNS-SD strings that have to be truncated.
+static std::string PathologicalConfig()
+{
+  json config = json::parse(kFullConfig);
+
+  json& unknown = config["generator_metadata"];
+  for (int i = 0; i < 1000; ++i)
+  {
+    json& entry = unknown["entry_" + std::to_string(i)];
+    entry["id"] = i;
+    entry["name"] = "An entry with a reasonably long descriptive name";
+    entry["values"] = {1, 2.5, "three", nullptr, true, json::array({json::object({{"nested", "deeply"}})})};
+  }
+
+  json& listen_interfaces = config["listen_interfaces"];
+  for (int i = 0; i < 1000; ++i)
+    listen_interfaces.push_back("eth" + std::to_string(i));
+
+  config["dns_sd"]["service_instance_name"] = std::string(1000, 's');
+  config["dns_sd"]["manufacturer"] = std::string(1000, 'm');
+  config["dns_sd"]["model"] = std::string(1000, 'd');
+  return config.dump(2);
+}
+
+static void BM_ReadBrokerConfig(benchmark::State& state, const std::string& config_json)
+{
+  for (auto _ : state)
+  {
+    std::istringstream stream(config_json);
+    BrokerConfig       config;
+    benchmark::DoNotOptimize(config.Read(stream));
+  }
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * config_json.size()));
+}
+BENCHMARK_CAPTURE(BM_ReadBrokerConfig, minimal, std::string("{}"));
+BENCHMARK_CAPTURE(BM_ReadBrokerConfig, typical, kFullConfig);
+BENCHMARK_CAPTURE(BM_ReadBrokerConfig, pathological, PathologicalConfig());
+BENCHMARK_CAPTURE(BM_ReadBrokerConfig, all_invalid, kInvalidConfig);
+// The first and last log level names
+BENCHMARK_CAPTURE(BM_ReadBrokerConfig, log_level_debug, std::string(R"({ "log_level": "debug" })"));
+BENCHMARK_CAPTURE(BM_ReadBrokerConfig, log_level_emerg, std::string(R"({ "log_level": "emerg" })"));
+
+static void BM_SetBrokerConfigDefaults(benchmark::State& state)
+{
+  BrokerConfig config;
+  for (auto _ : state)
+  {
+    config.SetDefaults();
+    benchmark::DoNotOptimize(config);
+  }
+}
+BENCHMARK(BM_SetBrokerConfigDefaults);
+
+// A configuration with ten times as many settings as the broker's, split evenly between integers,
+// strings, booleans and enumerations, half of them in nested objects.
+namespace
+{
+constexpr size_t kLargeSettingCount = 10 * 26;
+
+struct LargeConfig
+{
+  struct Diff
+  {
+    bool any{false};
+  };
+
+  std::array<unsigned int, kLargeSettingCount> ints{};
+  std::array<std::string, kLargeSettingCount>  strings{};
+  std::array<bool, kLargeSettingCount>         bools{};
+  std::array<int, kLargeSettingCount>          enums{};
+};
+
+std::array<std::string, kLargeSettingCount> large_setting_pointers;
+
+std::string LargeSettingName(size_t index)
+{
+  return "setting_" + std::to_string(index);
+}
+
+const std::string& LargeSettingPointer(size_t index)
+{
+  std::string& pointer = large_setting_pointers[index];
+  if (pointer.empty())
+    pointer = (index % 2 ? "/group_" + std::to_string(index % 10) + "/" : "/") + LargeSettingName(index);
+  return pointer;
+}
+
+// The accessor for one element of one of the LargeConfig arrays.
+template <typename T, std::array<T, kLargeSettingCount> LargeConfig::*Member>
+struct LargeConfigElement
+{
+  size_t index;
+
+  T&       operator()(LargeConfig& config) const { return (config.*Member)[index]; }
+  const T& operator()(const LargeConfig& config) const { return (config.*Member)[index]; }
+};
+
+template <typename T, std::array<T, kLargeSettingCount> LargeConfig::*Member, typename Rule, typename Default>
+auto MakeLargeField(size_t index, Rule rule, Default default_value, std::string_view description)
+{
+  return config_schema::MakeField<LargeConfig>(LargeSettingPointer(index), rule,
+                                               LargeConfigElement<T, Member>{index}, default_value,
+                                               &LargeConfig::Diff::any, description);
+}
+
+auto MakeLargeSettingGroup(size_t first_index)
+{
+  return std::make_tuple(
+      MakeLargeField<unsigned int, &LargeConfig::ints>(first_index, config_schema::IntRule<unsigned int>{0, 100000},
+                                                       100u, "An integer."),
+      MakeLargeField<std::string, &LargeConfig::strings>(first_index + 1, config_schema::StringRule{63, true},
+                                                         "default", "A string."),
+      MakeLargeField<bool, &LargeConfig::bools>(first_index + 2, config_schema::BoolRule{}, true, "A boolean."),
+      MakeLargeField<int, &LargeConfig::enums>(first_index + 3,
+                                               config_schema::Enum<int>({{"low", 0}, {"medium", 1}, {"high", 2}}), 1,
+                                               "An enumeration."));
+}
+
+// Groups of four settings of different types, repeated. The schema is an array so that it can be
+// built at run time.
+using LargeSchema = std::array<decltype(MakeLargeSettingGroup(0)), kLargeSettingCount / 4>;
+
+const LargeSchema& GetLargeSchema()
+{
+  static const LargeSchema schema = []() {
+    LargeSchema new_schema;
+    for (size_t i = 0; i < new_schema.size(); ++i)
+      new_schema[i] = MakeLargeSettingGroup(i * 4);
+    return new_schema;
+  }();
+  return schema;
+}
+
+std::string LargeConfigJson()
+{
+  json config = json::object();
+  for (size_t i = 0; i < kLargeSettingCount; ++i)
+  {
+    json& parent = (i % 2) ? config["group_" + std::to_string(i % 10)] : config;
+    switch (i % 4)
+    {
+      case 0:
+        parent[LargeSettingName(i)] = 5000u;
+        break;
+      case 1:
+        parent[LargeSettingName(i)] = "a string value";
+        break;
+      case 2:
+        parent[LargeSettingName(i)] = false;
+        break;
+      default:
+        parent[LargeSettingName(i)] = "high";
+        break;
+    }
+  }
+  return config.dump(2);
+}
+}  // namespace
+
+static void BM_ReadAndCompareLargeConfig(benchmark::State& state)
+{
+  const auto&                      schema = GetLargeSchema();
+  const config_schema::SchemaIndex index(schema);
+  const std::string                config_json = LargeConfigJson();
+
+  LargeConfig running;
+  config_schema::SetDefaults(schema, running);
+
+  for (auto _ : state)
+  {
+    std::istringstream stream(config_json);
+
+    auto                                            config = std::make_unique<LargeConfig>();
+    config_schema::Reader<LargeConfig, LargeSchema> reader(schema, index, *config, nullptr);
+    benchmark::DoNotOptimize(reader.Parse(stream));
+    benchmark::DoNotOptimize(reader.Finish());
+    benchmark::DoNotOptimize(config_schema::Compare(schema, running, *config));
+  }
+}
+BENCHMARK(BM_ReadAndCompareLargeConfig);
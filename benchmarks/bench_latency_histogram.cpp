@@ -0,0 +1,55 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+// Compares the cost to a recording thread of LatencyHistogram, whose threads record into separate
+// shards, against MetricsRegistry::Histogram, whose counters are shared by every thread.
+
+#include "latency_histogram.h"
+#include "metrics.h"
+#include "benchmark/benchmark.h"
+
+static void BM_SharedHistogram(benchmark::State& state)
+{
+  static MetricsRegistry::Histogram histogram({1e-6, 1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1.0});
+
+  double value = 0.0;
+  for (auto _ : state)
+  {
+    histogram.Observe(value);
+    value = (value < 1.0) ? value + 1e-4 : 0.0;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SharedHistogram)->Threads(1)->Threads(4)->UseRealTime();
+
+static void BM_ShardedLatencyHistogram(benchmark::State& state)
+{
+  static LatencyHistogram histogram;
+
+  uint64_t value = 0;
+  for (auto _ : state)
+  {
+    histogram.Record(value);
+    value = (value < 1000000) ? value + 100 : 0;
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ShardedLatencyHistogram)->Threads(1)->Threads(4)->UseRealTime();
@@ -0,0 +1,84 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+// Compares timestamps per second from LogTimestampProvider against converting the wall clock to
+// local time through the C library on every call, which looks up the time zone each time much like
+// the platform GetLogTimestamp() implementations used to.
+
+#include <chrono>
+#include <ctime>
+#include "log_timestamp_provider.h"
+#include "benchmark/benchmark.h"
+
+static int UtcOffsetFromCLibrary()
+{
+  const std::time_t now = std::time(nullptr);
+  std::tm           local_tm{};
+  std::tm           utc_tm{};
+#ifdef _WIN32
+  localtime_s(&local_tm, &now);
+  gmtime_s(&utc_tm, &now);
+#else
+  localtime_r(&now, &local_tm);
+  gmtime_r(&now, &utc_tm);
+#endif
+  // Treat both as local time; the difference is the offset.
+  local_tm.tm_isdst = 0;
+  utc_tm.tm_isdst = 0;
+  return static_cast<int>(std::difftime(std::mktime(&local_tm), std::mktime(&utc_tm)) / 60);
+}
+
+static void BM_UncachedLogTimestamp(benchmark::State& state)
+{
+  for (auto _ : state)
+  {
+    const auto        now = std::chrono::system_clock::now();
+    const std::time_t now_time = std::chrono::system_clock::to_time_t(now);
+    const auto        msec =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+
+    std::tm local_tm{};
+#ifdef _WIN32
+    localtime_s(&local_tm, &now_time);
+#else
+    localtime_r(&now_time, &local_tm);
+#endif
+    etcpal::LogTimestamp timestamp(local_tm.tm_year + 1900, local_tm.tm_mon + 1, local_tm.tm_mday, local_tm.tm_hour,
+                                   local_tm.tm_min, local_tm.tm_sec, static_cast<unsigned int>(msec),
+                                   UtcOffsetFromCLibrary());
+    benchmark::DoNotOptimize(timestamp);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_UncachedLogTimestamp)->Threads(1)->Threads(4)->UseRealTime();
+
+static void BM_CachedLogTimestamp(benchmark::State& state)
+{
+  static LogTimestampProvider provider(UtcOffsetFromCLibrary);
+
+  for (auto _ : state)
+  {
+    auto timestamp = provider.Now();
+    benchmark::DoNotOptimize(timestamp);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CachedLogTimestamp)->Threads(1)->Threads(4)->UseRealTime();
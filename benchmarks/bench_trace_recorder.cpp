@@ -0,0 +1,53 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+// The cost of a TraceRecorder::Span with tracing off, which is what every traced phase of the
+// service pays normally, against the cost with tracing on.
+
+#include "trace_recorder.h"
+#include "benchmark/benchmark.h"
+
+static void BM_SpanDisabled(benchmark::State& state)
+{
+  TraceRecorder::Stop();
+  for (auto _ : state)
+  {
+    TraceRecorder::Span span("Disabled");
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpanDisabled);
+
+// Once the thread's buffer is full, further spans are timed but dropped, so this measures the
+// clock reads and the uncontended lock rather than the buffer's growth.
+static void BM_SpanEnabled(benchmark::State& state)
+{
+  TraceRecorder::Start();
+  for (auto _ : state)
+  {
+    TraceRecorder::Span span("Enabled");
+    benchmark::ClobberMemory();
+  }
+  TraceRecorder::Stop();
+
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SpanEnabled);
@@ -0,0 +1,227 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "admin_server.h"
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+static const struct
+{
+  const char* name;
+  int         log_mask;
+} kLogLevels[] = {
+    {"debug", ETCPAL_LOG_UPTO(ETCPAL_LOG_DEBUG)},   {"info", ETCPAL_LOG_UPTO(ETCPAL_LOG_INFO)},
+    {"notice", ETCPAL_LOG_UPTO(ETCPAL_LOG_NOTICE)}, {"warning", ETCPAL_LOG_UPTO(ETCPAL_LOG_WARNING)},
+    {"err", ETCPAL_LOG_UPTO(ETCPAL_LOG_ERR)},       {"crit", ETCPAL_LOG_UPTO(ETCPAL_LOG_CRIT)},
+    {"alert", ETCPAL_LOG_UPTO(ETCPAL_LOG_ALERT)},   {"emerg", ETCPAL_LOG_UPTO(ETCPAL_LOG_EMERG)},
+};
+
+static constexpr char kHelp[] =
+    "help                     List the commands\n"
+    "status                   The broker's state, the log level and the restart counters\n"
+    "stats                    The metrics, in the Prometheus text format\n"
+    "recent_log               The flight recorder's messages, oldest first\n"
+    "log_level <level>        Change the log level: debug, info, notice, warning, err, crit, alert or emerg\n"
+    "restart                  Restart the broker\n"
+    "trace start|stop|write   Start or stop tracing the broker's startup and shutdown, or write the trace\n"
+    "clients                  List the broker's clients (not supported)\n"
+    "quit                     Close the connection\n";
+
+bool AdminServer::Startup(const Settings& settings, etcpal::Logger* log)
+{
+  if (running_ || !settings.enable)
+    return true;
+
+  log_ = log;
+  if (!Open())
+  {
+    if (log_)
+      log_->Error("Error opening the admin socket at \"%s\"; admin commands will not be available.", path_.c_str());
+    return false;
+  }
+
+  running_ = true;
+  if (!thread_.Start([this]() { Serve(); }).IsOk())
+  {
+    running_ = false;
+    Close();
+    return false;
+  }
+
+  if (log_)
+    log_->Info("Accepting admin commands at \"%s\".", path_.c_str());
+  return true;
+}
+
+void AdminServer::Shutdown()
+{
+  if (!running_)
+    return;
+
+  running_ = false;
+  Wake();
+  thread_.Join();
+  Close();
+}
+
+bool AdminServer::ProcessInput(std::string& input, std::string& output)
+{
+  size_t line_begin = 0;
+  size_t line_end = 0;
+  bool   keep_open = true;
+  while (keep_open && (line_end = input.find('\n', line_begin)) != std::string::npos)
+  {
+    std::string line = input.substr(line_begin, line_end - line_begin);
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+    line_begin = line_end + 1;
+    keep_open = HandleLine(line, output);
+  }
+  input.erase(0, line_begin);
+
+  if (keep_open && input.size() > kMaxLineLength)
+  {
+    output += "ERR Line too long\n";
+    keep_open = false;
+  }
+  if (!keep_open)
+    input.clear();
+  return keep_open;
+}
+
+bool AdminServer::ParseLogLevel(const std::string& name, int& log_mask)
+{
+  for (const auto& level : kLogLevels)
+  {
+    if (name == level.name)
+    {
+      log_mask = level.log_mask;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char* AdminServer::LogLevelName(int log_mask)
+{
+  for (const auto& level : kLogLevels)
+  {
+    if (log_mask == level.log_mask)
+      return level.name;
+  }
+  return "custom";
+}
+
+// Returns false if the connection should be closed once the output is sent.
+bool AdminServer::HandleLine(const std::string& line, std::string& output)
+{
+  std::istringstream       stream(line);
+  std::vector<std::string> args;
+  for (std::string arg; stream >> arg;)
+    args.push_back(arg);
+
+  if (args.empty())
+    return true;
+
+  std::string body;
+  std::string error;
+  bool        keep_open = true;
+
+  const std::string& command = args[0];
+  if (command == "help")
+  {
+    body = kHelp;
+  }
+  else if (command == "status")
+  {
+    body = handler_.HandleStatusRequest();
+  }
+  else if (command == "stats")
+  {
+    body = handler_.HandleStatsRequest();
+  }
+  else if (command == "recent_log")
+  {
+    if (!handler_.HandleRecentLogRequest(body))
+    {
+      error = body;
+      body.clear();
+    }
+  }
+  else if (command == "log_level")
+  {
+    int log_mask = 0;
+    if (args.size() != 2 || !ParseLogLevel(args[1], log_mask))
+    {
+      error = "Usage: log_level debug|info|notice|warning|err|crit|alert|emerg";
+    }
+    else
+    {
+      if (log_)
+        log_->Notice("Log level changed to \"%s\" by an admin command.", args[1].c_str());
+      handler_.HandleLogLevelChange(log_mask);
+    }
+  }
+  else if (command == "restart")
+  {
+    if (log_)
+      log_->Notice("Restart requested by an admin command.");
+    handler_.HandleRestartRequest();
+  }
+  else if (command == "trace")
+  {
+    static const std::pair<const char*, TraceAction> kTraceActions[] = {
+        {"start", TraceAction::kStart}, {"stop", TraceAction::kStop}, {"write", TraceAction::kWrite}};
+
+    const auto action = std::find_if(std::begin(kTraceActions), std::end(kTraceActions), [&](const auto& action) {
+      return args.size() == 2 && args[1] == action.first;
+    });
+    if (action == std::end(kTraceActions))
+    {
+      error = "Usage: trace start|stop|write";
+    }
+    else if (!handler_.HandleTraceRequest(action->second, body))
+    {
+      error = body;
+      body.clear();
+    }
+  }
+  else if (command == "clients")
+  {
+    error = "The RDMnet library doesn't report the broker's clients";
+  }
+  else if (command == "quit")
+  {
+    keep_open = false;
+  }
+  else
+  {
+    error = "Unknown command \"" + command + "\"; try \"help\"";
+  }
+
+  output += body;
+  if (!body.empty() && body.back() != '\n')
+    output += '\n';
+  output += error.empty() ? "OK\n" : "ERR " + error + "\n";
+  return keep_open;
+}
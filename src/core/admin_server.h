@@ -0,0 +1,124 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef ADMIN_SERVER_H_
+#define ADMIN_SERVER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include "etcpal/cpp/log.h"
+#include "etcpal/cpp/thread.h"
+
+// AdminServer : A local control channel for inspecting and adjusting the running service.
+//
+// Clients send one command per line and get back zero or more lines of output, followed by a line
+// that is either "OK" or "ERR <reason>". The commands are:
+//
+//   help                     List the commands
+//   status                   The broker's state, the log level and the restart counters
+//   stats                    The metrics, in the Prometheus text format
+//   recent_log               The flight recorder's messages, oldest first
+//   log_level <level>        Change the log level until the configuration next changes it
+//   restart                  Restart the broker, as a reload signal would
+//   trace start|stop|write   Start or stop tracing, or write the trace so far; see TraceRecorder
+//   clients                  Not supported; the RDMnet library doesn't report its clients
+//   quit                     Close the connection
+//
+// The server runs on its own thread and only calls the handler, which must be safe to call from it,
+// so a slow or stuck client can't hold up the broker. Platform implementations provide the
+// transport, which is only reachable from the local machine; the protocol is handled here.
+class AdminServer
+{
+public:
+  enum class TraceAction
+  {
+    kStart,
+    kStop,  // Also writes the trace
+    kWrite
+  };
+
+  class Handler
+  {
+  public:
+    virtual ~Handler() = default;
+
+    virtual std::string HandleStatusRequest() = 0;
+    virtual std::string HandleStatsRequest() = 0;
+    // Returns false, with the reason in output, if there are no recent messages to give.
+    virtual bool HandleRecentLogRequest(std::string& output) = 0;
+    virtual void HandleLogLevelChange(int log_mask) = 0;
+    virtual void HandleRestartRequest() = 0;
+    // Returns false, with the reason in output, if the action failed.
+    virtual bool HandleTraceRequest(TraceAction action, std::string& output) = 0;
+  };
+
+  struct Settings
+  {
+    bool enable{false};
+  };
+
+  // Longer lines are answered with an error and the connection is closed.
+  static constexpr size_t kMaxLineLength = 1024;
+
+  AdminServer(Handler& handler, std::string path) : handler_(handler), path_(std::move(path)) {}
+  virtual ~AdminServer() = default;
+
+  AdminServer(const AdminServer& other) = delete;
+  AdminServer& operator=(const AdminServer& other) = delete;
+
+  // Start serving, or do nothing if settings.enable is false. Returns false if the transport could
+  // not be set up. Derived classes must call Shutdown() in their destructors.
+  bool Startup(const Settings& settings, etcpal::Logger* log = nullptr);
+  void Shutdown();
+
+  [[nodiscard]] bool               running() const { return running_; }
+  [[nodiscard]] const std::string& path() const { return path_; }
+
+  // Handle the complete lines at the start of input, removing them and appending the responses to
+  // output. Returns false once the connection should be closed, after output has been sent.
+  bool ProcessInput(std::string& input, std::string& output);
+
+  // The names used by the log_level setting, e.g. "info" for ETCPAL_LOG_UPTO(ETCPAL_LOG_INFO).
+  static bool        ParseLogLevel(const std::string& name, int& log_mask);
+  static const char* LogLevelName(int log_mask);
+
+protected:
+  etcpal::Logger* log() const { return log_; }
+
+  // Platform transports. Open() and Close() are called on the caller's thread, Serve() on the
+  // server's; Serve() returns once running() is false, and Wake() makes it notice promptly.
+  virtual bool Open() = 0;
+  virtual void Close() = 0;
+  virtual void Serve() = 0;
+  virtual void Wake() = 0;
+
+private:
+  Handler&          handler_;
+  const std::string path_;
+  etcpal::Logger*   log_{nullptr};
+
+  std::atomic<bool> running_{false};
+  etcpal::Thread    thread_;
+
+  bool HandleLine(const std::string& line, std::string& output);
+};
+
+#endif  // ADMIN_SERVER_H_
@@ -0,0 +1,281 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "async_log_writer.h"
+#include "binary_log_record.h"
+
+#include <cstring>
+#include <cstdint>
+
+// The writer hands data to the output in chunks of roughly this size.
+static constexpr size_t kBatchSize = 64 * 1024;
+
+// How long a blocked producer waits before checking the buffer again. This only bounds the wait if
+// a wakeup from the writer thread is missed; blocked producers are normally woken right away.
+static constexpr int kBlockedRetryMs = 10;
+
+static size_t RoundUpToPowerOfTwo(size_t val)
+{
+  size_t result = 2;  // The ring buffer algorithm needs at least two slots
+  while (result < val)
+    result <<= 1;
+  return result;
+}
+
+AsyncLogWriter::AsyncLogWriter(size_t capacity)
+{
+  const size_t num_slots = RoundUpToPowerOfTwo(capacity);
+  slots_ = std::make_unique<Slot[]>(num_slots);
+  mask_ = num_slots - 1;
+
+  for (size_t i = 0; i < num_slots; ++i)
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+
+  batch_.reserve(kBatchSize + kMaxMessageLength + 1);
+}
+
+AsyncLogWriter::~AsyncLogWriter()
+{
+  Shutdown();
+}
+
+// file_size is the size of the log file that output is appending to, counted toward rotation.
+bool AsyncLogWriter::Startup(Output& output, const Settings& settings, uint64_t file_size)
+{
+  if (running_)
+    return false;
+
+  output_ = &output;
+  file_size_ = file_size;
+  SetSettings(settings);
+
+  running_ = true;
+  if (!writer_thread_.Start([this]() { WriterThread(); }).IsOk())
+  {
+    running_ = false;
+    output_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+// Stop accepting messages and return once everything already pushed has been written and flushed.
+void AsyncLogWriter::Shutdown()
+{
+  if (!running_.exchange(false))
+    return;
+
+  wake_signal_.Notify();
+  writer_thread_.Join();
+  output_ = nullptr;
+}
+
+void AsyncLogWriter::SetSettings(const Settings& settings)
+{
+  flush_interval_ms_ = settings.flush_interval_ms;
+  overflow_policy_ = settings.overflow_policy;
+  format_ = settings.format;
+  max_file_size_ = settings.max_file_size;
+
+  // The writer may be sleeping on the old interval, or the file may already be over a new size limit.
+  WakeWriter();
+}
+
+// Copy a line of text into the ring buffer. Safe to call from any number of threads at once. Returns
+// false if the message was dropped.
+bool AsyncLogWriter::Push(const char* message)
+{
+  if (!message)
+    return false;
+
+  size_t length = 0;
+  while (length < kMaxMessageLength && message[length] != '\0')
+    ++length;
+
+  return PushData(message, length, true);
+}
+
+// Push a message from etcpal in the configured format.
+bool AsyncLogWriter::PushLogMessage(const EtcPalLogStrings& strings)
+{
+  // The human-readable string is only built for the text format, so fall back to the binary format
+  // if it's missing while the format is being changed.
+  if (format_ == Format::kText && strings.human_readable)
+    return Push(strings.human_readable);
+
+  char         record[kMaxMessageLength];
+  const size_t length = BinaryLogRecord::Encode(strings.log_timestamp, strings.priority, strings.raw, record,
+                                                sizeof(record));
+  return PushData(record, length, false);
+}
+
+// This is a bounded multi-producer queue in the style of Dmitry Vyukov's: each slot's sequence
+// number tells a producer whether the slot is free for the position it's trying to claim.
+bool AsyncLogWriter::PushData(const char* data, size_t length, bool append_newline)
+{
+  if (!running_)
+    return false;
+
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  Slot*  slot = nullptr;
+  while (true)
+  {
+    slot = &slots_[pos & mask_];
+    const size_t   seq = slot->sequence.load(std::memory_order_acquire);
+    const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+    if (diff == 0)
+    {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (diff < 0)
+    {
+      // The buffer is full.
+      if (overflow_policy_ == OverflowPolicy::kDrop || !running_)
+      {
+        ++dropped_count_;
+        return false;
+      }
+
+      ++blocked_producers_;
+      WakeWriter();
+      space_signal_.TryWait(kBlockedRetryMs);
+      --blocked_producers_;
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+    else
+    {
+      // Another producer claimed this position first.
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  std::memcpy(slot->data, data, length);
+  slot->length = length;
+  slot->append_newline = append_newline;
+  slot->sequence.store(pos + 1, std::memory_order_release);
+
+  // Batch up messages unless the buffer is filling up or the user wants every message written
+  // right away.
+  const size_t fill = pos + 1 - dequeue_pos_.load(std::memory_order_relaxed);
+  if (flush_interval_ms_ == 0 || fill >= (capacity() / 2))
+    WakeWriter();
+
+  return true;
+}
+
+// Only signal the writer once per wakeup, no matter how many producers ask.
+void AsyncLogWriter::WakeWriter()
+{
+  if (!wake_pending_.exchange(true))
+    wake_signal_.Notify();
+}
+
+void AsyncLogWriter::WriterThread()
+{
+  while (running_)
+  {
+    const uint32_t interval = flush_interval_ms_;
+    if (interval == 0)
+      wake_signal_.Wait();
+    else
+      wake_signal_.TryWait(static_cast<int>(interval));
+
+    wake_pending_ = false;
+
+    if (Drain() > 0)
+      output_->FlushLogData();
+    RotateIfNeeded();
+  }
+
+  // Write out whatever is left before shutting down.
+  Drain();
+  output_->FlushLogData();
+  RotateIfNeeded();
+}
+
+// Move all available messages from the ring buffer to the output. Returns the number of bytes
+// written.
+size_t AsyncLogWriter::Drain()
+{
+  size_t bytes_written = 0;
+
+  const uint64_t dropped = dropped_count_;
+  if (dropped != reported_dropped_count_)
+  {
+    batch_ += "WARNING: " + std::to_string(dropped - reported_dropped_count_) +
+              " log message(s) were dropped because the log buffer was full.\n";
+    reported_dropped_count_ = dropped;
+  }
+
+  size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+  while (true)
+  {
+    Slot&        slot = slots_[pos & mask_];
+    const size_t seq = slot.sequence.load(std::memory_order_acquire);
+    if (seq != pos + 1)
+      break;  // Empty, or the producer hasn't finished copying yet
+
+    batch_.append(slot.data, slot.length);
+    if (slot.append_newline)
+      batch_.push_back('\n');
+
+    // Hand the slot back to producers for the next lap around the buffer.
+    slot.sequence.store(pos + mask_ + 1, std::memory_order_release);
+    dequeue_pos_.store(++pos, std::memory_order_relaxed);
+
+    if (blocked_producers_ > 0)
+      space_signal_.Notify();
+
+    if (batch_.size() >= kBatchSize)
+    {
+      bytes_written += batch_.size();
+      WriteBatch();
+      RotateIfNeeded();
+    }
+  }
+
+  bytes_written += batch_.size();
+  WriteBatch();
+  return bytes_written;
+}
+
+void AsyncLogWriter::WriteBatch()
+{
+  if (!batch_.empty())
+  {
+    output_->WriteLogData(batch_.data(), batch_.size());
+    file_size_ += batch_.size();
+    batch_.clear();
+  }
+}
+
+// Rotation happens here on the writer thread, so threads that are logging never wait for it; they
+// only see the ring buffer fill up a bit more than usual in the meantime.
+void AsyncLogWriter::RotateIfNeeded()
+{
+  const uint32_t max_file_size = max_file_size_;
+  if (max_file_size != 0 && file_size_ >= max_file_size)
+  {
+    output_->FlushLogData();
+    output_->RotateLogFile();
+    file_size_ = 0;
+  }
+}
@@ -0,0 +1,141 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef ASYNC_LOG_WRITER_H_
+#define ASYNC_LOG_WRITER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "etcpal/cpp/signal.h"
+#include "etcpal/cpp/thread.h"
+#include "etcpal/log.h"
+
+// AsyncLogWriter : Takes log file I/O off of the threads that generate log messages.
+//
+// Any number of threads Push() messages into a bounded, lock-free ring buffer. A single writer
+// thread drains the buffer in batches and hands them to an Output, flushing once per batch instead
+// of after every message.
+class AsyncLogWriter
+{
+public:
+  // What Push() does when the ring buffer is full.
+  enum class OverflowPolicy
+  {
+    kDrop,  // Discard the message and count it; the count is written to the log later.
+    kBlock  // Wait for the writer thread to make room.
+  };
+
+  // How PushLogMessage() writes messages to the log file.
+  enum class Format
+  {
+    kText,   // etcpal's human-readable strings, one per line
+    kBinary  // BinaryLogRecords; see binary_log_record.h
+  };
+
+  struct Settings
+  {
+    // How long messages may sit in the buffer before the writer thread wakes up to write them. The
+    // writer also wakes early when the buffer is half full. 0 writes every message immediately.
+    uint32_t       flush_interval_ms{1000};
+    OverflowPolicy overflow_policy{OverflowPolicy::kDrop};
+    // The log file is rotated once it grows past this many bytes. 0 disables rotation.
+    uint32_t       max_file_size{10 * 1024 * 1024};
+    Format         format{Format::kText};
+  };
+
+  // The destination for log data, implemented by the platform. Only ever called from the writer
+  // thread.
+  class Output
+  {
+  public:
+    virtual ~Output() = default;
+
+    virtual void WriteLogData(const char* data, size_t size) = 0;
+    virtual void FlushLogData() = 0;
+    // Move the current log file out of the way and start a new one. Called right after
+    // FlushLogData().
+    virtual void RotateLogFile() = 0;
+  };
+
+  static constexpr size_t kDefaultCapacity = 4096;  // Messages; rounded up to a power of two
+  static constexpr size_t kMaxMessageLength = 1024;  // Longer messages are truncated
+
+  explicit AsyncLogWriter(size_t capacity = kDefaultCapacity);
+  ~AsyncLogWriter();
+
+  AsyncLogWriter(const AsyncLogWriter& other) = delete;
+  AsyncLogWriter& operator=(const AsyncLogWriter& other) = delete;
+
+  bool Startup(Output& output, const Settings& settings, uint64_t file_size = 0);
+  void Shutdown();
+
+  void SetSettings(const Settings& settings);
+
+  bool Push(const char* message);
+  bool PushLogMessage(const EtcPalLogStrings& strings);
+
+  [[nodiscard]] size_t   capacity() const { return mask_ + 1; }
+  [[nodiscard]] uint64_t dropped_count() const { return dropped_count_; }
+
+private:
+  struct Slot
+  {
+    std::atomic<size_t> sequence{0};
+    size_t              length{0};
+    bool                append_newline{false};
+    char                data[kMaxMessageLength];
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t                  mask_{0};
+
+  // Keep the producer and consumer positions on separate cache lines.
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) std::atomic<size_t> dequeue_pos_{0};
+
+  std::atomic<uint32_t>       flush_interval_ms_{0};
+  std::atomic<OverflowPolicy> overflow_policy_{OverflowPolicy::kDrop};
+  std::atomic<Format>         format_{Format::kText};
+  std::atomic<uint32_t>       max_file_size_{0};
+  std::atomic<uint64_t>       dropped_count_{0};
+  std::atomic<int>            blocked_producers_{0};
+  std::atomic<bool>           wake_pending_{false};
+  std::atomic<bool>           running_{false};
+
+  // Writer thread state
+  Output*        output_{nullptr};
+  etcpal::Thread writer_thread_;
+  etcpal::Signal wake_signal_;   // Producers -> writer: there is data to write
+  etcpal::Signal space_signal_;  // Writer -> blocked producers: there is room in the buffer
+  std::string    batch_;
+  uint64_t       reported_dropped_count_{0};
+  uint64_t       file_size_{0};
+
+  bool   PushData(const char* data, size_t length, bool append_newline);
+  void   WakeWriter();
+  void   WriterThread();
+  size_t Drain();
+  void   WriteBatch();
+  void   RotateIfNeeded();
+};
+
+#endif  // ASYNC_LOG_WRITER_H_
@@ -0,0 +1,238 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "binary_log_record.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "nlohmann/json.hpp"
+
+// Indexed by priority. The text format uses the same abbreviations as etcpal's human-readable log
+// strings; JSON uses the names from the log_level config setting.
+static constexpr const char* kSeverityStrings[] = {"EMRG", "ALRT", "CRIT", "ERR ", "WARN", "NOTI", "INFO", "DBUG"};
+static constexpr const char* kSeverityNames[] = {"emerg", "alert", "crit", "err", "warning", "notice", "info", "debug"};
+
+static void PackU16(char* buf, uint16_t val)
+{
+  buf[0] = static_cast<char>(val & 0xffu);
+  buf[1] = static_cast<char>((val >> 8) & 0xffu);
+}
+
+static uint16_t UnpackU16(const char* buf)
+{
+  return static_cast<uint16_t>(static_cast<uint8_t>(buf[0]) | (static_cast<uint8_t>(buf[1]) << 8));
+}
+
+static const char* SeverityStringFrom(int priority, const char* const* strings)
+{
+  if (priority >= ETCPAL_LOG_EMERG && priority <= ETCPAL_LOG_DEBUG)
+    return strings[priority];
+  return "????";
+}
+
+// FormatText() builds lines with these rather than snprintf(), so that crash handlers can use it.
+// Text that doesn't fit in size is cut off.
+static void AppendText(char* buf, size_t size, size_t& length, const char* text, size_t text_length)
+{
+  const size_t count = std::min(text_length, size - length);
+  std::memcpy(buf + length, text, count);
+  length += count;
+}
+
+static void AppendText(char* buf, size_t size, size_t& length, const char* text)
+{
+  AppendText(buf, size, length, text, std::strlen(text));
+}
+
+// Zero-padded to at least width digits.
+static void AppendNumber(char* buf, size_t size, size_t& length, unsigned int value, int width)
+{
+  char digits[10];
+  int  count = 0;
+  do
+  {
+    digits[count++] = static_cast<char>('0' + (value % 10));
+    value /= 10;
+  } while (value != 0);
+  while (count < width && count < static_cast<int>(sizeof(digits)))
+    digits[count++] = '0';
+
+  while (count > 0 && length < size)
+    buf[length++] = digits[--count];
+}
+
+static std::string FormatTimestamp(const EtcPalLogTimestamp& timestamp)
+{
+  const int utc_offset_abs = std::abs(timestamp.utc_offset);
+
+  char buf[64];
+  snprintf(buf, sizeof(buf), "%04u-%02u-%02u %02u:%02u:%02u.%03u%c%02d:%02d", timestamp.year, timestamp.month,
+           timestamp.day, timestamp.hour, timestamp.minute, timestamp.second, timestamp.msec,
+           (timestamp.utc_offset < 0 ? '-' : '+'), utc_offset_abs / 60, utc_offset_abs % 60);
+  return buf;
+}
+
+size_t BinaryLogRecord::Encode(const EtcPalLogTimestamp* timestamp,
+                               int                       priority,
+                               const char*               message,
+                               char*                     buf,
+                               size_t                    buf_size)
+{
+  if (buf_size < kHeaderSize)
+    return 0;
+
+  const size_t max_length = std::min<size_t>(buf_size - kHeaderSize, UINT16_MAX);
+
+  size_t length = 0;
+  if (message)
+  {
+    while (length < max_length && message[length] != '\0')
+      ++length;
+  }
+
+  buf[0] = static_cast<char>(kMarker);
+  buf[1] = static_cast<char>(kVersion);
+  if (timestamp)
+  {
+    PackU16(&buf[2], static_cast<uint16_t>(timestamp->year));
+    buf[4] = static_cast<char>(timestamp->month);
+    buf[5] = static_cast<char>(timestamp->day);
+    buf[6] = static_cast<char>(timestamp->hour);
+    buf[7] = static_cast<char>(timestamp->minute);
+    buf[8] = static_cast<char>(timestamp->second);
+    PackU16(&buf[9], static_cast<uint16_t>(timestamp->msec));
+    PackU16(&buf[11], static_cast<uint16_t>(static_cast<int16_t>(timestamp->utc_offset)));
+  }
+  else
+  {
+    std::memset(&buf[2], 0, 11);
+  }
+  buf[13] = static_cast<char>(priority);
+  PackU16(&buf[14], static_cast<uint16_t>(length));
+
+  if (length > 0)
+    std::memcpy(&buf[kHeaderSize], message, length);
+  return kHeaderSize + length;
+}
+
+BinaryLogRecord::DecodeResult BinaryLogRecord::Decode(const char*      data,
+                                                      size_t           size,
+                                                      BinaryLogRecord& record,
+                                                      size_t&          consumed)
+{
+  if (size < 2)
+    return DecodeResult::kNeedMoreData;
+  if (static_cast<uint8_t>(data[0]) != kMarker || static_cast<uint8_t>(data[1]) != kVersion)
+    return DecodeResult::kInvalid;
+  if (size < kHeaderSize)
+    return DecodeResult::kNeedMoreData;
+
+  const size_t length = UnpackU16(&data[14]);
+  if (size < kHeaderSize + length)
+    return DecodeResult::kNeedMoreData;
+
+  record.timestamp.year = UnpackU16(&data[2]);
+  record.timestamp.month = static_cast<uint8_t>(data[4]);
+  record.timestamp.day = static_cast<uint8_t>(data[5]);
+  record.timestamp.hour = static_cast<uint8_t>(data[6]);
+  record.timestamp.minute = static_cast<uint8_t>(data[7]);
+  record.timestamp.second = static_cast<uint8_t>(data[8]);
+  record.timestamp.msec = UnpackU16(&data[9]);
+  record.timestamp.utc_offset = static_cast<int16_t>(UnpackU16(&data[11]));
+  record.has_timestamp = (record.timestamp.year != 0);
+  record.priority = static_cast<uint8_t>(data[13]);
+  record.message.assign(&data[kHeaderSize], length);
+
+  consumed = kHeaderSize + length;
+  return DecodeResult::kOk;
+}
+
+const char* BinaryLogRecord::SeverityString(int priority)
+{
+  return SeverityStringFrom(priority, kSeverityStrings);
+}
+
+size_t BinaryLogRecord::FormatText(const EtcPalLogTimestamp* timestamp,
+                                   int                       priority,
+                                   const char*               message,
+                                   size_t                    message_length,
+                                   char*                     buf,
+                                   size_t                    buf_size)
+{
+  if (buf_size == 0)
+    return 0;
+
+  const size_t size = buf_size - 1;  // Room for the terminator
+  size_t       length = 0;
+  if (timestamp)
+  {
+    const auto&        t = *timestamp;
+    const unsigned int utc_offset = static_cast<unsigned int>(std::abs(t.utc_offset));
+    AppendNumber(buf, size, length, t.year, 4);
+    AppendText(buf, size, length, "-");
+    AppendNumber(buf, size, length, t.month, 2);
+    AppendText(buf, size, length, "-");
+    AppendNumber(buf, size, length, t.day, 2);
+    AppendText(buf, size, length, " ");
+    AppendNumber(buf, size, length, t.hour, 2);
+    AppendText(buf, size, length, ":");
+    AppendNumber(buf, size, length, t.minute, 2);
+    AppendText(buf, size, length, ":");
+    AppendNumber(buf, size, length, t.second, 2);
+    AppendText(buf, size, length, ".");
+    AppendNumber(buf, size, length, t.msec, 3);
+    AppendText(buf, size, length, (t.utc_offset < 0) ? "-" : "+");
+    AppendNumber(buf, size, length, utc_offset / 60, 2);
+    AppendText(buf, size, length, ":");
+    AppendNumber(buf, size, length, utc_offset % 60, 2);
+    AppendText(buf, size, length, " ");
+  }
+  AppendText(buf, size, length, "[");
+  AppendText(buf, size, length, SeverityString(priority));
+  AppendText(buf, size, length, "] ");
+  if (message)
+    AppendText(buf, size, length, message, message_length);
+
+  buf[length] = '\0';
+  return length;
+}
+
+std::string BinaryLogRecord::ToText() const
+{
+  std::string text;
+  if (has_timestamp)
+    text = FormatTimestamp(timestamp) + " ";
+  text += std::string("[") + SeverityString(priority) + "] " + message;
+  return text;
+}
+
+std::string BinaryLogRecord::ToJson() const
+{
+  nlohmann::json json_record;
+  if (has_timestamp)
+    json_record["timestamp"] = FormatTimestamp(timestamp);
+  json_record["priority"] = priority;
+  json_record["severity"] = SeverityStringFrom(priority, kSeverityNames);
+  json_record["message"] = message;
+
+  // Log messages aren't guaranteed to be valid UTF-8.
+  return json_record.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
+}
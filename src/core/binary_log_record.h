@@ -0,0 +1,90 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef BINARY_LOG_RECORD_H_
+#define BINARY_LOG_RECORD_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "etcpal/log.h"
+
+// BinaryLogRecord : A log message as written to the log file in the binary log format.
+//
+// Each record is a fixed 16-byte header followed by the message text, all little-endian:
+//
+//   0     Record marker (0x1e)
+//   1     Format version (1)
+//   2-3   Year (0 if the message had no timestamp)
+//   4-8   Month, day, hour, minute, second
+//   9-10  Milliseconds
+//   11-12 UTC offset in minutes (signed)
+//   13    Priority (ETCPAL_LOG_EMERG - ETCPAL_LOG_DEBUG)
+//   14-15 Message length
+//
+// Records are not newline-terminated. The service still writes a few plain text lines to the same
+// file (the startup banner, warnings about the log file itself); these never start with the record
+// marker, so a reader can tell the two apart.
+struct BinaryLogRecord
+{
+  static constexpr uint8_t kMarker = 0x1e;
+  static constexpr uint8_t kVersion = 1;
+  static constexpr size_t  kHeaderSize = 16;
+
+  enum class DecodeResult
+  {
+    kOk,
+    kNeedMoreData,  // data holds the start of a record, but not all of it
+    kInvalid
+  };
+
+  EtcPalLogTimestamp timestamp{};
+  bool               has_timestamp{false};
+  int                priority{0};
+  std::string        message;
+
+  // Encode a record into buf. Messages too long to fit are truncated. Returns the number of bytes
+  // written, or 0 if buf can't even hold the header.
+  static size_t Encode(const EtcPalLogTimestamp* timestamp,
+                       int                       priority,
+                       const char*               message,
+                       char*                     buf,
+                       size_t                    buf_size);
+
+  static DecodeResult Decode(const char* data, size_t size, BinaryLogRecord& record, size_t& consumed);
+
+  // Write a message into buf the same way as etcpal's human-readable log strings; timestamp may be
+  // null. The line is truncated to fit and null-terminated. Returns its length. Doesn't allocate,
+  // and only makes async-signal-safe calls, so crash handlers can use it.
+  static size_t FormatText(const EtcPalLogTimestamp* timestamp,
+                           int                       priority,
+                           const char*               message,
+                           size_t                    message_length,
+                           char*                     buf,
+                           size_t                    buf_size);
+
+  // Renders the record the same way as etcpal's human-readable log strings.
+  [[nodiscard]] std::string ToText() const;
+  [[nodiscard]] std::string ToJson() const;
+
+  // The severity abbreviation etcpal uses in human-readable log strings, e.g. "WARN".
+  static const char* SeverityString(int priority);
+};
+
+#endif  // BINARY_LOG_RECORD_H_
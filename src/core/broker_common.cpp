@@ -19,7 +19,9 @@
 
 #include "broker_common.h"
 #include "etcpal/cpp/log.h"
+#include "flight_recorder.h"
 #include <cassert>
+#include <chrono>
 
 class AssertLogHandler : public etcpal::LogMessageHandler
 {
@@ -42,6 +44,13 @@ private:
   AssertLogHandler log_handler_;
 };
 
+uint64_t SteadyClockMs()
+{
+  return static_cast<uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
+
 bool AssertVerifyFail(const char*                             exp,
                       const char*                             file,
                       const char*                             func,
@@ -52,6 +61,9 @@ bool AssertVerifyFail(const char*                             exp,
   logger.Critical(R"(ASSERTION "%s" FAILED (FILE: "%s" FUNCTION: "%s" LINE: %d))", exp ? exp : "", file ? file : "",
                   func ? func : "", line);
 
+  // Save the lead-up to the failure before a debug build aborts.
+  FlightRecorder::DumpForCrash("assertion failure");
+
   assert(false);
   return false;
 }
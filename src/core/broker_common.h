@@ -20,8 +20,12 @@
 #ifndef BROKER_COMMON_H_
 #define BROKER_COMMON_H_
 
+#include <cstdint>
 #include "etcpal/cpp/log.h"
 
+// Milliseconds on a monotonic clock, for measuring intervals.
+uint64_t SteadyClockMs();
+
 bool AssertVerifyFail(const char*                             exp,
                       const char*                             file,
                       const char*                             func,
@@ -19,90 +19,82 @@
 
 #include "broker_config.h"
 
+#include <algorithm>
 #include <cinttypes>
-#include <functional>
+#include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <limits>
-#include <map>
-#include <type_traits>
+#include <sstream>
+#include <tuple>
 #include <utility>
+#include <vector>
 #include "etcpal/uuid.h"
-#include "broker_common.h"
+#include "config_schema.h"
 
-constexpr const char kValidationFailLogPrefix[] = "Invalid value found in configuration file: ";
-constexpr const char kValidationFailLogPostfix[] = " (default will be used instead).";
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
-template <typename... Args>
-void LogParseError(etcpal::Logger* log, const std::string& format, Args&&... args)
-{
-  if (log)
-  {
-    log->Notice(std::string(kValidationFailLogPrefix + format + kValidationFailLogPostfix).c_str(),
-                std::forward<Args>(args)...);
-  }
-}
-
-// A set of information needed to validate an element in the config file's JSON.
-struct Validator final
-{
-  // Pointer to the key
-  const json::json_pointer pointer;
-  // The expected value type
-  const json::value_t type;
-  // A function to validate and store the value in the config's settings structure. This must be provided.
-  std::function<bool(const json&, BrokerConfig&, etcpal::Logger*)> validate_and_store;
-  // A function to store the default setting in the settings structure if the value is not present
-  // in the config file or is invalid. This must be provided.
-  std::function<void(BrokerConfig&)> store_default;
-};
+using config_schema::LogParseError;
 
 // The CID must be a string representation of a UUID.
-bool ValidateAndStoreCid(const json& val, BrokerConfig& config, etcpal::Logger* log)
+bool ValidateAndStoreCid(const json& val, etcpal::Uuid& cid, etcpal::Logger* log)
 {
-  config.settings.cid = etcpal::Uuid::FromString(val);
-  if (!config.settings.cid.IsNull())
+  const std::string& cid_string = val.get_ref<const std::string&>();
+
+  cid = etcpal::Uuid::FromString(cid_string);
+  if (!cid.IsNull())
   {
     return true;
   }
   else
   {
-    LogParseError(log, "\"%s\" is not a valid CID", std::string(val).c_str());
+    LogParseError(log, "\"%s\" is not a valid CID", cid_string.c_str());
     return false;
   }
 }
 
+json CidToJson(const etcpal::Uuid& cid)
+{
+  return cid.ToString();
+}
+
 // The UID takes the form:
 // "uid": {
 //   "type": < "static" | "dynamic" >,
 //   "manufacturer_id": <number, always present>,
 //   "device_id": <number, present only if type is "static">
 // }
-bool ValidateAndStoreUid(const json& val, BrokerConfig& config, etcpal::Logger* log)
+bool ValidateAndStoreUid(const json& val, rdm::Uid& uid, etcpal::Logger* log)
 {
-  if (!val.contains("type"))
+  const auto type_val = val.find("type");
+  if (type_val == val.end())
   {
     LogParseError(log, "The \"uid\" object must contain a \"type\" field");
     return false;
   }
-  if (!val["type"].is_string())
+  if (!type_val->is_string())
   {
-    LogParseError(log, "The value for setting \"/uid/type\" was of invalid type \"%s\"", val["type"].type_name());
+    LogParseError(log, "The value for setting \"/uid/type\" was of invalid type \"%s\"", type_val->type_name());
     return false;
   }
-  if (!val.contains("manufacturer_id"))
+  const auto manufacturer_id_val = val.find("manufacturer_id");
+  if (manufacturer_id_val == val.end())
   {
     LogParseError(log, "The \"uid\" object must contain a \"manufacturer_id\" field");
     return false;
   }
-  if (!val["manufacturer_id"].is_number_integer())
+  if (!manufacturer_id_val->is_number_integer())
   {
     LogParseError(log, "The value for setting \"/uid/manufacturer_id\" was of invalid type \"%s\"",
-                  val["manufacturer_id"].type_name());
+                  manufacturer_id_val->type_name());
     return false;
   }
 
-  const std::string type = val["type"];
-  const int64_t     manufacturer_id = val["manufacturer_id"];
+  const std::string& type = type_val->get_ref<const std::string&>();
+  const int64_t      manufacturer_id = *manufacturer_id_val;
 
   if (manufacturer_id <= 0 || manufacturer_id >= 0x8000)
   {
@@ -110,39 +102,40 @@ bool ValidateAndStoreUid(const json& val, BrokerConfig& config, etcpal::Logger*
     return false;
   }
 
+  const auto device_id_val = val.find("device_id");
   if (type == "static")
   {
-    if (!val.contains("device_id"))
+    if (device_id_val == val.end())
     {
       LogParseError(log, "When \"/uid/type\" is \"static\", the \"uid\" object must contain a \"device_id\" field");
       return false;
     }
-    if (!val["device_id"].is_number_integer())
+    if (!device_id_val->is_number_integer())
     {
       LogParseError(log, "The value for setting \"/uid/device_id\" was of invalid type \"%s\"",
-                    val["device_id"].type_name());
+                    device_id_val->type_name());
       return false;
     }
 
-    const int64_t device_id = val["device_id"];
+    const int64_t device_id = *device_id_val;
     if (device_id < 0 || device_id > 0xffffffff)
     {
       LogParseError(log, "Static UID: \"%" PRId64 "\" is not a valid Device ID", device_id);
       return false;
     }
 
-    config.settings.uid = rdm::Uid::Static(static_cast<uint16_t>(manufacturer_id), static_cast<uint32_t>(device_id));
+    uid = rdm::Uid::Static(static_cast<uint16_t>(manufacturer_id), static_cast<uint32_t>(device_id));
     return true;
   }
   else if (type == "dynamic")
   {
-    if (val.contains("device_id"))
+    if (device_id_val != val.end())
     {
       LogParseError(log,
                     "When \"/uid/type\" is \"dynamic\", the \"uid\" object must not contain a \"device_id\" field");
       return false;
     }
-    config.settings.uid = rdm::Uid::DynamicUidRequest(static_cast<uint16_t>(manufacturer_id));
+    uid = rdm::Uid::DynamicUidRequest(static_cast<uint16_t>(manufacturer_id));
     return true;
   }
   else
@@ -152,153 +145,32 @@ bool ValidateAndStoreUid(const json& val, BrokerConfig& config, etcpal::Logger*
   }
 }
 
-// Store a generic string.
-bool ValidateAndStoreString(const char*     key_ptr,
-                            const json&     val,
-                            std::string&    string,
-                            size_t          max_size,
-                            etcpal::Logger* log,
-                            bool            truncation_allowed = true)
+json UidToJson(const rdm::Uid& uid)
 {
-  if (!BROKER_ASSERT_VERIFY(key_ptr, [log](const char* msg) {
-        if (log)
-          log->Critical(msg);
-      }))
-  {
-    return false;
-  }
-
-  const std::string str_val = val;
-  if (str_val.empty())
-  {
-    LogParseError(log, "Empty string is not allowed for field \"%s\"", key_ptr);
-    return false;
-  }
-
-  if (str_val.length() > max_size)
-  {
-    if (truncation_allowed)
-    {
-      string = str_val.substr(0, max_size);
-      if (log)
-      {
-        log->Notice("Configuration file: Truncating overlong string \"%s\" for field \"%s\" to \"%s\".",
-                    str_val.c_str(), key_ptr, string.c_str());
-      }
-      return true;
-    }
-    else
-    {
-      LogParseError(log, "String value \"%s\" is too long for field \"%s\" of maximum length %zu", str_val.c_str(),
-                    key_ptr, max_size);
-      return false;
-    }
-  }
-
-  string = str_val;
-  return true;
+  if (uid.IsDynamicUidRequest())
+    return {{"type", "dynamic"}, {"manufacturer_id", uid.manufacturer_id()}};
+  return {{"type", "static"}, {"manufacturer_id", uid.manufacturer_id()}, {"device_id", uid.device_id()}};
 }
 
-// Get the printf-style format string of a given integral type
-template <typename IntType>
-class FormatStringOf
+bool ValidateAndStoreInterfaceList(const json& val, std::vector<std::string>& listen_interfaces, etcpal::Logger* log)
 {
-public:
-  static const char* value;
-};
-
-// Specialize this for each type that ValidateAndStoreInt is used for.
-// clang-format off
-template<> const char* FormatStringOf<unsigned int>::value = "%u";
-template<> const char* FormatStringOf<uint16_t>::value = "%" PRIu16;
-// clang-format on
-
-// Validate an arithmetic type and set it in the settings struct if it is within the valid range
-// for its type.
-template <typename IntType>
-bool ValidateAndStoreInt(
-    const char*                        key_ptr,
-    const json&                        val,
-    IntType&                           setting,
-    etcpal::Logger*                    log,
-    const std::pair<IntType, IntType>& limits = std::make_pair<IntType, IntType>(std::numeric_limits<IntType>::min(),
-                                                                                 std::numeric_limits<IntType>::max()))
-{
-  static_assert(std::is_integral<IntType>(), "This function can only be used with integral types.");
-
-  if (!BROKER_ASSERT_VERIFY(key_ptr, [log](const char* msg) {
-        if (log)
-          log->Critical(msg);
-      }))
-  {
-    return false;
-  }
-
-  const int64_t int_val = val;
-  if (int_val < limits.first || int_val > limits.second)
-  {
-    LogParseError(log,
-                  std::string("Integer value \"%" PRId64 "\" is outside allowable range [") +
-                      FormatStringOf<IntType>::value + ", " + FormatStringOf<IntType>::value + "] for field \"%s\"",
-                  int_val, limits.first, limits.second, key_ptr);
-    return false;
-  }
-  setting = static_cast<IntType>(int_val);
-  return true;
-}
-
-bool ValidateAndStoreInterfaceList(const json& val, BrokerConfig& config, etcpal::Logger* log)
-{
-  const std::vector<json> listen_interfaces = val;
-  for (const json& listen_interface : listen_interfaces)
+  listen_interfaces.clear();
+  listen_interfaces.reserve(val.size());
+  for (const json& listen_interface : val)
   {
     if (listen_interface.type() != json::value_t::string)
     {
       LogParseError(log, "The array field \"/listen_interfaces\" may only contain values of type \"string\"");
-      config.settings.listen_interfaces.clear();
       return false;
     }
-    config.settings.listen_interfaces.push_back(listen_interface);
+    listen_interfaces.push_back(listen_interface.get_ref<const std::string&>());
   }
   return true;
 }
 
-// clang-format off
-const std::map<std::string, int> kLogLevelOptions = {
-  {"debug", ETCPAL_LOG_UPTO(ETCPAL_LOG_DEBUG)},
-  {"info", ETCPAL_LOG_UPTO(ETCPAL_LOG_INFO)},
-  {"notice", ETCPAL_LOG_UPTO(ETCPAL_LOG_NOTICE)},
-  {"warning", ETCPAL_LOG_UPTO(ETCPAL_LOG_WARNING)},
-  {"err", ETCPAL_LOG_UPTO(ETCPAL_LOG_ERR)},
-  {"crit", ETCPAL_LOG_UPTO(ETCPAL_LOG_CRIT)},
-  {"alert", ETCPAL_LOG_UPTO(ETCPAL_LOG_ALERT)},
-  {"emerg", ETCPAL_LOG_UPTO(ETCPAL_LOG_EMERG)},
-};
-// clang-format on
-
-// Join all the possible log levels in a readable set of the form {"level1", "level2", ...} for
-// error logging.
-std::string GetLogLevelOptions()
-{
-  return "{" +
-         std::accumulate(std::next(kLogLevelOptions.begin()), kLogLevelOptions.end(),
-                         "\"" + kLogLevelOptions.begin()->first + "\"",
-                         [](std::string a, auto b) { return std::move(a) + ", \"" + b.first + "\""; }) +
-         "}";
-}
-
-bool ValidateAndStoreLogLevel(const json& val, BrokerConfig& config, etcpal::Logger* log)
+json InterfaceListToJson(const std::vector<std::string>& listen_interfaces)
 {
-  const std::string log_level = val;
-  auto              level_pair = kLogLevelOptions.find(log_level);
-  if (level_pair == kLogLevelOptions.end())
-  {
-    LogParseError(log, "The value for field \"/log_level\" must be one of " + GetLogLevelOptions());
-    return false;
-  }
-
-  config.log_mask = level_pair->second;
-  return true;
+  return listen_interfaces;
 }
 
 // A typical full, valid configuration file looks something like:
@@ -323,230 +195,789 @@ bool ValidateAndStoreLogLevel(const json& val, BrokerConfig& config, etcpal::Log
 //   ],
 //
 //   "log_level": "info",
+//   "log_flush_interval_ms": 1000,
+//   "log_overflow_policy": "drop",
+//   "log_format": "text",
+//   "log_max_size": 10485760,
+//   "log_max_files": 5,
+//   "log_max_total_size": 0,
+//   "log_compress": true,
+//   "flight_recorder_size": 1000,
+//
+//   "enable_metrics": false,
+//   "metrics_port": 9464,
+//   "stats_interval_s": 300,
+//   "enable_admin_socket": false,
+//   "enable_trace": false,
 //
 //   "max_connections": 20000,
 //   "max_controllers": 1000,
 //   "max_controller_messages": 500,
 //   "max_devices": 20000,
 //   "max_device_messages": 500,
-//   "max_reject_connections": 1000
+//   "max_reject_connections": 1000,
+//
+//   "restart_mode": "overlapped",
+//   "restart_drain_ms": 5000
 // }
 // Any or all of these items can be omitted to use the default value for that key.
 
+template <typename Rule, typename Access, typename Default>
+constexpr auto Setting(std::string_view          pointer,
+                      Rule                      rule,
+                      Access                    access,
+                      Default                   default_value,
+                      bool BrokerConfig::Diff::*diff_flag,
+                      std::string_view          description)
+{
+  return config_schema::MakeField<BrokerConfig>(pointer, rule, access, default_value, diff_flag, description);
+}
+
+using config_schema::BoolRule;
+using config_schema::CustomRule;
+using config_schema::Enum;
+using config_schema::IntRule;
+using config_schema::StringRule;
+using Diff = BrokerConfig::Diff;
+
+constexpr auto kUnlimited = std::numeric_limits<unsigned int>::max();
+constexpr auto kUint32Max = std::numeric_limits<uint32_t>::max();
+
 // clang-format off
-// This array should always be processed top to bottom in case the default of one property depends on the value of the property above it.
-static const Validator kSettingsValidatorArray[] = {
-  {
-    "/cid"_json_pointer,
-    json::value_t::string,
-    ValidateAndStoreCid,
-    [](auto& config) { config.settings.cid = config.default_cid(); },
-  },
-  {
-    "/uid"_json_pointer,
-    json::value_t::object,
-    ValidateAndStoreUid,
-    [](auto& config) { config.settings.uid = rdm::Uid::DynamicUidRequest(0x6574); }, // Set ETC's manufacturer ID
-  },
-  {
-    "/dns_sd/service_instance_name"_json_pointer,
-    json::value_t::string,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreString("/dns_sd/service_instance_name", val, config.settings.dns.service_instance_name, E133_SERVICE_NAME_STRING_PADDED_LENGTH - 1, log);
-    },
-    [](auto& config) {
-      // Add our CID to the service instance name, to help disambiguate.
-      // This entry is placed after the CID property's entry in the array, so config.settings.cid has already been loaded and can be used.
-      config.settings.dns.service_instance_name = "ETC RDMnet Broker " + config.settings.cid.ToString();
-    }
-  },
-  {
-    "/dns_sd/manufacturer"_json_pointer,
-    json::value_t::string,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreString("/dns_sd/manufacturer", val, config.settings.dns.manufacturer, E133_MANUFACTURER_STRING_PADDED_LENGTH - 1, log);
-    },
-    [](auto& config) { config.settings.dns.manufacturer = "ETC"; }
-  },
-  {
-    "/dns_sd/model"_json_pointer,
-    json::value_t::string,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreString("/dns_sd/model", val, config.settings.dns.model, E133_MODEL_STRING_PADDED_LENGTH - 1, log);
-    },
-    [](auto& config) { config.settings.dns.model = "RDMnet Broker Service"; }
-  },
-  {
-    "/scope"_json_pointer,
-    json::value_t::string,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreString("/scope", val, config.settings.scope, E133_SCOPE_STRING_PADDED_LENGTH -1, log, false);
-    },
-    [](auto& config) { config.settings.scope = E133_DEFAULT_SCOPE; }
-  },
-  {
-    "/listen_port"_json_pointer,
-    json::value_t::number_unsigned,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreInt<uint16_t>("/listen_port", val, config.settings.listen_port, log, std::make_pair<uint16_t, uint16_t>(1024, 65535));
-    },
-    [](auto& config) { config.settings.listen_port = 0u; }
-  },
-  {
-    "/listen_interfaces"_json_pointer,
-    json::value_t::array,
-    ValidateAndStoreInterfaceList,
-    [](auto& config) { config.settings.listen_interfaces.clear(); }
-  },
+// The settings are processed top to bottom, so the default of one setting can depend on the value
+// of a setting above it.
+static constexpr auto kSchema = std::make_tuple(
+  Setting("/cid",
+          CustomRule<etcpal::Uuid>{json::value_t::string, ValidateAndStoreCid, CidToJson, "UUID string"},
+          [](auto& config) -> auto& { return config.settings.cid; },
+          [](const BrokerConfig& config) { return config.default_cid(); },
+          &Diff::cid,
+          "The broker's CID. Defaults to a CID generated from this machine's network hardware."),
+  Setting("/uid",
+          CustomRule<rdm::Uid>{json::value_t::object, ValidateAndStoreUid, UidToJson,
+                               "object with \"type\", \"manufacturer_id\" and \"device_id\""},
+          [](auto& config) -> auto& { return config.settings.uid; },
+          [](const BrokerConfig&) { return rdm::Uid::DynamicUidRequest(0x6574); },  // ETC's manufacturer ID
+          &Diff::uid,
+          "The broker's UID, static or dynamic. Defaults to a dynamic UID with ETC's manufacturer ID."),
+  Setting("/dns_sd/service_instance_name",
+          StringRule{E133_SERVICE_NAME_STRING_PADDED_LENGTH - 1, true},
+          [](auto& config) -> auto& { return config.settings.dns.service_instance_name; },
+          // Add our CID to the service instance name, to help disambiguate. The CID is above this
+          // setting, so it has already been loaded.
+          [](const BrokerConfig& config) { return "ETC RDMnet Broker " + config.settings.cid.ToString(); },
+          &Diff::dns_sd,
+          "The DNS-SD service instance name. Defaults to \"ETC RDMnet Broker \" followed by the CID."),
+  Setting("/dns_sd/manufacturer",
+          StringRule{E133_MANUFACTURER_STRING_PADDED_LENGTH - 1, true},
+          [](auto& config) -> auto& { return config.settings.dns.manufacturer; },
+          "ETC",
+          &Diff::dns_sd,
+          "The manufacturer advertised over DNS-SD."),
+  Setting("/dns_sd/model",
+          StringRule{E133_MODEL_STRING_PADDED_LENGTH - 1, true},
+          [](auto& config) -> auto& { return config.settings.dns.model; },
+          "RDMnet Broker Service",
+          &Diff::dns_sd,
+          "The model advertised over DNS-SD."),
+  Setting("/scope",
+          StringRule{E133_SCOPE_STRING_PADDED_LENGTH - 1, false},
+          [](auto& config) -> auto& { return config.settings.scope; },
+          E133_DEFAULT_SCOPE,
+          &Diff::scope,
+          "The RDMnet scope the broker serves."),
+  Setting("/listen_port",
+          IntRule<uint16_t>{1024, 65535},
+          [](auto& config) -> auto& { return config.settings.listen_port; },
+          uint16_t{0},
+          &Diff::listen_port,
+          "The TCP port to listen on. Defaults to an ephemeral port."),
+  Setting("/listen_interfaces",
+          CustomRule<std::vector<std::string>>{json::value_t::array, ValidateAndStoreInterfaceList,
+                                               InterfaceListToJson, "array of interface names"},
+          [](auto& config) -> auto& { return config.settings.listen_interfaces; },
+          [](const BrokerConfig&) { return std::vector<std::string>{}; },
+          &Diff::listen_interfaces,
+          "The network interfaces to listen on. Defaults to all interfaces."),
+  Setting("/log_level",
+          Enum<int>({
+            {"debug", ETCPAL_LOG_UPTO(ETCPAL_LOG_DEBUG)},
+            {"info", ETCPAL_LOG_UPTO(ETCPAL_LOG_INFO)},
+            {"notice", ETCPAL_LOG_UPTO(ETCPAL_LOG_NOTICE)},
+            {"warning", ETCPAL_LOG_UPTO(ETCPAL_LOG_WARNING)},
+            {"err", ETCPAL_LOG_UPTO(ETCPAL_LOG_ERR)},
+            {"crit", ETCPAL_LOG_UPTO(ETCPAL_LOG_CRIT)},
+            {"alert", ETCPAL_LOG_UPTO(ETCPAL_LOG_ALERT)},
+            {"emerg", ETCPAL_LOG_UPTO(ETCPAL_LOG_EMERG)},
+          }),
+          [](auto& config) -> auto& { return config.log_mask; },
+          ETCPAL_LOG_UPTO(ETCPAL_LOG_INFO),
+          &Diff::log_level,
+          "The lowest priority of message written to the log file."),
+  Setting("/log_flush_interval_ms",
+          IntRule<uint32_t>{0, 60000},
+          [](auto& config) -> auto& { return config.log_writer.flush_interval_ms; },
+          AsyncLogWriter::Settings{}.flush_interval_ms,
+          &Diff::log_output,
+          "The longest a log message may wait in memory before it is written; 0 writes immediately."),
+  Setting("/log_overflow_policy",
+          Enum<AsyncLogWriter::OverflowPolicy>({
+            {"drop", AsyncLogWriter::OverflowPolicy::kDrop},
+            {"block", AsyncLogWriter::OverflowPolicy::kBlock},
+          }),
+          [](auto& config) -> auto& { return config.log_writer.overflow_policy; },
+          AsyncLogWriter::Settings{}.overflow_policy,
+          &Diff::log_output,
+          "What happens to new log messages when the log buffer is full."),
+  Setting("/log_format",
+          Enum<AsyncLogWriter::Format>({
+            {"text", AsyncLogWriter::Format::kText},
+            {"binary", AsyncLogWriter::Format::kBinary},
+          }),
+          [](auto& config) -> auto& { return config.log_writer.format; },
+          AsyncLogWriter::Settings{}.format,
+          &Diff::log_output,
+          "The format of the log file."),
+  Setting("/log_max_size",
+          IntRule<uint32_t>{0, kUint32Max},
+          [](auto& config) -> auto& { return config.log_writer.max_file_size; },
+          AsyncLogWriter::Settings{}.max_file_size,
+          &Diff::log_output,
+          "The log file is rotated once it grows past this many bytes; 0 disables rotation."),
+  Setting("/log_max_files",
+          IntRule<unsigned int>{1, 100},
+          [](auto& config) -> auto& { return config.log_archive.max_files; },
+          LogArchiver::Settings{}.max_files,
+          &Diff::log_output,
+          "The number of rotated log files to keep."),
+  Setting("/log_max_total_size",
+          IntRule<uint32_t>{0, kUint32Max},
+          [](auto& config) -> auto& { return config.log_archive.max_total_size; },
+          LogArchiver::Settings{}.max_total_size,
+          &Diff::log_output,
+          "Rotated log files are deleted once they take up more than this many bytes; 0 is no limit."),
+  Setting("/log_compress",
+          BoolRule{},
+          [](auto& config) -> auto& { return config.log_archive.compress; },
+          LogArchiver::Settings{}.compress,
+          &Diff::log_output,
+          "Whether rotated log files are compressed."),
+  Setting("/flight_recorder_size",
+          IntRule<unsigned int>{0, 100000},
+          [](auto& config) -> auto& { return config.flight_recorder_size; },
+          1000u,
+          &Diff::flight_recorder,
+          "The number of recent log messages kept in memory; 0 disables the flight recorder."),
+  Setting("/enable_metrics",
+          BoolRule{},
+          [](auto& config) -> auto& { return config.metrics.enable; },
+          MetricsExporter::Settings{}.enable,
+          &Diff::metrics,
+          "Whether metrics are served in the Prometheus text format on the loopback interface."),
+  Setting("/metrics_port",
+          IntRule<uint16_t>{1024, 65535},
+          [](auto& config) -> auto& { return config.metrics.port; },
+          MetricsExporter::Settings{}.port,
+          &Diff::metrics,
+          "The TCP port metrics are served on, at /metrics."),
+  Setting("/stats_interval_s",
+          IntRule<unsigned int>{0, 86400},
+          [](auto& config) -> auto& { return config.stats_interval_s; },
+          300u,
+          &Diff::stats,
+          "How often, in seconds, statistics are written to the log; 0 disables them."),
+  Setting("/enable_admin_socket",
+          BoolRule{},
+          [](auto& config) -> auto& { return config.admin.enable; },
+          AdminServer::Settings{}.enable,
+          &Diff::admin,
+          "Whether admin commands are accepted on a local socket (a named pipe on Windows)."),
+  Setting("/enable_trace",
+          BoolRule{},
+          [](auto& config) -> auto& { return config.enable_trace; },
+          false,
+          &Diff::trace,
+          "Whether the durations of startup, shutdown and restarts are traced, for viewing in Perfetto."),
+  Setting("/max_connections",
+          IntRule<unsigned int>{0, kUnlimited},
+          [](auto& config) -> auto& { return config.settings.limits.connections; },
+          0u,
+          &Diff::limits,
+          "The maximum number of client connections; 0 is no limit."),
+  Setting("/max_controllers",
+          IntRule<unsigned int>{0, kUnlimited},
+          [](auto& config) -> auto& { return config.settings.limits.controllers; },
+          0u,
+          &Diff::limits,
+          "The maximum number of controllers; 0 is no limit."),
+  Setting("/max_controller_messages",
+          IntRule<unsigned int>{0, kUnlimited},
+          [](auto& config) -> auto& { return config.settings.limits.controller_messages; },
+          500u,
+          &Diff::limits,
+          "The maximum number of messages queued for each controller; 0 is no limit."),
+  Setting("/max_devices",
+          IntRule<unsigned int>{0, kUnlimited},
+          [](auto& config) -> auto& { return config.settings.limits.devices; },
+          0u,
+          &Diff::limits,
+          "The maximum number of devices; 0 is no limit."),
+  Setting("/max_device_messages",
+          IntRule<unsigned int>{0, kUnlimited},
+          [](auto& config) -> auto& { return config.settings.limits.device_messages; },
+          500u,
+          &Diff::limits,
+          "The maximum number of messages queued for each device; 0 is no limit."),
+  Setting("/max_reject_connections",
+          IntRule<unsigned int>{0, kUnlimited},
+          [](auto& config) -> auto& { return config.settings.limits.reject_connections; },
+          1000u,
+          &Diff::limits,
+          "The number of connections past max_connections that are accepted only to be rejected; 0 is no limit."),
+  Setting("/enable_broker",
+          BoolRule{},
+          [](auto& config) -> auto& { return config.enable_broker; },
+          true,
+          &Diff::enable_broker,
+          "Whether the service runs a broker."),
+  Setting("/restart_mode",
+          Enum<BrokerConfig::RestartMode>({
+            {"standard", BrokerConfig::RestartMode::kStandard},
+            {"overlapped", BrokerConfig::RestartMode::kOverlapped},
+          }),
+          [](auto& config) -> auto& { return config.restart_mode; },
+          BrokerConfig::RestartMode::kStandard,
+          &Diff::restart_mode,
+          "How the broker is restarted when a configuration change requires it."),
+  Setting("/restart_drain_ms",
+          IntRule<unsigned int>{0, kUnlimited},
+          [](auto& config) -> auto& { return config.restart_drain_ms; },
+          5000u,
+          &Diff::restart_mode,
+          "How long the old broker keeps running after an overlapped restart.")
+);
+// clang-format on
+
+static const config_schema::SchemaIndex kSchemaIndex(kSchema);
+
+struct BrokerConfig::FileCache
+{
+  // A file from the fragment directory. Its contents are parsed when it is merged.
+  struct Fragment
+  {
+    std::string   path;
+    FileSignature signature;
+    json          document;
+  };
+
+  std::string           path;
+  FileSignature         signature;
+  ParseResult           result{ParseResult::kOk};
+  BrokerConfig          config;
+  std::vector<Fragment> fragments;  // In the order they are merged
+  json                  document;   // The configuration file's contents, only kept if there are fragments
+
+  static std::vector<Fragment> FindFragments(const std::string& path);
+  static bool                  ParseDocument(const std::string& path, const std::string& contents, json& document,
+                                             etcpal::Logger* log);
+  static bool                  SameSizeAndTime(const FileSignature& a, const FileSignature& b);
+
+  bool            IsUnmodified(const std::string& path, const FileSignature& signature,
+                               const std::vector<Fragment>& fragments) const;
+  const Fragment* FindUnmodified(const Fragment& fragment) const;
+  ParseResult     Merge(BrokerConfig& read_config, const FileCache* previous, const std::string& contents,
+                        etcpal::Logger* log);
+};
+
+// A snapshot holds the settings that were read from a configuration file, in CBOR, after a header
+// that identifies the file's contents (all little-endian):
+//
+//   0-3   "RBCS"
+//   4     Format version (2)
+//   5     The ParseResult of reading the file
+//   6-7   Reserved
+//   8-15  Configuration file size
+//   16-23 Configuration file hash
+//   24-31 Schema hash; see SchemaHash()
+//
+// Settings that were invalid or missing in the file aren't in the snapshot, so they get their
+// defaults when it is read, just as when the file itself is read.
+static constexpr char    kSnapshotMagic[4] = {'R', 'B', 'C', 'S'};
+static constexpr uint8_t kSnapshotVersion = 2;
+static constexpr size_t  kSnapshotHeaderSize = 32;
+
+static void PackU64(char* buf, uint64_t val)
+{
+  for (size_t i = 0; i < 8; ++i)
+    buf[i] = static_cast<char>((val >> (8 * i)) & 0xffu);
+}
+
+static uint64_t UnpackU64(const char* buf)
+{
+  uint64_t val = 0;
+  for (size_t i = 0; i < 8; ++i)
+    val |= static_cast<uint64_t>(static_cast<uint8_t>(buf[i])) << (8 * i);
+  return val;
+}
+
+// 64-bit FNV-1a
+static uint64_t HashContents(const std::string& contents)
+{
+  uint64_t hash = 0xcbf29ce484222325u;
+  for (const char c : contents)
   {
-    "/log_level"_json_pointer,
-    json::value_t::string,
-    ValidateAndStoreLogLevel,
-    [](auto& config) { config.log_mask = ETCPAL_LOG_UPTO(ETCPAL_LOG_INFO); }
-  },
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 0x100000001b3u;
+  }
+  return hash;
+}
+
+// Files are saved by writing a temporary file and renaming it over the original, which would
+// otherwise replace the original's permissions (and owner) with the service's defaults. Copy them
+// from the file the temporary one is standing in for, if it exists.
+static void CopyFileAccess(const std::string& from_path, const std::string& to_path)
+{
+  namespace fs = std::filesystem;
+
+  std::error_code ec;
+  const auto      status = fs::status(from_path, ec);
+  if (ec || !fs::exists(status))
+    return;
+
+#ifndef _WIN32
+  // Done first, since changing the owner can clear permission bits. Only root can give a file
+  // away, so without it just the group is copied, and failing that the service's user and group
+  // stay the owners.
+  struct stat from_stat;
+  if (stat(from_path.c_str(), &from_stat) == 0)
+  {
+    const bool owner_copied = chown(to_path.c_str(), from_stat.st_uid, from_stat.st_gid) == 0 ||
+                              chown(to_path.c_str(), static_cast<uid_t>(-1), from_stat.st_gid) == 0;
+    static_cast<void>(owner_copied);
+  }
+#endif
+
+  fs::permissions(to_path, status.permissions(), fs::perm_options::replace, ec);
+}
+
+// A snapshot only holds the settings the binary that wrote it knew about, so one written before an
+// upgrade that added settings would hide them until the file next changed. The documentation names
+// every setting along with its type and default, so its hash changes whenever the schema does.
+static uint64_t SchemaHash()
+{
+  static const uint64_t hash = HashContents(BrokerConfig::Documentation());
+  return hash;
+}
+
+// Read the JSON configuration from an input stream. Each setting is validated and stored as it is
+// parsed. Extra keys present in the JSON which we don't recognize are considered valid. If the
+// stream can't be parsed, the configuration is left unchanged.
+BrokerConfig::ParseResult BrokerConfig::Read(std::istream& stream, etcpal::Logger* log)
+{
+  return ParseSettings(stream, json::input_format_t::json, log);
+}
+
+BrokerConfig::ParseResult BrokerConfig::ReadFile(const std::string& path, std::istream& stream, etcpal::Logger* log)
+{
+  namespace fs = std::filesystem;
+
+  std::error_code ec;
+  FileSignature   signature;
+  signature.size = fs::file_size(path, ec);
+  if (!ec)
+    signature.modified_time = static_cast<int64_t>(fs::last_write_time(path, ec).time_since_epoch().count());
+  if (ec)
+    return Read(stream, log);  // Without a way to tell whether the file changed, just read it.
+
+  std::vector<FileCache::Fragment> fragments = FileCache::FindFragments(path);
+  if (file_cache_ && file_cache_->IsUnmodified(path, signature, fragments))
   {
-    "/max_connections"_json_pointer,
-    json::value_t::number_unsigned,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreInt<unsigned int>("/max_connections", val, config.settings.limits.connections, log);
-    },
-    [](auto& config) { config.settings.limits.connections = 0; }
-  },
+    if (log)
+      log->Debug("Configuration files have not been modified; using the settings read from them before.");
+    UseFileCache(file_cache_);
+    return file_cache_->result;
+  }
+
+  const std::string contents{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+  signature.hash = HashContents(contents);
+  if (file_cache_ && file_cache_->path == path && file_cache_->signature.size == signature.size &&
+      file_cache_->signature.hash == signature.hash && file_cache_->fragments.empty() && fragments.empty())
   {
-    "/max_controllers"_json_pointer,
-    json::value_t::number_unsigned,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreInt<unsigned int>("/max_controllers", val, config.settings.limits.controllers, log);
-    },
-    [](auto& config) { config.settings.limits.controllers = 0; }
-  },
+    if (log)
+      log->Debug("Configuration file contents have not changed; using the settings read from it before.");
+    UseFileCache(file_cache_);
+    return file_cache_->result;
+  }
+
+  auto cache = std::make_shared<FileCache>();
+  cache->path = path;
+  cache->signature = signature;
+  cache->config = *this;
+  cache->config.file_cache_.reset();
+  cache->fragments = std::move(fragments);
+
+  // Fragments change the settings the file would give on its own, so the snapshot isn't used.
+  if (!cache->fragments.empty())
   {
-    "/max_controller_messages"_json_pointer,
-    json::value_t::number_unsigned,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreInt<unsigned int>("/max_controller_messages", val, config.settings.limits.controller_messages, log);
-    },
-    [](auto& config) { config.settings.limits.controller_messages = 500; }
-  },
+    const ParseResult result = cache->Merge(*this, file_cache_.get(), contents, log);
+    if (result == ParseResult::kOk || result == ParseResult::kInvalidSetting)
+      file_cache_ = std::move(cache);
+    return result;
+  }
+
+  // Try the snapshot, and fall back to parsing the file if it doesn't match or can't be read.
+  const std::string snapshot_path = path + kSnapshotExtension;
+  std::ifstream     snapshot(snapshot_path, std::ios::binary);
+  char              header[kSnapshotHeaderSize];
+  if (snapshot.read(header, kSnapshotHeaderSize) && std::equal(header, header + 4, kSnapshotMagic) &&
+      static_cast<uint8_t>(header[4]) == kSnapshotVersion && UnpackU64(&header[8]) == signature.size &&
+      UnpackU64(&header[16]) == signature.hash && UnpackU64(&header[24]) == SchemaHash())
+  {
+    const auto result = static_cast<ParseResult>(header[5]);
+    if ((result == ParseResult::kOk || result == ParseResult::kInvalidSetting) &&
+        cache->config.ParseSettings(snapshot, json::input_format_t::cbor, log) == ParseResult::kOk)
+    {
+      if (log)
+        log->Debug("Read the configuration from its snapshot at %s.", snapshot_path.c_str());
+      cache->result = result;
+      UseFileCache(std::move(cache));
+      return result;
+    }
+  }
+  snapshot.close();
+
+  json               stored_settings;
+  std::istringstream contents_stream(contents);
+  cache->result = ParseSettings(contents_stream, json::input_format_t::json, log, &stored_settings);
+  if (cache->result != ParseResult::kOk && cache->result != ParseResult::kInvalidSetting)
+    return cache->result;
+
+  cache->config = *this;
+  cache->config.file_cache_.reset();
+  file_cache_ = cache;
+
+  // Save the snapshot for the next time the service starts, replacing the old one in one step.
+  PackU64(&header[0], 0);
+  std::copy(kSnapshotMagic, kSnapshotMagic + 4, header);
+  header[4] = static_cast<char>(kSnapshotVersion);
+  header[5] = static_cast<char>(cache->result);
+  PackU64(&header[8], signature.size);
+  PackU64(&header[16], signature.hash);
+  PackU64(&header[24], SchemaHash());
+  const std::vector<uint8_t> payload = json::to_cbor(stored_settings);
+
+  const std::string temp_path = snapshot_path + ".tmp";
+  std::ofstream     temp_file(temp_path, std::ios::binary | std::ios::trunc);
+  temp_file.write(header, kSnapshotHeaderSize);
+  temp_file.write(reinterpret_cast<const char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+  temp_file.close();
+  CopyFileAccess(path, temp_path);  // The snapshot is as readable as the file it was read from
+  if (temp_file)
+    fs::rename(temp_path, snapshot_path, ec);
+  if (!temp_file || ec)
   {
-    "/max_devices"_json_pointer,
-    json::value_t::number_unsigned,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreInt<unsigned int>("/max_devices", val, config.settings.limits.devices, log);
-    },
-    [](auto& config) { config.settings.limits.devices = 0; }
-  },
+    if (log)
+      log->Debug("Could not save a snapshot of the configuration at %s.", snapshot_path.c_str());
+    fs::remove(temp_path, ec);
+  }
+
+  return cache->result;
+}
+
+// The fragments' paths are hashed too, so that renaming one (which changes the order they are merged
+// in) changes the hash. A file that can't be read hashes the same as an empty one.
+uint64_t BrokerConfig::HashFiles(const std::string& path)
+{
+  std::string contents;
+  const auto  append_file = [&contents](const std::string& file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    contents.append(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    contents.push_back('\0');
+  };
+
+  append_file(path);
+  for (const auto& fragment : FileCache::FindFragments(path))
+  {
+    contents.append(fragment.path);
+    contents.push_back('\0');
+    append_file(fragment.path);
+  }
+  return HashContents(contents);
+}
+
+// Setting values are only ever written where the user would look for them: in the configuration
+// file, or in the last fragment that sets the value, since that is the one that takes effect. The
+// file is rewritten with its keys in their original order and replaced in one step, so a reader
+// never sees it half-written.
+bool BrokerConfig::SaveSetting(const std::string& path,
+                               const std::string& pointer,
+                               const json&        value,
+                               etcpal::Logger*    log)
+{
+  namespace fs = std::filesystem;
+  using ordered_json = nlohmann::ordered_json;
+
+  const auto read_document = [](const std::string& file_path, ordered_json& document) {
+    std::ifstream file(file_path, std::ios::binary);
+    if (!file.is_open())
+      return false;
+    document = ordered_json::parse(file, nullptr, false);
+    return !document.is_discarded() && document.is_object();
+  };
+
+  const ordered_json::json_pointer setting(pointer);
+
+  std::string  target_path = path;
+  ordered_json document;
+  for (const auto& fragment : FileCache::FindFragments(path))
   {
-    "/max_device_messages"_json_pointer,
-    json::value_t::number_unsigned,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreInt<unsigned int>("/max_device_messages", val, config.settings.limits.device_messages, log);
-    },
-    [](auto& config) { config.settings.limits.device_messages = 500; }
-  },
+    ordered_json fragment_document;
+    if (read_document(fragment.path, fragment_document) && fragment_document.contains(setting))
+    {
+      target_path = fragment.path;
+      document = std::move(fragment_document);
+    }
+  }
+
+  std::error_code ec;
+  if (target_path == path && !read_document(path, document))
   {
-    "/max_reject_connections"_json_pointer,
-    json::value_t::number_unsigned,
-    [](const json& val, auto& config, auto log) {
-      return ValidateAndStoreInt<unsigned int>("/max_reject_connections", val, config.settings.limits.reject_connections, log);
-    },
-    [](auto& config) { config.settings.limits.reject_connections = 1000; }
-  },
+    // A missing file is created, but one that can't be parsed is left for the user to fix.
+    if (fs::exists(path, ec))
+    {
+      if (log)
+        log->Notice("Could not save a setting to %s: the contents must be a JSON object.", path.c_str());
+      return false;
+    }
+    document = ordered_json::object();
+  }
+
+  document[setting] = ordered_json::parse(value.dump());
+
+  const std::string temp_path = target_path + ".tmp";
+  std::ofstream     temp_file(temp_path, std::ios::binary | std::ios::trunc);
+  temp_file << document.dump(2) << '\n';
+  temp_file.close();
+  CopyFileAccess(target_path, temp_path);
+  if (temp_file)
+    fs::rename(temp_path, target_path, ec);
+  if (!temp_file || ec)
   {
-    "/enable_broker"_json_pointer,
-    json::value_t::boolean,
-    [](const json& val, auto& config, auto log) {
-      config.enable_broker = val;
-      return true;
-    },
-    [](auto& config) { config.enable_broker = true; }
+    if (log)
+      log->Notice("Could not save a setting to %s.", target_path.c_str());
+    fs::remove(temp_path, ec);
+    return false;
   }
-};
-// clang-format on
+  return true;
+}
 
-// Read the JSON configuration from an input stream.
-BrokerConfig::ParseResult BrokerConfig::Read(std::istream& stream, etcpal::Logger* log)
+// Fragments are the files in the fragment directory next to the configuration file with the same
+// extension, merged in lexical order of their names.
+std::vector<BrokerConfig::FileCache::Fragment> BrokerConfig::FileCache::FindFragments(const std::string& path)
 {
-  try
-  {
-    stream >> current_;
-    return ValidateCurrent(log);
+  namespace fs = std::filesystem;
+
+  const fs::path        base_path(path);
+  std::vector<Fragment> fragments;
+  std::error_code       ec;
+  for (fs::directory_iterator entry(base_path.parent_path() / kFragmentDirectory, ec), end; !ec && entry != end;
+       entry.increment(ec))
+  {
+    if (entry->path().extension() != base_path.extension() || !entry->is_regular_file(ec))
+      continue;
+
+    Fragment fragment;
+    fragment.path = entry->path().string();
+    fragment.signature.size = entry->file_size(ec);
+    if (!ec)
+      fragment.signature.modified_time = static_cast<int64_t>(entry->last_write_time(ec).time_since_epoch().count());
+    if (!ec)
+      fragments.push_back(std::move(fragment));
   }
-  catch (json::parse_error& e)
+
+  std::sort(fragments.begin(), fragments.end(),
+            [](const Fragment& a, const Fragment& b) { return a.path < b.path; });
+  return fragments;
+}
+
+bool BrokerConfig::FileCache::ParseDocument(const std::string& path,
+                                            const std::string& contents,
+                                            json&              document,
+                                            etcpal::Logger*    log)
+{
+  document = json::parse(contents, nullptr, false);
+  if (document.is_discarded() || !document.is_object())
   {
     if (log)
-      log->Notice("Could not parse configuration file: %s", e.what());
-    return ParseResult::kJsonParseErr;
+      log->Notice("Could not parse configuration file %s: the contents must be a JSON object.", path.c_str());
+    return false;
   }
+  return true;
 }
 
-void BrokerConfig::SetDefaults()
+// Files are compared by size and modification time only, so that nothing needs to be read.
+bool BrokerConfig::FileCache::SameSizeAndTime(const FileSignature& a, const FileSignature& b)
+{
+  return a.size == b.size && a.modified_time == b.modified_time;
+}
+
+bool BrokerConfig::FileCache::IsUnmodified(const std::string&           other_path,
+                                           const FileSignature&         other_signature,
+                                           const std::vector<Fragment>& other_fragments) const
+{
+  return path == other_path && SameSizeAndTime(signature, other_signature) &&
+         std::equal(fragments.begin(), fragments.end(), other_fragments.begin(), other_fragments.end(),
+                    [](const Fragment& a, const Fragment& b) {
+                      return a.path == b.path && SameSizeAndTime(a.signature, b.signature);
+                    });
+}
+
+const BrokerConfig::FileCache::Fragment* BrokerConfig::FileCache::FindUnmodified(const Fragment& fragment) const
 {
-  for (const auto& setting : kSettingsValidatorArray)  // kSettingsValidatorArray must be iterated first to last
+  for (const auto& old_fragment : fragments)
   {
-    if (setting.store_default)
-      setting.store_default(*this);
+    if (old_fragment.path == fragment.path && SameSizeAndTime(old_fragment.signature, fragment.signature))
+      return &old_fragment;
   }
+  return nullptr;
 }
 
-// Validate the JSON object contained in the "current_" member, which presumably has just been
-// deserialized. Currently, extra keys present in the JSON which we don't recognize are considered
-// valid.
-BrokerConfig::ParseResult BrokerConfig::ValidateCurrent(etcpal::Logger* log)
+// Each fragment is merged over the configuration file and the fragments before it as a JSON merge
+// patch (RFC 7386): objects are merged key by key, other values replace what was there, and null
+// removes a setting so that it gets its default. Files that haven't changed since the previous
+// read are not parsed again. The merged document is then validated like a single file.
+BrokerConfig::ParseResult BrokerConfig::FileCache::Merge(BrokerConfig&      read_config,
+                                                         const FileCache*   previous,
+                                                         const std::string& contents,
+                                                         etcpal::Logger*    log)
 {
-  if (!current_.is_object())
+  if (previous && previous->path == path && !previous->fragments.empty() &&
+      previous->signature.size == signature.size && previous->signature.hash == signature.hash)
+  {
+    document = previous->document;
+  }
+  else if (!ParseDocument(path, contents, document, log))
   {
-    // Root type must be an object
     return ParseResult::kJsonParseErr;
   }
 
-  ParseResult res = ParseResult::kOk;
-
-  for (const auto& setting : kSettingsValidatorArray)  // kSettingsValidatorArray must be iterated first to last
+  json merged = document;
+  for (auto& fragment : fragments)
   {
-    assert(setting.store_default);
-    assert(setting.validate_and_store);
-
-    // Check each key that matches an item in our settings array.
-    if (current_.contains(setting.pointer))
+    const Fragment* unchanged = previous ? previous->FindUnmodified(fragment) : nullptr;
+    if (unchanged)
     {
-      const json val = current_[setting.pointer];
-
-      // If a setting is set to "null" in the JSON, store the default value.
-      if (val.is_null())
-      {
-        setting.store_default(*this);
-      }
-      else
-      {
-        if (val.type() != setting.type)
-        {
-          // The value type of this item does not match the type of the corresponding default setting.
-          LogParseError(log, "The value for setting \"%s\" was of invalid type \"%s\"",
-                        setting.pointer.to_string().c_str(), val.type_name());
-          setting.store_default(*this);
-          res = ParseResult::kInvalidSetting;
-        }
-        else if (!setting.validate_and_store(val, *this, log))  // Try to validate the setting's value.
-        {
-          setting.store_default(*this);
-          res = ParseResult::kInvalidSetting;
-        }
-      }
+      fragment.document = unchanged->document;
     }
     else
     {
-      // The "store_default" function may not be present, in which case the default-constructed
-      // value in the output settings is left as-is.
-      setting.store_default(*this);
-
+      std::ifstream     file(fragment.path, std::ios::binary);
+      const std::string fragment_contents{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+      if (!file.is_open() || !ParseDocument(fragment.path, fragment_contents, fragment.document, log))
+        return ParseResult::kJsonParseErr;
       if (log)
-      {
-        log->Debug("Configuration file: No value present for \"%s\", using default.",
-                   setting.pointer.to_string().c_str());
-      }
+        log->Debug("Read configuration fragment %s.", fragment.path.c_str());
     }
+    merged.merge_patch(fragment.document);
   }
 
-  return res;
+  const std::vector<uint8_t> merged_cbor = json::to_cbor(merged);
+  std::istringstream         merged_stream(std::string(merged_cbor.begin(), merged_cbor.end()));
+  result = read_config.ParseSettings(merged_stream, json::input_format_t::cbor, log);
+  config = read_config;
+  config.file_cache_.reset();
+  return result;
+}
+
+// Settings are read into a copy, which replaces this configuration only if the stream could be
+// parsed. If stored_settings is given, it receives the settings that were read successfully.
+BrokerConfig::ParseResult BrokerConfig::ParseSettings(std::istream&       stream,
+                                                      json::input_format_t format,
+                                                      etcpal::Logger*      log,
+                                                      json*                stored_settings)
+{
+  BrokerConfig                                          read_config(*this);
+  config_schema::Reader<BrokerConfig, decltype(kSchema)> reader(kSchema, kSchemaIndex, read_config, log);
+  if (!reader.Parse(stream, format))
+    return ParseResult::kJsonParseErr;
+
+  const bool all_valid = reader.Finish();
+  if (stored_settings)
+    *stored_settings = reader.StoredSettings();
+
+  *this = std::move(read_config);
+  return all_valid ? ParseResult::kOk : ParseResult::kInvalidSetting;
+}
+
+void BrokerConfig::UseFileCache(std::shared_ptr<const FileCache> file_cache)
+{
+  *this = file_cache->config;
+  file_cache_ = std::move(file_cache);
+}
+
+void BrokerConfig::SetDefaults()
+{
+  config_schema::SetDefaults(kSchema, *this);
+}
+
+// A line for each setting in the configuration file, with its allowed values, default and purpose.
+std::string BrokerConfig::Documentation()
+{
+  return config_schema::Document(kSchema);
+}
+
+bool BrokerConfig::Diff::Empty() const
+{
+  return !(cid || uid || dns_sd || scope || listen_port || listen_interfaces || limits || log_level || enable_broker ||
+           restart_mode || log_output || flight_recorder || metrics || stats || admin || trace);
+}
+
+// Whether the running broker must be torn down and started again to apply these changes. The log,
+// metrics, statistics, admin, trace and restart settings are owned by the shell and can always be
+// changed in place (the flight recorder size is only read when the service starts, so restarting
+// the broker wouldn't apply it either), and the RDMnet broker can move to a new scope while it
+// runs. Everything else is copied into the RDMnet broker at startup and the library has no way to
+// change it on a running instance.
+bool BrokerConfig::Diff::RequiresRestart() const
+{
+  return cid || uid || dns_sd || listen_port || listen_interfaces || limits || enable_broker;
+}
+
+// The names of the changed settings, for logging, e.g. "scope, log_level".
+std::string BrokerConfig::Diff::ToString() const
+{
+  static const std::pair<bool Diff::*, const char*> kNames[] = {
+      {&Diff::cid, "cid"},
+      {&Diff::uid, "uid"},
+      {&Diff::dns_sd, "dns_sd"},
+      {&Diff::scope, "scope"},
+      {&Diff::listen_port, "listen_port"},
+      {&Diff::listen_interfaces, "listen_interfaces"},
+      {&Diff::limits, "limits"},
+      {&Diff::log_level, "log_level"},
+      {&Diff::enable_broker, "enable_broker"},
+      {&Diff::restart_mode, "restart_mode"},
+      {&Diff::log_output, "log_output"},
+      {&Diff::flight_recorder, "flight_recorder"},
+      {&Diff::metrics, "metrics"},
+      {&Diff::stats, "stats"},
+      {&Diff::admin, "admin"},
+      {&Diff::trace, "trace"},
+  };
+
+  std::string names;
+  for (const auto& name : kNames)
+  {
+    if (!(this->*name.first))
+      continue;
+    if (!names.empty())
+      names += ", ";
+    names += name.second;
+  }
+  return names;
+}
+
+BrokerConfig::Diff BrokerConfig::Compare(const BrokerConfig& old_config, const BrokerConfig& new_config)
+{
+  return config_schema::Compare(kSchema, old_config, new_config);
 }
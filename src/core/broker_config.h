@@ -20,7 +20,9 @@
 #ifndef BROKER_CONFIG_H_
 #define BROKER_CONFIG_H_
 
+#include <cstdint>
 #include <istream>
+#include <memory>
 #include <string>
 #include "etcpal/cpp/uuid.h"
 #include "etcpal/inet.h"
@@ -28,6 +30,10 @@
 #include "etcpal/netint.h"
 #include "rdmnet/cpp/broker.h"
 #include "nlohmann/json.hpp"
+#include "admin_server.h"
+#include "async_log_writer.h"
+#include "log_archiver.h"
+#include "metrics_exporter.h"
 
 using json = nlohmann::json;
 
@@ -44,20 +50,97 @@ public:
     kOk
   };
 
-  rdmnet::Broker::Settings settings;
-  int                      log_mask;
-  bool                     enable_broker;
+  // How the shell restarts the broker when a change requires it.
+  enum class RestartMode
+  {
+    kStandard,   // Shut down the running broker, then start the new one.
+    kOverlapped  // Start the new broker first, then shut down the old one after a drain period.
+  };
+
+  // The set of settings that differ between two configurations.
+  struct Diff
+  {
+    bool cid{false};
+    bool uid{false};
+    bool dns_sd{false};
+    bool scope{false};
+    bool listen_port{false};
+    bool listen_interfaces{false};
+    bool limits{false};
+    bool log_level{false};
+    bool enable_broker{false};
+    bool restart_mode{false};
+    bool log_output{false};
+    bool flight_recorder{false};
+    bool metrics{false};
+    bool stats{false};
+    bool admin{false};
+    bool trace{false};
+
+    [[nodiscard]] bool        Empty() const;
+    [[nodiscard]] bool        RequiresRestart() const;
+    [[nodiscard]] std::string ToString() const;
+  };
+
+  rdmnet::Broker::Settings  settings;
+  int                       log_mask{0};
+  bool                      enable_broker{false};
+  RestartMode               restart_mode{RestartMode::kStandard};
+  unsigned int              restart_drain_ms{0};
+  AsyncLogWriter::Settings  log_writer;
+  LogArchiver::Settings     log_archive;
+  unsigned int              flight_recorder_size{0};  // Messages kept in memory; 0 disables the flight recorder
+  MetricsExporter::Settings metrics;
+  unsigned int              stats_interval_s{0};  // How often statistics are written to the log; 0 disables them
+  AdminServer::Settings     admin;
+  bool                      enable_trace{false};  // Record lifecycle spans for a Chrome trace; see TraceRecorder
 
   [[nodiscard]] ParseResult Read(std::istream& stream, etcpal::Logger* log = nullptr);
+  // Read a configuration file that was opened from path, along with any fragments in the fragment
+  // directory next to it. If the files haven't changed since this configuration (or the one it was
+  // copied from) last read them, the settings read then are used again, and only the files that
+  // changed are parsed again otherwise. Without fragments, the snapshot saved next to the file when
+  // it was last parsed is used if it matches the file's contents.
+  [[nodiscard]] ParseResult ReadFile(const std::string& path, std::istream& stream, etcpal::Logger* log = nullptr);
   void                      SetDefaults();
 
+  [[nodiscard]] static Diff        Compare(const BrokerConfig& old_config, const BrokerConfig& new_config);
+  [[nodiscard]] static std::string Documentation();
+  // Hash the contents of a configuration file and of the fragments merged over it.
+  [[nodiscard]] static uint64_t HashFiles(const std::string& path);
+  // Change a setting, given as a JSON pointer (e.g. "/scope"), in a configuration file.
+  [[nodiscard]] static bool SaveSetting(const std::string& path,
+                                        const std::string& pointer,
+                                        const json&        value,
+                                        etcpal::Logger*    log = nullptr);
+
   [[nodiscard]] const etcpal::Uuid& default_cid() const { return default_cid_; }
 
+  // Appended to the configuration file's path to name its snapshot.
+  static constexpr char kSnapshotExtension[] = ".snapshot";
+  // Next to the configuration file, holds fragments that are merged over it.
+  static constexpr char kFragmentDirectory[] = "conf.d";
+
 private:
-  json         current_;
-  etcpal::Uuid default_cid_{etcpal::Uuid::OsPreferred()};
+  // Identifies the contents of a configuration file.
+  struct FileSignature
+  {
+    uintmax_t size{0};
+    int64_t   modified_time{0};
+    uint64_t  hash{0};
+  };
+
+  // The result of the last configuration file read, shared between copies of the configuration.
+  struct FileCache;
+
+  etcpal::Uuid                     default_cid_{etcpal::Uuid::OsPreferred()};
+  std::shared_ptr<const FileCache> file_cache_;
 
-  [[nodiscard]] ParseResult ValidateCurrent(etcpal::Logger* log);
+  [[nodiscard]] ParseResult ParseSettings(std::istream&       stream,
+                                          json::input_format_t format,
+                                          etcpal::Logger*      log,
+                                          json*                stored_settings = nullptr);
+  void                      UseFileCache(std::shared_ptr<const FileCache> file_cache);
 };
 
 #endif  // BROKER_CONFIG_H_
@@ -20,20 +20,38 @@
 #ifndef BROKER_OS_INTERFACE_H_
 #define BROKER_OS_INTERFACE_H_
 
+#include <cstdint>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <utility>
 #include "etcpal/cpp/log.h"
+#include "admin_server.h"
+#include "async_log_writer.h"
 #include "broker_config.h"
+#include "log_archiver.h"
 
 class BrokerOsInterface : public etcpal::LogMessageHandler
 {
 public:
+  // The service's use of the machine, for statistics. Values the platform can't provide are 0.
+  struct ResourceUsage
+  {
+    uint64_t resident_bytes{0};
+    uint64_t cpu_time_us{0};  // User and system time, since the process started
+    uint64_t dropped_log_messages{0};
+  };
+
   virtual ~BrokerOsInterface() = default;
 
   virtual std::string                           GetLogFilePath() const = 0;
   virtual bool                                  OpenLogFile() = 0;
   virtual std::pair<std::string, std::ifstream> GetConfFile(etcpal::Logger& log) = 0;
+  virtual void                                  SetLogWriterSettings(const AsyncLogWriter::Settings& settings) = 0;
+  virtual void                                  SetLogArchiveSettings(const LogArchiver::Settings& settings) = 0;
+  virtual ResourceUsage                         GetResourceUsage() const = 0;
+  // The platform's admin transport, at the platform's path for it.
+  virtual std::unique_ptr<AdminServer>          CreateAdminServer(AdminServer::Handler& handler) = 0;
 };
 
 #endif  // BROKER_OS_INTERFACE_H_
@@ -19,104 +19,403 @@
 
 #include "broker_shell.h"
 
+#include <chrono>
 #include <iostream>
 #include <cstring>
+#include <filesystem>
+#include <optional>
 #include "etcpal/netint.h"
-#include "etcpal/thread.h"
 #include "rdmnet/cpp/common.h"
+#include "binary_log_record.h"
 #include "broker_version.h"
+#include "trace_recorder.h"
 
+static constexpr char kFlightRecorderFileName[] = "broker_flight_recorder.log";
+static constexpr char kTraceFileName[] = "broker_trace.json";
+
+// The metrics the shell keeps. The RDMnet library doesn't report its clients or message traffic,
+// so those are limited to what the shell itself sees: the broker's state, its configured limits,
+// restarts, the log messages it produces (which include every rejected connection and queue
+// overflow it reports), and how long the shell's calls into it take.
+struct BrokerShell::Metrics
+{
+  // The operations whose durations are recorded. kLogDispatch is the time the shell adds to every
+  // log message on the thread that logged it, which is often one of the broker's.
+  enum Operation
+  {
+    kStartup,
+    kShutdown,
+    kScopeChange,
+    kConfigLoad,
+    kLogDispatch,
+    kNumOperations
+  };
+
+  static constexpr const char* kOperationNames[kNumOperations] = {"startup", "shutdown", "scope_change",
+                                                                  "config_load", "log_dispatch"};
+
+  // The running totals behind the statistics line; each line reports the change since the last.
+  struct Totals
+  {
+    std::chrono::steady_clock::time_point time;
+    uint64_t                              restarts{0};
+    uint64_t                              startup_failures{0};
+    uint64_t                              log_messages{0};
+    uint64_t                              warnings{0};  // Warning priority or worse
+    uint64_t                              cpu_time_us{0};
+    uint64_t                              dropped_log_messages{0};
+  };
+
+  explicit Metrics(MetricsRegistry& registry);
+
+  Totals ReadTotals(const BrokerOsInterface::ResourceUsage& usage) const;
+
+  MetricsRegistry::Gauge&                                                broker_up;
+  std::array<MetricsRegistry::Gauge*, 6>                                 limits;  // See UpdateLimitMetrics()
+  std::array<MetricsRegistry::Counter*, RestartScheduler::kNumTriggers> restarts_requested;
+  MetricsRegistry::Counter&                                              restarts_coalesced;
+  MetricsRegistry::Counter&                                              standard_restarts;
+  MetricsRegistry::Counter&                                              overlapped_restarts;
+  MetricsRegistry::Counter&                                              startup_failures;
+  MetricsRegistry::Histogram&                                            restart_downtime;
+  MetricsRegistry::Counter&                                              network_changes;
+  std::array<MetricsRegistry::Counter*, ETCPAL_LOG_DEBUG + 1>            log_messages;  // By priority
+  std::array<LatencyHistogram*, kNumOperations>                          durations;
+  std::array<LatencyHistogram::Snapshot, kNumOperations>                 logged_durations;  // See LogStats()
+  Totals                                                                 logged_totals;     // See LogStats()
+  std::chrono::steady_clock::time_point                                  broker_started;
+};
+
+BrokerShell::Metrics::Metrics(MetricsRegistry& registry)
+    : broker_up(registry.AddGauge("rdmnet_broker_up", "Whether the broker is running.")),
+      restarts_coalesced(registry.AddCounter("rdmnet_broker_restart_requests_coalesced_total",
+                                             "Restart requests folded into a restart that was already pending.")),
+      standard_restarts(registry.AddCounter("rdmnet_broker_restarts_total", "Broker restarts, by restart mode.",
+                                            {{"mode", "standard"}})),
+      overlapped_restarts(registry.AddCounter("rdmnet_broker_restarts_total", "Broker restarts, by restart mode.",
+                                              {{"mode", "overlapped"}})),
+      startup_failures(registry.AddCounter("rdmnet_broker_startup_failures_total", "Failed broker startups.")),
+      restart_downtime(registry.AddHistogram("rdmnet_broker_restart_downtime_seconds",
+                                             "Time without a listening broker during standard restarts.",
+                                             {0.01, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0, 30.0})),
+      network_changes(registry.AddCounter("rdmnet_broker_network_changes_total",
+                                          "Address and interface changes reported by the operating system."))
+{
+  static const char* const kLimitNames[] = {"connections", "controllers",     "controller_messages",
+                                            "devices",     "device_messages", "reject_connections"};
+  for (size_t i = 0; i < limits.size(); ++i)
+  {
+    limits[i] = &registry.AddGauge("rdmnet_broker_limit", "The broker's configured limits; 0 is no limit.",
+                                   {{"limit", kLimitNames[i]}});
+  }
+
+  for (size_t i = 0; i < restarts_requested.size(); ++i)
+  {
+    const auto trigger = static_cast<RestartScheduler::Trigger>(i);
+    restarts_requested[i] = &registry.AddCounter("rdmnet_broker_restart_requests_total",
+                                                 "Restart and configuration reload requests, by what made them.",
+                                                 {{"trigger", RestartScheduler::TriggerName(trigger)}});
+  }
+
+  static const char* const kPriorityNames[] = {"emerg",   "alert",  "crit", "err",
+                                               "warning", "notice", "info", "debug"};
+  for (size_t i = 0; i < log_messages.size(); ++i)
+  {
+    log_messages[i] = &registry.AddCounter("rdmnet_broker_log_messages_total",
+                                           "Messages passed to the log, by priority.",
+                                           {{"priority", kPriorityNames[i]}});
+  }
+
+  for (size_t i = 0; i < durations.size(); ++i)
+  {
+    durations[i] = &registry.AddLatencyHistogram("rdmnet_broker_operation_duration_seconds",
+                                                 "How long broker operations take, by operation.",
+                                                 {{"operation", kOperationNames[i]}});
+  }
+}
+
+// Only reads counters, so it's cheap enough to call whenever a statistics line is due.
+BrokerShell::Metrics::Totals BrokerShell::Metrics::ReadTotals(const BrokerOsInterface::ResourceUsage& usage) const
+{
+  Totals totals;
+  totals.time = std::chrono::steady_clock::now();
+  totals.restarts = standard_restarts.value() + overlapped_restarts.value();
+  totals.startup_failures = startup_failures.value();
+  for (size_t i = 0; i < log_messages.size(); ++i)
+  {
+    totals.log_messages += log_messages[i]->value();
+    if (i <= ETCPAL_LOG_WARNING)
+      totals.warnings += log_messages[i]->value();
+  }
+  totals.cpu_time_us = usage.cpu_time_us;
+  totals.dropped_log_messages = usage.dropped_log_messages;
+  return totals;
+}
+
+BrokerShell::BrokerShell(BrokerOsInterface& os_interface)
+    : os_interface_(os_interface), shell_metrics_(std::make_unique<Metrics>(metrics_))
+{
+}
+
+BrokerShell::~BrokerShell() = default;
+
+// Whether tracing is enabled isn't known until the configuration has been read, so Init() is always
+// traced and the spans are discarded if it turns out not to be.
 bool BrokerShell::Init()
 {
+  TraceRecorder::Start();
+  TraceRecorder::Span span("BrokerShell::Init");
+
   if (OpenLogFile())
   {
-    if (log_.Startup(os_interface_))
+    if (log_.Startup(*this))
     {
-      LoadBrokerConfig();
-      log_.SetLogMask(broker_config_.log_mask);
+      LoadBrokerConfig(broker_config_);
+      trace_path_ = std::filesystem::path(os_interface_.GetLogFilePath()).replace_filename(kTraceFileName).string();
+      if (!broker_config_.enable_trace)
+        TraceRecorder::Cancel();
+      StartFlightRecorder(broker_config_.flight_recorder_size);
+      ApplyLogMask(broker_config_.log_mask);
+      ApplyLogOutputSettings(broker_config_);
+      ApplyMetricsSettings(broker_config_.metrics);
+      admin_server_ = os_interface_.CreateAdminServer(*this);
+      ApplyAdminSettings(broker_config_.admin);
       ready_to_run_ = true;
     }
   }
 
+  if (!ready_to_run_)
+    TraceRecorder::Cancel();
   return ready_to_run_;
 }
 
 void BrokerShell::Deinit()
 {
+  if (admin_server_)
+    admin_server_->Shutdown();
+  metrics_exporter_.Shutdown();
+
+  if (TraceRecorder::enabled())
+  {
+    TraceRecorder::Stop();
+    WriteTrace();
+  }
+
   if (ready_to_run_)
     log_.Shutdown();
+
+  if (flight_recorder_)
+    FlightRecorder::SetCrashDumpTarget(nullptr, std::string{});
 }
 
-bool BrokerShell::Run()
+bool BrokerShell::Run(const std::function<void()>& started)
 {
   if (!ready_to_run_)
     return false;
 
-  if (!rdmnet::Init(log_))
-    return false;
+  TraceRecorder::SetThreadName("BrokerShell::Run");
+  TraceRecorder::Span run_span("BrokerShell::Run");
+
+  {
+    TraceRecorder::Span init_span("rdmnet::Init");
+    if (!rdmnet::Init(log_))
+      return false;
+  }
+
+  bool                          startup_broker = true;
+  bool                          force_restart = false;
+  bool                          started_reported = false;
+  std::unique_ptr<BrokerConfig> staged_config;
+
+  // Set while a restart is in progress, to measure how long no broker is listening. It stays set
+  // through failed startups and their retries, until a broker is running again.
+  std::optional<std::chrono::steady_clock::time_point> restart_begin;
+  // Covers handling a restart request, from reading the configuration to the new broker starting.
+  std::optional<TraceRecorder::Span> restart_span;
+
+  if (broker_config_.stats_interval_s != 0u)
+    stats_timer_.Start(broker_config_.stats_interval_s * 1000u);
+  shell_metrics_->logged_totals = shell_metrics_->ReadTotals(os_interface_.GetResourceUsage());
 
-  bool startup_broker = true;
   while (true)
   {
     if (startup_broker)
     {
       startup_broker = false;
+      StartupBroker();
 
-      if (broker_config_.enable_broker)
+      if (started && !started_reported)
       {
-        if (etcpal_netint_refresh_interfaces() != kEtcPalErrOk)
-          log_.Error("Error refreshing network interfaces - broker may not work correctly.");
+        started();
+        started_reported = true;
+      }
 
-        auto res = broker_.Startup(broker_config_.settings, &log_, this);
-        if (!res)
-        {
-          log_.Notice("Broker startup failed (%s), running with broker functionality disabled.", res.ToCString());
-          broker_config_.enable_broker = false;
-        }
+      if (restart_begin && broker_running_)
+      {
+        const auto downtime = std::chrono::steady_clock::now() - *restart_begin;
+        shell_metrics_->restart_downtime.Observe(std::chrono::duration<double>(downtime).count());
+        log_.Info("Broker restart complete (%lld ms from shutdown to startup).",
+                  static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(downtime).count()));
+        restart_begin.reset();
       }
-      else
+
+      if (restart_span)
       {
-        log_.Info("Running with broker functionality disabled.");
+        restart_span.reset();
+        if (TraceRecorder::enabled())
+          WriteTrace();
       }
     }
 
+    if (draining_broker_ && drain_timer_.IsExpired())
+      FinishDraining();
+
+    if (broker_config_.stats_interval_s != 0u && stats_timer_.IsExpired())
+    {
+      LogStats();
+      stats_timer_.Reset();
+    }
+
     if (shutdown_requested_)
     {
       break;
     }
-    else if (TimeToRestartBroker())
+    else if (TimeToRestartBroker(force_restart, staged_config))
     {
-      log_.Info("Restart requested, restarting broker and applying changes...");
+      restart_span.emplace("Restart request");
+
+      // Stage the new configuration while the current broker keeps running. Copy the current
+      // config first to keep the same default CID.
+      BrokerConfig new_config = broker_config_;
+      if (staged_config)
+      {
+        log_.Info("Applying the changed configuration...");
+        new_config = std::move(*staged_config);
+        staged_config.reset();
+      }
+      else
+      {
+        log_.Info("Restart requested, reloading configuration...");
+        if (!LoadBrokerConfig(new_config))
+        {
+          log_.Notice("The new configuration is unusable - keeping the current configuration.");
+          new_config = broker_config_;
+        }
+      }
+
+      if (ApplySettingsChanges(new_config, force_restart))
+      {
+        if (OverlappedRestart(new_config))
+        {
+          RestartExecuted();
+          restart_span.reset();
+          if (TraceRecorder::enabled())
+            WriteTrace();
+          continue;
+        }
+
+        log_.Info("Restarting broker and applying changes...");
 
-      if (broker_config_.enable_broker)
-        broker_.Shutdown();
+        if (!restart_begin)
+          restart_begin = std::chrono::steady_clock::now();
 
-      LoadBrokerConfig();
-      ApplySettingsChanges();
+        // Retrying a failed startup, or starting a broker that was disabled, isn't a restart.
+        if (broker_running_)
+        {
+          shell_metrics_->standard_restarts.Increment();
+          RestartExecuted();
+
+          LatencyHistogram::ScopedTimer timer(*shell_metrics_->durations[Metrics::kShutdown]);
+          TraceRecorder::Span          shutdown_span("rdmnet::Broker::Shutdown");
+          broker_->Shutdown();
+        }
+        broker_running_ = false;
+        shell_metrics_->broker_up.Set(0);
+
+        broker_config_ = std::move(new_config);
+        startup_broker = true;
+        continue;
+      }
 
-      startup_broker = true;
+      broker_config_ = std::move(new_config);
+      restart_span.reset();
     }
 
-    etcpal_thread_sleep(300);
+    WaitForWakeup();
   }
 
-  if (broker_config_.enable_broker)
-    broker_.Shutdown();
+  if (draining_broker_)
+    FinishDraining();
 
-  rdmnet::Deinit();
+  if (broker_running_)
+  {
+    LatencyHistogram::ScopedTimer timer(*shell_metrics_->durations[Metrics::kShutdown]);
+    TraceRecorder::Span          shutdown_span("rdmnet::Broker::Shutdown");
+    broker_->Shutdown();
+  }
+  broker_running_ = false;
+  shell_metrics_->broker_up.Set(0);
+
+  {
+    TraceRecorder::Span deinit_span("rdmnet::Deinit");
+    rdmnet::Deinit();
+  }
   return true;
 }
 
-void BrokerShell::RequestRestart(uint32_t cooldown_ms)
+// Both of these read the configuration file again, so any configuration staged by the config
+// watcher is superseded.
+void BrokerShell::RequestRestart(RestartScheduler::Trigger trigger)
+{
+  etcpal::MutexGuard guard(lock_);
+  staged_config_.reset();
+  LockedRequestRestart(trigger);
+}
+
+// Re-read the configuration file, restarting the broker only if a changed setting requires it.
+void BrokerShell::RequestConfigReload()
 {
   etcpal::MutexGuard guard(lock_);
-  LockedRequestRestart(cooldown_ms);
+  staged_config_.reset();
+  LockedRequestRestart(RestartScheduler::Trigger::kManual, false);
+}
+
+// Apply a configuration the config watcher has already read, restarting the broker only if a
+// changed setting requires it. Can be called from any thread.
+void BrokerShell::HandleConfigChanged(const BrokerConfig& new_config, const BrokerConfig::Diff& diff)
+{
+  etcpal::MutexGuard guard(lock_);
+  log_.Info("The broker configuration has changed (%s) - applying it.", diff.ToString().c_str());
+  staged_config_ = std::make_unique<BrokerConfig>(new_config);
+  LockedRequestRestart(RestartScheduler::Trigger::kConfigChange, false);
+}
+
+// Restart the broker if any of the changes affects an interface it listens on. Can be called from
+// any thread.
+void BrokerShell::HandleNetworkChanges(const NetworkChangeMonitor::Changes& changes)
+{
+  etcpal::MutexGuard guard(lock_);
+
+  shell_metrics_->network_changes.Increment(changes.size());
+  for (const auto& change : changes)
+    log_.Debug("Network change: %s.", change.ToString().c_str());
+
+  if (NetworkChangeMonitor::Affects(changes, listen_interfaces_))
+  {
+    log_.Info("A network change was detected - requesting broker restart.");
+    LockedRequestRestart(RestartScheduler::Trigger::kNetworkChange);
+  }
+  else
+  {
+    log_.Info("A network change was detected on interfaces the broker doesn't listen on - ignoring it.");
+  }
 }
 
 void BrokerShell::AsyncShutdown()
 {
   log_.Info("Shutdown requested, Broker shutting down...");
   shutdown_requested_ = true;
+  wake_signal_.Notify();
 }
 
 void BrokerShell::PrintVersion()
@@ -130,6 +429,27 @@ void BrokerShell::PrintVersion()
   std::cout << "or implied.\n";
 }
 
+// Write the flight recorder's contents to a file next to the log file. Can be called from any
+// thread.
+bool BrokerShell::DumpFlightRecorder(const char* reason)
+{
+  const FlightRecorder* recorder = active_flight_recorder_.load();
+  if (!recorder)
+  {
+    log_.Notice("The flight recorder is disabled; there is nothing to dump.");
+    return false;
+  }
+
+  if (!recorder->DumpToFile(flight_recorder_path_, reason))
+  {
+    log_.Error("Error writing the flight recorder to \"%s\".", flight_recorder_path_.c_str());
+    return false;
+  }
+
+  log_.Info("Flight recorder written to \"%s\".", flight_recorder_path_.c_str());
+  return true;
+}
+
 bool BrokerShell::OpenLogFile()
 {
   if (!os_interface_.OpenLogFile())
@@ -140,67 +460,631 @@ bool BrokerShell::OpenLogFile()
   return true;
 }
 
-void BrokerShell::LoadBrokerConfig()
+void BrokerShell::StartupBroker()
 {
-  broker_config_.SetDefaults();  // Start with defaults - settings will be changed as needed.
+  TraceRecorder::Span span("BrokerShell::StartupBroker");
+
+  SetListenInterfaces(broker_config_.settings.listen_interfaces);
+  UpdateLimitMetrics(broker_config_);
+
+  if (broker_config_.enable_broker)
+  {
+    RefreshNetworkInterfaces();
+
+    etcpal::Error res = kEtcPalErrOk;
+    {
+      LatencyHistogram::ScopedTimer timer(*shell_metrics_->durations[Metrics::kStartup]);
+      TraceRecorder::Span          startup_span("rdmnet::Broker::Startup");
+      res = broker_->Startup(broker_config_.settings, &log_, this);
+    }
+    broker_running_ = res.IsOk();
+    shell_metrics_->broker_up.Set(broker_running_ ? 1 : 0);
+    if (broker_running_)
+      shell_metrics_->broker_started = std::chrono::steady_clock::now();
+
+    etcpal::MutexGuard guard(lock_);
+    if (broker_running_)
+    {
+      restart_scheduler_.StartupSucceeded();
+    }
+    else
+    {
+      shell_metrics_->startup_failures.Increment();
+      shell_metrics_->restarts_requested[static_cast<size_t>(RestartScheduler::Trigger::kStartupRetry)]->Increment();
+      const uint32_t retry_ms = restart_scheduler_.StartupFailed();
+      log_.Notice("Broker startup failed (%s), retrying in %u ms.", res.ToCString(), retry_ms);
+      wake_signal_.Notify();
+    }
+  }
+  else
+  {
+    log_.Info("Running with broker functionality disabled.");
+  }
+}
 
-  auto conf_file_pair = os_interface_.GetConfFile(log_);
+// Start a second broker with the new configuration while the current one is still serving, so
+// there is never a moment without a broker to connect to. The old broker stays up for the drain
+// period so that clients have time to discover the new one via DNS-SD before they are disconnected.
+//
+// The RDMnet library binds its own listen sockets without address reuse, so both brokers can only
+// run at the same time if they don't compete for the same fixed port. Returns false if an
+// overlapped restart was not possible; the caller then falls back to a standard restart.
+bool BrokerShell::OverlappedRestart(BrokerConfig& new_config)
+{
+  TraceRecorder::Span span("BrokerShell::OverlappedRestart");
+
+  if (new_config.restart_mode != BrokerConfig::RestartMode::kOverlapped)
+    return false;
+
+  if (!broker_running_ || !new_config.enable_broker)
+    return false;
+
+  if ((new_config.settings.listen_port != 0u) &&
+      (new_config.settings.listen_port == broker_config_.settings.listen_port))
+  {
+    log_.Info("Overlapped restart is not possible while the listen port stays fixed at %u.",
+              static_cast<unsigned int>(new_config.settings.listen_port));
+    return false;
+  }
+
+  // Only one broker can be draining at a time.
+  if (draining_broker_)
+    FinishDraining();
+
+  log_.Info("Starting replacement broker before shutting down the current one...");
+
+  const auto start_begin = std::chrono::steady_clock::now();
+
+  RefreshNetworkInterfaces();
+
+  auto          new_broker = std::make_unique<rdmnet::Broker>();
+  etcpal::Error res = kEtcPalErrOk;
+  {
+    LatencyHistogram::ScopedTimer timer(*shell_metrics_->durations[Metrics::kStartup]);
+    TraceRecorder::Span          startup_span("rdmnet::Broker::Startup");
+    res = new_broker->Startup(new_config.settings, &log_, this);
+  }
+  if (!res)
+  {
+    log_.Notice("Replacement broker startup failed (%s), falling back to a standard restart.", res.ToCString());
+    return false;
+  }
+
+  const auto startup_time = std::chrono::steady_clock::now() - start_begin;
+  log_.Info("Replacement broker started in %lld ms with no downtime. Previous broker will shut down in %u ms.",
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(startup_time).count()),
+            new_config.restart_drain_ms);
+
+  draining_broker_ = std::move(broker_);
+  broker_ = std::move(new_broker);
+  broker_config_ = std::move(new_config);
+  SetListenInterfaces(broker_config_.settings.listen_interfaces);
+  UpdateLimitMetrics(broker_config_);
+  shell_metrics_->overlapped_restarts.Increment();
+  shell_metrics_->broker_started = std::chrono::steady_clock::now();
+  drain_timer_.Start(broker_config_.restart_drain_ms);
+  return true;
+}
+
+void BrokerShell::RefreshNetworkInterfaces()
+{
+  TraceRecorder::Span span("etcpal_netint_refresh_interfaces");
+  if (etcpal_netint_refresh_interfaces() != kEtcPalErrOk)
+    log_.Error("Error refreshing network interfaces - broker may not work correctly.");
+}
+
+// Network changes are matched against these from other threads.
+void BrokerShell::SetListenInterfaces(const std::vector<std::string>& listen_interfaces)
+{
+  etcpal::MutexGuard guard(lock_);
+  listen_interfaces_ = listen_interfaces;
+}
+
+void BrokerShell::FinishDraining()
+{
+  TraceRecorder::Span span("BrokerShell::FinishDraining");
+
+  log_.Info("Shutting down previous broker after overlapped restart.");
+  {
+    LatencyHistogram::ScopedTimer timer(*shell_metrics_->durations[Metrics::kShutdown]);
+    TraceRecorder::Span          shutdown_span("rdmnet::Broker::Shutdown");
+    draining_broker_->Shutdown();
+  }
+  draining_broker_.reset();
+}
+
+// Read and validate the configuration file into config. Returns false if the file could not be
+// opened or parsed; config then holds the defaults with broker functionality disabled.
+bool BrokerShell::LoadBrokerConfig(BrokerConfig& config)
+{
+  TraceRecorder::Span span("BrokerShell::LoadBrokerConfig");
+
+  config.SetDefaults();  // Start with defaults - settings will be changed as needed.
+
+  std::pair<std::string, std::ifstream> conf_file_pair;
+  {
+    TraceRecorder::Span open_span("GetConfFile");
+    conf_file_pair = os_interface_.GetConfFile(log_);
+  }
   if (!conf_file_pair.second.is_open())
   {
-    broker_config_.enable_broker = false;
+    config.enable_broker = false;
     if (conf_file_pair.first.empty())
       log_.Notice("Error opening configuration file.");
     else
       log_.Notice("Error opening configuration file located at path \"%s\".", conf_file_pair.first.c_str());
+    return false;
   }
 
   log_.Info("Reading configuration file at %s...", conf_file_pair.first.c_str());
 
-  auto parse_res = broker_config_.Read(conf_file_pair.second, &log_);
+  // Unchanged files are not parsed again; see BrokerConfig::ReadFile().
+  auto parse_res = BrokerConfig::ParseResult::kOk;
+  {
+    LatencyHistogram::ScopedTimer timer(*shell_metrics_->durations[Metrics::kConfigLoad]);
+    TraceRecorder::Span          read_span("BrokerConfig::ReadFile");
+    parse_res = config.ReadFile(conf_file_pair.first, conf_file_pair.second, &log_);
+  }
 
   // kInvalidSetting is treated as non-fatal because it makes sure default values are used in place of invalid ones.
   if ((parse_res != BrokerConfig::ParseResult::kOk) && (parse_res != BrokerConfig::ParseResult::kInvalidSetting))
-    broker_config_.enable_broker = false;  // Error was already logged in the Read call above.
+  {
+    config.enable_broker = false;  // Error was already logged in the Read call above.
+    return false;
+  }
+
+  return true;
 }
 
 void BrokerShell::HandleScopeChanged(const std::string& new_scope)
 {
   etcpal::MutexGuard guard(lock_);
   new_scope_ = new_scope;
-  LockedRequestRestart();
+  LockedRequestRestart(RestartScheduler::Trigger::kScopeChange, false);
 }
 
-void BrokerShell::ApplySettingsChanges()
+// Move the running broker to a new scope without restarting it. Its listen sockets stay open while
+// it registers with DNS-SD under the new scope. E1.33 ties every client connection to the scope it
+// was made on, so the clients are still disconnected (as reconfigured, rather than shut down) and
+// reconnect to the broker once they find it under the new scope. Returns false if the scope could
+// not be changed; the broker must then be restarted.
+bool BrokerShell::ChangeScope(const std::string& new_scope)
 {
-  etcpal::MutexGuard guard(lock_);
+  if (!broker_running_)
+    return true;  // The next startup uses the new scope.
+
+  etcpal::Error res = kEtcPalErrOk;
+  {
+    LatencyHistogram::ScopedTimer timer(*shell_metrics_->durations[Metrics::kScopeChange]);
+    TraceRecorder::Span          scope_span("rdmnet::Broker::ChangeScope");
+    res = broker_->ChangeScope(new_scope, kRdmnetDisconnectUserReconfigure);
+  }
+  if (!res)
+  {
+    log_.Notice("Changing the broker's scope in place failed (%s), restarting the broker instead.", res.ToCString());
+    return false;
+  }
 
-  log_.SetLogMask(broker_config_.log_mask);
+  log_.Info("Broker scope changed to \"%s\" without a restart.", new_scope.c_str());
+  return true;
+}
 
-  if (!new_scope_.empty())
+// Save a scope that was set over RDMnet to the configuration file, so that the broker doesn't go
+// back to the old scope the next time it starts.
+void BrokerShell::PersistScope(const std::string& new_scope)
+{
+  const std::string path = os_interface_.GetConfFile(log_).first;
+  if (!path.empty() && BrokerConfig::SaveSetting(path, "/scope", new_scope, &log_))
+  {
+    log_.Info("Saved the new scope to the configuration.");
+  }
+  else
+  {
+    log_.Warning("WARNING: Could not save the new scope; the broker will return to its previous scope the next time "
+                 "the service starts.");
+  }
+}
+
+// The recorder's memory is allocated once here, so its size can't change while the service runs.
+void BrokerShell::StartFlightRecorder(unsigned int size)
+{
+  if (size == 0 || flight_recorder_)
+    return;
+
+  flight_recorder_path_ =
+      std::filesystem::path(os_interface_.GetLogFilePath()).replace_filename(kFlightRecorderFileName).string();
+  flight_recorder_ = std::make_unique<FlightRecorder>(size);
+  active_flight_recorder_ = flight_recorder_.get();
+  FlightRecorder::SetCrashDumpTarget(flight_recorder_.get(), flight_recorder_path_);
+}
+
+// The flight recorder captures messages of every priority, so etcpal has to pass them all through
+// while the log file only gets the configured level.
+void BrokerShell::ApplyLogMask(int log_mask)
+{
+  file_log_mask_ = log_mask;
+  if (active_flight_recorder_.load())
+    log_.SetLogMask(log_mask | ETCPAL_LOG_UPTO(ETCPAL_LOG_DEBUG));
+  else
+    log_.SetLogMask(log_mask);
+}
+
+void BrokerShell::ApplyLogOutputSettings(const BrokerConfig& config)
+{
+  // etcpal only builds the raw message string. With the flight recorder on, every debug message
+  // reaches HandleLogMessage(), so the human-readable line is only built there, for the messages
+  // that are written in the text format. Messages that arrive without one while switching formats
+  // are written in binary, which is harmless.
+  log_.SetLogAction(0);
+  text_log_format_ = (config.log_writer.format == AsyncLogWriter::Format::kText);
+
+  os_interface_.SetLogArchiveSettings(config.log_archive);
+  os_interface_.SetLogWriterSettings(config.log_writer);
+}
+
+void BrokerShell::ApplyMetricsSettings(const MetricsExporter::Settings& settings)
+{
+  metrics_exporter_.Shutdown();
+  metrics_exporter_.Startup(settings, &log_);
+}
+
+// Shutting the server down joins its thread, which may be waiting on lock_ to answer a command, so
+// this is never called with lock_ held.
+void BrokerShell::ApplyAdminSettings(const AdminServer::Settings& settings)
+{
+  if (!admin_server_)
+    return;
+
+  if (settings.enable)
+    admin_server_->Startup(settings, &log_);
+  else
+    admin_server_->Shutdown();
+}
+
+// Turning tracing off writes out what was traced.
+void BrokerShell::ApplyTraceSettings(bool enable)
+{
+  if (enable && !TraceRecorder::enabled())
   {
-    broker_config_.settings.scope = new_scope_;
-    new_scope_.clear();
+    TraceRecorder::Start();
+    log_.Info("Tracing broker startup and shutdown; the trace is written to \"%s\" after each restart.",
+              trace_path_.c_str());
   }
+  else if (!enable && TraceRecorder::enabled())
+  {
+    TraceRecorder::Stop();
+    WriteTrace();
+  }
+}
+
+// Called from the Run() thread and the admin server's; TraceRecorder serializes the writes.
+bool BrokerShell::WriteTrace()
+{
+  if (!TraceRecorder::WriteChromeTrace(trace_path_))
+  {
+    log_.Error("Error writing the trace to \"%s\".", trace_path_.c_str());
+    return false;
+  }
+
+  log_.Info("Trace written to \"%s\".", trace_path_.c_str());
+  return true;
+}
+
+// Published so that the client and queue counts the broker logs can be compared against them.
+void BrokerShell::UpdateLimitMetrics(const BrokerConfig& config)
+{
+  const auto& limits = config.settings.limits;
+  const unsigned int values[] = {limits.connections, limits.controllers,     limits.controller_messages,
+                                 limits.devices,     limits.device_messages, limits.reject_connections};
+  for (size_t i = 0; i < shell_metrics_->limits.size(); ++i)
+    shell_metrics_->limits[i]->Set(values[i]);
+}
+
+// Write what happened since the last statistics line to the log: a summary of the broker's state
+// and the service's activity and resource use, then the percentiles of each operation's duration
+// over the interval, for the operations that happened at all. Rates are over the time actually
+// elapsed, which can be longer than the interval if the Run thread was busy.
+void BrokerShell::LogStats()
+{
+  const auto  usage = os_interface_.GetResourceUsage();
+  const auto  totals = shell_metrics_->ReadTotals(usage);
+  const auto& last = shell_metrics_->logged_totals;
+  const auto  elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(totals.time - last.time).count();
+  const double elapsed_s = elapsed_us > 0 ? static_cast<double>(elapsed_us) / 1e6 : 1.0;
+
+  std::string broker_state = "disabled";
+  if (broker_running_)
+  {
+    const auto uptime = std::chrono::steady_clock::now() - shell_metrics_->broker_started;
+    broker_state = "up " + std::to_string(std::chrono::duration_cast<std::chrono::seconds>(uptime).count()) + " s";
+  }
+  else if (broker_config_.enable_broker)
+  {
+    broker_state = "down";
+  }
+
+  log_.Info(
+      "Stats over the last %.0f s: broker %s, %llu restarts, %llu failed startups; %llu log messages (%.1f/s), "
+      "%llu warnings or worse, %llu dropped; %.1f MB resident, %.1f%% CPU",
+      elapsed_s, broker_state.c_str(), static_cast<unsigned long long>(totals.restarts - last.restarts),
+      static_cast<unsigned long long>(totals.startup_failures - last.startup_failures),
+      static_cast<unsigned long long>(totals.log_messages - last.log_messages),
+      static_cast<double>(totals.log_messages - last.log_messages) / elapsed_s,
+      static_cast<unsigned long long>(totals.warnings - last.warnings),
+      static_cast<unsigned long long>(totals.dropped_log_messages - last.dropped_log_messages),
+      static_cast<double>(usage.resident_bytes) / (1024.0 * 1024.0),
+      elapsed_us > 0 ? static_cast<double>(totals.cpu_time_us - last.cpu_time_us) * 100.0 / elapsed_us : 0.0);
+  shell_metrics_->logged_totals = totals;
+
+  std::string durations;
+  for (size_t i = 0; i < Metrics::kNumOperations; ++i)
+  {
+    const auto snapshot = shell_metrics_->durations[i]->Read();
+    const auto interval = snapshot.Since(shell_metrics_->logged_durations[i]);
+    shell_metrics_->logged_durations[i] = snapshot;
+    if (interval.count == 0)
+      continue;
+
+    if (!durations.empty())
+      durations += "; ";
+    durations += Metrics::kOperationNames[i];
+    durations += ' ';
+    durations += interval.ToString();
+  }
+
+  if (!durations.empty())
+    log_.Info("Durations over the last %u s: %s", broker_config_.stats_interval_s, durations.c_str());
+}
+
+// Compare a freshly-loaded configuration against the one the broker is running with and apply
+// whatever can be changed in place. Returns true if the broker must be restarted to pick up the
+// rest of the changes.
+bool BrokerShell::ApplySettingsChanges(BrokerConfig& new_config, bool force_restart)
+{
+  TraceRecorder::Span span("BrokerShell::ApplySettingsChanges");
+
+  std::string new_scope;
+  {
+    etcpal::MutexGuard guard(lock_);
+    new_scope.swap(new_scope_);
+  }
+  if (!new_scope.empty())
+  {
+    new_config.settings.scope = new_scope;
+    PersistScope(new_scope);
+  }
+
+  // broker_config_ is only used on this thread, so the rest runs without lock_. ChangeScope() in
+  // particular must not hold it: the broker's notify callbacks take it from the broker's thread.
+  const auto diff = BrokerConfig::Compare(broker_config_, new_config);
+
+  if (diff.log_level)
+  {
+    log_.Info("Applying new log level.");
+    ApplyLogMask(new_config.log_mask);
+  }
+
+  if (diff.flight_recorder)
+    log_.Notice("The new flight recorder size will take effect the next time the service starts.");
+
+  if (diff.log_output)
+    ApplyLogOutputSettings(new_config);
+
+  if (diff.metrics)
+    ApplyMetricsSettings(new_config.metrics);
+
+  if (diff.stats && new_config.stats_interval_s != 0u)
+    stats_timer_.Start(new_config.stats_interval_s * 1000u);
+
+  if (diff.admin)
+    ApplyAdminSettings(new_config.admin);
+
+  if (diff.trace)
+    ApplyTraceSettings(new_config.enable_trace);
+
+  // A broker that isn't running (and won't be) has nothing to restart.
+  if (!broker_running_ && !new_config.enable_broker)
+    return false;
+
+  if (force_restart || diff.RequiresRestart())
+    return true;
+
+  if (diff.scope && !ChangeScope(new_config.settings.scope))
+    return true;
+
+  if (diff.Empty())
+    log_.Info("Configuration unchanged, broker will keep running.");
+  else
+    log_.Info("All configuration changes applied without restarting the broker.");
+
+  return false;
 }
 
-bool BrokerShell::TimeToRestartBroker()
+bool BrokerShell::TimeToRestartBroker(bool& force_restart, std::unique_ptr<BrokerConfig>& staged_config)
 {
   etcpal::MutexGuard guard(lock_);
 
-  // The timer is used to prevent "restart spamming" if tons of restarts are requested at once.
-  if (restart_requested_ && restart_timer_.IsExpired())
+  if (restart_scheduler_.TakeDue(force_restart))
   {
-    restart_requested_ = false;
+    staged_config = std::move(staged_config_);
     return true;
   }
 
   return false;
 }
 
-void BrokerShell::LockedRequestRestart(uint32_t cooldown_ms)
+// The admin server calls these from its own thread, so they only use what is safe to share: the
+// metrics, the restart scheduler (under the lock), and the atomics behind the log and the flight
+// recorder.
+std::string BrokerShell::HandleStatusRequest()
+{
+  const auto counters = GetRestartCounters();
+
+  std::string status = "broker: ";
+  status += (shell_metrics_->broker_up.value() != 0) ? "up" : "down";
+  status += "\nlog_level: ";
+  status += AdminServer::LogLevelName(file_log_mask_.load(std::memory_order_relaxed));
+  status += "\nrestarts: " + std::to_string(counters.executed);
+  status += "\nstartup_failures: " + std::to_string(counters.startup_failures);
+  status += "\nrestart_requests_coalesced: " + std::to_string(counters.coalesced);
+  status += '\n';
+  return status;
+}
+
+std::string BrokerShell::HandleStatsRequest()
 {
-  restart_requested_ = true;
+  return metrics_.RenderPrometheus();
+}
+
+bool BrokerShell::HandleRecentLogRequest(std::string& output)
+{
+  const FlightRecorder* recorder = active_flight_recorder_.load();
+  if (!recorder)
+  {
+    output = "The flight recorder is disabled";
+    return false;
+  }
+
+  output = recorder->DumpToString();
+  return true;
+}
+
+// Lasts until the configured log level changes, which replaces it.
+void BrokerShell::HandleLogLevelChange(int log_mask)
+{
+  ApplyLogMask(log_mask);
+}
+
+void BrokerShell::HandleRestartRequest()
+{
+  RequestRestart(RestartScheduler::Trigger::kManual);
+}
+
+bool BrokerShell::HandleTraceRequest(AdminServer::TraceAction action, std::string& output)
+{
+  switch (action)
+  {
+    case AdminServer::TraceAction::kStart:
+      TraceRecorder::Start();
+      output = "Tracing; the trace is written to " + trace_path_ + " when it stops";
+      return true;
+    case AdminServer::TraceAction::kStop:
+      TraceRecorder::Stop();
+      break;
+    case AdminServer::TraceAction::kWrite:
+    default:
+      break;
+  }
+
+  if (!WriteTrace())
+  {
+    output = "Error writing the trace to " + trace_path_;
+    return false;
+  }
+  output = trace_path_;
+  return true;
+}
 
-  if (cooldown_ms > restart_timer_.GetRemaining())  // Don't cancel out previous cooldown
-    restart_timer_.Start(cooldown_ms);
+// Config reloads and scope changes that were applied without restarting the broker aren't counted,
+// and don't start the triggers' minimum intervals.
+void BrokerShell::RestartExecuted()
+{
+  etcpal::MutexGuard guard(lock_);
+  restart_scheduler_.RestartExecuted();
+}
+
+RestartScheduler::Counters BrokerShell::GetRestartCounters() const
+{
+  etcpal::MutexGuard guard(lock_);
+  return restart_scheduler_.counters();
+}
+
+// Block the Run() loop until there is something to do: a shutdown, a new restart request, the
+// expiry of the cooldown on a pending restart, the end of an overlapped restart's drain period, or
+// the next statistics line. Requests that arrive between the check and the wait are not lost, since
+// the signal stays posted until it is consumed.
+void BrokerShell::WaitForWakeup()
+{
+  bool     timeout_pending = false;
+  uint32_t timeout_ms = 0u;
+  {
+    etcpal::MutexGuard guard(lock_);
+    const int          until_due = restart_scheduler_.TimeUntilDue();
+    if (until_due >= 0)
+    {
+      timeout_pending = true;
+      timeout_ms = static_cast<uint32_t>(until_due);
+    }
+  }
+
+  if (draining_broker_)
+  {
+    const uint32_t drain_remaining = drain_timer_.GetRemaining();
+    if (!timeout_pending || drain_remaining < timeout_ms)
+      timeout_ms = drain_remaining;
+    timeout_pending = true;
+  }
+
+  if (broker_config_.stats_interval_s != 0u)
+  {
+    const uint32_t stats_remaining = stats_timer_.GetRemaining();
+    if (!timeout_pending || stats_remaining < timeout_ms)
+      timeout_ms = stats_remaining;
+    timeout_pending = true;
+  }
+
+  if (!timeout_pending)
+    wake_signal_.Wait();
+  else if (timeout_ms > 0u)
+    wake_signal_.TryWait(static_cast<int>(timeout_ms));
+}
+
+// The scheduler decides when the restart happens; requests that arrive while one is pending are
+// coalesced into it.
+void BrokerShell::LockedRequestRestart(RestartScheduler::Trigger trigger, bool force_restart)
+{
+  shell_metrics_->restarts_requested[static_cast<size_t>(trigger)]->Increment();
+  if (!restart_scheduler_.Request(trigger, force_restart))
+  {
+    shell_metrics_->restarts_coalesced.Increment();
+    log_.Debug("Restart request (%s) coalesced into the pending restart.", RestartScheduler::TriggerName(trigger));
+  }
+
+  wake_signal_.Notify();
+}
+
+etcpal::LogTimestamp BrokerShell::GetLogTimestamp()
+{
+  return os_interface_.GetLogTimestamp();
+}
+
+void BrokerShell::HandleLogMessage(const EtcPalLogStrings& strings)
+{
+  LatencyHistogram::ScopedTimer timer(*shell_metrics_->durations[Metrics::kLogDispatch]);
+
+  FlightRecorder* recorder = active_flight_recorder_.load(std::memory_order_acquire);
+  if (recorder)
+    recorder->Record(strings);
+
+  // Messages below the configured level only get here for the flight recorder, so they aren't
+  // counted.
+  if (ETCPAL_LOG_MASK(strings.priority) & file_log_mask_.load(std::memory_order_relaxed))
+  {
+    if (strings.priority >= 0 && strings.priority < static_cast<int>(shell_metrics_->log_messages.size()))
+      shell_metrics_->log_messages[static_cast<size_t>(strings.priority)]->Increment();
+
+    if (text_log_format_.load(std::memory_order_relaxed) && strings.raw)
+    {
+      char             human_readable[ETCPAL_LOG_STR_MAX_LEN];
+      EtcPalLogStrings with_text = strings;
+      BinaryLogRecord::FormatText(strings.log_timestamp, strings.priority, strings.raw, std::strlen(strings.raw),
+                                  human_readable, sizeof(human_readable));
+      with_text.human_readable = human_readable;
+      os_interface_.HandleLogMessage(with_text);
+    }
+    else
+    {
+      os_interface_.HandleLogMessage(strings);
+    }
+  }
 }
@@ -20,65 +20,162 @@
 #ifndef BROKER_SHELL_H_
 #define BROKER_SHELL_H_
 
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <array>
 #include <atomic>
 #include "etcpal/inet.h"
 #include "etcpal/cpp/mutex.h"
+#include "etcpal/cpp/signal.h"
 #include "etcpal/cpp/log.h"
 #include "etcpal/cpp/timer.h"
 #include "rdmnet/cpp/broker.h"
+#include "admin_server.h"
 #include "broker_config.h"
 #include "broker_os_interface.h"
+#include "config_watcher.h"
+#include "flight_recorder.h"
+#include "metrics.h"
+#include "metrics_exporter.h"
+#include "network_change_monitor.h"
+#include "restart_scheduler.h"
 
 // BrokerShell : Platform-neutral wrapper around the Broker library from a generic console
 // application. Instantiates and drives the Broker library.
 
-class BrokerShell : public rdmnet::Broker::NotifyHandler
+class BrokerShell : public rdmnet::Broker::NotifyHandler,
+                    public ConfigWatcher::NotifyHandler,
+                    private AdminServer::Handler,
+                    private etcpal::LogMessageHandler
 {
 public:
-  BrokerShell(BrokerOsInterface& os_interface) : os_interface_(os_interface){};
+  BrokerShell(BrokerOsInterface& os_interface);
+  ~BrokerShell();
 
   bool Init();
   void Deinit();
 
-  bool Run();
+  // started is called on Run()'s thread once the broker has first been started (or startup
+  // has failed and will be retried, or the broker is disabled), e.g. to tell a service manager that
+  // the service is ready.
+  bool Run(const std::function<void()>& started = nullptr);
 
-  void RequestRestart(uint32_t cooldown_ms = 0u);
+  void RequestRestart(RestartScheduler::Trigger trigger = RestartScheduler::Trigger::kManual);
+  void RequestConfigReload();
+  void HandleNetworkChanges(const NetworkChangeMonitor::Changes& changes);
   void AsyncShutdown();
 
+  RestartScheduler::Counters GetRestartCounters() const;
+
+  // The configuration the shell is running with. Only safe to use before Run() is called, or from
+  // the thread that calls it.
+  const BrokerConfig& config() const { return broker_config_; }
+
   void PrintVersion();
 
+  bool DumpFlightRecorder(const char* reason = "requested");
+
   etcpal::Logger& log() { return log_; }
 
+  // The shell's metrics, which are also served over HTTP if the configuration enables it.
+  const MetricsRegistry& metrics() const { return metrics_; }
+
 private:
-  BrokerOsInterface& os_interface_;
-  rdmnet::Broker     broker_;
-  etcpal::Logger     log_;
+  struct Metrics;
+
+  BrokerOsInterface&              os_interface_;
+  std::unique_ptr<rdmnet::Broker> broker_{std::make_unique<rdmnet::Broker>()};
+  etcpal::Logger                  log_;
+
+  // During an overlapped restart, the previous broker keeps serving its clients until the drain
+  // timer expires. Only touched from the Run() thread.
+  std::unique_ptr<rdmnet::Broker> draining_broker_;
+  etcpal::Timer                   drain_timer_;
+
+  // Statistics are written to the log each time this expires. Only touched from the Run() thread.
+  etcpal::Timer stats_timer_;
 
   BrokerConfig broker_config_;
 
+  // Every log message goes to the flight recorder, if there is one; only the ones that pass
+  // file_log_mask_ are passed on to the OS interface. The recorder is created in Init() and lives
+  // until the shell is destroyed.
+  std::unique_ptr<FlightRecorder> flight_recorder_;
+  std::atomic<FlightRecorder*>    active_flight_recorder_{nullptr};
+  std::atomic<int>                file_log_mask_{ETCPAL_LOG_UPTO(ETCPAL_LOG_INFO)};
+  std::atomic<bool>               text_log_format_{true};  // Whether to build human-readable lines
+  std::string                     flight_recorder_path_;
+
+  // Metrics are registered in the constructor and updated lock-free from any thread.
+  MetricsRegistry          metrics_;
+  std::unique_ptr<Metrics> shell_metrics_;
+  MetricsExporter          metrics_exporter_{metrics_};
+
+  // Created in Init(); null if the platform has no admin transport. Its thread calls the
+  // AdminServer::Handler functions below, some of which take lock_, so it must never be started or
+  // shut down with lock_ held.
+  std::unique_ptr<AdminServer> admin_server_;
+
+  // Where the Chrome trace is written; set in Init(). See TraceRecorder.
+  std::string trace_path_;
+
   bool ready_to_run_{false};
+  bool broker_running_{false};  // Only touched from the Run() thread
 
   // Handle changes at runtime
-  mutable etcpal::Mutex lock_;  // These are guarded by this lock
-  etcpal::Timer         restart_timer_;
-  bool                  restart_requested_{false};
-  bool                  shutdown_requested_{false};
-  std::string           new_scope_;
+  mutable etcpal::Mutex         lock_;  // These are guarded by this lock
+  RestartScheduler              restart_scheduler_;  // Pending restarts and config reloads
+  std::string                   new_scope_;
+  std::vector<std::string>      listen_interfaces_;  // Those of the running broker
+  std::unique_ptr<BrokerConfig> staged_config_;      // Read by the config watcher; used instead of the file
+
+  std::atomic<bool> shutdown_requested_{false};
+  etcpal::Signal    wake_signal_;  // Posted whenever the Run() loop has something new to act on
 
   bool OpenLogFile();
-  void LoadBrokerConfig();
+  bool LoadBrokerConfig(BrokerConfig& config);
+  void StartupBroker();
+  void RefreshNetworkInterfaces();
+  void SetListenInterfaces(const std::vector<std::string>& listen_interfaces);
+  bool OverlappedRestart(BrokerConfig& new_config);
+  void FinishDraining();
 
   void HandleScopeChanged(const std::string& new_scope) override;
+  bool ChangeScope(const std::string& new_scope);
+  void PersistScope(const std::string& new_scope);
+  void HandleConfigChanged(const BrokerConfig& new_config, const BrokerConfig::Diff& diff) override;
   void PrintWarningMessage();
 
-  void ApplySettingsChanges();
-
-  bool TimeToRestartBroker();
-
-  void LockedRequestRestart(uint32_t cooldown_ms = 0u);
+  void StartFlightRecorder(unsigned int size);
+  void ApplyLogMask(int log_mask);
+  void ApplyLogOutputSettings(const BrokerConfig& config);
+  void ApplyMetricsSettings(const MetricsExporter::Settings& settings);
+  void ApplyAdminSettings(const AdminServer::Settings& settings);
+  void ApplyTraceSettings(bool enable);
+  bool WriteTrace();
+  void UpdateLimitMetrics(const BrokerConfig& config);
+  void LogStats();
+  bool ApplySettingsChanges(BrokerConfig& new_config, bool force_restart);
+
+  bool TimeToRestartBroker(bool& force_restart, std::unique_ptr<BrokerConfig>& staged_config);
+  void RestartExecuted();
+  void WaitForWakeup();
+
+  void LockedRequestRestart(RestartScheduler::Trigger trigger, bool force_restart = true);
+
+  // AdminServer::Handler
+  std::string HandleStatusRequest() override;
+  std::string HandleStatsRequest() override;
+  bool        HandleRecentLogRequest(std::string& output) override;
+  void        HandleLogLevelChange(int log_mask) override;
+  void        HandleRestartRequest() override;
+  bool        HandleTraceRequest(AdminServer::TraceAction action, std::string& output) override;
+
+  // etcpal::LogMessageHandler
+  etcpal::LogTimestamp GetLogTimestamp() override;
+  void                 HandleLogMessage(const EtcPalLogStrings& strings) override;
 };
 
 #endif  // BROKER_SHELL_H_
@@ -0,0 +1,707 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef CONFIG_SCHEMA_H_
+#define CONFIG_SCHEMA_H_
+
+#include <algorithm>
+#include <array>
+#include <cinttypes>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "etcpal/cpp/log.h"
+#include "nlohmann/json.hpp"
+
+// config_schema : Describes the settings of a JSON configuration file once, at compile time.
+//
+// A schema is a constexpr std::tuple of Fields, one per setting, in the order they are processed.
+// Each Field holds the setting's JSON pointer, a Rule that validates the JSON value, an accessor
+// for where the value lives in the Config structure, the default value (or a function that
+// computes it from the settings before it), the Config::Diff flag it sets when it changes, and a
+// description. Reader, SetDefaults(), Compare() and Document() walk the tuple with a fold
+// expression, so every call is resolved at compile time; see ForEachField() for nesting.
+namespace config_schema
+{
+using json = nlohmann::json;
+
+constexpr const char kValidationFailLogPrefix[] = "Invalid value found in configuration file: ";
+constexpr const char kValidationFailLogPostfix[] = " (default will be used instead).";
+
+template <typename... Args>
+void LogParseError(etcpal::Logger* log, const std::string& format, Args&&... args)
+{
+  if (log)
+  {
+    log->Notice(std::string(kValidationFailLogPrefix + format + kValidationFailLogPostfix).c_str(),
+                std::forward<Args>(args)...);
+  }
+}
+
+// An unsigned integer within [min, max].
+template <typename IntType>
+struct IntRule
+{
+  static_assert(std::is_integral<IntType>::value && std::is_unsigned<IntType>::value,
+                "IntRule is only for unsigned integer settings.");
+
+  IntType min;
+  IntType max;
+
+  static constexpr json::value_t type() { return json::value_t::number_unsigned; }
+
+  bool Validate(std::string_view pointer, const json& val, IntType& setting, etcpal::Logger* log) const
+  {
+    const uint64_t int_val = val.get_ref<const json::number_unsigned_t&>();
+    if (int_val < min || int_val > max)
+    {
+      LogParseError(log, "Integer value \"%" PRIu64 "\" is outside allowable range [%s, %s] for field \"%.*s\"",
+                    int_val, std::to_string(min).c_str(), std::to_string(max).c_str(),
+                    static_cast<int>(pointer.size()), pointer.data());
+      return false;
+    }
+    setting = static_cast<IntType>(int_val);
+    return true;
+  }
+
+  std::string Describe() const { return "integer from " + std::to_string(min) + " to " + std::to_string(max); }
+  std::string Format(IntType value) const { return std::to_string(value); }
+  json        ToJson(IntType value) const { return json(static_cast<json::number_unsigned_t>(value)); }
+};
+
+struct BoolRule
+{
+  static constexpr json::value_t type() { return json::value_t::boolean; }
+
+  bool Validate(std::string_view, const json& val, bool& setting, etcpal::Logger*) const
+  {
+    setting = val.get<bool>();
+    return true;
+  }
+
+  std::string Describe() const { return "boolean"; }
+  std::string Format(bool value) const { return value ? "true" : "false"; }
+  json        ToJson(bool value) const { return json(value); }
+};
+
+// A non-empty string of at most max_length characters. Longer strings are truncated if
+// truncation_allowed, and rejected otherwise.
+struct StringRule
+{
+  size_t max_length;
+  bool   truncation_allowed;
+
+  static constexpr json::value_t type() { return json::value_t::string; }
+
+  bool Validate(std::string_view pointer, const json& val, std::string& setting, etcpal::Logger* log) const
+  {
+    const int          pointer_length = static_cast<int>(pointer.size());
+    const std::string& str_val = val.get_ref<const std::string&>();
+    if (str_val.empty())
+    {
+      LogParseError(log, "Empty string is not allowed for field \"%.*s\"", pointer_length, pointer.data());
+      return false;
+    }
+
+    if (str_val.length() > max_length)
+    {
+      if (!truncation_allowed)
+      {
+        LogParseError(log, "String value \"%s\" is too long for field \"%.*s\" of maximum length %zu",
+                      str_val.c_str(), pointer_length, pointer.data(), max_length);
+        return false;
+      }
+
+      setting = str_val.substr(0, max_length);
+      if (log)
+      {
+        log->Notice("Configuration file: Truncating overlong string \"%s\" for field \"%.*s\" to \"%s\".",
+                    str_val.c_str(), pointer_length, pointer.data(), setting.c_str());
+      }
+      return true;
+    }
+
+    setting = str_val;
+    return true;
+  }
+
+  std::string Describe() const { return "string of up to " + std::to_string(max_length) + " characters"; }
+  std::string Format(const std::string& value) const { return "\"" + value + "\""; }
+  json        ToJson(const std::string& value) const { return json(value); }
+};
+
+// A string naming one of a fixed set of values.
+template <typename T, size_t N>
+struct EnumRule
+{
+  std::array<std::pair<std::string_view, T>, N> options;
+
+  static constexpr json::value_t type() { return json::value_t::string; }
+
+  bool Validate(std::string_view pointer, const json& val, T& setting, etcpal::Logger* log) const
+  {
+    const std::string& str_val = val.get_ref<const std::string&>();
+    for (const auto& option : options)
+    {
+      if (option.first == str_val)
+      {
+        setting = option.second;
+        return true;
+      }
+    }
+
+    LogParseError(log, "The value for field \"%.*s\" must be one of %s", static_cast<int>(pointer.size()),
+                  pointer.data(), Describe().c_str());
+    return false;
+  }
+
+  // {"option1", "option2", ...}
+  std::string Describe() const
+  {
+    std::string description = "{";
+    for (const auto& option : options)
+      description += (description.size() > 1 ? ", \"" : "\"") + std::string(option.first) + "\"";
+    return description + "}";
+  }
+
+  std::string Format(const T& value) const
+  {
+    for (const auto& option : options)
+    {
+      if (option.second == value)
+        return "\"" + std::string(option.first) + "\"";
+    }
+    return std::string{};
+  }
+
+  json ToJson(const T& value) const
+  {
+    for (const auto& option : options)
+    {
+      if (option.second == value)
+        return json(std::string(option.first));
+    }
+    return json{};
+  }
+};
+
+template <typename T, size_t N, size_t... I>
+constexpr EnumRule<T, N> MakeEnumRule(const std::pair<std::string_view, T> (&options)[N], std::index_sequence<I...>)
+{
+  return {{{options[I]...}}};
+}
+
+// Enum<T>({{"name", value}, ...})
+template <typename T, size_t N>
+constexpr EnumRule<T, N> Enum(const std::pair<std::string_view, T> (&options)[N])
+{
+  return MakeEnumRule(options, std::make_index_sequence<N>{});
+}
+
+// A setting that needs its own validation, such as an object or an array.
+template <typename Setting>
+struct CustomRule
+{
+  using ValidateFunction = bool (*)(const json& val, Setting& setting, etcpal::Logger* log);
+  using ToJsonFunction = json (*)(const Setting& setting);
+
+  json::value_t    json_type;
+  ValidateFunction validate;
+  ToJsonFunction   to_json;
+  const char*      description;
+
+  constexpr json::value_t type() const { return json_type; }
+
+  bool Validate(std::string_view, const json& val, Setting& setting, etcpal::Logger* log) const
+  {
+    return validate(val, setting, log);
+  }
+
+  std::string Describe() const { return description; }
+  std::string Format(const Setting&) const { return std::string{}; }
+  json        ToJson(const Setting& setting) const { return to_json(setting); }
+};
+
+template <typename Config, typename Rule, typename Access, typename Default>
+struct Field
+{
+  std::string_view    pointer;
+  Rule                rule;
+  Access              access;  // Returns a reference to the setting, given a Config
+  Default             default_value;
+  bool Config::Diff::*diff_flag;
+  std::string_view    description;
+
+  bool Validate(const json& val, Config& config, etcpal::Logger* log) const
+  {
+    return rule.Validate(pointer, val, access(config), log);
+  }
+
+  void StoreDefault(Config& config) const
+  {
+    if constexpr (std::is_invocable<const Default&, const Config&>::value)
+      access(config) = default_value(config);
+    else
+      access(config) = default_value;
+  }
+
+  void Compare(const Config& old_config, const Config& new_config, typename Config::Diff& diff) const
+  {
+    if (!(access(old_config) == access(new_config)))
+      diff.*diff_flag = true;
+  }
+
+  std::string Document() const
+  {
+    std::string doc = "\"" + std::string(pointer) + "\": " + rule.Describe();
+    if constexpr (!std::is_invocable<const Default&, const Config&>::value)
+    {
+      const std::string default_string = rule.Format(default_value);
+      if (!default_string.empty())
+        doc += ", default " + default_string;
+    }
+    return doc + ". " + std::string(description);
+  }
+};
+
+template <typename Config, typename Rule, typename Access, typename Default>
+constexpr Field<Config, Rule, Access, Default> MakeField(std::string_view    pointer,
+                                                         Rule                rule,
+                                                         Access              access,
+                                                         Default             default_value,
+                                                         bool Config::Diff::*diff_flag,
+                                                         std::string_view    description)
+{
+  return {pointer, rule, access, default_value, diff_flag, description};
+}
+
+template <typename T>
+struct IsField : std::false_type
+{
+};
+template <typename Config, typename Rule, typename Access, typename Default>
+struct IsField<Field<Config, Rule, Access, Default>> : std::true_type
+{
+};
+
+template <typename T>
+struct IsArray : std::false_type
+{
+};
+template <typename T, size_t N>
+struct IsArray<std::array<T, N>> : std::true_type
+{
+};
+
+// Call fn with each Field of schema, in order. A schema is a Field, a std::tuple of schemas, which
+// is unrolled at compile time, or a std::array of schemas of the same type, which is walked with a
+// loop so that long runs of similar settings don't each need their own code.
+template <typename Schema, typename Fn>
+void ForEachField(const Schema& schema, Fn&& fn)
+{
+  if constexpr (IsField<Schema>::value)
+  {
+    fn(schema);
+  }
+  else if constexpr (IsArray<Schema>::value)
+  {
+    for (const auto& element : schema)
+      ForEachField(element, fn);
+  }
+  else
+  {
+    std::apply([&fn](const auto&... element) { (ForEachField(element, fn), ...); }, schema);
+  }
+}
+
+// The number of Fields in a schema.
+template <typename Schema>
+struct FieldCount;
+template <typename Schema>
+struct FieldCount<const Schema> : FieldCount<Schema>
+{
+};
+template <typename Config, typename Rule, typename Access, typename Default>
+struct FieldCount<Field<Config, Rule, Access, Default>> : std::integral_constant<size_t, 1>
+{
+};
+template <typename T, size_t N>
+struct FieldCount<std::array<T, N>> : std::integral_constant<size_t, N * FieldCount<T>::value>
+{
+};
+template <typename... Ts>
+struct FieldCount<std::tuple<Ts...>> : std::integral_constant<size_t, (FieldCount<Ts>::value + ... + 0)>
+{
+};
+
+// Call fn with the Field at position index in ForEachField() order.
+template <typename Schema, typename Fn>
+void VisitField(const Schema& schema, size_t index, Fn&& fn)
+{
+  if constexpr (IsField<Schema>::value)
+  {
+    fn(schema);
+  }
+  else if constexpr (IsArray<Schema>::value)
+  {
+    constexpr size_t kElementFields = FieldCount<typename Schema::value_type>::value;
+    VisitField(schema[index / kElementFields], index % kElementFields, fn);
+  }
+  else
+  {
+    std::apply(
+        [index, &fn](const auto&... element) {
+          size_t first = 0;
+          const auto visit_if_contains = [index, &fn, &first](const auto& element) {
+            constexpr size_t kElementFields = FieldCount<std::decay_t<decltype(element)>>::value;
+            if (index >= first && index < first + kElementFields)
+              VisitField(element, index - first, fn);
+            first += kElementFields;
+          };
+          (visit_if_contains(element), ...);
+        },
+        schema);
+  }
+}
+
+// The positions of a schema's Fields, sorted by pointer, for finding the Field for a key. Build it
+// once for each schema.
+class SchemaIndex
+{
+public:
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  template <typename Schema>
+  explicit SchemaIndex(const Schema& schema)
+  {
+    ForEachField(schema, [this](const auto& field) { entries_.emplace_back(field.pointer, entries_.size()); });
+    std::sort(entries_.begin(), entries_.end());
+  }
+
+  size_t Find(std::string_view pointer) const
+  {
+    const auto entry = std::lower_bound(entries_.begin(), entries_.end(), pointer,
+                                        [](const auto& entry, std::string_view value) { return entry.first < value; });
+    return (entry != entries_.end() && entry->first == pointer) ? entry->second : kNotFound;
+  }
+
+private:
+  std::vector<std::pair<std::string_view, size_t>> entries_;
+};
+
+// Reads settings from JSON documents with nlohmann's SAX interface, validating and storing each
+// setting as soon as its value has been parsed, so that no document is ever built in memory. Only
+// the values of settings that are themselves objects or arrays are collected before being
+// validated. Keys that aren't in the schema are skipped.
+//
+// Parse() can be called for more than one document; a setting in a later document replaces the
+// same setting from an earlier one. Finish() then stores the defaults of the settings that were
+// missing, null or invalid, in schema order, so that a computed default can depend on the settings
+// before it.
+template <typename Config, typename Schema>
+class Reader
+{
+public:
+  Reader(const Schema& schema, const SchemaIndex& index, Config& config, etcpal::Logger* log)
+      : schema_(schema), index_(index), config_(config), log_(log)
+  {
+  }
+
+  // Returns false if the document couldn't be parsed, or its root isn't an object. Documents can
+  // also be read from CBOR or any other format nlohmann can parse.
+  bool Parse(std::istream& stream, json::input_format_t format = json::input_format_t::json)
+  {
+    path_.clear();
+    container_path_lengths_.clear();
+    skip_depth_ = 0;
+    capture_stack_.clear();
+    root_is_object_ = true;
+
+    // Like operator>>, ignore anything after the end of a JSON document.
+    const bool strict = (format != json::input_format_t::json);
+    return json::sax_parse(stream, this, format, strict) && root_is_object_;
+  }
+
+  // Returns false if any setting was invalid.
+  bool Finish()
+  {
+    size_t index = 0;
+    ForEachField(schema_, [this, &index](const auto& field) {
+      const SettingState state = states_[index++];
+      if (state == SettingState::kStored)
+        return;
+
+      field.StoreDefault(config_);
+      if (state == SettingState::kMissing && log_)
+      {
+        log_->Debug("Configuration file: No value present for \"%.*s\", using default.",
+                    static_cast<int>(field.pointer.size()), field.pointer.data());
+      }
+    });
+    return all_valid_;
+  }
+
+  // The settings that were read from the documents and stored, as a document of the same form.
+  json StoredSettings() const
+  {
+    json   settings = json::object();
+    size_t index = 0;
+    ForEachField(schema_, [this, &settings, &index](const auto& field) {
+      if (states_[index++] == SettingState::kStored)
+      {
+        const Config& config = config_;
+        settings[json::json_pointer(std::string(field.pointer))] = field.rule.ToJson(field.access(config));
+      }
+    });
+    return settings;
+  }
+
+  // The SAX interface, called by the parser.
+  bool null() { return Value(json{}); }
+  bool boolean(bool val) { return Value(json(val)); }
+  bool number_integer(json::number_integer_t val) { return Value(json(val)); }
+  bool number_unsigned(json::number_unsigned_t val) { return Value(json(val)); }
+  bool number_float(json::number_float_t val, const json::string_t&) { return Value(json(val)); }
+  bool string(json::string_t& val) { return Value(json(std::move(val))); }
+  bool binary(json::binary_t& val) { return Value(json(json::binary_t(std::move(val)))); }
+  bool start_object(size_t) { return StartContainer(json::value_t::object); }
+  bool end_object() { return EndContainer(); }
+  bool start_array(size_t) { return StartContainer(json::value_t::array); }
+  bool end_array() { return EndContainer(); }
+
+  bool key(json::string_t& val)
+  {
+    key_.swap(val);
+    return true;
+  }
+
+  bool parse_error(size_t, const std::string&, const json::exception& ex)
+  {
+    if (log_)
+      log_->Notice("Could not parse configuration file: %s", ex.what());
+    return false;
+  }
+
+private:
+  enum class SettingState : uint8_t
+  {
+    kMissing,
+    kStored,
+    kDefault  // Null or invalid; the default is stored by Finish()
+  };
+
+  const Schema&      schema_;
+  const SchemaIndex& index_;
+  Config&            config_;
+  etcpal::Logger*    log_;
+
+  std::array<SettingState, FieldCount<Schema>::value> states_{};  // In schema order
+  bool                                                all_valid_{true};
+  bool                                                root_is_object_{true};
+
+  std::string         path_;  // The pointer to the object being read
+  std::vector<size_t> container_path_lengths_;
+  std::string         key_;
+  size_t              skip_depth_{0};  // Nesting depth within an array that isn't a setting
+
+  // The value of a setting that is an object or an array, while it's being read.
+  json               captured_;
+  std::vector<json*> capture_stack_;
+  std::string        capture_pointer_;
+
+  bool Value(json&& val)
+  {
+    if (skip_depth_ > 0)
+      return true;
+
+    if (!capture_stack_.empty())
+    {
+      AddToCapture(std::move(val));
+      return true;
+    }
+
+    if (container_path_lengths_.empty())
+    {
+      root_is_object_ = false;
+      return false;
+    }
+
+    const size_t path_length = path_.size();
+    AppendKeyToPath();
+    Store(path_, val);
+    path_.resize(path_length);
+    return true;
+  }
+
+  bool StartContainer(json::value_t type)
+  {
+    if (skip_depth_ > 0)
+    {
+      ++skip_depth_;
+      return true;
+    }
+
+    if (!capture_stack_.empty())
+    {
+      capture_stack_.push_back(&AddToCapture(json(type)));
+      return true;
+    }
+
+    if (container_path_lengths_.empty())
+    {
+      if (type != json::value_t::object)
+      {
+        root_is_object_ = false;
+        return false;
+      }
+      container_path_lengths_.push_back(0);
+      return true;
+    }
+
+    const size_t path_length = path_.size();
+    AppendKeyToPath();
+    if (index_.Find(path_) != SchemaIndex::kNotFound)
+    {
+      captured_ = json(type);
+      capture_stack_.push_back(&captured_);
+      capture_pointer_ = path_;
+      path_.resize(path_length);
+    }
+    else if (type == json::value_t::object)
+    {
+      container_path_lengths_.push_back(path_length);
+    }
+    else
+    {
+      skip_depth_ = 1;
+      path_.resize(path_length);
+    }
+    return true;
+  }
+
+  bool EndContainer()
+  {
+    if (skip_depth_ > 0)
+    {
+      --skip_depth_;
+    }
+    else if (!capture_stack_.empty())
+    {
+      capture_stack_.pop_back();
+      if (capture_stack_.empty())
+        Store(capture_pointer_, captured_);
+    }
+    else
+    {
+      path_.resize(container_path_lengths_.back());
+      container_path_lengths_.pop_back();
+    }
+    return true;
+  }
+
+  // Keys are escaped as in a JSON pointer (RFC 6901), so that a key containing '/' can't name a
+  // nested setting.
+  void AppendKeyToPath()
+  {
+    path_ += '/';
+    for (const char c : key_)
+    {
+      if (c == '~')
+        path_ += "~0";
+      else if (c == '/')
+        path_ += "~1";
+      else
+        path_ += c;
+    }
+  }
+
+  json& AddToCapture(json&& val)
+  {
+    json& container = *capture_stack_.back();
+    if (container.is_array())
+    {
+      container.push_back(std::move(val));
+      return container.back();
+    }
+    return (container[key_] = std::move(val));
+  }
+
+  void Store(std::string_view pointer, const json& val)
+  {
+    const size_t index = index_.Find(pointer);
+    if (index == SchemaIndex::kNotFound)
+      return;
+
+    SettingState& state = states_[index];
+    VisitField(schema_, index, [&](const auto& field) {
+      if (val.is_null())
+      {
+        state = SettingState::kDefault;
+      }
+      else if (val.type() != field.rule.type())
+      {
+        LogParseError(log_, "The value for setting \"%.*s\" was of invalid type \"%s\"",
+                      static_cast<int>(pointer.size()), pointer.data(), val.type_name());
+        state = SettingState::kDefault;
+        all_valid_ = false;
+      }
+      else if (field.Validate(val, config_, log_))
+      {
+        state = SettingState::kStored;
+      }
+      else
+      {
+        state = SettingState::kDefault;
+        all_valid_ = false;
+      }
+    });
+  }
+};
+
+template <typename Config, typename Schema>
+void SetDefaults(const Schema& schema, Config& config)
+{
+  ForEachField(schema, [&config](const auto& field) { field.StoreDefault(config); });
+}
+
+template <typename Config, typename Schema>
+typename Config::Diff Compare(const Schema& schema, const Config& old_config, const Config& new_config)
+{
+  typename Config::Diff diff;
+  ForEachField(schema, [&](const auto& field) { field.Compare(old_config, new_config, diff); });
+  return diff;
+}
+
+// One line per setting: its pointer, allowed values, default and description.
+template <typename Schema>
+std::string Document(const Schema& schema)
+{
+  std::string doc;
+  ForEachField(schema, [&doc](const auto& field) { doc += field.Document() + "\n"; });
+  return doc;
+}
+
+}  // namespace config_schema
+
+#endif  // CONFIG_SCHEMA_H_
@@ -0,0 +1,99 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "config_watcher.h"
+
+#include <fstream>
+#include <utility>
+
+ConfigWatcher::ConfigWatcher(NotifyHandler& handler, uint32_t debounce_ms, ClockFunction clock)
+    : handler_(handler), debounce_ms_(debounce_ms), clock_(std::move(clock))
+{
+}
+
+bool ConfigWatcher::Start(const std::string& path, const BrokerConfig& config, etcpal::Logger* log)
+{
+  path_ = path;
+  config_ = config;
+  hash_ = BrokerConfig::HashFiles(path);
+  log_ = log;
+  check_pending_ = false;
+  return true;
+}
+
+void ConfigWatcher::Stop()
+{
+  check_pending_ = false;
+}
+
+// Each event pushes the check back, so it is made once the burst is over.
+void ConfigWatcher::EventReceived()
+{
+  check_pending_ = true;
+  last_event_ms_ = clock_();
+}
+
+int ConfigWatcher::TimeUntilCheck() const
+{
+  if (!check_pending_)
+    return -1;
+
+  const uint64_t elapsed = clock_() - last_event_ms_;
+  return (elapsed >= debounce_ms_) ? 0 : static_cast<int>(debounce_ms_ - elapsed);
+}
+
+bool ConfigWatcher::CheckIfDue()
+{
+  if (TimeUntilCheck() != 0)
+    return false;
+  check_pending_ = false;
+
+  const uint64_t hash = BrokerConfig::HashFiles(path_);
+  if (hash == hash_)
+  {
+    if (log_)
+      log_->Debug("The configuration files were written, but their contents did not change.");
+    return false;
+  }
+  hash_ = hash;
+
+  // Read into a copy, so that settings left at their defaults keep the same values (e.g. the
+  // default CID).
+  BrokerConfig  new_config = config_;
+  std::ifstream file(path_);
+  const auto    result = new_config.ReadFile(path_, file, log_);
+  if (result != BrokerConfig::ParseResult::kOk && result != BrokerConfig::ParseResult::kInvalidSetting)
+  {
+    if (log_)
+      log_->Notice("The changed configuration could not be read - keeping the current configuration.");
+    return false;
+  }
+
+  const auto diff = BrokerConfig::Compare(config_, new_config);
+  config_ = std::move(new_config);
+  if (diff.Empty())
+  {
+    if (log_)
+      log_->Debug("The configuration files changed, but none of the settings did.");
+    return false;
+  }
+
+  handler_.HandleConfigChanged(config_, diff);
+  return true;
+}
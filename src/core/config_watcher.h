@@ -0,0 +1,97 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef CONFIG_WATCHER_H_
+#define CONFIG_WATCHER_H_
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include "etcpal/cpp/log.h"
+#include "broker_common.h"
+#include "broker_config.h"
+
+// ConfigWatcher : Decides when changes to the configuration file, and to the fragments merged over
+// it, are worth telling the shell about.
+//
+// Platform implementations call EventReceived() for each file system event that may have changed
+// the files. A burst of events (an editor saving in several writes, or a deployment tool copying in
+// several fragments) is coalesced: the files are only looked at once no event has arrived for the
+// debounce window. Nothing happens if their contents hash the same as they did the last time they
+// were looked at. Otherwise they are read, and if any setting changed, the handler is given the new
+// configuration along with the settings that differ. Whoever drives the watcher waits for at most
+// TimeUntilCheck() and then calls CheckIfDue().
+//
+// A ConfigWatcher is not thread-safe; it is meant to be driven from a single thread.
+class ConfigWatcher
+{
+public:
+  class NotifyHandler
+  {
+  public:
+    virtual ~NotifyHandler() = default;
+
+    virtual void HandleConfigChanged(const BrokerConfig& new_config, const BrokerConfig::Diff& diff) = 0;
+  };
+
+  // Returns a monotonic time in milliseconds.
+  using ClockFunction = std::function<uint64_t()>;
+
+  static constexpr uint32_t kDefaultDebounceMs = 500u;
+
+  explicit ConfigWatcher(NotifyHandler& handler,
+                         uint32_t       debounce_ms = kDefaultDebounceMs,
+                         ClockFunction  clock = SteadyClockMs);
+  virtual ~ConfigWatcher() = default;
+
+  ConfigWatcher(const ConfigWatcher&) = delete;
+  ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+  // Start watching the configuration file at path. config holds the settings currently read from
+  // it; changes are reported relative to it.
+  virtual bool Start(const std::string& path, const BrokerConfig& config, etcpal::Logger* log = nullptr);
+  virtual void Stop();
+
+  void EventReceived();
+
+  // Milliseconds until the pending check is due, or -1 if there is none.
+  int  TimeUntilCheck() const;
+  // Returns true if the check was made and the handler was called.
+  bool CheckIfDue();
+
+  const std::string& path() const { return path_; }
+
+protected:
+  etcpal::Logger* log() const { return log_; }
+
+private:
+  NotifyHandler&      handler_;
+  const uint32_t      debounce_ms_;
+  const ClockFunction clock_;
+
+  std::string     path_;
+  BrokerConfig    config_;
+  uint64_t        hash_{0};
+  etcpal::Logger* log_{nullptr};
+
+  bool     check_pending_{false};
+  uint64_t last_event_ms_{0};
+};
+
+#endif  // CONFIG_WATCHER_H_
@@ -0,0 +1,227 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "flight_recorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include "binary_log_record.h"
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// The crash dump target is kept in fixed storage so that DumpForCrash() doesn't need the heap.
+static std::atomic<const FlightRecorder*> crash_dump_recorder{nullptr};
+static char                               crash_dump_path[1024];
+
+// The timestamp is packed into two words so that it can be kept in atomics.
+static void PackTimestamp(const EtcPalLogTimestamp& t, uint64_t& date, uint64_t& time)
+{
+  date = (static_cast<uint64_t>(t.year & 0xffffu) << 32) | ((t.month & 0xffu) << 24) | ((t.day & 0xffu) << 16) |
+         ((t.hour & 0xffu) << 8) | (t.minute & 0xffu);
+  time = (static_cast<uint64_t>(t.second & 0xffffu) << 48) | (static_cast<uint64_t>(t.msec & 0xffffu) << 32) |
+         static_cast<uint32_t>(t.utc_offset);
+}
+
+static void UnpackTimestamp(uint64_t date, uint64_t time, EtcPalLogTimestamp& t)
+{
+  t.year = static_cast<unsigned int>((date >> 32) & 0xffffu);
+  t.month = static_cast<unsigned int>((date >> 24) & 0xffu);
+  t.day = static_cast<unsigned int>((date >> 16) & 0xffu);
+  t.hour = static_cast<unsigned int>((date >> 8) & 0xffu);
+  t.minute = static_cast<unsigned int>(date & 0xffu);
+  t.second = static_cast<unsigned int>((time >> 48) & 0xffffu);
+  t.msec = static_cast<unsigned int>((time >> 32) & 0xffffu);
+  t.utc_offset = static_cast<int32_t>(static_cast<uint32_t>(time & 0xffffffffu));
+}
+
+FlightRecorder::FlightRecorder(size_t capacity)
+    : capacity_(std::max<size_t>(capacity, 1)), slots_(std::make_unique<Slot[]>(capacity_))
+{
+}
+
+void FlightRecorder::Record(const EtcPalLogStrings& strings)
+{
+  const uint64_t position = next_position_.fetch_add(1, std::memory_order_relaxed);
+  Slot&          slot = slots_[position % capacity_];
+
+  slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.has_timestamp.store(strings.log_timestamp != nullptr, std::memory_order_relaxed);
+  if (strings.log_timestamp)
+  {
+    uint64_t date = 0;
+    uint64_t time = 0;
+    PackTimestamp(*strings.log_timestamp, date, time);
+    slot.date.store(date, std::memory_order_relaxed);
+    slot.time.store(time, std::memory_order_relaxed);
+  }
+  slot.priority.store(strings.priority, std::memory_order_relaxed);
+
+  size_t length = 0;
+  if (strings.raw)
+  {
+    for (; length < kMaxMessageLength && strings.raw[length] != '\0'; ++length)
+      slot.message[length].store(strings.raw[length], std::memory_order_relaxed);
+  }
+  slot.length.store(static_cast<uint16_t>(length), std::memory_order_relaxed);
+
+  slot.sequence.store(2 * position + 2, std::memory_order_release);
+}
+
+bool FlightRecorder::DumpToFile(const std::string& path, const char* reason) const
+{
+  FILE* file = std::fopen(path.c_str(), "w");
+  if (!file)
+    return false;
+
+  std::fprintf(file, "RDMnet Broker flight recorder dump (%s)\n", reason ? reason : "requested");
+  Dump(file);
+  return (std::fclose(file) == 0);
+}
+
+void FlightRecorder::Dump(FILE* file) const
+{
+  FormatRecords([file](const char* line, size_t length) { std::fwrite(line, 1, length, file); });
+  std::fflush(file);
+}
+
+std::string FlightRecorder::DumpToString() const
+{
+  std::string dump;
+  FormatRecords([&dump](const char* line, size_t length) { dump.append(line, length); });
+  return dump;
+}
+
+// Format each recorded message as a line, oldest first, and pass it to write_line. Lines are built
+// on the stack, so this doesn't allocate unless write_line does.
+template <typename WriteLine>
+void FlightRecorder::FormatRecords(WriteLine&& write_line) const
+{
+  const uint64_t end = next_position_.load(std::memory_order_acquire);
+  const uint64_t begin = (end > capacity_) ? (end - capacity_) : 0;
+
+  SlotCopy copy;
+  char     line[kMaxMessageLength + 64];
+  for (uint64_t position = begin; position < end; ++position)
+  {
+    if (!ReadSlot(position, copy))
+      continue;
+
+    // One byte is kept for the newline.
+    size_t length = BinaryLogRecord::FormatText(copy.has_timestamp ? &copy.timestamp : nullptr, copy.priority,
+                                                copy.message, copy.length, line, sizeof(line) - 1);
+    line[length++] = '\n';
+    write_line(line, length);
+  }
+}
+
+void FlightRecorder::SetCrashDumpTarget(const FlightRecorder* recorder, const std::string& path)
+{
+  crash_dump_recorder = nullptr;
+  if (recorder && path.size() < sizeof(crash_dump_path))
+  {
+    std::memcpy(crash_dump_path, path.c_str(), path.size() + 1);
+    crash_dump_recorder = recorder;
+  }
+}
+
+#ifdef _WIN32
+
+// Windows calls this from an unhandled exception filter, not a signal handler, so stdio is fine.
+void FlightRecorder::DumpForCrash(const char* reason)
+{
+  const FlightRecorder* recorder = crash_dump_recorder.load();
+  if (!recorder)
+    return;
+
+  FILE* file = std::fopen(crash_dump_path, "w");
+  if (file)
+  {
+    std::fprintf(file, "RDMnet Broker flight recorder dump (%s)\n", reason ? reason : "crash");
+    recorder->Dump(file);
+    std::fclose(file);
+  }
+}
+
+#else
+
+static void WriteAll(int fd, const char* data, size_t length)
+{
+  while (length > 0)
+  {
+    const ssize_t written = write(fd, data, length);
+    if (written < 0 && errno == EINTR)
+      continue;
+    if (written <= 0)
+      return;
+    data += written;
+    length -= static_cast<size_t>(written);
+  }
+}
+
+// Called from signal handlers, so this only uses async-signal-safe calls, and the stack.
+void FlightRecorder::DumpForCrash(const char* reason)
+{
+  const FlightRecorder* recorder = crash_dump_recorder.load();
+  if (!recorder)
+    return;
+
+  const int fd = open(crash_dump_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (fd == -1)
+    return;
+
+  static constexpr char kHeader[] = "RDMnet Broker flight recorder dump (";
+  if (!reason)
+    reason = "crash";
+  WriteAll(fd, kHeader, sizeof(kHeader) - 1);
+  WriteAll(fd, reason, std::strlen(reason));
+  WriteAll(fd, ")\n", 2);
+
+  recorder->FormatRecords([fd](const char* line, size_t line_length) { WriteAll(fd, line, line_length); });
+  close(fd);
+}
+
+#endif
+
+// Copy a slot, returning false if it has been overwritten since position was recorded or is being
+// written right now.
+bool FlightRecorder::ReadSlot(uint64_t position, SlotCopy& copy) const
+{
+  const Slot&    slot = slots_[position % capacity_];
+  const uint64_t expected_sequence = 2 * position + 2;
+
+  if (slot.sequence.load(std::memory_order_acquire) != expected_sequence)
+    return false;
+
+  copy.has_timestamp = slot.has_timestamp.load(std::memory_order_relaxed);
+  UnpackTimestamp(slot.date.load(std::memory_order_relaxed), slot.time.load(std::memory_order_relaxed),
+                  copy.timestamp);
+  copy.priority = slot.priority.load(std::memory_order_relaxed);
+  copy.length = std::min<uint16_t>(slot.length.load(std::memory_order_relaxed), kMaxMessageLength);
+  for (uint16_t i = 0; i < copy.length; ++i)
+    copy.message[i] = slot.message[i].load(std::memory_order_relaxed);
+
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return (slot.sequence.load(std::memory_order_relaxed) == expected_sequence);
+}
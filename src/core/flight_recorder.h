@@ -0,0 +1,97 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef FLIGHT_RECORDER_H_
+#define FLIGHT_RECORDER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "etcpal/log.h"
+
+// FlightRecorder : Keeps the most recent log messages of every priority in memory, so that debug
+// detail is available after a failure even when the log file only gets higher-priority messages.
+//
+// All of the memory is allocated up front. Record() copies the message into the next slot of a
+// ring, overwriting the oldest message once the ring is full, and never blocks or allocates. A dump
+// can be taken from any thread while messages are being recorded; slots that are being written at
+// that moment are skipped.
+class FlightRecorder
+{
+public:
+  static constexpr size_t kMaxMessageLength = 256;  // Longer messages are truncated
+
+  explicit FlightRecorder(size_t capacity);
+
+  void Record(const EtcPalLogStrings& strings);
+
+  // Write the recorded messages to a file, oldest first, replacing any previous dump. reason is
+  // written in the header line.
+  bool DumpToFile(const std::string& path, const char* reason) const;
+  void Dump(FILE* file) const;
+  // The same lines as Dump() writes.
+  std::string DumpToString() const;
+
+  size_t capacity() const { return capacity_; }
+
+  // The recorder that DumpForCrash() writes out, and where. The process can have only one.
+  static void SetCrashDumpTarget(const FlightRecorder* recorder, const std::string& path);
+  // Dump the crash dump target, if any. For use from crash handlers and failed assertions; it
+  // doesn't allocate, and on POSIX systems it is async-signal-safe.
+  static void DumpForCrash(const char* reason);
+
+private:
+  // A slot is a seqlock: a dump can read it while it is being overwritten, and uses the sequence to
+  // tell whether what it read is whole. The fields are atomics, accessed with relaxed ordering, so
+  // that the racing reads are still well-defined.
+  struct Slot
+  {
+    // Odd while the slot is being written; otherwise 2 * (the record's position + 1).
+    std::atomic<uint64_t> sequence{0};
+    std::atomic<uint64_t> date{0};  // The timestamp, packed; see PackTimestamp()
+    std::atomic<uint64_t> time{0};
+    std::atomic<bool>     has_timestamp{false};
+    std::atomic<int>      priority{0};
+    std::atomic<uint16_t> length{0};
+    std::atomic<char>     message[kMaxMessageLength];
+  };
+
+  // A copy of a slot that was read whole.
+  struct SlotCopy
+  {
+    EtcPalLogTimestamp timestamp;
+    bool               has_timestamp;
+    int                priority;
+    uint16_t           length;
+    char               message[kMaxMessageLength];
+  };
+
+  const size_t            capacity_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<uint64_t>   next_position_{0};
+
+  bool ReadSlot(uint64_t position, SlotCopy& copy) const;
+  template <typename WriteLine>
+  void FormatRecords(WriteLine&& write_line) const;
+};
+
+#endif  // FLIGHT_RECORDER_H_
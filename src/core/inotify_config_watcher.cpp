@@ -0,0 +1,118 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "inotify_config_watcher.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <filesystem>
+
+static constexpr uint32_t kDirEvents = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+
+InotifyConfigWatcher::~InotifyConfigWatcher()
+{
+  Stop();
+}
+
+bool InotifyConfigWatcher::Start(const std::string& path, const BrokerConfig& config, etcpal::Logger* log)
+{
+  Stop();
+  ConfigWatcher::Start(path, config, log);
+
+  const std::filesystem::path file_path(path);
+  dir_ = file_path.parent_path().string();
+  file_name_ = file_path.filename().string();
+
+  fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd_ < 0)
+    return false;
+
+  dir_watch_ = inotify_add_watch(fd_, dir_.c_str(), kDirEvents);
+  if (dir_watch_ < 0)
+  {
+    Stop();
+    return false;
+  }
+  WatchFragmentDir();
+  return true;
+}
+
+void InotifyConfigWatcher::Stop()
+{
+  if (fd_ >= 0)
+    close(fd_);
+  fd_ = -1;
+  dir_watch_ = -1;
+  fragment_dir_watch_ = -1;
+  ConfigWatcher::Stop();
+}
+
+void InotifyConfigWatcher::Receive()
+{
+  alignas(struct inotify_event) char buf[4096];
+
+  ssize_t size;
+  while (fd_ >= 0 && (size = read(fd_, buf, sizeof(buf))) > 0)
+  {
+    for (ssize_t offset = 0; offset < size;)
+    {
+      const auto*       event = reinterpret_cast<const struct inotify_event*>(&buf[offset]);
+      const std::string name = (event->len > 0) ? event->name : "";
+      offset += static_cast<ssize_t>(sizeof(struct inotify_event) + event->len);
+
+      // Events were lost, and may have included a change. Checking costs no more than hashing the
+      // files, which finds nothing to do if they haven't changed. The fragment directory may have
+      // been created among the lost events, too.
+      if (event->mask & IN_Q_OVERFLOW)
+      {
+        if (fragment_dir_watch_ < 0)
+          WatchFragmentDir();
+        EventReceived();
+      }
+      else if (event->wd == dir_watch_)
+      {
+        if (name == file_name_)
+        {
+          EventReceived();
+        }
+        else if (name == BrokerConfig::kFragmentDirectory && (event->mask & IN_ISDIR) &&
+                 (event->mask & (IN_CREATE | IN_MOVED_TO)))
+        {
+          WatchFragmentDir();
+          EventReceived();
+        }
+      }
+      else if (event->wd == fragment_dir_watch_)
+      {
+        if (event->mask & IN_IGNORED)  // The directory was removed
+          fragment_dir_watch_ = -1;
+        EventReceived();
+      }
+    }
+  }
+}
+
+// The fragment directory may not exist yet; it is watched once it is created.
+void InotifyConfigWatcher::WatchFragmentDir()
+{
+  const std::string fragment_dir = dir_ + "/" + BrokerConfig::kFragmentDirectory;
+  fragment_dir_watch_ = inotify_add_watch(fd_, fragment_dir.c_str(), kDirEvents | IN_ONLYDIR);
+}
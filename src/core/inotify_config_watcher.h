@@ -0,0 +1,57 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef INOTIFY_CONFIG_WATCHER_H_
+#define INOTIFY_CONFIG_WATCHER_H_
+
+#include <string>
+#include "config_watcher.h"
+
+// InotifyConfigWatcher : The Linux ConfigWatcher, which watches the directory holding the
+// configuration file, and the fragment directory in it, with inotify.
+//
+// The directories are watched rather than the files, so that files replaced by a rename (as most
+// editors save them) keep being watched. Only events for the configuration file and fragment
+// directory count; the snapshot written next to the file when it is read does not. The inotify
+// descriptor is non-blocking, so Receive() can be called whenever fd() is readable.
+class InotifyConfigWatcher : public ConfigWatcher
+{
+public:
+  using ConfigWatcher::ConfigWatcher;
+  ~InotifyConfigWatcher() override;
+
+  bool Start(const std::string& path, const BrokerConfig& config, etcpal::Logger* log = nullptr) override;
+  void Stop() override;
+
+  int fd() const { return fd_; }
+
+  // Read everything waiting on the inotify descriptor.
+  void Receive();
+
+private:
+  int         fd_{-1};
+  int         dir_watch_{-1};
+  int         fragment_dir_watch_{-1};
+  std::string dir_;
+  std::string file_name_;
+
+  void WatchFragmentDir();
+};
+
+#endif  // INOTIFY_CONFIG_WATCHER_H_
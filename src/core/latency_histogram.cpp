@@ -0,0 +1,156 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "latency_histogram.h"
+
+#include <cmath>
+#include <cstdio>
+
+LatencyHistogram::LatencyHistogram() : shards_(std::make_unique<Shard[]>(kNumShards))
+{
+  for (size_t shard = 0; shard < kNumShards; ++shard)
+  {
+    for (auto& count : shards_[shard].counts)
+      count.store(0, std::memory_order_relaxed);
+    shards_[shard].sum.store(0, std::memory_order_relaxed);
+  }
+}
+
+void LatencyHistogram::Record(uint64_t value_us)
+{
+  if (value_us > kMaxValue)
+    value_us = kMaxValue;
+
+  Shard& shard = shards_[ThisThreadShard()];
+  shard.counts[BucketIndex(value_us)].fetch_add(1, std::memory_order_relaxed);
+  shard.sum.fetch_add(value_us, std::memory_order_relaxed);
+}
+
+// Values recorded while the shards are being read may or may not be included.
+LatencyHistogram::Snapshot LatencyHistogram::Read() const
+{
+  Snapshot snapshot;
+  snapshot.counts.assign(kNumBuckets, 0);
+  for (size_t shard = 0; shard < kNumShards; ++shard)
+  {
+    for (size_t i = 0; i < kNumBuckets; ++i)
+    {
+      const uint64_t count = shards_[shard].counts[i].load(std::memory_order_relaxed);
+      snapshot.counts[i] += count;
+      snapshot.count += count;
+    }
+    snapshot.sum += shards_[shard].sum.load(std::memory_order_relaxed);
+  }
+  return snapshot;
+}
+
+// Values below kSubBucketCount get a bucket each. Above that, the value's highest set bit picks
+// the power of two, and the next kSubBucketBits bits pick the bucket within it.
+size_t LatencyHistogram::BucketIndex(uint64_t value)
+{
+  if (value < kSubBucketCount)
+    return static_cast<size_t>(value);
+
+  unsigned int highest_bit = 0;
+  for (uint64_t v = value; v > 1; v >>= 1)
+    ++highest_bit;
+
+  const unsigned int shift = highest_bit - kSubBucketBits;
+  const uint64_t     sub_bucket = (value >> shift) - kSubBucketCount;
+  return (shift + 1) * kSubBucketCount + static_cast<size_t>(sub_bucket);
+}
+
+uint64_t LatencyHistogram::BucketLowerBound(size_t index)
+{
+  if (index < kSubBucketCount)
+    return index;
+
+  const size_t shift = index / kSubBucketCount - 1;
+  return (kSubBucketCount + index % kSubBucketCount) << shift;
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index)
+{
+  if (index < kSubBucketCount)
+    return index;
+
+  const size_t shift = index / kSubBucketCount - 1;
+  return BucketLowerBound(index) + (uint64_t{1} << shift) - 1;
+}
+
+// Threads are spread over the shards in the order they first record into any histogram.
+size_t LatencyHistogram::ThisThreadShard()
+{
+  static std::atomic<size_t> next_shard{0};
+  thread_local const size_t  shard = next_shard.fetch_add(1, std::memory_order_relaxed) % kNumShards;
+  return shard;
+}
+
+uint64_t LatencyHistogram::Snapshot::ValueAtQuantile(double quantile) const
+{
+  if (count == 0)
+    return 0;
+
+  uint64_t rank = static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(count)));
+  if (rank < 1)
+    rank = 1;
+  if (rank > count)
+    rank = count;
+
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < counts.size(); ++i)
+  {
+    cumulative += counts[i];
+    if (cumulative >= rank)
+      return BucketUpperBound(i);
+  }
+  return BucketUpperBound(counts.size() - 1);
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::Snapshot::Since(const Snapshot& earlier) const
+{
+  Snapshot difference = *this;
+  if (earlier.counts.size() != counts.size())
+    return difference;
+
+  for (size_t i = 0; i < counts.size(); ++i)
+    difference.counts[i] -= earlier.counts[i];
+  difference.count -= earlier.count;
+  difference.sum -= earlier.sum;
+  return difference;
+}
+
+static std::string FormatDuration(uint64_t value_us)
+{
+  char buf[32];
+  if (value_us < 1000)
+    snprintf(buf, sizeof(buf), "%uus", static_cast<unsigned int>(value_us));
+  else if (value_us < 1000000)
+    snprintf(buf, sizeof(buf), "%.1fms", static_cast<double>(value_us) / 1000.0);
+  else
+    snprintf(buf, sizeof(buf), "%.2fs", static_cast<double>(value_us) / 1000000.0);
+  return buf;
+}
+
+std::string LatencyHistogram::Snapshot::ToString() const
+{
+  return "p50=" + FormatDuration(ValueAtQuantile(0.5)) + " p99=" + FormatDuration(ValueAtQuantile(0.99)) +
+         " p99.9=" + FormatDuration(ValueAtQuantile(0.999)) + " max=" + FormatDuration(Max()) +
+         " n=" + std::to_string(count);
+}
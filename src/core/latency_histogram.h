@@ -0,0 +1,116 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// LatencyHistogram : Records durations, in microseconds, into log-bucketed buckets in the style of
+// HdrHistogram, for reading off percentiles.
+//
+// Each power of two is split into 16 equal buckets, so a percentile read from the histogram is
+// within 1/16 (6.25%) of the true value, at any scale from 1 us to the largest value recorded
+// (about 19 hours; longer durations are counted as that).
+//
+// Recording is lock-free and wait-free. Each thread records into one of a few shards, which are on
+// separate cache lines, so threads don't contend with each other; the shards are merged only when
+// the histogram is read.
+class LatencyHistogram
+{
+public:
+  static constexpr unsigned int kSubBucketBits = 4;
+  static constexpr size_t       kSubBucketCount = size_t{1} << kSubBucketBits;
+  static constexpr unsigned int kMaxValueBits = 36;
+  static constexpr uint64_t     kMaxValue = (uint64_t{1} << kMaxValueBits) - 1;
+  static constexpr size_t       kNumBuckets = (kMaxValueBits - kSubBucketBits + 1) * kSubBucketCount;
+  static constexpr size_t       kNumShards = 8;
+
+  struct Snapshot
+  {
+    std::vector<uint64_t> counts;  // Per bucket; empty if nothing was recorded
+    uint64_t              count{0};
+    uint64_t              sum{0};
+
+    // The value below which the given fraction (0 to 1) of recorded values fall, to the bucket's
+    // precision. 0 if nothing was recorded.
+    uint64_t ValueAtQuantile(double quantile) const;
+    uint64_t Max() const { return ValueAtQuantile(1.0); }
+
+    // What was recorded after an earlier snapshot of the same histogram was taken.
+    Snapshot Since(const Snapshot& earlier) const;
+
+    // e.g. "p50=120us p99=950us p99.9=1.9ms max=2.0ms n=1042"
+    std::string ToString() const;
+  };
+
+  // Records the time from its construction to its destruction.
+  class ScopedTimer
+  {
+  public:
+    explicit ScopedTimer(LatencyHistogram& histogram)
+        : histogram_(histogram), begin_(std::chrono::steady_clock::now())
+    {
+    }
+    ~ScopedTimer()
+    {
+      const auto elapsed = std::chrono::steady_clock::now() - begin_;
+      histogram_.Record(
+          static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+    }
+
+    ScopedTimer(const ScopedTimer& other) = delete;
+    ScopedTimer& operator=(const ScopedTimer& other) = delete;
+
+  private:
+    LatencyHistogram&                     histogram_;
+    std::chrono::steady_clock::time_point begin_;
+  };
+
+  LatencyHistogram();
+
+  LatencyHistogram(const LatencyHistogram& other) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram& other) = delete;
+
+  void     Record(uint64_t value_us);
+  Snapshot Read() const;
+
+  static size_t   BucketIndex(uint64_t value);
+  static uint64_t BucketLowerBound(size_t index);
+  static uint64_t BucketUpperBound(size_t index);  // The highest value that falls in the bucket
+
+private:
+  struct alignas(64) Shard
+  {
+    std::atomic<uint64_t> counts[kNumBuckets];
+    std::atomic<uint64_t> sum;
+  };
+
+  std::unique_ptr<Shard[]> shards_;
+
+  static size_t ThisThreadShard();
+};
+
+#endif  // LATENCY_HISTOGRAM_H_
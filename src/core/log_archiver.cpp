@@ -0,0 +1,345 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "log_archiver.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <utility>
+#include <vector>
+
+#ifdef RDMNETBROKER_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static constexpr char   kPendingFileInfix[] = ".pending.";
+static constexpr size_t kCompressChunkSize = 64 * 1024;
+
+#ifdef RDMNETBROKER_HAVE_ZLIB
+// Write a gzip-compatible copy of src_path to dest_path.
+static bool GzipFile(const fs::path& src_path, const fs::path& dest_path)
+{
+  std::ifstream src_file(src_path, std::ios::binary);
+  std::ofstream dest_file(dest_path, std::ios::binary | std::ios::trunc);
+  if (!src_file.is_open() || !dest_file.is_open())
+    return false;
+
+  // A window size of 15 + 16 selects the maximum window with a gzip header and trailer.
+  z_stream stream{};
+  if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    return false;
+
+  std::vector<char> in_buf(kCompressChunkSize);
+  std::vector<char> out_buf(kCompressChunkSize);
+
+  int flush = Z_NO_FLUSH;
+  do
+  {
+    src_file.read(in_buf.data(), static_cast<std::streamsize>(in_buf.size()));
+    if (src_file.bad())
+      break;
+
+    stream.next_in = reinterpret_cast<Bytef*>(in_buf.data());
+    stream.avail_in = static_cast<uInt>(src_file.gcount());
+    flush = src_file.eof() ? Z_FINISH : Z_NO_FLUSH;
+
+    do
+    {
+      stream.next_out = reinterpret_cast<Bytef*>(out_buf.data());
+      stream.avail_out = static_cast<uInt>(out_buf.size());
+      deflate(&stream, flush);
+      dest_file.write(out_buf.data(), static_cast<std::streamsize>(out_buf.size() - stream.avail_out));
+    } while (stream.avail_out == 0);
+  } while (flush != Z_FINISH);
+
+  deflateEnd(&stream);
+  dest_file.close();
+  return (flush == Z_FINISH) && !dest_file.fail();
+}
+#endif
+
+LogArchiver::~LogArchiver()
+{
+  Shutdown();
+}
+
+bool LogArchiver::Startup(const fs::path& log_file_path,
+                          const Settings& settings,
+                          ErrorHandler    error_handler,
+                          ThreadInitHook  thread_init)
+{
+  {
+    etcpal::MutexGuard guard(lock_);
+    if (running_)
+      return false;
+
+    log_file_path_ = log_file_path;
+    settings_ = settings;
+    error_handler_ = std::move(error_handler);
+    thread_init_ = std::move(thread_init);
+    running_ = true;
+
+    // Pick up any files that were rotated out but not archived before the last shutdown.
+    QueueLeftoverPendingFiles();
+  }
+
+  if (!archiver_thread_.Start([this]() { ArchiverThread(); }).IsOk())
+  {
+    etcpal::MutexGuard guard(lock_);
+    running_ = false;
+    return false;
+  }
+
+  wake_signal_.Notify();
+  return true;
+}
+
+// Files still waiting to be archived when this is called are left in place and picked up by the
+// next Startup().
+void LogArchiver::Shutdown()
+{
+  {
+    etcpal::MutexGuard guard(lock_);
+    if (!running_)
+      return;
+    running_ = false;
+  }
+
+  wake_signal_.Notify();
+  archiver_thread_.Join();
+}
+
+void LogArchiver::SetSettings(const Settings& settings)
+{
+  {
+    etcpal::MutexGuard guard(lock_);
+    settings_ = settings;
+  }
+
+  // The retention limits may have gone down.
+  wake_signal_.Notify();
+}
+
+// Move the log file out of the way and queue it to be archived. This is a single rename, so it is
+// quick no matter how large the log files are.
+std::error_code LogArchiver::RotateOut()
+{
+  etcpal::MutexGuard guard(lock_);
+  if (!running_)
+    return std::make_error_code(std::errc::operation_not_permitted);
+
+  fs::path pending_path = log_file_path_;
+  pending_path += kPendingFileInfix + std::to_string(next_pending_number_++);
+
+  std::error_code ec;
+  fs::rename(log_file_path_, pending_path, ec);
+  if (!ec)
+  {
+    pending_.push_back(pending_path);
+    wake_signal_.Notify();
+  }
+  return ec;
+}
+
+bool LogArchiver::CompressionSupported()
+{
+#ifdef RDMNETBROKER_HAVE_ZLIB
+  return true;
+#else
+  return false;
+#endif
+}
+
+fs::path LogArchiver::BackupPath(const fs::path& log_file_path, unsigned int backup_number, bool compressed)
+{
+  fs::path path = log_file_path;
+  if (backup_number != 0)
+    path += "." + std::to_string(backup_number);
+  if (compressed)
+    path += ".gz";
+  return path;
+}
+
+void LogArchiver::ArchiverThread()
+{
+  if (thread_init_)
+    thread_init_();
+
+  while (true)
+  {
+    wake_signal_.Wait();
+
+    // Work through everything that has been rotated out. The lock is only held to take files off
+    // the queue, so RotateOut() never waits on the file operations here.
+    while (true)
+    {
+      fs::path pending_path;
+      Settings settings;
+      {
+        etcpal::MutexGuard guard(lock_);
+        if (!running_)
+          return;
+
+        settings = settings_;
+        if (!pending_.empty())
+        {
+          pending_path = pending_.front();
+          pending_.pop_front();
+        }
+      }
+
+      if (pending_path.empty())
+      {
+        EnforceRetention(settings);
+        break;
+      }
+
+      ArchivePendingFile(pending_path, settings);
+    }
+  }
+}
+
+// Only called with lock_ held, from Startup().
+void LogArchiver::QueueLeftoverPendingFiles()
+{
+  const std::string prefix = log_file_path_.filename().string() + kPendingFileInfix;
+
+  std::vector<std::pair<uint64_t, fs::path>> leftovers;
+
+  std::error_code ec;
+  for (fs::directory_iterator it(log_file_path_.parent_path(), ec), end; !ec && it != end; it.increment(ec))
+  {
+    const std::string name = it->path().filename().string();
+    if (name.compare(0, prefix.size(), prefix) == 0)
+    {
+      const uint64_t number = std::strtoull(name.c_str() + prefix.size(), nullptr, 10);
+      leftovers.emplace_back(number, it->path());
+    }
+  }
+
+  std::sort(leftovers.begin(), leftovers.end());
+  for (auto& leftover : leftovers)
+  {
+    pending_.push_back(std::move(leftover.second));
+    next_pending_number_ = std::max(next_pending_number_, leftover.first + 1);
+  }
+}
+
+void LogArchiver::ArchivePendingFile(const fs::path& pending_path, const Settings& settings)
+{
+  // Shift each backup to the next higher number, starting with the highest and working down. A
+  // backup can exist both compressed and not if compression was interrupted; both are moved.
+  unsigned int highest_backup = 0;
+  while (BackupExists(highest_backup + 1))
+    ++highest_backup;
+
+  for (unsigned int backup_number = highest_backup; backup_number > 0; --backup_number)
+  {
+    for (bool compressed : {false, true})
+    {
+      const fs::path src_path = BackupPath(log_file_path_, backup_number, compressed);
+
+      std::error_code ec;
+      if (!fs::exists(src_path, ec))
+        continue;
+
+      fs::rename(src_path, BackupPath(log_file_path_, backup_number + 1, compressed), ec);
+      if (ec)
+      {
+        // Leave the pending file where it is; it will be picked up again on the next startup.
+        ReportError("Couldn't rename \"" + src_path.string() + "\"", ec);
+        return;
+      }
+    }
+  }
+
+  const fs::path backup_path = BackupPath(log_file_path_, 1);
+
+  std::error_code ec;
+  fs::rename(pending_path, backup_path, ec);
+  if (ec)
+  {
+    ReportError("Couldn't rename \"" + pending_path.string() + "\"", ec);
+    return;
+  }
+
+#ifdef RDMNETBROKER_HAVE_ZLIB
+  if (settings.compress)
+  {
+    const fs::path compressed_path = BackupPath(log_file_path_, 1, true);
+    if (GzipFile(backup_path, compressed_path))
+    {
+      fs::remove(backup_path, ec);
+    }
+    else
+    {
+      ReportError("Couldn't compress \"" + backup_path.string() + "\"");
+      fs::remove(compressed_path, ec);
+    }
+  }
+#endif
+
+  EnforceRetention(settings);
+}
+
+// Delete the oldest backups until both the file count and total size limits are met.
+void LogArchiver::EnforceRetention(const Settings& settings)
+{
+  uint64_t     total_size = 0;
+  unsigned int backup_number = 1;
+  for (; BackupExists(backup_number); ++backup_number)
+  {
+    for (bool compressed : {false, true})
+    {
+      std::error_code ec;
+      const auto      size = fs::file_size(BackupPath(log_file_path_, backup_number, compressed), ec);
+      if (!ec)
+        total_size += size;
+    }
+
+    if (backup_number > settings.max_files || (settings.max_total_size != 0 && total_size > settings.max_total_size))
+      break;
+  }
+
+  // Everything from here up is over a limit.
+  for (; BackupExists(backup_number); ++backup_number)
+  {
+    for (bool compressed : {false, true})
+    {
+      std::error_code ec;
+      fs::remove(BackupPath(log_file_path_, backup_number, compressed), ec);
+    }
+  }
+}
+
+bool LogArchiver::BackupExists(unsigned int backup_number) const
+{
+  std::error_code ec;
+  return fs::exists(BackupPath(log_file_path_, backup_number, true), ec) ||
+         fs::exists(BackupPath(log_file_path_, backup_number, false), ec);
+}
+
+void LogArchiver::ReportError(const std::string& message, const std::error_code& ec)
+{
+  if (error_handler_)
+    error_handler_("Error archiving log files: " + message + (ec ? " (" + ec.message() + ")" : std::string{}));
+}
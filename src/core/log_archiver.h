@@ -0,0 +1,102 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef LOG_ARCHIVER_H_
+#define LOG_ARCHIVER_H_
+
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <system_error>
+#include "etcpal/cpp/mutex.h"
+#include "etcpal/cpp/signal.h"
+#include "etcpal/cpp/thread.h"
+
+// LogArchiver : Owns the rotated copies of the log file.
+//
+// RotateOut() moves the active log file aside with a single rename, so the log writer can start a
+// new file right away. Everything else happens later on the archiver's own thread: the existing
+// backups are shifted up (broker.log.1 becomes broker.log.2, ...), the new backup is compressed to
+// broker.log.1.gz, and the oldest backups are deleted until the retention limits are met. Since
+// this thread is the only one that touches the backups, none of this needs to be coordinated with
+// logging.
+class LogArchiver
+{
+public:
+  struct Settings
+  {
+    unsigned int max_files{5};       // The number of backups to keep
+    uint32_t     max_total_size{0};  // Delete the oldest backups past this many bytes on disk; 0 = no limit
+    bool         compress{true};     // gzip backups; ignored if built without zlib
+  };
+
+  // Called on the archiver thread when something goes wrong.
+  using ErrorHandler = std::function<void(const std::string& message)>;
+  // Called once on the archiver thread before it does any work, e.g. to lower its priority.
+  using ThreadInitHook = std::function<void()>;
+
+  LogArchiver() = default;
+  ~LogArchiver();
+
+  LogArchiver(const LogArchiver& other) = delete;
+  LogArchiver& operator=(const LogArchiver& other) = delete;
+
+  bool Startup(const std::filesystem::path& log_file_path,
+               const Settings&              settings,
+               ErrorHandler                 error_handler,
+               ThreadInitHook               thread_init = nullptr);
+  void Shutdown();
+
+  void SetSettings(const Settings& settings);
+
+  // The log file must be closed when this is called, and the archiver must be running.
+  std::error_code RotateOut();
+
+  static bool CompressionSupported();
+
+  // Backup n of the log file, optionally compressed. Backup 0 is the log file itself.
+  static std::filesystem::path BackupPath(const std::filesystem::path& log_file_path,
+                                          unsigned int                 backup_number,
+                                          bool                         compressed = false);
+
+private:
+  std::filesystem::path log_file_path_;
+  ErrorHandler          error_handler_;
+  ThreadInitHook        thread_init_;
+
+  etcpal::Mutex                     lock_;
+  Settings                          settings_;
+  std::deque<std::filesystem::path> pending_;
+  uint64_t                          next_pending_number_{0};
+  bool                              running_{false};
+
+  etcpal::Thread archiver_thread_;
+  etcpal::Signal wake_signal_;
+
+  void ArchiverThread();
+  void QueueLeftoverPendingFiles();
+  void ArchivePendingFile(const std::filesystem::path& pending_path, const Settings& settings);
+  void EnforceRetention(const Settings& settings);
+  bool BackupExists(unsigned int backup_number) const;
+  void ReportError(const std::string& message, const std::error_code& ec = {});
+};
+
+#endif  // LOG_ARCHIVER_H_
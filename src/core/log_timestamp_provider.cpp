@@ -0,0 +1,144 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "log_timestamp_provider.h"
+
+#include <chrono>
+#include <utility>
+
+static constexpr int64_t kMsPerDay = 24 * 60 * 60 * 1000;
+
+static int64_t WallClockUs()
+{
+  using namespace std::chrono;
+  return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+static int64_t SteadyClockUs()
+{
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Division that rounds toward negative infinity, for times before the epoch.
+static int64_t FloorDiv(int64_t a, int64_t b)
+{
+  return (a >= 0) ? (a / b) : ((a - b + 1) / b);
+}
+
+LogTimestampProvider::LogTimestampProvider(UtcOffsetFunction get_utc_offset, uint32_t refresh_interval_ms)
+    : get_utc_offset_(std::move(get_utc_offset)), refresh_interval_us_(static_cast<int64_t>(refresh_interval_ms) * 1000)
+{
+  Refresh();
+}
+
+etcpal::LogTimestamp LogTimestampProvider::Now()
+{
+  Base    base = LoadBase();
+  int64_t steady_us = SteadyClockUs();
+
+  if (refresh_requested_.load(std::memory_order_relaxed) || (steady_us - base.steady_us >= refresh_interval_us_))
+  {
+    // If another thread is already refreshing, carry on with the old base rather than waiting.
+    if (Refresh())
+    {
+      base = LoadBase();
+      steady_us = SteadyClockUs();
+    }
+  }
+
+  const int64_t utc_time_us = base.wall_us + (steady_us - base.steady_us);
+  return ToLogTimestamp(FloorDiv(utc_time_us, 1000) + static_cast<int64_t>(base.utc_offset) * 60 * 1000,
+                        base.utc_offset);
+}
+
+// Called when the platform learns that the time zone or the system clock has changed.
+void LogTimestampProvider::Invalidate()
+{
+  refresh_requested_.store(true, std::memory_order_relaxed);
+}
+
+// This is Howard Hinnant's civil_from_days() algorithm, which counts in 400-year eras of 146097
+// days starting from 0000-03-01 so that leap days fall at the end of each year.
+etcpal::LogTimestamp LogTimestampProvider::ToLogTimestamp(int64_t local_time_ms, int utc_offset)
+{
+  const int64_t days = FloorDiv(local_time_ms, kMsPerDay);
+  const int64_t ms_of_day = local_time_ms - days * kMsPerDay;
+
+  const int64_t  shifted_days = days + 719468;
+  const int64_t  era = FloorDiv(shifted_days, 146097);
+  const uint32_t day_of_era = static_cast<uint32_t>(shifted_days - era * 146097);
+  const uint32_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+  const uint32_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  const uint32_t shifted_month = (5 * day_of_year + 2) / 153;
+  const uint32_t day = day_of_year - (153 * shifted_month + 2) / 5 + 1;
+  const uint32_t month = (shifted_month < 10) ? (shifted_month + 3) : (shifted_month - 9);
+  const int64_t  year = static_cast<int64_t>(year_of_era) + era * 400 + (month <= 2 ? 1 : 0);
+
+  const uint32_t ms = static_cast<uint32_t>(ms_of_day);
+  return etcpal::LogTimestamp(static_cast<unsigned int>(year), month, day, ms / 3600000, (ms / 60000) % 60,
+                              (ms / 1000) % 60, ms % 1000, utc_offset);
+}
+
+LogTimestampProvider::Base LogTimestampProvider::LoadBase() const
+{
+  while (true)
+  {
+    const uint32_t sequence = sequence_.load(std::memory_order_acquire);
+    if (sequence % 2 == 0)
+    {
+      Base base;
+      base.wall_us = base_wall_us_.load(std::memory_order_relaxed);
+      base.steady_us = base_steady_us_.load(std::memory_order_relaxed);
+      base.utc_offset = base_utc_offset_.load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence_.load(std::memory_order_relaxed) == sequence)
+        return base;
+    }
+  }
+}
+
+// Returns false if another thread is already refreshing.
+bool LogTimestampProvider::Refresh()
+{
+  if (!refresh_lock_.TryLock())
+    return false;
+
+  refresh_requested_.store(false, std::memory_order_relaxed);
+
+  // Query the time zone before taking the base time, so that a slow query doesn't make the base
+  // time stale.
+  const int     utc_offset = get_utc_offset_ ? get_utc_offset_() : 0;
+  const int64_t wall_us = WallClockUs();
+  const int64_t steady_us = SteadyClockUs();
+
+  const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  base_wall_us_.store(wall_us, std::memory_order_relaxed);
+  base_steady_us_.store(steady_us, std::memory_order_relaxed);
+  base_utc_offset_.store(utc_offset, std::memory_order_relaxed);
+
+  sequence_.store(sequence + 2, std::memory_order_release);
+
+  refresh_lock_.Unlock();
+  return true;
+}
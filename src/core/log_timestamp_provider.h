@@ -0,0 +1,80 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef LOG_TIMESTAMP_PROVIDER_H_
+#define LOG_TIMESTAMP_PROVIDER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "etcpal/cpp/log.h"
+#include "etcpal/cpp/mutex.h"
+
+// LogTimestampProvider : Produces local-time log timestamps without asking the OS for the time
+// zone on every log message.
+//
+// The UTC offset and a wall-clock base time are cached together and refreshed once every refresh
+// interval, or on the next call after Invalidate(). In between, timestamps are the cached base plus
+// the time elapsed on the monotonic clock. Time zone changes, daylight saving transitions and
+// wall-clock adjustments therefore show up in the log within one refresh interval, or right away
+// if the platform calls Invalidate() when it is notified of them.
+//
+// Now() is safe to call from any number of threads at once; readers never block each other.
+class LogTimestampProvider
+{
+public:
+  // Returns the local time zone's current offset from UTC in minutes (e.g. -300 for UTC-05:00).
+  using UtcOffsetFunction = std::function<int()>;
+
+  static constexpr uint32_t kDefaultRefreshIntervalMs = 1000;
+
+  explicit LogTimestampProvider(UtcOffsetFunction get_utc_offset,
+                                uint32_t          refresh_interval_ms = kDefaultRefreshIntervalMs);
+
+  etcpal::LogTimestamp Now();
+  void                 Invalidate();
+
+  // Convert milliseconds since 1970-01-01 00:00:00 local time to a timestamp.
+  static etcpal::LogTimestamp ToLogTimestamp(int64_t local_time_ms, int utc_offset);
+
+private:
+  struct Base
+  {
+    int64_t wall_us;    // UTC microseconds since the epoch at the last refresh
+    int64_t steady_us;  // The monotonic clock at the same moment
+    int     utc_offset;
+  };
+
+  UtcOffsetFunction get_utc_offset_;
+  const int64_t     refresh_interval_us_;
+
+  // The base is published with a sequence lock: the sequence number is odd while Refresh() is
+  // changing it, and readers retry if it changed while they were reading.
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<int64_t>  base_wall_us_{0};
+  std::atomic<int64_t>  base_steady_us_{0};
+  std::atomic<int>      base_utc_offset_{0};
+  std::atomic<bool>     refresh_requested_{false};
+  etcpal::Mutex         refresh_lock_;
+
+  Base LoadBase() const;
+  bool Refresh();
+};
+
+#endif  // LOG_TIMESTAMP_PROVIDER_H_
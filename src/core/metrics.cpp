@@ -0,0 +1,263 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+
+void MetricsRegistry::Gauge::SetMax(int64_t value)
+{
+  int64_t current = value_.load(std::memory_order_relaxed);
+  while (current < value && !value_.compare_exchange_weak(current, value, std::memory_order_relaxed))
+  {
+  }
+}
+
+MetricsRegistry::Histogram::Histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)), counts_(std::make_unique<std::atomic<uint64_t>[]>(bounds_.size() + 1))
+{
+  for (size_t i = 0; i <= bounds_.size(); ++i)
+    counts_[i].store(0, std::memory_order_relaxed);
+}
+
+void MetricsRegistry::Histogram::Observe(double value)
+{
+  const size_t bucket = static_cast<size_t>(std::lower_bound(bounds_.begin(), bounds_.end(), value) - bounds_.begin());
+  counts_[bucket].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+
+  double sum = sum_.load(std::memory_order_relaxed);
+  while (!sum_.compare_exchange_weak(sum, sum + value, std::memory_order_relaxed))
+  {
+  }
+}
+
+// The buckets are read one at a time while observations may still be arriving, so a snapshot can
+// be off by the observations in flight. The count is taken from the buckets so that it always
+// matches them.
+MetricsRegistry::Histogram::Snapshot MetricsRegistry::Histogram::Read() const
+{
+  Snapshot snapshot;
+  snapshot.bounds = bounds_;
+  snapshot.counts.reserve(bounds_.size() + 1);
+  for (size_t i = 0; i <= bounds_.size(); ++i)
+  {
+    snapshot.counts.push_back(counts_[i].load(std::memory_order_relaxed));
+    snapshot.count += snapshot.counts.back();
+  }
+  snapshot.sum = sum_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+MetricsRegistry::Counter& MetricsRegistry::AddCounter(const std::string& name,
+                                                      const std::string& help,
+                                                      const Labels&      labels)
+{
+  etcpal::MutexGuard guard(lock_);
+  Series&            series = FindOrAddSeries(name, help, Type::kCounter, labels);
+  if (!series.counter)
+    series.counter = std::make_unique<Counter>();
+  return *series.counter;
+}
+
+MetricsRegistry::Gauge& MetricsRegistry::AddGauge(const std::string& name,
+                                                  const std::string& help,
+                                                  const Labels&      labels)
+{
+  etcpal::MutexGuard guard(lock_);
+  Series&            series = FindOrAddSeries(name, help, Type::kGauge, labels);
+  if (!series.gauge)
+    series.gauge = std::make_unique<Gauge>();
+  return *series.gauge;
+}
+
+MetricsRegistry::Histogram& MetricsRegistry::AddHistogram(const std::string&  name,
+                                                          const std::string&  help,
+                                                          std::vector<double> bounds,
+                                                          const Labels&       labels)
+{
+  etcpal::MutexGuard guard(lock_);
+  Series&            series = FindOrAddSeries(name, help, Type::kHistogram, labels);
+  if (!series.histogram)
+    series.histogram = std::make_unique<Histogram>(std::move(bounds));
+  return *series.histogram;
+}
+
+LatencyHistogram& MetricsRegistry::AddLatencyHistogram(const std::string& name,
+                                                      const std::string& help,
+                                                      const Labels&      labels)
+{
+  etcpal::MutexGuard guard(lock_);
+  Series&            series = FindOrAddSeries(name, help, Type::kSummary, labels);
+  if (!series.latency)
+    series.latency = std::make_unique<LatencyHistogram>();
+  return *series.latency;
+}
+
+// The metrics themselves are allocated separately, so the references handed out stay valid as the
+// vectors grow.
+MetricsRegistry::Series& MetricsRegistry::FindOrAddSeries(const std::string& name,
+                                                         const std::string& help,
+                                                         Type               type,
+                                                         const Labels&      labels)
+{
+  auto family = std::find_if(families_.begin(), families_.end(),
+                             [&](const Family& existing) { return existing.name == name && existing.type == type; });
+  if (family == families_.end())
+  {
+    families_.push_back(Family{name, help, type, {}});
+    family = std::prev(families_.end());
+  }
+
+  auto series = std::find_if(family->series.begin(), family->series.end(),
+                             [&labels](const Series& existing) { return existing.labels == labels; });
+  if (series != family->series.end())
+    return *series;
+
+  family->series.push_back(Series{labels, nullptr, nullptr, nullptr, nullptr});
+  return family->series.back();
+}
+
+static void AppendEscaped(std::string& out, const std::string& value, bool escape_quotes)
+{
+  for (char c : value)
+  {
+    if (c == '\\')
+      out += "\\\\";
+    else if (c == '\n')
+      out += "\\n";
+    else if (c == '"' && escape_quotes)
+      out += "\\\"";
+    else
+      out += c;
+  }
+}
+
+// Appends e.g. {trigger="manual",le="0.5"}, or nothing if there are no labels.
+static void AppendLabels(std::string&                   out,
+                         const MetricsRegistry::Labels& labels,
+                         const char*                    extra_name = nullptr,
+                         const std::string&             extra_value = std::string{})
+{
+  if (labels.empty() && !extra_name)
+    return;
+
+  out += '{';
+  bool first = true;
+  for (const auto& label : labels)
+  {
+    if (!first)
+      out += ',';
+    first = false;
+    out += label.first;
+    out += "=\"";
+    AppendEscaped(out, label.second, true);
+    out += '"';
+  }
+  if (extra_name)
+  {
+    if (!first)
+      out += ',';
+    out += extra_name;
+    out += "=\"";
+    out += extra_value;
+    out += '"';
+  }
+  out += '}';
+}
+
+static std::string FormatDouble(double value)
+{
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.15g", value);
+  return buf;
+}
+
+static void AppendSample(std::string& out, const std::string& name, const char* suffix, const std::string& labels,
+                         const std::string& value)
+{
+  out += name;
+  out += suffix;
+  out += labels;
+  out += ' ';
+  out += value;
+  out += '\n';
+}
+
+std::string MetricsRegistry::RenderPrometheus() const
+{
+  static const char* const kTypeNames[] = {"counter", "gauge", "histogram", "summary"};
+  static const std::pair<double, const char*> kQuantiles[] = {{0.5, "0.5"}, {0.99, "0.99"}, {0.999, "0.999"}};
+
+  etcpal::MutexGuard guard(lock_);
+
+  std::string out;
+  for (const auto& family : families_)
+  {
+    out += "# HELP " + family.name + ' ';
+    AppendEscaped(out, family.help, false);
+    out += "\n# TYPE " + family.name + ' ' + kTypeNames[static_cast<int>(family.type)] + '\n';
+
+    for (const auto& series : family.series)
+    {
+      std::string labels;
+      AppendLabels(labels, series.labels);
+
+      if (series.counter)
+      {
+        AppendSample(out, family.name, "", labels, std::to_string(series.counter->value()));
+      }
+      else if (series.gauge)
+      {
+        AppendSample(out, family.name, "", labels, std::to_string(series.gauge->value()));
+      }
+      else if (series.histogram)
+      {
+        const auto snapshot = series.histogram->Read();
+        uint64_t   cumulative = 0;
+        for (size_t i = 0; i < snapshot.counts.size(); ++i)
+        {
+          cumulative += snapshot.counts[i];
+          std::string bucket_labels;
+          AppendLabels(bucket_labels, series.labels, "le",
+                       (i < snapshot.bounds.size()) ? FormatDouble(snapshot.bounds[i]) : std::string{"+Inf"});
+          AppendSample(out, family.name, "_bucket", bucket_labels, std::to_string(cumulative));
+        }
+        AppendSample(out, family.name, "_sum", labels, FormatDouble(snapshot.sum));
+        AppendSample(out, family.name, "_count", labels, std::to_string(snapshot.count));
+      }
+      else if (series.latency)
+      {
+        const auto snapshot = series.latency->Read();
+        for (const auto& quantile : kQuantiles)
+        {
+          std::string quantile_labels;
+          AppendLabels(quantile_labels, series.labels, "quantile", quantile.second);
+          const uint64_t value_us = snapshot.ValueAtQuantile(quantile.first);
+          AppendSample(out, family.name, "", quantile_labels, FormatDouble(static_cast<double>(value_us) / 1e6));
+        }
+        AppendSample(out, family.name, "_sum", labels, FormatDouble(static_cast<double>(snapshot.sum) / 1e6));
+        AppendSample(out, family.name, "_count", labels, std::to_string(snapshot.count));
+      }
+    }
+  }
+  return out;
+}
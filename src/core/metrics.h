@@ -0,0 +1,149 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef METRICS_H_
+#define METRICS_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "etcpal/cpp/mutex.h"
+#include "latency_histogram.h"
+
+// MetricsRegistry : Holds the service's counters, gauges and histograms and renders them in the
+// Prometheus text exposition format.
+//
+// Metrics are registered once, up front, and the references returned stay valid for the lifetime of
+// the registry. Updating a metric is a single atomic operation, so it never blocks and is safe from
+// any thread, including the broker's; the registry's lock is only taken to register metrics and to
+// render them.
+class MetricsRegistry
+{
+public:
+  // Name/value pairs that distinguish the series of one metric, e.g. {{"trigger", "manual"}}.
+  using Labels = std::vector<std::pair<std::string, std::string>>;
+
+  // A value that only goes up.
+  class Counter
+  {
+  public:
+    void     Increment(uint64_t amount = 1) { value_.fetch_add(amount, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<uint64_t> value_{0};
+  };
+
+  // A value that can go up and down.
+  class Gauge
+  {
+  public:
+    void    Set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void    Add(int64_t amount) { value_.fetch_add(amount, std::memory_order_relaxed); }
+    // Raise the value to at least value, for high-water marks.
+    void    SetMax(int64_t value);
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+  private:
+    std::atomic<int64_t> value_{0};
+  };
+
+  // Counts observations into buckets with fixed upper bounds. Observations above the largest
+  // bound go into an implicit +Inf bucket.
+  class Histogram
+  {
+  public:
+    struct Snapshot
+    {
+      std::vector<double>   bounds;
+      std::vector<uint64_t> counts;  // Per bucket, not cumulative; one more than bounds, for +Inf
+      uint64_t              count{0};
+      double                sum{0.0};
+    };
+
+    // bounds must be sorted in increasing order.
+    explicit Histogram(std::vector<double> bounds);
+
+    void     Observe(double value);
+    Snapshot Read() const;
+
+  private:
+    std::vector<double>                      bounds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> counts_;
+    std::atomic<uint64_t>                    count_{0};
+    std::atomic<double>                      sum_{0.0};
+  };
+
+  MetricsRegistry() = default;
+  MetricsRegistry(const MetricsRegistry& other) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry& other) = delete;
+
+  // Register a metric, or get the one already registered with the same name and labels. A name
+  // must only be used for one type of metric. Names follow the Prometheus conventions: counters end
+  // in "_total", and units are spelled out ("_seconds").
+  Counter&   AddCounter(const std::string& name, const std::string& help, const Labels& labels = {});
+  Gauge&     AddGauge(const std::string& name, const std::string& help, const Labels& labels = {});
+  Histogram& AddHistogram(const std::string&  name,
+                          const std::string&  help,
+                          std::vector<double> bounds,
+                          const Labels&       labels = {});
+  // Rendered as a summary of the 0.5, 0.99 and 0.999 quantiles, in seconds. The name should end in
+  // "_seconds".
+  LatencyHistogram& AddLatencyHistogram(const std::string& name, const std::string& help, const Labels& labels = {});
+
+  // Prometheus text format, version 0.0.4.
+  std::string RenderPrometheus() const;
+
+private:
+  enum class Type
+  {
+    kCounter,
+    kGauge,
+    kHistogram,
+    kSummary
+  };
+
+  struct Series
+  {
+    Labels                            labels;
+    std::unique_ptr<Counter>          counter;
+    std::unique_ptr<Gauge>            gauge;
+    std::unique_ptr<Histogram>        histogram;
+    std::unique_ptr<LatencyHistogram> latency;
+  };
+
+  struct Family
+  {
+    std::string         name;
+    std::string         help;
+    Type                type;
+    std::vector<Series> series;  // In registration order
+  };
+
+  mutable etcpal::Mutex lock_;
+  std::vector<Family>   families_;  // In registration order
+
+  Series& FindOrAddSeries(const std::string& name, const std::string& help, Type type, const Labels& labels);
+};
+
+#endif  // METRICS_H_
@@ -0,0 +1,235 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "metrics_exporter.h"
+
+#include <string>
+#include "etcpal/common.h"
+
+static constexpr int    kRequestTimeoutMs = 2000;  // How long a client has to send its request
+static constexpr size_t kMaxRequestSize = 8192;    // Longer requests are rejected
+static constexpr char   kMetricsPath[] = "/metrics";
+
+MetricsExporter::~MetricsExporter()
+{
+  Shutdown();
+}
+
+bool MetricsExporter::Startup(const Settings& settings, etcpal::Logger* log)
+{
+  if (running_ || !settings.enable)
+    return true;
+
+  log_ = log;
+  if (etcpal_init(ETCPAL_FEATURE_SOCKETS) != kEtcPalErrOk)
+    return false;
+
+  if (!OpenListenSocket(settings.port) || !OpenWakeSocket())
+  {
+    if (log_)
+      log_->Error("Error opening the metrics port %u; metrics will not be served.",
+                  static_cast<unsigned int>(settings.port));
+    CloseSockets();
+    etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+    return false;
+  }
+
+  running_ = true;
+  if (!thread_.Start([this]() { ServerThread(); }).IsOk())
+  {
+    running_ = false;
+    CloseSockets();
+    etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+    return false;
+  }
+
+  if (log_)
+    log_->Info("Serving metrics at http://127.0.0.1:%u%s", static_cast<unsigned int>(port_), kMetricsPath);
+  return true;
+}
+
+void MetricsExporter::Shutdown()
+{
+  if (!running_)
+    return;
+
+  running_ = false;
+  const char wake = 0;
+  etcpal_sendto(wake_socket_, &wake, sizeof(wake), 0, &wake_addr_);
+  thread_.Join();
+  CloseSockets();
+  etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+}
+
+// Metrics are only served on the loopback interface; anything further afield needs a proxy or an
+// agent on this machine.
+bool MetricsExporter::OpenListenSocket(uint16_t port)
+{
+  if (etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &listen_socket_) != kEtcPalErrOk)
+    return false;
+
+  const int reuse = 1;
+  etcpal_setsockopt(listen_socket_, ETCPAL_SOL_SOCKET, ETCPAL_SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  EtcPalSockAddr addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&addr.ip, 0x7f000001);
+  addr.port = port;
+
+  EtcPalSockAddr bound_addr;
+  if (etcpal_bind(listen_socket_, &addr) != kEtcPalErrOk || etcpal_listen(listen_socket_, 4) != kEtcPalErrOk ||
+      etcpal_getsockname(listen_socket_, &bound_addr) != kEtcPalErrOk)
+  {
+    return false;
+  }
+
+  port_ = bound_addr.port;
+  return true;
+}
+
+// Shutdown() sends a datagram to this socket to wake the server thread, which otherwise waits for
+// connections indefinitely. It sends the datagram from the same socket, to its own address.
+bool MetricsExporter::OpenWakeSocket()
+{
+  if (etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_DGRAM, &wake_socket_) != kEtcPalErrOk)
+    return false;
+
+  EtcPalSockAddr addr;
+  ETCPAL_IP_SET_V4_ADDRESS(&addr.ip, 0x7f000001);
+  addr.port = 0;
+  if (etcpal_bind(wake_socket_, &addr) != kEtcPalErrOk || etcpal_getsockname(wake_socket_, &wake_addr_) != kEtcPalErrOk)
+    return false;
+
+  ETCPAL_IP_SET_V4_ADDRESS(&wake_addr_.ip, 0x7f000001);
+  return true;
+}
+
+void MetricsExporter::CloseSockets()
+{
+  for (etcpal_socket_t* socket : {&listen_socket_, &wake_socket_})
+  {
+    if (*socket != ETCPAL_SOCKET_INVALID)
+      etcpal_close(*socket);
+    *socket = ETCPAL_SOCKET_INVALID;
+  }
+}
+
+void MetricsExporter::ServerThread()
+{
+  EtcPalPollContext poll_context;
+  if (etcpal_poll_context_init(&poll_context) != kEtcPalErrOk)
+    return;
+
+  if (etcpal_poll_add_socket(&poll_context, listen_socket_, ETCPAL_POLL_IN, nullptr) == kEtcPalErrOk &&
+      etcpal_poll_add_socket(&poll_context, wake_socket_, ETCPAL_POLL_IN, nullptr) == kEtcPalErrOk)
+  {
+    while (running_)
+    {
+      EtcPalPollEvent event;
+      if (etcpal_poll_wait(&poll_context, &event, ETCPAL_WAIT_FOREVER) != kEtcPalErrOk ||
+          !(event.events & ETCPAL_POLL_IN))
+      {
+        continue;
+      }
+
+      // Any local process can send to the wake socket, so only running_ says whether to stop.
+      if (event.socket == wake_socket_)
+      {
+        char datagram[16];
+        etcpal_recvfrom(wake_socket_, datagram, sizeof(datagram), 0, nullptr);
+        continue;
+      }
+
+      etcpal_socket_t conn = ETCPAL_SOCKET_INVALID;
+      EtcPalSockAddr  remote_addr;
+      if (etcpal_accept(listen_socket_, &remote_addr, &conn) == kEtcPalErrOk)
+      {
+        ServeConnection(conn);
+        etcpal_close(conn);
+      }
+    }
+  }
+  etcpal_poll_remove_socket(&poll_context, wake_socket_);
+  etcpal_poll_remove_socket(&poll_context, listen_socket_);
+
+  etcpal_poll_context_deinit(&poll_context);
+}
+
+// Only the request line matters; the headers are read and ignored.
+void MetricsExporter::ServeConnection(etcpal_socket_t conn)
+{
+  const int timeout = kRequestTimeoutMs;
+  etcpal_setsockopt(conn, ETCPAL_SOL_SOCKET, ETCPAL_SO_RCVTIMEO, &timeout, sizeof(timeout));
+  etcpal_setsockopt(conn, ETCPAL_SOL_SOCKET, ETCPAL_SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+  std::string request;
+  while (request.find("\r\n\r\n") == std::string::npos)
+  {
+    if (request.size() >= kMaxRequestSize)
+    {
+      SendResponse(conn, "431 Request Header Fields Too Large", "text/plain", "Request too large.\n");
+      return;
+    }
+
+    char      buf[1024];
+    const int received = etcpal_recv(conn, buf, sizeof(buf), 0);
+    if (received <= 0)
+      return;
+    request.append(buf, static_cast<size_t>(received));
+  }
+
+  // e.g. "GET /metrics HTTP/1.1"; a query string is allowed and ignored.
+  const std::string request_line = request.substr(0, request.find("\r\n"));
+  const size_t      method_end = request_line.find(' ');
+  const size_t      target_end = request_line.find(' ', method_end + 1);
+  if (method_end == std::string::npos || target_end == std::string::npos)
+  {
+    SendResponse(conn, "400 Bad Request", "text/plain", "Bad request.\n");
+    return;
+  }
+
+  const std::string method = request_line.substr(0, method_end);
+  const std::string target = request_line.substr(method_end + 1, target_end - method_end - 1);
+  const std::string path = target.substr(0, target.find('?'));
+
+  if (path != kMetricsPath)
+    SendResponse(conn, "404 Not Found", "text/plain", "Metrics are served at /metrics.\n");
+  else if (method != "GET")
+    SendResponse(conn, "405 Method Not Allowed", "text/plain", "Only GET is supported.\n");
+  else
+    SendResponse(conn, "200 OK", "text/plain; version=0.0.4; charset=utf-8", registry_.RenderPrometheus());
+}
+
+void MetricsExporter::SendResponse(etcpal_socket_t    conn,
+                                   const char*        status,
+                                   const char*        content_type,
+                                   const std::string& body)
+{
+  std::string response = std::string("HTTP/1.1 ") + status + "\r\nContent-Type: " + content_type +
+                         "\r\nContent-Length: " + std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n";
+  response += body;
+
+  size_t sent = 0;
+  while (sent < response.size())
+  {
+    const int result = etcpal_send(conn, response.data() + sent, response.size() - sent, 0);
+    if (result <= 0)
+      return;
+    sent += static_cast<size_t>(result);
+  }
+}
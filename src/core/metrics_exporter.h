@@ -0,0 +1,82 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef METRICS_EXPORTER_H_
+#define METRICS_EXPORTER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "etcpal/cpp/log.h"
+#include "etcpal/cpp/thread.h"
+#include "etcpal/socket.h"
+#include "metrics.h"
+
+// MetricsExporter : Serves a MetricsRegistry to Prometheus over HTTP on the loopback interface.
+//
+// The exporter runs its own thread, which answers "GET /metrics" with the registry rendered in the
+// Prometheus text format and everything else with 404. Requests are answered one at a time; a
+// client that doesn't finish sending its request in time is disconnected. Scraping only reads the
+// metrics, so it never holds up the threads that update them.
+class MetricsExporter
+{
+public:
+  struct Settings
+  {
+    bool     enable{false};
+    uint16_t port{kDefaultPort};  // 0 picks an ephemeral port; see port()
+  };
+
+  // The port registered for Prometheus exporters of this kind.
+  static constexpr uint16_t kDefaultPort = 9464;
+
+  explicit MetricsExporter(const MetricsRegistry& registry) : registry_(registry) {}
+  ~MetricsExporter();
+
+  MetricsExporter(const MetricsExporter& other) = delete;
+  MetricsExporter& operator=(const MetricsExporter& other) = delete;
+
+  // Start serving, or do nothing if settings.enable is false. Returns false if the listening socket
+  // could not be set up.
+  bool Startup(const Settings& settings, etcpal::Logger* log = nullptr);
+  void Shutdown();
+
+  [[nodiscard]] bool     running() const { return running_; }
+  [[nodiscard]] uint16_t port() const { return port_; }  // The port being listened on, if running
+
+private:
+  const MetricsRegistry& registry_;
+  etcpal::Logger*        log_{nullptr};
+
+  etcpal_socket_t   listen_socket_{ETCPAL_SOCKET_INVALID};
+  uint16_t          port_{0};
+  etcpal_socket_t   wake_socket_{ETCPAL_SOCKET_INVALID};
+  EtcPalSockAddr    wake_addr_{};
+  std::atomic<bool> running_{false};
+  etcpal::Thread    thread_;
+
+  bool OpenListenSocket(uint16_t port);
+  bool OpenWakeSocket();
+  void CloseSockets();
+  void ServerThread();
+  void ServeConnection(etcpal_socket_t conn);
+  void SendResponse(etcpal_socket_t conn, const char* status, const char* content_type, const std::string& body);
+};
+
+#endif  // METRICS_EXPORTER_H_
@@ -0,0 +1,241 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "netlink_network_monitor.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <linux/if_addr.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+
+NetlinkNetworkMonitor::~NetlinkNetworkMonitor()
+{
+  Close();
+}
+
+bool NetlinkNetworkMonitor::Open()
+{
+  fd_ = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+  if (fd_ < 0)
+    return false;
+
+  struct sockaddr_nl addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.nl_family = AF_NETLINK;
+  addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+  if (bind(fd_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0)
+  {
+    Close();
+    return false;
+  }
+
+  StartResync();
+  return (dump_state_ != DumpState::kIdle);
+}
+
+void NetlinkNetworkMonitor::Close()
+{
+  if (fd_ >= 0)
+    close(fd_);
+  fd_ = -1;
+  dump_state_ = DumpState::kIdle;
+}
+
+void NetlinkNetworkMonitor::Receive()
+{
+  alignas(struct nlmsghdr) char buf[16384];
+  while (fd_ >= 0)
+  {
+    struct sockaddr_nl sender;
+    socklen_t          sender_len = sizeof(sender);
+    memset(&sender, 0, sizeof(sender));
+    const ssize_t size =
+        recvfrom(fd_, buf, sizeof(buf), 0, reinterpret_cast<struct sockaddr*>(&sender), &sender_len);
+    if (size > 0)
+    {
+      // Any local process can send to the socket; only the kernel's messages are believed.
+      if (sender.nl_pid == 0)
+        ProcessMessages(buf, static_cast<size_t>(size));
+    }
+    else if (size < 0 && errno == ENOBUFS)
+    {
+      // Notifications were dropped, so the table can't be trusted until it has been read again.
+      if (dump_state_ == DumpState::kIdle)
+        StartResync();
+      else
+        resync_pending_ = true;
+    }
+    else if (size < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    else
+    {
+      break;
+    }
+  }
+}
+
+// Parses the link and address messages the monitor subscribes to, and the end of each dump.
+// Anything else is skipped.
+void NetlinkNetworkMonitor::ProcessMessages(const void* data, size_t size)
+{
+  int remaining = static_cast<int>(size);
+  for (auto header = static_cast<const struct nlmsghdr*>(data); NLMSG_OK(header, remaining);
+       header = NLMSG_NEXT(header, remaining))
+  {
+    switch (header->nlmsg_type)
+    {
+      case NLMSG_DONE:
+      case NLMSG_ERROR:  // An error ends a dump as well.
+        if (dump_state_ != DumpState::kIdle && header->nlmsg_seq == sequence_)
+          FinishDump();
+        break;
+      case RTM_NEWLINK:
+      case RTM_DELLINK: {
+        if (header->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifinfomsg)))
+          break;
+
+        const auto* info = static_cast<const struct ifinfomsg*>(NLMSG_DATA(header));
+        const auto  index = static_cast<unsigned int>(info->ifi_index);
+        if (header->nlmsg_type == RTM_DELLINK)
+        {
+          RemoveInterface(index);
+          break;
+        }
+
+        int attr_remaining = static_cast<int>(IFLA_PAYLOAD(header));
+        for (auto attr = IFLA_RTA(info); RTA_OK(attr, attr_remaining); attr = RTA_NEXT(attr, attr_remaining))
+        {
+          if (attr->rta_type == IFLA_IFNAME)
+          {
+            const auto* name = static_cast<const char*>(RTA_DATA(attr));
+            SetInterfaceName(index, std::string(name, strnlen(name, RTA_PAYLOAD(attr))));
+          }
+        }
+        break;
+      }
+      case RTM_NEWADDR:
+      case RTM_DELADDR: {
+        if (header->nlmsg_len < NLMSG_LENGTH(sizeof(struct ifaddrmsg)))
+          break;
+
+        const auto* info = static_cast<const struct ifaddrmsg*>(NLMSG_DATA(header));
+        if (info->ifa_family != AF_INET && info->ifa_family != AF_INET6)
+          break;
+        const size_t address_length = (info->ifa_family == AF_INET) ? 4 : 16;
+
+        // IFA_LOCAL is the interface's own address; IFA_ADDRESS is the peer's on point-to-point
+        // links, and the same as IFA_LOCAL (or the only one present) otherwise.
+        const void* local = nullptr;
+        const void* address = nullptr;
+        uint32_t    flags = info->ifa_flags;
+
+        int attr_remaining = static_cast<int>(IFA_PAYLOAD(header));
+        for (auto attr = IFA_RTA(info); RTA_OK(attr, attr_remaining); attr = RTA_NEXT(attr, attr_remaining))
+        {
+          if (attr->rta_type == IFA_LOCAL && RTA_PAYLOAD(attr) >= address_length)
+            local = RTA_DATA(attr);
+          else if (attr->rta_type == IFA_ADDRESS && RTA_PAYLOAD(attr) >= address_length)
+            address = RTA_DATA(attr);
+          else if (attr->rta_type == IFA_FLAGS && RTA_PAYLOAD(attr) >= sizeof(uint32_t))
+            memcpy(&flags, RTA_DATA(attr), sizeof(uint32_t));
+        }
+        if (local)
+          address = local;
+        if (!address)
+          break;
+
+        etcpal::IpAddr ip;
+        if (info->ifa_family == AF_INET)
+        {
+          uint32_t v4;
+          memcpy(&v4, address, sizeof(v4));
+          ip = etcpal::IpAddr::FromV4(ntohl(v4));
+        }
+        else
+        {
+          ip = etcpal::IpAddr::FromV6(static_cast<const uint8_t*>(address));
+        }
+
+        // An IPv6 address can't be used until duplicate address detection has passed.
+        const auto index = static_cast<unsigned int>(info->ifa_index);
+        if (header->nlmsg_type == RTM_DELADDR || (flags & (IFA_F_TENTATIVE | IFA_F_DADFAILED)))
+          RemoveAddress(index, ip);
+        else
+          AddAddress(index, ip);
+        break;
+      }
+      default:
+        break;
+    }
+  }
+}
+
+void NetlinkNetworkMonitor::StartResync()
+{
+  if (fd_ < 0)
+    return;
+
+  resync_pending_ = false;
+  BeginResync();
+  dump_state_ = SendDumpRequest(RTM_GETLINK) ? DumpState::kLinks : DumpState::kIdle;
+}
+
+// Only one dump can be in progress on a socket, so the addresses are requested once the links are
+// done. Names need to be known before the addresses on them are.
+bool NetlinkNetworkMonitor::SendDumpRequest(uint16_t type)
+{
+  struct
+  {
+    struct nlmsghdr header;
+    struct rtgenmsg body;
+  } request;
+  memset(&request, 0, sizeof(request));
+  request.header.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtgenmsg));
+  request.header.nlmsg_type = type;
+  request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  request.header.nlmsg_seq = ++sequence_;
+  request.body.rtgen_family = AF_UNSPEC;
+
+  struct sockaddr_nl kernel;
+  memset(&kernel, 0, sizeof(kernel));
+  kernel.nl_family = AF_NETLINK;
+  return (sendto(fd_, &request, request.header.nlmsg_len, 0, reinterpret_cast<struct sockaddr*>(&kernel),
+                 sizeof(kernel)) >= 0);
+}
+
+void NetlinkNetworkMonitor::FinishDump()
+{
+  if (dump_state_ == DumpState::kLinks && SendDumpRequest(RTM_GETADDR))
+  {
+    dump_state_ = DumpState::kAddresses;
+    return;
+  }
+
+  EndResync();
+  dump_state_ = DumpState::kIdle;
+  if (resync_pending_)
+    StartResync();
+}
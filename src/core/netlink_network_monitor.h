@@ -0,0 +1,71 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef NETLINK_NETWORK_MONITOR_H_
+#define NETLINK_NETWORK_MONITOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "network_change_monitor.h"
+
+// NetlinkNetworkMonitor : The Linux NetworkChangeMonitor, which listens for link and address
+// notifications on an rtnetlink socket.
+//
+// When opened, and again whenever the kernel reports that notifications were dropped, the monitor
+// resynchronizes by dumping all links and then all addresses; the dump replies are processed the
+// same way as notifications. The socket is non-blocking, so Receive() can be called whenever fd()
+// is readable.
+class NetlinkNetworkMonitor : public NetworkChangeMonitor
+{
+public:
+  NetlinkNetworkMonitor() = default;
+  ~NetlinkNetworkMonitor() override;
+
+  NetlinkNetworkMonitor(const NetlinkNetworkMonitor&) = delete;
+  NetlinkNetworkMonitor& operator=(const NetlinkNetworkMonitor&) = delete;
+
+  bool Open();
+  void Close();
+  int  fd() const { return fd_; }
+
+  // Read and process everything waiting on the socket.
+  void Receive();
+
+  // Process a buffer of netlink messages, as received from the socket.
+  void ProcessMessages(const void* data, size_t size);
+
+private:
+  enum class DumpState
+  {
+    kIdle,
+    kLinks,
+    kAddresses
+  };
+
+  int       fd_{-1};
+  uint32_t  sequence_{0};
+  DumpState dump_state_{DumpState::kIdle};
+  bool      resync_pending_{false};
+
+  void StartResync();
+  bool SendDumpRequest(uint16_t type);
+  void FinishDump();
+};
+
+#endif  // NETLINK_NETWORK_MONITOR_H_
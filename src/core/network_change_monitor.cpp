@@ -0,0 +1,159 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "network_change_monitor.h"
+
+#include <algorithm>
+
+std::string NetworkChangeMonitor::Change::ToString() const
+{
+  switch (type)
+  {
+    case Type::kAddressAdded:
+      return "address " + address.ToString() + " added on " + interface_name;
+    case Type::kAddressRemoved:
+      return "address " + address.ToString() + " removed from " + interface_name;
+    case Type::kInterfaceRenamed:
+    default:
+      return "interface " + old_interface_name + " renamed to " + interface_name;
+  }
+}
+
+void NetworkChangeMonitor::SetInterfaceName(unsigned int index, const std::string& name)
+{
+  Interface& interface = interfaces_[index];
+  interface.seen = true;
+  if (interface.name == name)
+    return;
+
+  if (!interface.name.empty() && synchronized_)
+  {
+    Change change{Change::Type::kInterfaceRenamed, name, interface.name, etcpal::IpAddr{}};
+    changes_.push_back(std::move(change));
+  }
+  interface.name = name;
+}
+
+void NetworkChangeMonitor::RemoveInterface(unsigned int index)
+{
+  auto interface = interfaces_.find(index);
+  if (interface == interfaces_.end())
+    return;
+
+  for (const auto& address : interface->second.addresses)
+    RecordChange(Change::Type::kAddressRemoved, interface->second, address.first);
+  interfaces_.erase(interface);
+}
+
+void NetworkChangeMonitor::AddAddress(unsigned int index, const etcpal::IpAddr& address)
+{
+  Interface& interface = interfaces_[index];
+  interface.seen = true;
+
+  auto existing = std::find_if(interface.addresses.begin(), interface.addresses.end(),
+                               [&address](const auto& entry) { return entry.first == address; });
+  if (existing != interface.addresses.end())
+  {
+    existing->second = true;
+    return;
+  }
+
+  interface.addresses.emplace_back(address, true);
+  RecordChange(Change::Type::kAddressAdded, interface, address);
+}
+
+void NetworkChangeMonitor::RemoveAddress(unsigned int index, const etcpal::IpAddr& address)
+{
+  auto interface = interfaces_.find(index);
+  if (interface == interfaces_.end())
+    return;
+
+  auto& addresses = interface->second.addresses;
+  auto  existing = std::find_if(addresses.begin(), addresses.end(),
+                                [&address](const auto& entry) { return entry.first == address; });
+  if (existing == addresses.end())
+    return;
+
+  addresses.erase(existing);
+  RecordChange(Change::Type::kAddressRemoved, interface->second, address);
+}
+
+void NetworkChangeMonitor::BeginResync()
+{
+  resyncing_ = true;
+  for (auto& interface : interfaces_)
+  {
+    interface.second.seen = false;
+    for (auto& address : interface.second.addresses)
+      address.second = false;
+  }
+}
+
+void NetworkChangeMonitor::EndResync()
+{
+  if (!resyncing_)
+    return;
+
+  for (auto interface = interfaces_.begin(); interface != interfaces_.end();)
+  {
+    auto& addresses = interface->second.addresses;
+    for (auto address = addresses.begin(); address != addresses.end();)
+    {
+      if (!address->second || !interface->second.seen)
+      {
+        RecordChange(Change::Type::kAddressRemoved, interface->second, address->first);
+        address = addresses.erase(address);
+      }
+      else
+      {
+        ++address;
+      }
+    }
+
+    if (interface->second.seen)
+      ++interface;
+    else
+      interface = interfaces_.erase(interface);
+  }
+
+  resyncing_ = false;
+  synchronized_ = true;
+}
+
+// An interface whose name isn't known yet can't be matched, so it only affects a broker listening
+// on all interfaces.
+bool NetworkChangeMonitor::Affects(const Changes& changes, const std::vector<std::string>& listen_interfaces)
+{
+  if (listen_interfaces.empty())
+    return !changes.empty();
+
+  const auto listened_on = [&listen_interfaces](const std::string& name) {
+    return !name.empty() &&
+           std::find(listen_interfaces.begin(), listen_interfaces.end(), name) != listen_interfaces.end();
+  };
+  return std::any_of(changes.begin(), changes.end(), [&listened_on](const Change& change) {
+    return listened_on(change.interface_name) || listened_on(change.old_interface_name);
+  });
+}
+
+void NetworkChangeMonitor::RecordChange(Change::Type type, const Interface& interface, const etcpal::IpAddr& address)
+{
+  if (synchronized_)
+    changes_.push_back(Change{type, interface.name, std::string{}, address});
+}
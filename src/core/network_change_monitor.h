@@ -0,0 +1,94 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef NETWORK_CHANGE_MONITOR_H_
+#define NETWORK_CHANGE_MONITOR_H_
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+#include "etcpal/cpp/inet.h"
+
+// NetworkChangeMonitor : Keeps a table of the IP addresses on each of the system's network
+// interfaces, as reported by the platform, and works out which reports actually change it.
+//
+// OS notifications are much noisier than the changes the broker cares about: IPv6 addresses are
+// reported again every time their lifetimes are refreshed, and links going up and down are
+// reported whether or not any address comes or goes. Only an interface gaining or losing an
+// address, or being renamed, is recorded as a change.
+//
+// Platform implementations report what they learn through the functions below. The table is
+// filled by a resynchronization (BeginResync(), a report of everything, EndResync()); changes are
+// only recorded once the first one has finished. Not thread-safe.
+class NetworkChangeMonitor
+{
+public:
+  struct Change
+  {
+    enum class Type
+    {
+      kAddressAdded,
+      kAddressRemoved,
+      kInterfaceRenamed
+    };
+
+    Type           type;
+    std::string    interface_name;
+    std::string    old_interface_name;  // Only for kInterfaceRenamed
+    etcpal::IpAddr address;             // Not for kInterfaceRenamed
+
+    std::string ToString() const;
+  };
+  using Changes = std::vector<Change>;
+
+  virtual ~NetworkChangeMonitor() = default;
+
+  void SetInterfaceName(unsigned int index, const std::string& name);
+  void RemoveInterface(unsigned int index);
+  void AddAddress(unsigned int index, const etcpal::IpAddr& address);
+  void RemoveAddress(unsigned int index, const etcpal::IpAddr& address);
+
+  // Interfaces and addresses that aren't reported again between these calls are removed.
+  void BeginResync();
+  void EndResync();
+
+  bool    synchronized() const { return synchronized_; }
+  Changes TakeChanges() { return std::move(changes_); }
+
+  // Whether a broker listening on listen_interfaces (all interfaces if empty) is affected.
+  static bool Affects(const Changes& changes, const std::vector<std::string>& listen_interfaces);
+
+private:
+  struct Interface
+  {
+    std::string                                 name;
+    std::vector<std::pair<etcpal::IpAddr, bool>> addresses;  // With whether it was seen during a resync
+    bool                                        seen{true};
+  };
+
+  std::map<unsigned int, Interface> interfaces_;
+  Changes                           changes_;
+  bool                              synchronized_{false};
+  bool                              resyncing_{false};
+
+  void RecordChange(Change::Type type, const Interface& interface, const etcpal::IpAddr& address);
+};
+
+#endif  // NETWORK_CHANGE_MONITOR_H_
@@ -0,0 +1,155 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "restart_scheduler.h"
+
+#include <algorithm>
+#include <random>
+#include <utility>
+
+RestartScheduler::RestartScheduler() : RestartScheduler(Settings{}, SteadyClockMs, UniformRandom)
+{
+}
+
+RestartScheduler::RestartScheduler(const Settings& settings, ClockFunction clock, RandomFunction random)
+    : settings_(settings), clock_(std::move(clock)), random_(std::move(random))
+{
+}
+
+bool RestartScheduler::Request(Trigger trigger, bool force_restart)
+{
+  const auto      index = static_cast<size_t>(trigger);
+  const auto&     trigger_settings = settings_.triggers[index];
+  const uint64_t  now = clock_();
+  uint64_t        due_ms = now + trigger_settings.cooldown_ms;
+  const uint64_t& last_restart = last_restart_ms_[index];
+  if (last_restart != 0)
+    due_ms = std::max(due_ms, last_restart + trigger_settings.min_interval_ms);
+
+  ++counters_.requested[index];
+  const bool coalesced = pending_;
+  if (coalesced)
+    ++counters_.coalesced;
+
+  if (trigger == Trigger::kManual || trigger == Trigger::kConfigChange)
+    consecutive_failures_ = 0;
+
+  Schedule(trigger, force_restart, due_ms, trigger_settings.cooldown_ms == 0);
+  return !coalesced;
+}
+
+int RestartScheduler::TimeUntilDue() const
+{
+  if (!pending_)
+    return -1;
+
+  const uint64_t now = clock_();
+  return (now >= due_ms_) ? 0 : static_cast<int>(due_ms_ - now);
+}
+
+bool RestartScheduler::TakeDue(bool& force_restart)
+{
+  if (TimeUntilDue() != 0)
+    return false;
+
+  force_restart = force_restart_;
+  taken_triggers_ = pending_triggers_;
+  pending_ = false;
+  force_restart_ = false;
+  has_deadline_ = false;
+  pending_triggers_ = 0;
+  return true;
+}
+
+void RestartScheduler::RestartExecuted()
+{
+  // Clock values of 0 mark triggers that never caused a restart.
+  const uint64_t now = std::max<uint64_t>(clock_(), 1u);
+  for (size_t i = 0; i < kNumTriggers; ++i)
+  {
+    if (taken_triggers_ & (1u << i))
+      last_restart_ms_[i] = now;
+  }
+
+  taken_triggers_ = 0;
+  ++counters_.executed;
+}
+
+// The backoff doubles with each consecutive failure, up to the maximum.
+uint32_t RestartScheduler::StartupFailed()
+{
+  ++counters_.startup_failures;
+  const unsigned int doublings = std::min(consecutive_failures_++, 31u);
+
+  const uint64_t backoff = std::min<uint64_t>(static_cast<uint64_t>(settings_.initial_backoff_ms) << doublings,
+                                              settings_.max_backoff_ms);
+  const double   factor = 1.0 + settings_.jitter * (2.0 * random_() - 1.0);
+  const auto     delay_ms = static_cast<uint32_t>(std::max(0.0, static_cast<double>(backoff) * factor));
+
+  Schedule(Trigger::kStartupRetry, true, clock_() + delay_ms, false);
+  ++counters_.requested[static_cast<size_t>(Trigger::kStartupRetry)];
+  return delay_ms;
+}
+
+void RestartScheduler::StartupSucceeded()
+{
+  consecutive_failures_ = 0;
+}
+
+const char* RestartScheduler::TriggerName(Trigger trigger)
+{
+  switch (trigger)
+  {
+    case Trigger::kManual:
+      return "manual";
+    case Trigger::kScopeChange:
+      return "scope_change";
+    case Trigger::kNetworkChange:
+      return "network_change";
+    case Trigger::kConfigChange:
+      return "config_change";
+    case Trigger::kStartupRetry:
+    default:
+      return "startup_retry";
+  }
+}
+
+double RestartScheduler::UniformRandom()
+{
+  static thread_local std::minstd_rand engine{std::random_device{}()};
+  return std::uniform_real_distribution<double>(0.0, 1.0)(engine);
+}
+
+// Requests push a pending restart back to when they are due, except past the deadline set by a
+// request without a cooldown, which also brings it forward to its own due time.
+void RestartScheduler::Schedule(Trigger trigger, bool force_restart, uint64_t due_ms, bool is_deadline)
+{
+  due_ms_ = pending_ ? std::max(due_ms_, due_ms) : due_ms;
+  if (is_deadline)
+  {
+    deadline_ms_ = has_deadline_ ? std::min(deadline_ms_, due_ms) : due_ms;
+    has_deadline_ = true;
+  }
+  if (has_deadline_)
+    due_ms_ = std::min(due_ms_, deadline_ms_);
+
+  pending_ = true;
+  force_restart_ = force_restart_ || force_restart;
+  pending_triggers_ |= 1u << static_cast<unsigned int>(trigger);
+}
@@ -0,0 +1,133 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef RESTART_SCHEDULER_H_
+#define RESTART_SCHEDULER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "broker_common.h"
+
+// RestartScheduler : Decides when the broker is restarted.
+//
+// Each request names its trigger. Every trigger has a cooldown, which delays the restart so that
+// more requests can arrive and be coalesced into it, and a minimum interval, which keeps one
+// trigger from restarting the broker again soon after the last restart it caused (so a flapping
+// interface can't make the broker thrash). A request with a cooldown can push a pending restart
+// back; a request without one can bring it forward, but only as far as its own minimum interval
+// allows, and later requests can't push it back past that.
+//
+// When the broker fails to start, a retry is scheduled after an exponential backoff with jitter,
+// instead of giving up on the broker. A manual request or a configuration change may well have
+// fixed the cause, so it resets the backoff and doesn't wait for the retry.
+//
+// A RestartScheduler is not thread-safe; the shell guards it with its own lock.
+class RestartScheduler
+{
+public:
+  enum class Trigger
+  {
+    kManual,         // Requested through the service (e.g. a restart or reload signal)
+    kScopeChange,    // The broker's scope was changed over RDMnet
+    kNetworkChange,  // An address or interface changed
+    kConfigChange,   // The configuration files changed
+    kStartupRetry    // A previous startup failed
+  };
+  static constexpr size_t kNumTriggers = 5;
+
+  struct TriggerSettings
+  {
+    uint32_t cooldown_ms{0};
+    uint32_t min_interval_ms{0};
+  };
+
+  struct Settings
+  {
+    std::array<TriggerSettings, kNumTriggers> triggers{{
+        {0u, 0u},         // kManual
+        {0u, 0u},         // kScopeChange
+        {5000u, 30000u},  // kNetworkChange
+        {0u, 0u},         // kConfigChange
+        {0u, 0u},         // kStartupRetry (delayed by the backoff instead)
+    }};
+    uint32_t initial_backoff_ms{1000u};
+    uint32_t max_backoff_ms{60000u};
+    double   jitter{0.2};  // Backoff delays vary randomly by up to this fraction either way
+  };
+
+  struct Counters
+  {
+    std::array<uint64_t, kNumTriggers> requested{};
+    uint64_t                           coalesced{0};  // Requests made while a restart was already pending
+    uint64_t                           executed{0};  // Requests that restarted the broker
+    uint64_t                           startup_failures{0};
+  };
+
+  // Returns a random number in [0, 1).
+  using RandomFunction = std::function<double()>;
+  // Returns a monotonic time in milliseconds.
+  using ClockFunction = std::function<uint64_t()>;
+
+  RestartScheduler();
+  RestartScheduler(const Settings& settings, ClockFunction clock, RandomFunction random);
+
+  // Returns false if the request was coalesced into a restart that was already pending.
+  bool Request(Trigger trigger, bool force_restart = true);
+
+  // Milliseconds until the pending restart is due, or -1 if there is none.
+  int TimeUntilDue() const;
+  // If a restart is due, clears it and returns true; force_restart is set if any of the requests
+  // coalesced into it must restart the broker.
+  bool TakeDue(bool& force_restart);
+  // Call when the request last taken by TakeDue() actually restarted the broker, rather than being
+  // applied in place. Only restarts count towards the triggers' minimum intervals.
+  void RestartExecuted();
+
+  // Schedules a retry, and returns the delay before it.
+  uint32_t StartupFailed();
+  void     StartupSucceeded();
+
+  const Counters& counters() const { return counters_; }
+
+  static const char* TriggerName(Trigger trigger);
+  static double      UniformRandom();
+
+private:
+  const Settings       settings_;
+  const ClockFunction  clock_;
+  const RandomFunction random_;
+
+  bool     pending_{false};
+  bool     force_restart_{false};
+  uint64_t due_ms_{0};
+  uint64_t deadline_ms_{0};       // The latest due_ms_ may be pushed back to, if has_deadline_
+  bool     has_deadline_{false};  // Set by requests without a cooldown
+  uint32_t pending_triggers_{0};  // A bit for each trigger coalesced into the pending restart
+  uint32_t taken_triggers_{0};    // The same, for the request last taken by TakeDue()
+
+  std::array<uint64_t, kNumTriggers> last_restart_ms_{};  // 0 if the trigger never caused a restart
+  unsigned int                       consecutive_failures_{0};
+  Counters                           counters_;
+
+  void Schedule(Trigger trigger, bool force_restart, uint64_t due_ms, bool is_deadline);
+};
+
+#endif  // RESTART_SCHEDULER_H_
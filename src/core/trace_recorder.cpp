@@ -0,0 +1,195 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "trace_recorder.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "etcpal/cpp/mutex.h"
+#include "nlohmann/json.hpp"
+
+std::atomic<bool> TraceRecorder::enabled_{false};
+
+struct TraceEvent
+{
+  const char* name;
+  int64_t     begin_us;  // Since the trace was started
+  int64_t     duration_us;
+};
+
+struct TraceThreadBuffer
+{
+  etcpal::Mutex           lock;  // Only contended by ChromeTrace() and Start()
+  std::vector<TraceEvent> events;
+  uint64_t                dropped{0};
+  const char*             name{nullptr};
+  int                     tid{0};
+};
+
+struct TraceRegistry
+{
+  etcpal::Mutex                                   lock;
+  etcpal::Mutex                                   write_lock;  // Held while writing a trace file
+  std::vector<std::shared_ptr<TraceThreadBuffer>> buffers;
+  int                                             next_tid{1};
+  std::atomic<std::chrono::steady_clock::rep>     origin{0};  // When the trace was started
+};
+
+static TraceRegistry& GetRegistry()
+{
+  static TraceRegistry registry;
+  return registry;
+}
+
+// Called with the registry's lock held.
+static void ClearBuffers(TraceRegistry& registry)
+{
+  for (auto& buffer : registry.buffers)
+  {
+    etcpal::MutexGuard buffer_guard(buffer->lock);
+    buffer->events.clear();
+    buffer->dropped = 0;
+  }
+}
+
+// Registered on first use; the registry keeps the buffer, and what was recorded in it, after the
+// thread exits.
+static TraceThreadBuffer& GetThreadBuffer()
+{
+  thread_local std::shared_ptr<TraceThreadBuffer> buffer;
+  if (!buffer)
+  {
+    buffer = std::make_shared<TraceThreadBuffer>();
+    buffer->events.reserve(TraceRecorder::kMaxEventsPerThread);
+
+    TraceRegistry&     registry = GetRegistry();
+    etcpal::MutexGuard guard(registry.lock);
+    buffer->tid = registry.next_tid++;
+    registry.buffers.push_back(buffer);
+  }
+  return *buffer;
+}
+
+void TraceRecorder::Start()
+{
+  TraceRegistry&     registry = GetRegistry();
+  etcpal::MutexGuard guard(registry.lock);
+
+  // Forget the threads that have exited since the last trace; their buffers are only held here.
+  registry.buffers.erase(std::remove_if(registry.buffers.begin(), registry.buffers.end(),
+                                        [](const auto& buffer) { return buffer.use_count() == 1; }),
+                         registry.buffers.end());
+  registry.origin = std::chrono::steady_clock::now().time_since_epoch().count();
+  ClearBuffers(registry);
+  enabled_ = true;
+}
+
+void TraceRecorder::Stop()
+{
+  enabled_ = false;
+}
+
+void TraceRecorder::Cancel()
+{
+  TraceRegistry&     registry = GetRegistry();
+  etcpal::MutexGuard guard(registry.lock);
+  enabled_ = false;
+  ClearBuffers(registry);
+}
+
+void TraceRecorder::SetThreadName(const char* name)
+{
+  TraceThreadBuffer& buffer = GetThreadBuffer();
+  etcpal::MutexGuard guard(buffer.lock);
+  buffer.name = name;
+}
+
+// Spans that began before the trace was started are left out, as are those that end after it was
+// stopped; they would be cut off. The start time and whether tracing is on are read under the
+// buffer's lock, so a span can't land in a buffer that Start() or Cancel() has just cleared.
+void TraceRecorder::Record(const char*                           name,
+                           std::chrono::steady_clock::time_point begin,
+                           std::chrono::steady_clock::time_point end)
+{
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+
+  TraceThreadBuffer& buffer = GetThreadBuffer();
+  etcpal::MutexGuard guard(buffer.lock);
+  if (!enabled_.load(std::memory_order_relaxed))
+    return;
+
+  const std::chrono::steady_clock::time_point origin{std::chrono::steady_clock::duration{GetRegistry().origin.load()}};
+  if (begin < origin)
+    return;
+
+  if (buffer.events.size() >= kMaxEventsPerThread)
+  {
+    ++buffer.dropped;
+    return;
+  }
+  buffer.events.push_back(TraceEvent{name, duration_cast<microseconds>(begin - origin).count(),
+                                     duration_cast<microseconds>(end - begin).count()});
+}
+
+bool TraceRecorder::WriteChromeTrace(const std::string& path)
+{
+  etcpal::MutexGuard guard(GetRegistry().write_lock);
+  const std::string  trace = ChromeTrace();
+
+  std::ofstream file(path, std::ios::out | std::ios::trunc);
+  file << trace;
+  return static_cast<bool>(file.flush());
+}
+
+// Complete ("X") events for the spans and metadata ("M") events for the thread names; see the
+// Trace Event Format document. Everything is reported as one process.
+std::string TraceRecorder::ChromeTrace()
+{
+  nlohmann::json events = nlohmann::json::array();
+  uint64_t       dropped = 0;
+
+  TraceRegistry&     registry = GetRegistry();
+  etcpal::MutexGuard guard(registry.lock);
+  for (const auto& buffer : registry.buffers)
+  {
+    etcpal::MutexGuard buffer_guard(buffer->lock);
+    if (buffer->name)
+    {
+      events.push_back(
+          {{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", buffer->tid}, {"args", {{"name", buffer->name}}}});
+    }
+    for (const auto& event : buffer->events)
+    {
+      events.push_back({{"name", event.name},
+                        {"ph", "X"},
+                        {"pid", 1},
+                        {"tid", buffer->tid},
+                        {"ts", event.begin_us},
+                        {"dur", event.duration_us}});
+    }
+    dropped += buffer->dropped;
+  }
+
+  const nlohmann::json trace = {
+      {"displayTimeUnit", "ms"}, {"traceEvents", events}, {"otherData", {{"dropped_spans", dropped}}}};
+  return trace.dump();
+}
@@ -0,0 +1,92 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef TRACE_RECORDER_H_
+#define TRACE_RECORDER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// TraceRecorder : Records how long the phases of the service's life take (reading the
+// configuration, starting and stopping the broker, restarts), and writes them out in the Chrome
+// trace event format, to be viewed in Perfetto or chrome://tracing.
+//
+// Tracing is process-wide and off until Start() is called. While it is off, a Span costs one
+// relaxed load and a branch. While it is on, each thread records into a buffer of its own, which is
+// only locked against WriteChromeTrace(); a thread whose buffer is full drops its further spans.
+class TraceRecorder
+{
+public:
+  static constexpr size_t kMaxEventsPerThread = 4096;
+
+  // Records the time from its construction to its destruction under name, which must be a string
+  // literal or otherwise outlive the trace. Spans on one thread must nest.
+  class Span
+  {
+  public:
+    explicit Span(const char* name) : name_(name)
+    {
+      if (enabled_.load(std::memory_order_relaxed))
+        begin_ = std::chrono::steady_clock::now();
+    }
+    ~Span()
+    {
+      if (begin_ != std::chrono::steady_clock::time_point{})
+        Record(name_, begin_, std::chrono::steady_clock::now());
+    }
+
+    Span(const Span& other) = delete;
+    Span& operator=(const Span& other) = delete;
+
+  private:
+    const char*                           name_;
+    std::chrono::steady_clock::time_point begin_{};
+  };
+
+  // Discard whatever was recorded before and start recording.
+  static void Start();
+  // Stop recording; what was recorded is kept for WriteChromeTrace(). Spans that are still open are
+  // left out.
+  static void Stop();
+  // Stop recording and discard what was recorded.
+  static void Cancel();
+
+  static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+  // Write the spans recorded since the last Start(), replacing any previous file. Calls from
+  // different threads are serialized.
+  static bool WriteChromeTrace(const std::string& path);
+  // The trace as WriteChromeTrace() writes it.
+  static std::string ChromeTrace();
+
+  // Name the calling thread in the trace. name must outlive the trace.
+  static void SetThreadName(const char* name);
+
+private:
+  static std::atomic<bool> enabled_;
+
+  static void Record(const char*                           name,
+                     std::chrono::steady_clock::time_point begin,
+                     std::chrono::steady_clock::time_point end);
+};
+
+#endif  // TRACE_RECORDER_H_
@@ -0,0 +1,226 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "unix_admin_server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstddef>
+#include <utility>
+
+// Only the service's own user can connect.
+static constexpr mode_t kSocketMode = S_IRUSR | S_IWUSR;
+
+// A client that disconnects early must not raise SIGPIPE. macOS has no MSG_NOSIGNAL; the socket
+// option set in Accept() does the same there.
+#ifdef MSG_NOSIGNAL
+static constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+static constexpr int kSendFlags = 0;
+#endif
+
+static bool SetNonBlocking(int fd)
+{
+  const int flags = fcntl(fd, F_GETFL, 0);
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1 && fcntl(fd, F_SETFD, FD_CLOEXEC) != -1;
+}
+
+UnixAdminServer::~UnixAdminServer()
+{
+  Shutdown();
+}
+
+bool UnixAdminServer::Open()
+{
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  if (path().size() >= sizeof(addr.sun_path))
+  {
+    if (log())
+      log()->Error("The admin socket path \"%s\" is too long.", path().c_str());
+    return false;
+  }
+  memcpy(addr.sun_path, path().c_str(), path().size() + 1);
+
+  if (pipe(wake_fds_) != 0 || !SetNonBlocking(wake_fds_[0]) || !SetNonBlocking(wake_fds_[1]))
+  {
+    Close();
+    return false;
+  }
+
+  listen_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listen_fd_ == -1 || !SetNonBlocking(listen_fd_))
+  {
+    Close();
+    return false;
+  }
+
+  // A socket file left behind by a previous run would make bind() fail. The permissions are set
+  // before listen(), so there is no moment when another user could connect.
+  unlink(path().c_str());
+  if (bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      chmod(path().c_str(), kSocketMode) != 0 || listen(listen_fd_, static_cast<int>(kMaxConnections)) != 0)
+  {
+    if (log())
+      log()->Error("Error binding the admin socket: '%s'", strerror(errno));
+    Close();
+    return false;
+  }
+
+  return true;
+}
+
+void UnixAdminServer::Close()
+{
+  for (auto& conn : connections_)
+    close(conn.fd);
+  connections_.clear();
+
+  if (listen_fd_ != -1)
+  {
+    close(listen_fd_);
+    unlink(path().c_str());
+    listen_fd_ = -1;
+  }
+
+  for (int& fd : wake_fds_)
+  {
+    if (fd != -1)
+      close(fd);
+    fd = -1;
+  }
+}
+
+void UnixAdminServer::Wake()
+{
+  const char byte = 0;
+  [[maybe_unused]] const ssize_t result = write(wake_fds_[1], &byte, 1);
+}
+
+// The first two entries are always the wake pipe and the listening socket; the connections follow
+// in order.
+void UnixAdminServer::Serve()
+{
+  std::vector<pollfd> fds;
+  while (running())
+  {
+    fds.clear();
+    fds.push_back(pollfd{wake_fds_[0], POLLIN, 0});
+    fds.push_back(pollfd{listen_fd_, POLLIN, 0});
+    for (const auto& conn : connections_)
+      fds.push_back(pollfd{conn.fd, static_cast<short>(conn.output.empty() ? POLLIN : POLLOUT), 0});
+
+    if (poll(fds.data(), static_cast<nfds_t>(fds.size()), -1) < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      if (log())
+        log()->Error("Error waiting on the admin socket: '%s'", strerror(errno));
+      break;
+    }
+
+    // Walk backwards so that closed connections can be erased without disturbing the indices.
+    for (size_t i = connections_.size(); i-- > 0;)
+    {
+      const short revents = fds[i + 2].revents;
+      if (!revents)
+        continue;
+
+      Connection& conn = connections_[i];
+      bool        keep = true;
+      if (revents & POLLOUT)
+        keep = Send(conn);
+      else if (revents & (POLLIN | POLLHUP | POLLERR))
+        keep = Receive(conn);
+
+      if (!keep)
+      {
+        close(conn.fd);
+        connections_.erase(connections_.begin() + static_cast<std::ptrdiff_t>(i));
+      }
+    }
+
+    if (fds[1].revents & POLLIN)
+      Accept();
+  }
+}
+
+void UnixAdminServer::Accept()
+{
+  int fd;
+  while ((fd = accept(listen_fd_, nullptr, nullptr)) != -1)
+  {
+    if (connections_.size() >= kMaxConnections || !SetNonBlocking(fd))
+    {
+      close(fd);
+      continue;
+    }
+#ifdef SO_NOSIGPIPE
+    const int no_sigpipe = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+    Connection conn;
+    conn.fd = fd;
+    connections_.push_back(std::move(conn));
+  }
+}
+
+// Reads once per wakeup, so that a client sending continuously can't starve the others. Returns
+// false if the connection should be closed.
+bool UnixAdminServer::Receive(Connection& conn)
+{
+  if (conn.closing)
+    return false;
+
+  char          buf[1024];
+  const ssize_t received = recv(conn.fd, buf, sizeof(buf), 0);
+  if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+    return true;
+  if (received <= 0)
+    return false;  // Closed by the client, or an error
+
+  conn.input.append(buf, static_cast<size_t>(received));
+  conn.closing = !ProcessInput(conn.input, conn.output);
+  return Send(conn);
+}
+
+// Sends as much of the pending output as the socket will take. Returns false if the connection
+// should be closed.
+bool UnixAdminServer::Send(Connection& conn)
+{
+  while (!conn.output.empty())
+  {
+    const ssize_t sent = send(conn.fd, conn.output.data(), conn.output.size(), kSendFlags);
+    if (sent > 0)
+    {
+      conn.output.erase(0, static_cast<size_t>(sent));
+      continue;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+      return true;
+    return false;
+  }
+  return !conn.closing;
+}
@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef UNIX_ADMIN_SERVER_H_
+#define UNIX_ADMIN_SERVER_H_
+
+#include <string>
+#include <vector>
+#include "admin_server.h"
+
+// UnixAdminServer : The AdminServer for Linux and macOS, which listens on a Unix domain socket.
+//
+// The socket file is only accessible to the user the service runs as. Every descriptor is
+// non-blocking and the server thread waits on all of them with poll(), so several clients can be
+// connected at once and none of them can hold up the others. A pipe wakes the thread for shutdown.
+class UnixAdminServer : public AdminServer
+{
+public:
+  // More connections than this are closed as soon as they are accepted.
+  static constexpr size_t kMaxConnections = 4;
+
+  using AdminServer::AdminServer;
+  ~UnixAdminServer() override;
+
+protected:
+  bool Open() override;
+  void Close() override;
+  void Serve() override;
+  void Wake() override;
+
+private:
+  struct Connection
+  {
+    int         fd{-1};
+    std::string input;
+    std::string output;
+    bool        closing{false};  // Close once the output is sent
+  };
+
+  int                     listen_fd_{-1};
+  int                     wake_fds_[2]{-1, -1};
+  std::vector<Connection> connections_;  // Only touched from the server thread
+
+  void Accept();
+  bool Receive(Connection& conn);
+  bool Send(Connection& conn);
+};
+
+#endif  // UNIX_ADMIN_SERVER_H_
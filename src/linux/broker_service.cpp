@@ -0,0 +1,227 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "broker_service.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include "sd_notify.h"
+
+static constexpr int kMaxEpollEvents = 8;
+
+static sigset_t HandledSignals()
+{
+  sigset_t signals;
+  sigemptyset(&signals);
+  for (int signum : {SIGTERM, SIGINT, SIGHUP, SIGUSR1})
+    sigaddset(&signals, signum);
+  return signals;
+}
+
+bool BrokerService::BlockSignals()
+{
+  const sigset_t signals = HandledSignals();
+  return (sigprocmask(SIG_BLOCK, &signals, nullptr) == 0);
+}
+
+bool BrokerService::Run()
+{
+  if (!OpenEventSources())
+  {
+    CloseEventSources();
+    return false;
+  }
+
+  // systemd is told the service is ready once the broker has been started, so that units ordered
+  // after this one find it running.
+  bool shell_result = false;
+  if (!shell_thread_.Start([this, &shell_result]() {
+                      shell_result = broker_shell_.Run([]() { SdNotify("READY=1\nSTATUS=Running"); });
+                      const uint64_t done = 1;
+                      (void)write(shell_done_fd_, &done, sizeof(done));
+                    })
+           .IsOk())
+  {
+    CloseEventSources();
+    return false;
+  }
+
+  bool running = true;
+  while (running)
+  {
+    struct epoll_event events[kMaxEpollEvents];
+    const int event_count = epoll_wait(epoll_fd_, events, kMaxEpollEvents, config_watcher_.TimeUntilCheck());
+    if (event_count < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      log().Critical("FATAL: Waiting for service events failed (%s).", strerror(errno));
+      break;
+    }
+
+    for (int i = 0; i < event_count; ++i)
+    {
+      const int fd = events[i].data.fd;
+      if (fd == signal_fd_)
+        running = HandleSignals() && running;
+      else if (fd == config_watcher_.fd())
+        config_watcher_.Receive();
+      else if (fd == network_monitor_.fd())
+        HandleAddrChanges();
+      else if (fd == clock_fd_)
+        HandleClockChange();
+      else if (fd == shell_done_fd_)
+        running = false;
+    }
+
+    config_watcher_.CheckIfDue();
+  }
+
+  SdNotify("STOPPING=1");
+  broker_shell_.AsyncShutdown();
+  shell_thread_.Join();
+  CloseEventSources();
+  return shell_result;
+}
+
+// Only the signalfd and the eventfd are required; the service still runs, without the
+// corresponding change detection, if any of the others can't be set up.
+bool BrokerService::OpenEventSources()
+{
+  epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epoll_fd_ < 0)
+  {
+    log().Critical("FATAL: Could not create the service's epoll instance (%s).", strerror(errno));
+    return false;
+  }
+
+  const sigset_t signals = HandledSignals();
+  signal_fd_ = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+  shell_done_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (!AddToEpoll(signal_fd_) || !AddToEpoll(shell_done_fd_))
+  {
+    log().Critical("FATAL: Could not set up signal handling (%s).", strerror(errno));
+    return false;
+  }
+
+  // The shell's thread hasn't started yet, so its configuration can be copied safely.
+  const std::string conf_path = os_interface_.config_dir() + "/" + LinuxBrokerOsInterface::kConfFileName;
+  if (!config_watcher_.Start(conf_path, broker_shell_.config(), &log()) || !AddToEpoll(config_watcher_.fd()))
+    log().Warning("WARNING: Failed to initialize broker config change notification (%s).", strerror(errno));
+
+  if (!network_monitor_.Open() || !AddToEpoll(network_monitor_.fd()))
+    log().Error("ERROR: Failed to set up address table change detection (%s).", strerror(errno));
+
+  clock_fd_ = timerfd_create(CLOCK_REALTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (!ArmClockChangeTimer() || !AddToEpoll(clock_fd_))
+    log().Warning("WARNING: Failed to set up system clock change detection (%s).", strerror(errno));
+
+  return true;
+}
+
+void BrokerService::CloseEventSources()
+{
+  network_monitor_.Close();
+  config_watcher_.Stop();
+  for (int* fd : {&clock_fd_, &shell_done_fd_, &signal_fd_, &epoll_fd_})
+  {
+    if (*fd >= 0)
+      close(*fd);
+    *fd = -1;
+  }
+}
+
+bool BrokerService::AddToEpoll(int fd)
+{
+  if (fd < 0)
+    return false;
+
+  struct epoll_event event;
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+  return (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == 0);
+}
+
+// A timer that never expires, but is cancelled whenever the system clock is set.
+bool BrokerService::ArmClockChangeTimer()
+{
+  if (clock_fd_ < 0)
+    return false;
+
+  struct itimerspec never;
+  memset(&never, 0, sizeof(never));
+  never.it_value.tv_sec = std::numeric_limits<time_t>::max();
+  return (timerfd_settime(clock_fd_, TFD_TIMER_ABSTIME | TFD_TIMER_CANCEL_ON_SET, &never, nullptr) == 0);
+}
+
+// Returns false if the service should stop.
+bool BrokerService::HandleSignals()
+{
+  bool                    keep_running = true;
+  struct signalfd_siginfo info;
+  while (read(signal_fd_, &info, sizeof(info)) == sizeof(info))
+  {
+    switch (info.ssi_signo)
+    {
+      case SIGTERM:
+      case SIGINT:
+        keep_running = false;
+        break;
+      case SIGHUP:
+        log().Info("SIGHUP received - requesting config reload.");
+        broker_shell_.RequestConfigReload();
+        break;
+      case SIGUSR1:
+        broker_shell_.DumpFlightRecorder();
+        break;
+      default:
+        break;
+    }
+  }
+  return keep_running;
+}
+
+void BrokerService::HandleAddrChanges()
+{
+  network_monitor_.Receive();
+  const auto changes = network_monitor_.TakeChanges();
+  if (!changes.empty())
+    broker_shell_.HandleNetworkChanges(changes);
+}
+
+void BrokerService::HandleClockChange()
+{
+  uint64_t expirations;
+  if (read(clock_fd_, &expirations, sizeof(expirations)) < 0 && errno == ECANCELED)
+  {
+    os_interface_.HandleTimeChange();
+    ArmClockChangeTimer();
+  }
+}
@@ -0,0 +1,80 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef BROKER_SERVICE_H_
+#define BROKER_SERVICE_H_
+
+#include "broker_shell.h"
+#include "inotify_config_watcher.h"
+#include "linux_broker_os_interface.h"
+#include "netlink_network_monitor.h"
+#include "etcpal/cpp/thread.h"
+
+// BrokerService : Runs the broker shell on its own thread, and a control loop on the calling
+// thread that waits on a single epoll instance for:
+//
+// - SIGTERM and SIGINT, which shut the service down; SIGHUP, which reloads the configuration; and
+//   SIGUSR1, which writes out the flight recorder. These arrive through a signalfd.
+// - Changes to the configuration file and fragment directory (inotify). Bursts of changes are
+//   coalesced and only changed settings are passed on to the shell; see ConfigWatcher.
+// - Address changes (rtnetlink), which restart the broker after a cooldown if they affect an
+//   interface it listens on.
+// - The system clock being set (a timerfd), which refreshes the log timestamps.
+class BrokerService
+{
+public:
+  // Block the signals the control loop handles. Must be called before any thread is started, so
+  // that every thread inherits the mask and the signals are only delivered to the signalfd.
+  static bool BlockSignals();
+
+  bool Init() { return broker_shell_.Init(); }
+  void Deinit() { broker_shell_.Deinit(); }
+
+  // Returns when the service has been told to stop, or the shell stopped on its own.
+  bool Run();
+
+  void PrintVersion() { broker_shell_.PrintVersion(); }
+
+  etcpal::Logger& log() { return broker_shell_.log(); }
+
+private:
+  LinuxBrokerOsInterface os_interface_;
+  BrokerShell            broker_shell_{os_interface_};
+
+  etcpal::Thread        shell_thread_;
+  InotifyConfigWatcher  config_watcher_{broker_shell_};
+  NetlinkNetworkMonitor network_monitor_;
+
+  int epoll_fd_{-1};
+  int signal_fd_{-1};
+  int clock_fd_{-1};
+  int shell_done_fd_{-1};  // An eventfd, written when the shell's Run() returns
+
+  bool OpenEventSources();
+  void CloseEventSources();
+  bool AddToEpoll(int fd);
+
+  bool ArmClockChangeTimer();
+
+  bool HandleSignals();
+  void HandleAddrChanges();
+  void HandleClockChange();
+};
+
+#endif  // BROKER_SERVICE_H_
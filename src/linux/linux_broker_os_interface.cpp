@@ -0,0 +1,292 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "linux_broker_os_interface.h"
+
+#include "broker_version.h"
+#include "unix_admin_server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pwd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+// Log file mode = rw-r--r-- because it only needs to be written to by the service
+static constexpr mode_t kLogFileMode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
+
+static constexpr char kSystemConfigDir[] = "/etc/RDMnetBroker";
+static constexpr char kSystemLogDir[] = "/var/log/RDMnetBroker";
+static constexpr char kAdminSocketFileName[] = "admin.sock";
+static constexpr char kUserDirName[] = "RDMnetBroker";
+
+// ioprio_set() has no glibc wrapper; see ioprio_set(2).
+static constexpr int kIoprioWhoProcess = 1;
+static constexpr int kIoprioClassIdle = 3;
+static constexpr int kIoprioClassShift = 13;
+
+// An XDG base directory (e.g. $XDG_CONFIG_HOME), or its default under the home directory if the
+// variable is unset. The specification says relative paths are invalid and must be ignored.
+static std::string GetXdgDir(const char* env_var, const char* home_relative_default)
+{
+  const char* dir = getenv(env_var);
+  if (dir && dir[0] == '/')
+    return dir;
+
+  const char* home = getenv("HOME");
+  if (!home || !home[0])
+  {
+    const struct passwd* pw = getpwuid(geteuid());
+    home = pw ? pw->pw_dir : "";
+  }
+  return std::string(home) + "/" + home_relative_default;
+}
+
+static std::string GetConfigDir()
+{
+  if (geteuid() == 0)
+    return kSystemConfigDir;
+  return GetXdgDir("XDG_CONFIG_HOME", ".config") + "/" + kUserDirName;
+}
+
+static std::string GetLogDir()
+{
+  if (geteuid() == 0)
+    return kSystemLogDir;
+  return GetXdgDir("XDG_STATE_HOME", ".local/state") + "/" + kUserDirName;
+}
+
+static bool CreateInitialLogFileIfNeeded(const std::string& log_file_path)
+{
+  bool success = false;
+
+  // Call open for this to prevent truncation of an existing log.
+  int fd = open(log_file_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, kLogFileMode);
+  if (fd >= 0)
+    success = (close(fd) == 0);
+
+  if (!success)
+    std::cout << "FATAL: Could not create file '" << log_file_path << "' (" << strerror(errno) << ").\n";
+
+  return success;
+}
+
+// Only called when the timestamp provider refreshes, not for every log message.
+static int GetUtcOffset()
+{
+  // Look at TZ and /etc/localtime again, in case the time zone has changed.
+  tzset();
+
+  const time_t now = time(nullptr);
+  struct tm    local_time;
+  if (!localtime_r(&now, &local_time))
+    return 0;
+  return static_cast<int>(local_time.tm_gmtoff / 60);
+}
+
+LinuxBrokerOsInterface::LinuxBrokerOsInterface()
+    : config_dir_(GetConfigDir()), log_dir_(GetLogDir()), timestamp_provider_(GetUtcOffset)
+{
+}
+
+LinuxBrokerOsInterface::~LinuxBrokerOsInterface()
+{
+  log_writer_.Shutdown();
+  log_archiver_.Shutdown();
+
+  if (log_stream_.is_open())
+    log_stream_.close();
+}
+
+std::string LinuxBrokerOsInterface::GetLogFilePath() const
+{
+  return log_dir_ + "/" + kLogFileName;
+}
+
+bool LinuxBrokerOsInterface::OpenLogFile()
+{
+  // There's no installer to set up the log directory, so create it here if needed.
+  std::error_code ec;
+  std::filesystem::create_directories(log_dir_, ec);
+  if (ec)
+  {
+    std::cout << "FATAL: Could not create directory '" << log_dir_ << "' (" << ec.message() << ").\n";
+    return false;
+  }
+
+  const std::string log_file_path = GetLogFilePath();
+  if (!CreateInitialLogFileIfNeeded(log_file_path))
+    return false;
+
+  // Keep appending to the existing log; it is rotated by size from the log writer thread.
+  log_stream_.open(log_file_path, std::ios::out | std::ios::app);
+
+  struct stat    log_stat;
+  const uint64_t file_size = (stat(log_file_path.c_str(), &log_stat) == 0) ? static_cast<uint64_t>(log_stat.st_size)
+                                                                            : 0;
+
+  // Write an initial message to the log file
+  auto time = GetLogTimestamp();
+  log_stream_ << "Starting RDMnet Broker Service version " << BrokerVersion::VersionString() << " on "
+              << std::setfill('0') << std::setw(4) << time.get().year << "-" << std::setw(2) << time.get().month << "-"
+              << std::setw(2) << time.get().day << " at " << std::setw(2) << time.get().hour << ":" << std::setw(2)
+              << time.get().minute << ":" << std::setw(2) << time.get().second << "...\n";
+  log_stream_.flush();
+
+  // Log messages are written to the file from the writer's own thread from here on. The rotation
+  // limits aren't known until the configuration has been read, so rotation starts out disabled.
+  AsyncLogWriter::Settings writer_settings;
+  writer_settings.max_file_size = 0;
+  if (!log_writer_.Startup(*this, writer_settings, file_size))
+  {
+    std::cout << "FATAL: Error starting the log writer thread.\n";
+    return false;
+  }
+
+  return true;
+}
+
+std::pair<std::string, std::ifstream> LinuxBrokerOsInterface::GetConfFile(etcpal::Logger& log)
+{
+  // Make sure the directory exists, so that it can be watched for a configuration file to appear.
+  std::error_code ec;
+  std::filesystem::create_directories(config_dir_, ec);
+  if (ec)
+    log.Warning("WARNING: Could not create configuration directory %s (%s).", config_dir_.c_str(),
+                ec.message().c_str());
+
+  const std::string conf_file_path = config_dir_ + "/" + kConfFileName;
+  std::ifstream     conf_file(conf_file_path);
+  return std::make_pair(conf_file_path, std::move(conf_file));
+}
+
+etcpal::LogTimestamp LinuxBrokerOsInterface::GetLogTimestamp()
+{
+  return timestamp_provider_.Now();
+}
+
+void LinuxBrokerOsInterface::HandleTimeChange()
+{
+  timestamp_provider_.Invalidate();
+}
+
+void LinuxBrokerOsInterface::SetLogWriterSettings(const AsyncLogWriter::Settings& settings)
+{
+  log_writer_.SetSettings(settings);
+}
+
+// The archiver isn't started until the first settings arrive, so that it never prunes old logs
+// using limits other than the configured ones.
+void LinuxBrokerOsInterface::SetLogArchiveSettings(const LogArchiver::Settings& settings)
+{
+  if (log_archiver_.Startup(
+          GetLogFilePath(), settings,
+          [this](const std::string& message) { log_writer_.Push(("WARNING: " + message).c_str()); },
+          // Both priorities apply to the calling thread only.
+          []() {
+            setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+            syscall(SYS_ioprio_set, kIoprioWhoProcess, 0, kIoprioClassIdle << kIoprioClassShift);
+          }))
+  {
+    return;
+  }
+
+  log_archiver_.SetSettings(settings);
+}
+
+// The socket lives next to the log file, in a directory that belongs to the service's user.
+std::unique_ptr<AdminServer> LinuxBrokerOsInterface::CreateAdminServer(AdminServer::Handler& handler)
+{
+  return std::make_unique<UnixAdminServer>(handler, log_dir_ + "/" + kAdminSocketFileName);
+}
+
+// The resident set size is the second field of /proc/self/statm, in pages.
+BrokerOsInterface::ResourceUsage LinuxBrokerOsInterface::GetResourceUsage() const
+{
+  ResourceUsage usage;
+
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm)
+  {
+    unsigned long long size_pages = 0;
+    unsigned long long resident_pages = 0;
+    if (fscanf(statm, "%llu %llu", &size_pages, &resident_pages) == 2)
+      usage.resident_bytes = resident_pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    fclose(statm);
+  }
+
+  struct rusage rusage;
+  if (getrusage(RUSAGE_SELF, &rusage) == 0)
+  {
+    usage.cpu_time_us = static_cast<uint64_t>(rusage.ru_utime.tv_sec + rusage.ru_stime.tv_sec) * 1000000u +
+                        static_cast<uint64_t>(rusage.ru_utime.tv_usec + rusage.ru_stime.tv_usec);
+  }
+
+  usage.dropped_log_messages = log_writer_.dropped_count();
+  return usage;
+}
+
+void LinuxBrokerOsInterface::HandleLogMessage(const EtcPalLogStrings& strings)
+{
+  log_writer_.PushLogMessage(strings);
+}
+
+void LinuxBrokerOsInterface::WriteLogData(const char* data, size_t size)
+{
+  if (log_stream_.is_open())
+    log_stream_.write(data, static_cast<std::streamsize>(size));
+}
+
+void LinuxBrokerOsInterface::FlushLogData()
+{
+  if (log_stream_.is_open())
+    log_stream_.flush();
+}
+
+void LinuxBrokerOsInterface::RotateLogFile()
+{
+  if (log_stream_.is_open())
+    log_stream_.close();
+
+  // If rotating fails, keep appending to the current file rather than truncating it.
+  auto rotate_error = log_archiver_.RotateOut();
+
+  const std::string log_file_path = GetLogFilePath();
+  CreateInitialLogFileIfNeeded(log_file_path);
+  log_stream_.open(log_file_path, std::ios::out | (rotate_error ? std::ios::app : std::ios::trunc));
+
+  // Write an error message to the log file if it is open and there was an error rotating the logs
+  if (rotate_error && log_stream_.is_open())
+  {
+    log_stream_ << "WARNING: rotating log files failed with error: \"" << rotate_error.message() << "\"\n";
+    log_stream_.flush();
+  }
+}
@@ -0,0 +1,73 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef LINUX_BROKER_OS_INTERFACE_H_
+#define LINUX_BROKER_OS_INTERFACE_H_
+
+#include <string>
+#include "async_log_writer.h"
+#include "broker_os_interface.h"
+#include "log_archiver.h"
+#include "log_timestamp_provider.h"
+
+// Run as root (normally by systemd), the service uses /etc/RDMnetBroker for its configuration and
+// /var/log/RDMnetBroker for its logs. Run as any other user, it uses the RDMnetBroker directories
+// under $XDG_CONFIG_HOME and $XDG_STATE_HOME instead, so that it can be tried out without elevated
+// permissions.
+class LinuxBrokerOsInterface final : public BrokerOsInterface, private AsyncLogWriter::Output
+{
+public:
+  static constexpr char kConfFileName[] = "broker.conf";
+  static constexpr char kLogFileName[] = "broker.log";
+
+  LinuxBrokerOsInterface();
+  ~LinuxBrokerOsInterface();
+
+  void HandleTimeChange();
+
+  const std::string& config_dir() const { return config_dir_; }
+
+  // BrokerOsInterface
+  std::string                           GetLogFilePath() const override;
+  bool                                  OpenLogFile() override;
+  std::pair<std::string, std::ifstream> GetConfFile(etcpal::Logger& log) override;
+  void                                  SetLogWriterSettings(const AsyncLogWriter::Settings& settings) override;
+  void                                  SetLogArchiveSettings(const LogArchiver::Settings& settings) override;
+  ResourceUsage                         GetResourceUsage() const override;
+  std::unique_ptr<AdminServer>          CreateAdminServer(AdminServer::Handler& handler) override;
+
+  // etcpal::LogMessageHandler
+  etcpal::LogTimestamp GetLogTimestamp() override;
+  void                 HandleLogMessage(const EtcPalLogStrings& strings) override;
+
+private:
+  std::string          config_dir_;
+  std::string          log_dir_;
+  std::ofstream        log_stream_;
+  AsyncLogWriter       log_writer_;
+  LogArchiver          log_archiver_;
+  LogTimestampProvider timestamp_provider_;
+
+  // AsyncLogWriter::Output
+  void WriteLogData(const char* data, size_t size) override;
+  void FlushLogData() override;
+  void RotateLogFile() override;
+};
+
+#endif  // LINUX_BROKER_OS_INTERFACE_H_
@@ -0,0 +1,114 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+// The Linux entry point for the broker service. The service runs in the foreground; systemd
+// (see tools/install/linux) runs it as a daemon.
+
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include "broker_service.h"
+#include "flight_recorder.h"
+
+#include <cstdio>
+#include <cstdlib>
+
+void PrintUsage(const char* app_name)
+{
+  std::printf("Usage: %s [OPTIONAL_ACTION]\n", app_name ? app_name : "");
+  std::printf("\n");
+  std::printf("Optional actions:\n");
+  std::printf("  -version  Print version information and exit.\n");
+}
+
+// If saving the flight recorder takes longer than this, SIGALRM kills the process, so that a crash
+// never leaves it hung.
+static constexpr unsigned int kCrashDumpTimeoutS = 10;
+
+// The crash handler runs on its own stack, so that it still runs after the main thread's stack
+// overflows. Other threads have no alternate stack; a stack overflow there kills the process
+// without a dump.
+static char crash_handler_stack[64 * 1024];
+
+// Save the flight recorder, then crash as we would have without this handler: the handler was reset
+// to the default action when it was called, so the raised signal is delivered with that action once
+// the handler returns.
+void HandleCrashSignal(int signum)
+{
+  alarm(kCrashDumpTimeoutS);
+  FlightRecorder::DumpForCrash("fatal signal");
+  raise(signum);
+}
+
+bool InstallCrashHandler()
+{
+  stack_t stack{};
+  stack.ss_sp = crash_handler_stack;
+  stack.ss_size = sizeof(crash_handler_stack);
+  if (sigaltstack(&stack, nullptr) != 0)
+    return false;
+
+  struct sigaction action = {};
+  action.sa_handler = HandleCrashSignal;
+  action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+  sigemptyset(&action.sa_mask);
+  for (int signum : {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT})
+  {
+    if (sigaction(signum, &action, nullptr) != 0)
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  if (!BrokerService::BlockSignals())
+  {
+    std::printf("Error: Couldn't set up signal handling.\n");
+    return EXIT_FAILURE;
+  }
+
+  if (!InstallCrashHandler())
+    std::printf("Warning: Couldn't set up the crash handler; the flight recorder won't be saved on a crash.\n");
+
+  BrokerService service;
+
+  if (argc > 1)
+  {
+    if (strcmp(argv[1], "-version") == 0)
+    {
+      service.PrintVersion();
+      return EXIT_SUCCESS;
+    }
+
+    PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (!service.Init())
+    return EXIT_FAILURE;
+
+  int retval = EXIT_SUCCESS;
+  if (!service.Run())
+    retval = EXIT_FAILURE;
+
+  service.Deinit();
+
+  return retval;  // If Run() succeeded, getting here means the control loop ended, likely due to SIGTERM.
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "sd_notify.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+bool SdNotify(const std::string& state)
+{
+  const char* socket_path = getenv("NOTIFY_SOCKET");
+  if (!socket_path || (socket_path[0] != '/' && socket_path[0] != '@'))
+    return false;
+
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+
+  const size_t path_length = strlen(socket_path);
+  if (path_length >= sizeof(addr.sun_path))
+    return false;
+  memcpy(addr.sun_path, socket_path, path_length);
+
+  // A leading '@' names a socket in the abstract namespace.
+  if (addr.sun_path[0] == '@')
+    addr.sun_path[0] = '\0';
+
+  int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return false;
+
+  const socklen_t addr_length = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + path_length);
+  const ssize_t   sent = sendto(fd, state.data(), state.size(), MSG_NOSIGNAL,
+                                reinterpret_cast<const struct sockaddr*>(&addr), addr_length);
+  close(fd);
+  return (sent == static_cast<ssize_t>(state.size()));
+}
@@ -0,0 +1,31 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef SD_NOTIFY_H_
+#define SD_NOTIFY_H_
+
+#include <string>
+
+// Send a state change such as "READY=1" to systemd, over the datagram socket named by the
+// NOTIFY_SOCKET environment variable (see sd_notify(3)). This speaks the protocol directly so that
+// the service doesn't depend on libsystemd. Returns false, doing nothing, if the service was not
+// started by systemd with Type=notify.
+bool SdNotify(const std::string& state);
+
+#endif  // SD_NOTIFY_H_
@@ -0,0 +1,211 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+// Renders a broker log file written with "log_format": "binary" as text or as JSON lines. Plain
+// text lines in the file are passed through unchanged, so any broker log can be given to it.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "nlohmann/json.hpp"
+#include "binary_log_record.h"
+#include "broker_version.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+static constexpr size_t kReadChunkSize = 64 * 1024;
+
+void PrintUsage(const char* app_name)
+{
+  std::printf("Usage: %s [--json] [FILE]\n", app_name ? app_name : "");
+  std::printf("\n");
+  std::printf("Decode a binary RDMnet Broker log file to standard output. Reads from standard\n");
+  std::printf("input if FILE is omitted or is \"-\"; compressed logs can be piped through gunzip.\n");
+  std::printf("\n");
+  std::printf("  --json     Write one JSON object per log message instead of text.\n");
+  std::printf("  --version  Print the version and exit.\n");
+}
+
+class LogDecoder
+{
+public:
+  explicit LogDecoder(bool json) : json_(json) {}
+
+  // Decode as much of buf_ as possible. Returns false if a record is incomplete at the end of the
+  // input.
+  bool Process(bool end_of_input)
+  {
+    size_t pos = 0;
+    while (pos < buf_.size())
+    {
+      const char*  data = buf_.data() + pos;
+      const size_t size = buf_.size() - pos;
+
+      if (static_cast<uint8_t>(data[0]) == BinaryLogRecord::kMarker)
+      {
+        BinaryLogRecord record;
+        size_t          consumed = 0;
+        const auto      result = BinaryLogRecord::Decode(data, size, record, consumed);
+        if (result == BinaryLogRecord::DecodeResult::kOk)
+        {
+          Output(json_ ? record.ToJson() : record.ToText());
+          pos += consumed;
+          continue;
+        }
+        if (result == BinaryLogRecord::DecodeResult::kNeedMoreData)
+        {
+          if (end_of_input)
+          {
+            buf_.clear();
+            return false;
+          }
+          break;
+        }
+        // Otherwise, this isn't a record after all; treat it as text.
+      }
+
+      const char* newline = static_cast<const char*>(std::memchr(data, '\n', size));
+      if (!newline && !end_of_input)
+        break;
+
+      const size_t line_length = newline ? static_cast<size_t>(newline - data) : size;
+      OutputTextLine(std::string(data, line_length));
+      pos += newline ? line_length + 1 : line_length;
+    }
+
+    buf_.erase(0, pos);
+    return true;
+  }
+
+  std::string& buf() { return buf_; }
+
+private:
+  bool        json_;
+  std::string buf_;
+
+  void OutputTextLine(std::string line)
+  {
+    if (!line.empty() && line.back() == '\r')
+      line.pop_back();
+
+    if (json_)
+    {
+      nlohmann::json json_line;
+      json_line["text"] = line;
+      Output(json_line.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+    }
+    else
+    {
+      Output(line);
+    }
+  }
+
+  static void Output(const std::string& line)
+  {
+    std::fwrite(line.data(), 1, line.size(), stdout);
+    std::fputc('\n', stdout);
+  }
+};
+
+int main(int argc, char* argv[])
+{
+  bool        json = false;
+  const char* file_name = nullptr;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--json") == 0)
+    {
+      json = true;
+    }
+    else if (std::strcmp(argv[i], "--version") == 0)
+    {
+      std::printf("%s log decoder version %s\n", BrokerVersion::ProductNameString().c_str(),
+                  BrokerVersion::VersionString().c_str());
+      return 0;
+    }
+    else if (std::strcmp(argv[i], "--help") == 0 || std::strcmp(argv[i], "-h") == 0)
+    {
+      PrintUsage(argv[0]);
+      return 0;
+    }
+    else if (!file_name)
+    {
+      file_name = argv[i];
+    }
+    else
+    {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  FILE* input = stdin;
+  if (file_name && std::strcmp(file_name, "-") != 0)
+  {
+    input = std::fopen(file_name, "rb");
+    if (!input)
+    {
+      std::fprintf(stderr, "Error opening \"%s\": %s\n", file_name, std::strerror(errno));
+      return 1;
+    }
+  }
+#ifdef _WIN32
+  else
+  {
+    _setmode(_fileno(stdin), _O_BINARY);
+  }
+#endif
+
+  LogDecoder decoder(json);
+  char       chunk[kReadChunkSize];
+  bool       complete = true;
+  while (true)
+  {
+    const size_t bytes_read = std::fread(chunk, 1, sizeof(chunk), input);
+    decoder.buf().append(chunk, bytes_read);
+
+    const bool end_of_input = (bytes_read < sizeof(chunk));
+    complete = decoder.Process(end_of_input);
+    if (end_of_input)
+      break;
+  }
+
+  std::fflush(stdout);
+
+  const bool read_error = (std::ferror(input) != 0);
+  if (input != stdin)
+    std::fclose(input);
+
+  if (read_error)
+  {
+    std::fprintf(stderr, "Error reading input.\n");
+    return 1;
+  }
+  if (!complete)
+  {
+    std::fprintf(stderr, "Warning: the log ends with an incomplete record.\n");
+    return 2;
+  }
+  return 0;
+}
@@ -19,12 +19,11 @@
 
 #include "broker_service.h"
 
+#include <signal.h>
 #include <CoreFoundation/CoreFoundation.h>
+#include <dispatch/dispatch.h>
 #include <notify_keys.h>
 
-// The interval to wait before restarting (in case we get blasted with tons of notifications at once)
-static constexpr uint32_t kNetworkChangeCooldownMs = 5000u;
-
 static void InterfaceChangeCallback(CFNotificationCenterRef center,
                                     void*                   observer,
                                     CFStringRef             name,
@@ -35,10 +34,21 @@ static void InterfaceChangeCallback(CFNotificationCenterRef center,
   if (service)
   {
     service->log().Info("A network change was detected - requesting broker restart.");
-    service->RequestRestart(kNetworkChangeCooldownMs);
+    service->RequestRestart(RestartScheduler::Trigger::kNetworkChange);
   }
 }
 
+static void TimeChangeCallback(CFNotificationCenterRef center,
+                               void*                   observer,
+                               CFStringRef             name,
+                               const void*             object,
+                               CFDictionaryRef         userInfo)
+{
+  BrokerService* service = reinterpret_cast<BrokerService*>(observer);
+  if (service)
+    service->HandleTimeChange();
+}
+
 bool BrokerService::Run()
 {
   if (shell_thread_.Start([this]() { broker_shell_.Run(); }).IsOk())
@@ -47,6 +57,28 @@ bool BrokerService::Run()
     CFNotificationCenterAddObserver(CFNotificationCenterGetDarwinNotifyCenter(), this, InterfaceChangeCallback,
                                     CFSTR(kNotifySCNetworkChange), nullptr,
                                     CFNotificationSuspensionBehaviorDeliverImmediately);
+
+    // Log timestamps are based on a cached UTC offset and wall-clock time; refresh them right away
+    // when either changes.
+    for (CFStringRef notification : {CFSTR(kNotifyTimeZoneChange), CFSTR(kNotifyClockSet)})
+    {
+      CFNotificationCenterAddObserver(CFNotificationCenterGetDarwinNotifyCenter(), this, TimeChangeCallback,
+                                      notification, nullptr, CFNotificationSuspensionBehaviorDeliverImmediately);
+    }
+
+    // "kill -USR1" writes out the flight recorder. The dump runs on the main queue, which is
+    // serviced by the run loop below, rather than in the signal handler.
+    signal(SIGUSR1, SIG_IGN);
+    dump_signal_source_ = dispatch_source_create(DISPATCH_SOURCE_TYPE_SIGNAL, SIGUSR1, 0, dispatch_get_main_queue());
+    if (dump_signal_source_)
+    {
+      dispatch_set_context(dump_signal_source_, &broker_shell_);
+      dispatch_source_set_event_handler_f(dump_signal_source_, [](void* context) {
+        static_cast<BrokerShell*>(context)->DumpFlightRecorder();
+      });
+      dispatch_resume(dump_signal_source_);
+    }
+
     CFRunLoopRun();  // This loop handles the change detection and must be run on the main() thread.
     return true;
   }
@@ -56,9 +88,10 @@ bool BrokerService::Run()
 
 void BrokerService::AsyncShutdown()
 {
-  CFNotificationCenterRemoveObserver(CFNotificationCenterGetDarwinNotifyCenter(), this, CFSTR(kNotifySCNetworkChange),
-                                     nullptr);
+  CFNotificationCenterRemoveEveryObserver(CFNotificationCenterGetDarwinNotifyCenter(), this);
   CFRunLoopStop(CFRunLoopGetMain());
+  if (dump_signal_source_)
+    dispatch_source_cancel(dump_signal_source_);
 
   broker_shell_.AsyncShutdown();
   shell_thread_.Join();
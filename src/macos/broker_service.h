@@ -23,6 +23,7 @@
 #include "broker_shell.h"
 #include "mac_broker_os_interface.h"
 #include "etcpal/cpp/thread.h"
+#include <dispatch/dispatch.h>
 
 class BrokerService
 {
@@ -35,7 +36,11 @@ public:
 
   void PrintVersion() { broker_shell_.PrintVersion(); }
 
-  void RequestRestart(uint32_t cooldown_ms = 0u) { broker_shell_.RequestRestart(cooldown_ms); }
+  void RequestRestart(RestartScheduler::Trigger trigger = RestartScheduler::Trigger::kManual)
+  {
+    broker_shell_.RequestRestart(trigger);
+  }
+  void HandleTimeChange() { os_interface_.HandleTimeChange(); }
 
   etcpal::Logger& log() { return broker_shell_.log(); }
 
@@ -43,7 +48,8 @@ private:
   MacBrokerOsInterface os_interface_;
   BrokerShell          broker_shell_{os_interface_};
 
-  etcpal::Thread shell_thread_;
+  etcpal::Thread    shell_thread_;
+  dispatch_source_t dump_signal_source_{nullptr};
 };
 
 #endif  // BROKER_SERVICE_H_
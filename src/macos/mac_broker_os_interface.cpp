@@ -20,17 +20,19 @@
 #include "mac_broker_os_interface.h"
 
 #include "broker_version.h"
+#include "unix_admin_server.h"
 
-#include <cmath>
-#include <copyfile.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <pthread.h>
 #include <iostream>
 #include <string>
 #include <string.h>
+#include <sys/resource.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
+#include <mach/mach.h>
 #include <vector>
 
 #include <CoreFoundation/CoreFoundation.h>
@@ -40,8 +42,7 @@ static constexpr mode_t kLogFileMode = S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH;
 
 static constexpr char* kLogFilePath = "/usr/local/var/log/RDMnetBroker/broker.log";
 static constexpr char* kConfigFilePath = "/usr/local/etc/RDMnetBroker/broker.conf";
-
-static constexpr int kMaxLogRotationFiles = 5;
+static constexpr char* kAdminSocketPath = "/usr/local/var/log/RDMnetBroker/admin.sock";
 
 bool CreateInitialLogFileIfNeeded()
 {
@@ -59,59 +60,29 @@ bool CreateInitialLogFileIfNeeded()
   return success;
 }
 
-bool RotateLog(const std::string& src_path, const std::string& dest_path)
+// Only called when the timestamp provider refreshes, not for every log message.
+static int GetUtcOffset()
 {
-  bool success = false;
-
-  int src_fd = open(src_path.c_str(), O_RDONLY);
-  if (src_fd >= 0)
-  {
-    int dest_fd = creat(dest_path.c_str(), kLogFileMode);
-    if (dest_fd >= 0)
-    {
-      if (fcopyfile(src_fd, dest_fd, nullptr, COPYFILE_ALL) == 0)
-        success = true;
-
-      close(dest_fd);
-    }
-
-    close(src_fd);
-  }
-
-  return success;
+  // CoreFoundation caches the system time zone until it is told to look again.
+  CFTimeZoneResetSystem();
+  CFTimeZoneRef time_zone = CFTimeZoneCopySystem();
+  if (!time_zone)
+    return 0;
+
+  const CFTimeInterval utc_offset = CFTimeZoneGetSecondsFromGMT(time_zone, CFAbsoluteTimeGetCurrent()) / 60.0;
+  CFRelease(time_zone);
+  return static_cast<int>(utc_offset);
 }
 
-bool RotateLogs()
+MacBrokerOsInterface::MacBrokerOsInterface() : timestamp_provider_(GetUtcOffset)
 {
-  auto LogBackupFilePath = [&](int rotate_number) {
-    if (rotate_number == 0)
-      return std::string(kLogFilePath);
-
-    return (std::string(kLogFilePath) + "." + std::to_string(rotate_number));
-  };
-
-  // Determine the highest log backup file that already exists on the system
-  int rotate_number = 0;
-  for (; rotate_number < kMaxLogRotationFiles; ++rotate_number)
-  {
-    auto backup_path = LogBackupFilePath(rotate_number);
-    bool file_exists = (access(backup_path.c_str(), F_OK) == 0);
-    if (!file_exists)
-      break;
-  }
-
-  // Copy each file to the next higher-numbered file, starting with the highest and working down.
-  while (--rotate_number >= 0)
-  {
-    if (!RotateLog(LogBackupFilePath(rotate_number), LogBackupFilePath(rotate_number + 1)))
-      return false;
-  }
-
-  return true;
 }
 
 MacBrokerOsInterface::~MacBrokerOsInterface()
 {
+  log_writer_.Shutdown();
+  log_archiver_.Shutdown();
+
   if (log_stream_.is_open())
     log_stream_.close();
 }
@@ -123,14 +94,15 @@ std::string MacBrokerOsInterface::GetLogFilePath() const
 
 bool MacBrokerOsInterface::OpenLogFile()
 {
-  // Rotate first. This does nothing if the directory is empty.
-  bool rotate_error = !RotateLogs();
-
-  // Now create the initial log if the directory is empty.
+  // Create the initial log if the directory is empty.
   if (!CreateInitialLogFileIfNeeded())
     return false;
 
-  log_stream_.open(GetLogFilePath());
+  // Keep appending to the existing log; it is rotated by size from the log writer thread.
+  log_stream_.open(GetLogFilePath(), std::ios::out | std::ios::app);
+
+  struct stat log_stat;
+  const uint64_t file_size = (stat(kLogFilePath, &log_stat) == 0) ? static_cast<uint64_t>(log_stat.st_size) : 0;
 
   // Write an initial message to the log file
   auto time = GetLogTimestamp();
@@ -138,13 +110,18 @@ bool MacBrokerOsInterface::OpenLogFile()
               << std::setfill('0') << std::setw(4) << time.get().year << "-" << std::setw(2) << time.get().month << "-"
               << std::setw(2) << time.get().day << " at " << std::setw(2) << time.get().hour << ":" << std::setw(2)
               << time.get().minute << ":" << std::setw(2) << time.get().second << "...\n";
-
-  // Write an error message to the log file if it is open and there was an error rotating the logs
-  if (rotate_error)
-    log_stream_ << "WARNING: rotating log files failed with error: \"" << strerror(errno) << "\"\n";
-
   log_stream_.flush();
 
+  // Log messages are written to the file from the writer's own thread from here on. The rotation
+  // limits aren't known until the configuration has been read, so rotation starts out disabled.
+  AsyncLogWriter::Settings writer_settings;
+  writer_settings.max_file_size = 0;
+  if (!log_writer_.Startup(*this, writer_settings, file_size))
+  {
+    std::cout << "FATAL: Error starting the log writer thread.\n";
+    return false;
+  }
+
   return true;
 }
 
@@ -157,23 +134,92 @@ std::pair<std::string, std::ifstream> MacBrokerOsInterface::GetConfFile(etcpal::
 
 etcpal::LogTimestamp MacBrokerOsInterface::GetLogTimestamp()
 {
-  CFTimeZoneRef   time_zone = CFTimeZoneCopySystem();
-  CFAbsoluteTime  abs_time = CFAbsoluteTimeGetCurrent();
-  CFGregorianDate date = CFAbsoluteTimeGetGregorianDate(abs_time, time_zone);
-  unsigned int    msec = static_cast<unsigned int>(fmod(date.second, 1.0) * 1000.0);
-  CFTimeInterval  utc_offset = CFTimeZoneGetSecondsFromGMT(time_zone, abs_time) / 60.0;
+  return timestamp_provider_.Now();
+}
+
+void MacBrokerOsInterface::HandleTimeChange()
+{
+  timestamp_provider_.Invalidate();
+}
 
-  return etcpal::LogTimestamp(static_cast<unsigned int>(date.year), static_cast<unsigned int>(date.month),
-                              static_cast<unsigned int>(date.day), static_cast<unsigned int>(date.hour),
-                              static_cast<unsigned int>(date.minute), static_cast<unsigned int>(date.second), msec,
-                              static_cast<int>(utc_offset));
+void MacBrokerOsInterface::SetLogWriterSettings(const AsyncLogWriter::Settings& settings)
+{
+  log_writer_.SetSettings(settings);
+}
+
+// The archiver isn't started until the first settings arrive, so that it never prunes old logs
+// using limits other than the configured ones.
+void MacBrokerOsInterface::SetLogArchiveSettings(const LogArchiver::Settings& settings)
+{
+  if (log_archiver_.Startup(
+          kLogFilePath, settings,
+          [this](const std::string& message) { log_writer_.Push(("WARNING: " + message).c_str()); },
+          // The background QoS class also throttles the thread's disk I/O.
+          []() { pthread_set_qos_class_self_np(QOS_CLASS_BACKGROUND, 0); }))
+  {
+    return;
+  }
+
+  log_archiver_.SetSettings(settings);
+}
+
+std::unique_ptr<AdminServer> MacBrokerOsInterface::CreateAdminServer(AdminServer::Handler& handler)
+{
+  return std::make_unique<UnixAdminServer>(handler, kAdminSocketPath);
+}
+
+BrokerOsInterface::ResourceUsage MacBrokerOsInterface::GetResourceUsage() const
+{
+  ResourceUsage usage;
+
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t      count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+    usage.resident_bytes = info.resident_size;
+
+  struct rusage rusage;
+  if (getrusage(RUSAGE_SELF, &rusage) == 0)
+  {
+    usage.cpu_time_us = static_cast<uint64_t>(rusage.ru_utime.tv_sec + rusage.ru_stime.tv_sec) * 1000000u +
+                        static_cast<uint64_t>(rusage.ru_utime.tv_usec + rusage.ru_stime.tv_usec);
+  }
+
+  usage.dropped_log_messages = log_writer_.dropped_count();
+  return usage;
 }
 
 void MacBrokerOsInterface::HandleLogMessage(const EtcPalLogStrings& strings)
+{
+  log_writer_.PushLogMessage(strings);
+}
+
+void MacBrokerOsInterface::WriteLogData(const char* data, size_t size)
+{
+  if (log_stream_.is_open())
+    log_stream_.write(data, static_cast<std::streamsize>(size));
+}
+
+void MacBrokerOsInterface::FlushLogData()
+{
+  if (log_stream_.is_open())
+    log_stream_.flush();
+}
+
+void MacBrokerOsInterface::RotateLogFile()
 {
   if (log_stream_.is_open())
+    log_stream_.close();
+
+  // If rotating fails, keep appending to the current file rather than truncating it.
+  auto rotate_error = log_archiver_.RotateOut();
+
+  CreateInitialLogFileIfNeeded();
+  log_stream_.open(GetLogFilePath(), std::ios::out | (rotate_error ? std::ios::app : std::ios::trunc));
+
+  // Write an error message to the log file if it is open and there was an error rotating the logs
+  if (rotate_error && log_stream_.is_open())
   {
-    log_stream_ << strings.human_readable << "\n";
+    log_stream_ << "WARNING: rotating log files failed with error: \"" << rotate_error.message() << "\"\n";
     log_stream_.flush();
   }
 }
@@ -20,25 +20,42 @@
 #ifndef WIN_BROKER_OS_INTERFACE_H_
 #define WIN_BROKER_OS_INTERFACE_H_
 
+#include "async_log_writer.h"
 #include "broker_os_interface.h"
+#include "log_archiver.h"
+#include "log_timestamp_provider.h"
 
-class MacBrokerOsInterface final : public BrokerOsInterface
+class MacBrokerOsInterface final : public BrokerOsInterface, private AsyncLogWriter::Output
 {
 public:
-  MacBrokerOsInterface() = default;
+  MacBrokerOsInterface();
   ~MacBrokerOsInterface();
 
+  void HandleTimeChange();
+
   // BrokerOsInterface
   std::string                           GetLogFilePath() const override;
   bool                                  OpenLogFile() override;
   std::pair<std::string, std::ifstream> GetConfFile(etcpal::Logger& log) override;
+  void                                  SetLogWriterSettings(const AsyncLogWriter::Settings& settings) override;
+  void                                  SetLogArchiveSettings(const LogArchiver::Settings& settings) override;
+  ResourceUsage                         GetResourceUsage() const override;
+  std::unique_ptr<AdminServer>          CreateAdminServer(AdminServer::Handler& handler) override;
 
   // etcpal::LogMessageHandler
   etcpal::LogTimestamp GetLogTimestamp() override;
   void                 HandleLogMessage(const EtcPalLogStrings& strings) override;
 
 private:
-  std::ofstream log_stream_;
+  std::ofstream        log_stream_;
+  AsyncLogWriter       log_writer_;
+  LogArchiver          log_archiver_;
+  LogTimestampProvider timestamp_provider_;
+
+  // AsyncLogWriter::Output
+  void WriteLogData(const char* data, size_t size) override;
+  void FlushLogData() override;
+  void RotateLogFile() override;
 };
 
 #endif  // WIN_BROKER_OS_INTERFACE_H_
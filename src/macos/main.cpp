@@ -20,7 +20,9 @@
 // The MacOS entry point for the broker service.
 
 #include <signal.h>
+#include <unistd.h>
 #include "broker_service.h"
+#include "flight_recorder.h"
 
 #include <iostream>
 #include <cstdlib>
@@ -33,6 +35,45 @@ void HandleSignal(int signum)
     service.AsyncShutdown();
 }
 
+// If saving the flight recorder takes longer than this, SIGALRM kills the process, so that a crash
+// never leaves it hung.
+static constexpr unsigned int kCrashDumpTimeoutS = 10;
+
+// The crash handler runs on its own stack, so that it still runs after the main thread's stack
+// overflows. Other threads have no alternate stack; a stack overflow there kills the process
+// without a dump.
+static char crash_handler_stack[64 * 1024];
+
+// Save the flight recorder, then crash as we would have without this handler: the handler was reset
+// to the default action when it was called, so the raised signal is delivered with that action once
+// the handler returns.
+void HandleCrashSignal(int signum)
+{
+  alarm(kCrashDumpTimeoutS);
+  FlightRecorder::DumpForCrash("fatal signal");
+  raise(signum);
+}
+
+bool InstallCrashHandler()
+{
+  stack_t stack{};
+  stack.ss_sp = crash_handler_stack;
+  stack.ss_size = sizeof(crash_handler_stack);
+  if (sigaltstack(&stack, nullptr) != 0)
+    return false;
+
+  struct sigaction action = {};
+  action.sa_handler = HandleCrashSignal;
+  action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+  sigemptyset(&action.sa_mask);
+  for (int signum : {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT})
+  {
+    if (sigaction(signum, &action, nullptr) != 0)
+      return false;
+  }
+  return true;
+}
+
 int main()
 {
   if (!service.Init())
@@ -41,6 +82,9 @@ int main()
   // As a launchd daemon, we must set up a SIGTERM handler
   signal(SIGTERM, HandleSignal);
 
+  if (!InstallCrashHandler())
+    std::cout << "Warning: Couldn't set up the crash handler; the flight recorder won't be saved on a crash.\n";
+
   int retval = EXIT_SUCCESS;
   if (!service.Run())
     retval = EXIT_FAILURE;
@@ -23,9 +23,6 @@
 #include <strsafe.h>
 #include <system_error>
 
-// The interval to wait before restarting (in case we get blasted with tons of notifications at once)
-static constexpr uint32_t kNetworkChangeCooldownMs = 5000u;
-
 BrokerService* BrokerService::service_{nullptr};
 
 auto assert_log_fn = [](const char* msg) { std::cout << msg << "\n"; };
@@ -78,7 +75,9 @@ etcpal::Expected<HANDLE> BrokerService::InitConfigChangeDetectionHandle()
 
   std::wstring prefix(L"\\\\?\\");  // FindFirstChangeNotification requires this for wide paths
   std::wstring path = prefix + service_->os_interface_.GetConfigPath();
-  return FindFirstChangeNotification(path.c_str(), false, FILE_NOTIFY_CHANGE_LAST_WRITE);
+  // The subtree is watched for the fragment directory. Writes to anything else in the directory (like
+  // the snapshot) are filtered out by the config watcher, since they don't change the files' contents.
+  return FindFirstChangeNotification(path.c_str(), true, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
 }
 
 bool BrokerService::ProcessAddrChanges(PHANDLE handle, LPOVERLAPPED overlap)
@@ -92,7 +91,7 @@ bool BrokerService::ProcessAddrChanges(PHANDLE handle, LPOVERLAPPED overlap)
   {
     case WAIT_OBJECT_0:  // The address table has changed
       service_->broker_shell_.log().Info("A network change was detected - requesting broker restart.");
-      service_->broker_shell_.RequestRestart(kNetworkChangeCooldownMs);
+      service_->broker_shell_.RequestRestart(RestartScheduler::Trigger::kNetworkChange);
       ResetEvent(overlap->hEvent);
       return GetNextAddrChange(handle, overlap);
     case WAIT_TIMEOUT:  // The address table didn't change, do nothing
@@ -107,7 +106,7 @@ bool BrokerService::ProcessAddrChanges(PHANDLE handle, LPOVERLAPPED overlap)
   return true;
 }
 
-bool BrokerService::ProcessConfigChanges(HANDLE change_handle)
+bool BrokerService::ProcessConfigChanges(HANDLE change_handle, ConfigWatcher& config_watcher)
 {
   if (!BROKER_ASSERT_VERIFY(service_, assert_log_fn))
     return false;
@@ -121,12 +120,13 @@ bool BrokerService::ProcessConfigChanges(HANDLE change_handle)
   }
   else
   {
-    DWORD status = WaitForSingleObject(change_handle, kWaitMs);
+    const int   until_check = config_watcher.TimeUntilCheck();
+    const DWORD wait_ms = (until_check >= 0 && static_cast<DWORD>(until_check) < kWaitMs) ? until_check : kWaitMs;
+    DWORD       status = WaitForSingleObject(change_handle, wait_ms);
     switch (status)
     {
-      case WAIT_OBJECT_0:  // The config has changed
-        service_->broker_shell_.log().Info("The broker configuration file has changed - requesting broker restart.");
-        service_->broker_shell_.RequestRestart();
+      case WAIT_OBJECT_0:  // The config may have changed
+        config_watcher.EventReceived();
         if (!FindNextChangeNotification(change_handle))
         {
           service_->broker_shell_.log().Warning(
@@ -145,6 +145,7 @@ bool BrokerService::ProcessConfigChanges(HANDLE change_handle)
     }
   }
 
+  config_watcher.CheckIfDue();
   return true;
 }
 
@@ -169,11 +170,16 @@ DWORD WINAPI BrokerService::ServiceThread(LPVOID* /*arg*/)
     }
   });
 
-  // Also set up config change detection
+  // Also set up config change detection. The shell's Run() hasn't started yet, so its configuration
+  // can be copied safely.
+  BrokerShell&  shell = service_->broker_shell_;
+  ConfigWatcher config_watcher(shell);
+  config_watcher.Start(service_->os_interface_.GetConfFile(shell.log()).first, shell.config(), &shell.log());
+
   bool           stop_config_change_detection = false;
-  etcpal::Thread config_change_detection_thread([&stop_config_change_detection]() {
+  etcpal::Thread config_change_detection_thread([&stop_config_change_detection, &config_watcher]() {
     auto change_handle = InitConfigChangeDetectionHandle();
-    while (change_handle && !stop_config_change_detection && ProcessConfigChanges(*change_handle))
+    while (change_handle && !stop_config_change_detection && ProcessConfigChanges(*change_handle, config_watcher))
       ;
   });
 
@@ -240,7 +246,8 @@ void WINAPI BrokerService::ServiceMain(DWORD argc, PWSTR* argv)
 //     SERVICE_CONTROL_STOP
 //
 //   This parameter can also be a user-defined control code ranges from 128
-//   to 255.
+//   to 255. kDumpFlightRecorderControl writes out the flight recorder, e.g.
+//   sc control "ETC RDMnet Broker" 128.
 //
 void WINAPI BrokerService::ServiceCtrlHandler(DWORD control_code)
 {
@@ -255,6 +262,9 @@ void WINAPI BrokerService::ServiceCtrlHandler(DWORD control_code)
     case SERVICE_CONTROL_SHUTDOWN:
       service_->Shutdown();
       break;
+    case kDumpFlightRecorderControl:
+      service_->broker_shell_.DumpFlightRecorder();
+      break;
     default:
       break;
   }
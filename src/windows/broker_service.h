@@ -27,12 +27,16 @@
 #include <WS2tcpip.h>
 #include <iphlpapi.h>
 #include "broker_shell.h"
+#include "config_watcher.h"
 #include "win_broker_os_interface.h"
 #include "etcpal/cpp/error.h"
 
 class BrokerService
 {
 public:
+  // A user-defined service control code that asks the service to write out its flight recorder.
+  static constexpr DWORD kDumpFlightRecorderControl = 128;
+
   // Register the executable for a service with the Service Control Manager (SCM). After you call
   // Run(BrokerService*), the SCM issues a Start command, which results in a call to the OnStart
   // method in the service. This method blocks until the service has stopped.
@@ -70,7 +74,7 @@ private:
   static bool                     GetNextAddrChange(PHANDLE handle, LPOVERLAPPED overlap);
   static etcpal::Expected<HANDLE> InitConfigChangeDetectionHandle();
   static bool                     ProcessAddrChanges(PHANDLE handle, LPOVERLAPPED overlap);
-  static bool                     ProcessConfigChanges(HANDLE change_handle);
+  static bool                     ProcessConfigChanges(HANDLE change_handle, ConfigWatcher& config_watcher);
 
   static BrokerService* service_;  // The singleton service instance.
 
@@ -29,6 +29,7 @@
 #include "broker_common.h"
 #include "broker_service.h"
 #include "broker_version.h"
+#include "flight_recorder.h"
 
 void PrintVersion()
 {
@@ -47,8 +48,18 @@ void PrintUsage(const wchar_t* app_name)
   std::wprintf(L"  -version  Print version information and exit.\n");
 }
 
+// Save the flight recorder before the process goes down, then let Windows Error Reporting handle
+// the crash as usual.
+LONG WINAPI HandleUnhandledException(EXCEPTION_POINTERS* /*exception_info*/)
+{
+  FlightRecorder::DumpForCrash("unhandled exception");
+  return EXCEPTION_CONTINUE_SEARCH;
+}
+
 int wmain(int argc, wchar_t* argv[])
 {
+  SetUnhandledExceptionFilter(HandleUnhandledException);
+
   bool debug_mode = false;
 
   auto service = std::make_unique<BrokerService>(kServiceName);
@@ -0,0 +1,167 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "pipe_admin_server.h"
+
+#include <sddl.h>
+
+// Full access for the local system account and the built-in administrators; nobody else.
+static constexpr char kPipeSecurity[] = "D:P(A;;GA;;;SY)(A;;GA;;;BA)";
+
+static constexpr DWORD kPipeBufferSize = 4096;
+
+PipeAdminServer::~PipeAdminServer()
+{
+  Shutdown();
+}
+
+bool PipeAdminServer::Open()
+{
+  stop_event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+  io_event_ = CreateEventA(nullptr, TRUE, FALSE, nullptr);
+  if (!stop_event_ || !io_event_ ||
+      !ConvertStringSecurityDescriptorToSecurityDescriptorA(kPipeSecurity, SDDL_REVISION_1, &security_descriptor_,
+                                                            nullptr) ||
+      !CreatePipeInstance())
+  {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void PipeAdminServer::Close()
+{
+  if (pipe_ != INVALID_HANDLE_VALUE)
+    CloseHandle(pipe_);
+  pipe_ = INVALID_HANDLE_VALUE;
+
+  for (HANDLE* event : {&stop_event_, &io_event_})
+  {
+    if (*event)
+      CloseHandle(*event);
+    *event = nullptr;
+  }
+
+  if (security_descriptor_)
+    LocalFree(security_descriptor_);
+  security_descriptor_ = nullptr;
+}
+
+void PipeAdminServer::Wake()
+{
+  SetEvent(stop_event_);
+}
+
+// The pipe has a single instance, which insists on being the first, so no other process can have
+// created the pipe ahead of the service to impersonate it. The instance is kept open and reused for
+// every client, so the name is never free for another process to take.
+bool PipeAdminServer::CreatePipeInstance()
+{
+  SECURITY_ATTRIBUTES security_attributes{sizeof(SECURITY_ATTRIBUTES), security_descriptor_, FALSE};
+  pipe_ = CreateNamedPipeA(path().c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED | FILE_FLAG_FIRST_PIPE_INSTANCE,
+                           PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT | PIPE_REJECT_REMOTE_CLIENTS, 1,
+                           kPipeBufferSize, kPipeBufferSize, 0, &security_attributes);
+  return pipe_ != INVALID_HANDLE_VALUE;
+}
+
+void PipeAdminServer::Serve()
+{
+  while (running())
+  {
+    OVERLAPPED overlapped{};
+    overlapped.hEvent = io_event_;
+    ResetEvent(io_event_);
+
+    DWORD transferred = 0;
+    bool  connected = ConnectNamedPipe(pipe_, &overlapped) != FALSE;
+    if (!connected)
+    {
+      const DWORD error = GetLastError();
+      if (error == ERROR_PIPE_CONNECTED)
+        connected = true;
+      else if (error == ERROR_IO_PENDING)
+        connected = WaitForIo(overlapped, transferred);
+    }
+
+    if (connected)
+      ServeClient();
+
+    // Ready the same instance for the next client.
+    DisconnectNamedPipe(pipe_);
+  }
+}
+
+// Wait for an overlapped operation on the pipe, or for the server to be stopped, in which case the
+// operation is cancelled. Returns true if the operation completed successfully.
+bool PipeAdminServer::WaitForIo(OVERLAPPED& overlapped, DWORD& transferred)
+{
+  const HANDLE events[] = {io_event_, stop_event_};
+  if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0)
+  {
+    CancelIo(pipe_);
+    GetOverlappedResult(pipe_, &overlapped, &transferred, TRUE);
+    return false;
+  }
+  return GetOverlappedResult(pipe_, &overlapped, &transferred, FALSE) != FALSE;
+}
+
+void PipeAdminServer::ServeClient()
+{
+  std::string input;
+  bool        keep_open = true;
+  while (running())
+  {
+    char       buf[1024];
+    OVERLAPPED overlapped{};
+    overlapped.hEvent = io_event_;
+    ResetEvent(io_event_);
+
+    DWORD received = 0;
+    if (!ReadFile(pipe_, buf, sizeof(buf), &received, &overlapped))
+    {
+      if (GetLastError() != ERROR_IO_PENDING || !WaitForIo(overlapped, received))
+        return;
+    }
+    // Disconnecting discards whatever the client hasn't read yet, so after "quit" the connection is
+    // kept until the client closes its end, and anything more it sends is ignored.
+    if (received == 0 || !keep_open)
+      continue;
+
+    input.append(buf, received);
+    std::string output;
+    keep_open = ProcessInput(input, output);
+
+    size_t sent = 0;
+    while (sent < output.size())
+    {
+      overlapped = OVERLAPPED{};
+      overlapped.hEvent = io_event_;
+      ResetEvent(io_event_);
+
+      DWORD written = 0;
+      if (!WriteFile(pipe_, output.data() + sent, static_cast<DWORD>(output.size() - sent), &written, &overlapped))
+      {
+        if (GetLastError() != ERROR_IO_PENDING || !WaitForIo(overlapped, written))
+          return;
+      }
+      sent += written;
+    }
+  }
+}
@@ -0,0 +1,58 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef PIPE_ADMIN_SERVER_H_
+#define PIPE_ADMIN_SERVER_H_
+
+#include <winsock2.h>
+#include <windows.h>
+#include <string>
+#include "admin_server.h"
+
+// PipeAdminServer : The Windows AdminServer, which listens on a named pipe.
+//
+// The pipe rejects remote clients and is only accessible to the local system account and
+// administrators. Clients are served one at a time with overlapped I/O, so the server thread can
+// always be stopped promptly, even with a client connected.
+class PipeAdminServer : public AdminServer
+{
+public:
+  static constexpr char kDefaultPath[] = "\\\\.\\pipe\\RDMnetBroker";
+
+  using AdminServer::AdminServer;
+  ~PipeAdminServer() override;
+
+protected:
+  bool Open() override;
+  void Close() override;
+  void Serve() override;
+  void Wake() override;
+
+private:
+  HANDLE               pipe_{INVALID_HANDLE_VALUE};
+  HANDLE               stop_event_{nullptr};
+  HANDLE               io_event_{nullptr};
+  PSECURITY_DESCRIPTOR security_descriptor_{nullptr};
+
+  bool CreatePipeInstance();
+  bool WaitForIo(OVERLAPPED& overlapped, DWORD& transferred);
+  void ServeClient();
+};
+
+#endif  // PIPE_ADMIN_SERVER_H_
@@ -24,15 +24,16 @@
 #include <Windows.h>
 #include <ShlObj.h>
 #include <datetimeapi.h>
+#include <Psapi.h>
 #include "service_utils.h"
 #include "broker_common.h"
 #include "broker_version.h"
+#include "pipe_admin_server.h"
 
 constexpr const WCHAR                  kRelativeConfDirName[] = L"\\ETC\\RDMnetBroker\\Config";
 constexpr const WCHAR                  kConfFileName[] = L"broker.conf";
 static const std::vector<std::wstring> kRelativeLogFilePath = {L"ETC", L"RDMnetBroker", L"Logs"};
 static const std::wstring              kLogFileName = L"broker.log";
-static constexpr int                   kMaxLogRotationFiles = 5;
 
 std::string ConvertWstringToUtf8(const std::wstring& str)
 {
@@ -53,7 +54,27 @@ std::string ConvertWstringToUtf8(const std::wstring& str)
   return std::string{};
 }
 
-WindowsBrokerOsInterface::WindowsBrokerOsInterface()
+// Only called when the timestamp provider refreshes, not for every log message.
+static int GetUtcOffset()
+{
+  int                   utc_offset = 0;
+  TIME_ZONE_INFORMATION tzinfo;
+  switch (GetTimeZoneInformation(&tzinfo))
+  {
+    case TIME_ZONE_ID_UNKNOWN:
+    case TIME_ZONE_ID_STANDARD:
+      utc_offset = -(tzinfo.Bias + tzinfo.StandardBias);
+      break;
+    case TIME_ZONE_ID_DAYLIGHT:
+      utc_offset = -(tzinfo.Bias + tzinfo.DaylightBias);
+      break;
+    default:
+      break;
+  }
+  return utc_offset;
+}
+
+WindowsBrokerOsInterface::WindowsBrokerOsInterface() : timestamp_provider_(GetUtcOffset)
 {
   PWSTR   program_data_path;
   HRESULT get_known_folder_res = SHGetKnownFolderPath(FOLDERID_ProgramData, 0, NULL, &program_data_path);
@@ -74,6 +95,9 @@ WindowsBrokerOsInterface::WindowsBrokerOsInterface()
 
 WindowsBrokerOsInterface::~WindowsBrokerOsInterface()
 {
+  log_writer_.Shutdown();
+  log_archiver_.Shutdown();
+
   if (log_file_)
     fclose(log_file_);
 }
@@ -119,15 +143,17 @@ bool WindowsBrokerOsInterface::OpenLogFile()
     }
   }
 
-  DWORD rotate_result = RotateLogs();
-
-  log_file_ = _wfsopen(log_file_path_.c_str(), L"w", _SH_DENYWR);
+  // Keep appending to the existing log; it is rotated by size from the log writer thread.
+  log_file_ = _wfsopen(log_file_path_.c_str(), L"a", _SH_DENYWR);
   if (!log_file_)
   {
     std::cout << "FATAL: Error opening log file for writing: " << errno << '\n';
     return false;
   }
 
+  _fseeki64(log_file_, 0, SEEK_END);
+  const auto file_size = _ftelli64(log_file_);
+
   // Write an initial message to the log file
   auto time = GetLogTimestamp();
   char initial_msg[512];
@@ -136,17 +162,18 @@ bool WindowsBrokerOsInterface::OpenLogFile()
                    BrokerVersion::VersionString().c_str(), time.get().year, time.get().month, time.get().day,
                    time.get().hour, time.get().minute, time.get().second);
   fwrite(initial_msg, sizeof(char), strnlen_s(initial_msg, 100), log_file_);
+  fflush(log_file_);
 
-  // Write an error message to the log file if it is open and there was an error rotating the logs
-  if (rotate_result != 0)
+  // Log messages are written to the file from the writer's own thread from here on. The rotation
+  // limits aren't known until the configuration has been read, so rotation starts out disabled.
+  AsyncLogWriter::Settings writer_settings;
+  writer_settings.max_file_size = 0;
+  if (!log_writer_.Startup(*this, writer_settings, file_size > 0 ? static_cast<uint64_t>(file_size) : 0))
   {
-    wchar_t error_msg[512];
-    GetLastErrorMessage(rotate_result, error_msg, 512);
-    auto log_msg = "WARNING: rotating log files failed with error: \"" + ConvertWstringToUtf8(error_msg) + "\"\n";
-    fwrite(log_msg.c_str(), sizeof(char), log_msg.size(), log_file_);
+    std::cout << "FATAL: Error starting the log writer thread.\n";
+    return false;
   }
 
-  fflush(log_file_);
   return true;
 }
 
@@ -166,70 +193,91 @@ std::pair<std::string, std::ifstream> WindowsBrokerOsInterface::GetConfFile(etcp
 
 etcpal::LogTimestamp WindowsBrokerOsInterface::GetLogTimestamp()
 {
-  int                   utc_offset = 0;
-  TIME_ZONE_INFORMATION tzinfo;
-  switch (GetTimeZoneInformation(&tzinfo))
+  return timestamp_provider_.Now();
+}
+
+void WindowsBrokerOsInterface::SetLogWriterSettings(const AsyncLogWriter::Settings& settings)
+{
+  log_writer_.SetSettings(settings);
+}
+
+// The archiver isn't started until the first settings arrive, so that it never prunes old logs
+// using limits other than the configured ones.
+void WindowsBrokerOsInterface::SetLogArchiveSettings(const LogArchiver::Settings& settings)
+{
+  if (log_archiver_.Startup(
+          log_file_path_, settings,
+          [this](const std::string& message) { log_writer_.Push(("WARNING: " + message).c_str()); },
+          // Background mode lowers the thread's I/O priority as well as its CPU priority.
+          []() { SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN); }))
   {
-    case TIME_ZONE_ID_UNKNOWN:
-    case TIME_ZONE_ID_STANDARD:
-      utc_offset = -(tzinfo.Bias + tzinfo.StandardBias);
-      break;
-    case TIME_ZONE_ID_DAYLIGHT:
-      utc_offset = -(tzinfo.Bias + tzinfo.DaylightBias);
-      break;
-    default:
-      break;
+    return;
   }
 
-  SYSTEMTIME win_time;
-  GetLocalTime(&win_time);
+  log_archiver_.SetSettings(settings);
+}
 
-  return etcpal::LogTimestamp(win_time.wYear, win_time.wMonth, win_time.wDay, win_time.wHour, win_time.wMinute,
-                              win_time.wSecond, win_time.wMilliseconds, utc_offset);
+std::unique_ptr<AdminServer> WindowsBrokerOsInterface::CreateAdminServer(AdminServer::Handler& handler)
+{
+  return std::make_unique<PipeAdminServer>(handler, PipeAdminServer::kDefaultPath);
 }
 
-void WindowsBrokerOsInterface::HandleLogMessage(const EtcPalLogStrings& strings)
+BrokerOsInterface::ResourceUsage WindowsBrokerOsInterface::GetResourceUsage() const
 {
-  if (log_file_)
+  ResourceUsage usage;
+
+  PROCESS_MEMORY_COUNTERS memory;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory)))
+    usage.resident_bytes = memory.WorkingSetSize;
+
+  // The process times are in 100-nanosecond units.
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
   {
-    std::string str(strings.human_readable);
-    fwrite(str.c_str(), sizeof(char), str.length(), log_file_);
-    fwrite("\n", sizeof(char), 1, log_file_);
-    fflush(log_file_);
+    const auto to_us = [](const FILETIME& time) {
+      return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 10u;
+    };
+    usage.cpu_time_us = to_us(kernel_time) + to_us(user_time);
   }
+
+  usage.dropped_log_messages = log_writer_.dropped_count();
+  return usage;
+}
+
+void WindowsBrokerOsInterface::HandleLogMessage(const EtcPalLogStrings& strings)
+{
+  log_writer_.PushLogMessage(strings);
 }
 
-DWORD WindowsBrokerOsInterface::RotateLogs()
+void WindowsBrokerOsInterface::WriteLogData(const char* data, size_t size)
 {
-  // If we don't have the primary log file, just stop early
-  DWORD file_attr = GetFileAttributes(log_file_path_.c_str());
-  if (file_attr == INVALID_FILE_ATTRIBUTES)
-    return 0;
+  if (log_file_)
+    fwrite(data, sizeof(char), size, log_file_);
+}
 
-  int  rotate_number = 1;
-  auto LogBackupFileName = [&](int rotate_number) { return log_file_path_ + L"." + std::to_wstring(rotate_number); };
+void WindowsBrokerOsInterface::FlushLogData()
+{
+  if (log_file_)
+    fflush(log_file_);
+}
 
-  // Determine the highest log backup file that already exists on the system
-  for (; rotate_number < kMaxLogRotationFiles; ++rotate_number)
+void WindowsBrokerOsInterface::RotateLogFile()
+{
+  if (log_file_)
   {
-    file_attr = GetFileAttributes(LogBackupFileName(rotate_number).c_str());
-    if (file_attr == INVALID_FILE_ATTRIBUTES)
-      break;
+    fclose(log_file_);
+    log_file_ = nullptr;
   }
 
-  // Copy each file to the next higher-numbered file, starting with the highest and working down.
-  while (rotate_number-- > 0)
-  {
-    std::wstring src_file_name;
-    if (rotate_number == 0)
-      src_file_name = log_file_path_;
-    else
-      src_file_name = LogBackupFileName(rotate_number);
+  // If rotating fails, keep appending to the current file rather than truncating it.
+  auto rotate_error = log_archiver_.RotateOut();
+  log_file_ = _wfsopen(log_file_path_.c_str(), (rotate_error ? L"a" : L"w"), _SH_DENYWR);
 
-    if (!CopyFile(src_file_name.c_str(), LogBackupFileName(rotate_number + 1).c_str(), FALSE))
-    {
-      return GetLastError();
-    }
+  // Write an error message to the log file if it is open and there was an error rotating the logs
+  if (log_file_ && rotate_error)
+  {
+    auto log_msg = "WARNING: rotating log files failed with error: \"" + rotate_error.message() + "\"\n";
+    fwrite(log_msg.c_str(), sizeof(char), log_msg.size(), log_file_);
+    fflush(log_file_);
   }
-  return 0;
 }
@@ -20,9 +20,12 @@
 #ifndef WIN_BROKER_OS_INTERFACE_H_
 #define WIN_BROKER_OS_INTERFACE_H_
 
+#include "async_log_writer.h"
 #include "broker_os_interface.h"
+#include "log_archiver.h"
+#include "log_timestamp_provider.h"
 
-class WindowsBrokerOsInterface final : public BrokerOsInterface
+class WindowsBrokerOsInterface final : public BrokerOsInterface, private AsyncLogWriter::Output
 {
 public:
   WindowsBrokerOsInterface();
@@ -34,6 +37,10 @@ public:
   std::string                           GetLogFilePath() const override;
   bool                                  OpenLogFile() override;
   std::pair<std::string, std::ifstream> GetConfFile(etcpal::Logger& log) override;
+  void                                  SetLogWriterSettings(const AsyncLogWriter::Settings& settings) override;
+  void                                  SetLogArchiveSettings(const LogArchiver::Settings& settings) override;
+  ResourceUsage                         GetResourceUsage() const override;
+  std::unique_ptr<AdminServer>          CreateAdminServer(AdminServer::Handler& handler) override;
 
   // etcpal::LogMessageHandler
   etcpal::LogTimestamp GetLogTimestamp() override;
@@ -42,11 +49,17 @@ public:
 private:
   static std::wstring GetProgramDataPath();
 
-  std::wstring program_data_path_;
-  std::wstring log_file_path_;
-  FILE*        log_file_{nullptr};
+  std::wstring         program_data_path_;
+  std::wstring         log_file_path_;
+  FILE*                log_file_{nullptr};
+  AsyncLogWriter       log_writer_;
+  LogArchiver          log_archiver_;
+  LogTimestampProvider timestamp_provider_;
 
-  DWORD RotateLogs();
+  // AsyncLogWriter::Output
+  void WriteLogData(const char* data, size_t size) override;
+  void FlushLogData() override;
+  void RotateLogFile() override;
 };
 
 #endif  // WIN_BROKER_OS_INTERFACE_H_
@@ -0,0 +1,65 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#ifndef TEMP_DIR_TEST_H_
+#define TEMP_DIR_TEST_H_
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "gtest/gtest.h"
+
+// TempDirTest : A test fixture with an empty temporary directory of its own, named after the test so
+// that tests running in parallel never share files. The directory is removed after the test.
+class TempDirTest : public testing::Test
+{
+protected:
+  std::filesystem::path dir_;
+
+  void SetUp() override
+  {
+    const testing::TestInfo* info = testing::UnitTest::GetInstance()->current_test_info();
+    dir_ = std::filesystem::temp_directory_path() / (std::string(info->test_suite_name()) + "_" + info->name());
+
+    std::error_code ec;
+    std::filesystem::remove_all(dir_, ec);
+    std::filesystem::create_directories(dir_);
+  }
+
+  void TearDown() override
+  {
+    std::error_code ec;
+    std::filesystem::remove_all(dir_, ec);
+  }
+
+  static void WriteFile(const std::filesystem::path& path, const std::string& contents)
+  {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << contents;
+  }
+
+  static std::string ReadFile(const std::filesystem::path& path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+};
+
+#endif  // TEMP_DIR_TEST_H_
@@ -0,0 +1,167 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "admin_server.h"
+
+#include <string>
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::DoAll;
+using testing::Return;
+using testing::SetArgReferee;
+
+class MockAdminHandler : public AdminServer::Handler
+{
+public:
+  MOCK_METHOD(std::string, HandleStatusRequest, (), (override));
+  MOCK_METHOD(std::string, HandleStatsRequest, (), (override));
+  MOCK_METHOD(bool, HandleRecentLogRequest, (std::string & output), (override));
+  MOCK_METHOD(void, HandleLogLevelChange, (int log_mask), (override));
+  MOCK_METHOD(void, HandleRestartRequest, (), (override));
+  MOCK_METHOD(bool, HandleTraceRequest, (AdminServer::TraceAction action, std::string& output), (override));
+};
+
+// Only the protocol is tested here, so the transport does nothing.
+class NullAdminServer : public AdminServer
+{
+public:
+  using AdminServer::AdminServer;
+  ~NullAdminServer() override { Shutdown(); }
+
+protected:
+  bool Open() override { return true; }
+  void Close() override {}
+  void Serve() override {}
+  void Wake() override {}
+};
+
+class TestAdminServer : public testing::Test
+{
+protected:
+  MockAdminHandler handler_;
+  NullAdminServer  server_{handler_, "test"};
+
+  // Send input and return the response, or "CLOSED" followed by it if the server closed the
+  // connection.
+  std::string Send(const std::string& input)
+  {
+    input_ += input;
+    std::string output;
+    if (!server_.ProcessInput(input_, output))
+      return "CLOSED " + output;
+    return output;
+  }
+
+  std::string input_;
+};
+
+TEST_F(TestAdminServer, DisabledByDefault)
+{
+  EXPECT_TRUE(server_.Startup(AdminServer::Settings{}));
+  EXPECT_FALSE(server_.running());
+}
+
+TEST_F(TestAdminServer, StatusIsPassedThrough)
+{
+  EXPECT_CALL(handler_, HandleStatusRequest()).WillOnce(Return("broker: up\n"));
+  EXPECT_EQ(Send("status\n"), "broker: up\nOK\n");
+}
+
+TEST_F(TestAdminServer, OutputWithoutTrailingNewlineIsTerminated)
+{
+  EXPECT_CALL(handler_, HandleStatsRequest()).WillOnce(Return("metric 1"));
+  EXPECT_EQ(Send("stats\r\n"), "metric 1\nOK\n");
+}
+
+TEST_F(TestAdminServer, PartialLinesWaitForTheRest)
+{
+  EXPECT_CALL(handler_, HandleRestartRequest()).Times(1);
+  EXPECT_EQ(Send("rest"), "");
+  EXPECT_EQ(Send("art\n"), "OK\n");
+}
+
+TEST_F(TestAdminServer, SeveralCommandsInOneRead)
+{
+  EXPECT_CALL(handler_, HandleStatusRequest()).WillOnce(Return("a\n"));
+  EXPECT_CALL(handler_, HandleStatsRequest()).WillOnce(Return("b\n"));
+  EXPECT_EQ(Send("status\n\n  stats  \n"), "a\nOK\nb\nOK\n");
+}
+
+TEST_F(TestAdminServer, RecentLogFailureIsAnError)
+{
+  EXPECT_CALL(handler_, HandleRecentLogRequest(_)).WillOnce(DoAll(SetArgReferee<0>("Disabled"), Return(false)));
+  EXPECT_EQ(Send("recent_log\n"), "ERR Disabled\n");
+}
+
+TEST_F(TestAdminServer, LogLevelIsParsed)
+{
+  EXPECT_CALL(handler_, HandleLogLevelChange(ETCPAL_LOG_UPTO(ETCPAL_LOG_DEBUG))).Times(1);
+  EXPECT_EQ(Send("log_level debug\n"), "OK\n");
+}
+
+TEST_F(TestAdminServer, InvalidLogLevelIsAnError)
+{
+  EXPECT_CALL(handler_, HandleLogLevelChange(_)).Times(0);
+  EXPECT_EQ(Send("log_level loud\n").rfind("ERR Usage: ", 0), 0u);
+  EXPECT_EQ(Send("log_level\n").rfind("ERR Usage: ", 0), 0u);
+}
+
+TEST_F(TestAdminServer, LogLevelNamesRoundTrip)
+{
+  for (const char* name : {"debug", "info", "notice", "warning", "err", "crit", "alert", "emerg"})
+  {
+    int log_mask = 0;
+    ASSERT_TRUE(AdminServer::ParseLogLevel(name, log_mask));
+    EXPECT_STREQ(AdminServer::LogLevelName(log_mask), name);
+  }
+  EXPECT_STREQ(AdminServer::LogLevelName(ETCPAL_LOG_MASK(ETCPAL_LOG_ERR)), "custom");
+}
+
+TEST_F(TestAdminServer, TraceActionsAreParsed)
+{
+  EXPECT_CALL(handler_, HandleTraceRequest(AdminServer::TraceAction::kStart, _)).WillOnce(Return(true));
+  EXPECT_CALL(handler_, HandleTraceRequest(AdminServer::TraceAction::kStop, _))
+      .WillOnce(DoAll(SetArgReferee<1>("trace.json"), Return(true)));
+  EXPECT_EQ(Send("trace start\n"), "OK\n");
+  EXPECT_EQ(Send("trace stop\n"), "trace.json\nOK\n");
+  EXPECT_EQ(Send("trace\n"), "ERR Usage: trace start|stop|write\n");
+}
+
+TEST_F(TestAdminServer, ClientsAreNotSupported)
+{
+  EXPECT_EQ(Send("clients\n").rfind("ERR ", 0), 0u);
+}
+
+TEST_F(TestAdminServer, UnknownCommandIsAnError)
+{
+  EXPECT_EQ(Send("frobnicate\n"), "ERR Unknown command \"frobnicate\"; try \"help\"\n");
+}
+
+TEST_F(TestAdminServer, QuitClosesAfterResponding)
+{
+  EXPECT_CALL(handler_, HandleStatusRequest()).Times(0);
+  EXPECT_EQ(Send("quit\nstatus\n"), "CLOSED OK\n");
+}
+
+TEST_F(TestAdminServer, OverlongLineClosesTheConnection)
+{
+  EXPECT_EQ(Send(std::string(AdminServer::kMaxLineLength + 1, 'x')), "CLOSED ERR Line too long\n");
+}
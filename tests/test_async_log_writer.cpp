@@ -0,0 +1,311 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "async_log_writer.h"
+
+#include <algorithm>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "binary_log_record.h"
+#include "etcpal/cpp/signal.h"
+#include "gtest/gtest.h"
+
+// Collects everything the writer thread outputs.
+class TestLogOutput : public AsyncLogWriter::Output
+{
+public:
+  void WriteLogData(const char* data, size_t size) override
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    data_.append(data, size);
+  }
+
+  void FlushLogData() override
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    ++flush_count_;
+  }
+
+  void RotateLogFile() override
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    rotated_files_.push_back(data_);
+    data_.clear();
+  }
+
+  std::vector<std::string> Lines()
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+
+    std::vector<std::string> lines;
+    std::istringstream       stream(data_);
+    for (std::string line; std::getline(stream, line);)
+      lines.push_back(line);
+    return lines;
+  }
+
+  std::string data()
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    return data_;
+  }
+
+  int flush_count()
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    return flush_count_;
+  }
+
+  std::vector<std::string> rotated_files()
+  {
+    std::lock_guard<std::mutex> lock(lock_);
+    return rotated_files_;
+  }
+
+private:
+  std::mutex               lock_;
+  std::string              data_;
+  int                      flush_count_{0};
+  std::vector<std::string> rotated_files_;
+};
+
+// An output that holds up the writer thread until released, so the ring buffer can be filled.
+class BlockingLogOutput : public TestLogOutput
+{
+public:
+  void WriteLogData(const char* data, size_t size) override
+  {
+    release_.Wait();
+    release_.Notify();  // Stay released for subsequent writes
+    TestLogOutput::WriteLogData(data, size);
+  }
+
+  void Release() { release_.Notify(); }
+
+private:
+  etcpal::Signal release_;
+};
+
+class TestAsyncLogWriter : public testing::Test
+{
+protected:
+  static constexpr size_t kCapacity = 16;
+
+  AsyncLogWriter::Settings settings_;
+
+  void SetUp() override { settings_.max_file_size = 0; }
+};
+
+TEST_F(TestAsyncLogWriter, CapacityRoundedUpToPowerOfTwo)
+{
+  AsyncLogWriter writer(100);
+  EXPECT_EQ(writer.capacity(), 128u);
+}
+
+TEST_F(TestAsyncLogWriter, PushFailsWhenNotStarted)
+{
+  AsyncLogWriter writer(kCapacity);
+  EXPECT_FALSE(writer.Push("Test message"));
+}
+
+TEST_F(TestAsyncLogWriter, MessagesWrittenInOrderOnShutdown)
+{
+  TestLogOutput  output;
+  AsyncLogWriter writer(kCapacity);
+  ASSERT_TRUE(writer.Startup(output, settings_));
+
+  for (int i = 0; i < 10; ++i)
+    EXPECT_TRUE(writer.Push(("Message " + std::to_string(i)).c_str()));
+
+  writer.Shutdown();
+
+  auto lines = output.Lines();
+  ASSERT_EQ(lines.size(), 10u);
+  for (int i = 0; i < 10; ++i)
+    EXPECT_EQ(lines[i], "Message " + std::to_string(i));
+  EXPECT_GE(output.flush_count(), 1);
+}
+
+TEST_F(TestAsyncLogWriter, OverlongMessageIsTruncated)
+{
+  TestLogOutput  output;
+  AsyncLogWriter writer(kCapacity);
+  ASSERT_TRUE(writer.Startup(output, settings_));
+
+  const std::string long_message(AsyncLogWriter::kMaxMessageLength + 100, 'a');
+  EXPECT_TRUE(writer.Push(long_message.c_str()));
+  writer.Shutdown();
+
+  auto lines = output.Lines();
+  ASSERT_EQ(lines.size(), 1u);
+  EXPECT_EQ(lines[0], long_message.substr(0, AsyncLogWriter::kMaxMessageLength));
+}
+
+TEST_F(TestAsyncLogWriter, DropPolicyCountsAndReportsDroppedMessages)
+{
+  BlockingLogOutput output;
+  AsyncLogWriter    writer(kCapacity);
+  settings_.overflow_policy = AsyncLogWriter::OverflowPolicy::kDrop;
+  ASSERT_TRUE(writer.Startup(output, settings_));
+
+  // The writer thread may take one message out of the buffer before it blocks in the output, so
+  // push enough to be sure the buffer overflows.
+  size_t accepted = 0;
+  for (size_t i = 0; i < kCapacity + 10; ++i)
+  {
+    if (writer.Push("Test message"))
+      ++accepted;
+  }
+
+  EXPECT_GT(writer.dropped_count(), 0u);
+  EXPECT_EQ(accepted + writer.dropped_count(), kCapacity + 10);
+
+  output.Release();
+  writer.Shutdown();
+
+  auto lines = output.Lines();
+  ASSERT_FALSE(lines.empty());
+  EXPECT_EQ(lines.size(), accepted + 1);  // Plus one line reporting the drops
+  // The report comes before the messages still in the buffer, but maybe after one the writer had
+  // already taken out.
+  EXPECT_EQ(std::count_if(lines.begin(), lines.end(),
+                          [](const std::string& line) { return line.find("dropped") != std::string::npos; }),
+            1);
+}
+
+TEST_F(TestAsyncLogWriter, BlockPolicyLosesNothingFromConcurrentProducers)
+{
+  constexpr int kNumThreads = 4;
+  constexpr int kMessagesPerThread = 500;
+
+  TestLogOutput  output;
+  AsyncLogWriter writer(kCapacity);
+  settings_.overflow_policy = AsyncLogWriter::OverflowPolicy::kBlock;
+  settings_.flush_interval_ms = 5;
+  ASSERT_TRUE(writer.Startup(output, settings_));
+
+  std::vector<std::thread> producers;
+  for (int t = 0; t < kNumThreads; ++t)
+  {
+    producers.emplace_back([&writer, t]() {
+      for (int i = 0; i < kMessagesPerThread; ++i)
+        writer.Push((std::to_string(t) + ":" + std::to_string(i)).c_str());
+    });
+  }
+  for (auto& producer : producers)
+    producer.join();
+
+  writer.Shutdown();
+
+  EXPECT_EQ(writer.dropped_count(), 0u);
+
+  auto lines = output.Lines();
+  ASSERT_EQ(lines.size(), static_cast<size_t>(kNumThreads * kMessagesPerThread));
+
+  std::set<std::string> unique_lines(lines.begin(), lines.end());
+  EXPECT_EQ(unique_lines.size(), lines.size());
+}
+
+TEST_F(TestAsyncLogWriter, RotatesWhenFileSizeLimitReached)
+{
+  TestLogOutput  output;
+  AsyncLogWriter writer(kCapacity);
+  settings_.flush_interval_ms = 0;
+  settings_.max_file_size = 100;
+
+  // Start out with a file that is almost at the limit.
+  ASSERT_TRUE(writer.Startup(output, settings_, 90));
+
+  // 15 bytes with the newline
+  writer.Push("Test message 1");
+  writer.Shutdown();
+
+  auto rotated_files = output.rotated_files();
+  ASSERT_EQ(rotated_files.size(), 1u);
+  EXPECT_EQ(rotated_files[0], "Test message 1\n");
+  EXPECT_TRUE(output.Lines().empty());
+}
+
+TEST_F(TestAsyncLogWriter, NoRotationWhenDisabled)
+{
+  TestLogOutput  output;
+  AsyncLogWriter writer(kCapacity);
+  settings_.flush_interval_ms = 0;
+  ASSERT_TRUE(writer.Startup(output, settings_, 1000000));
+
+  writer.Push("Test message 1");
+  writer.Shutdown();
+
+  EXPECT_TRUE(output.rotated_files().empty());
+  EXPECT_EQ(output.Lines().size(), 1u);
+}
+
+TEST_F(TestAsyncLogWriter, NewSizeLimitAppliesToCurrentFile)
+{
+  TestLogOutput  output;
+  AsyncLogWriter writer(kCapacity);
+  settings_.flush_interval_ms = 0;
+  ASSERT_TRUE(writer.Startup(output, settings_, 500));
+
+  writer.Push("Test message 1");
+
+  settings_.max_file_size = 100;
+  writer.SetSettings(settings_);
+  writer.Shutdown();
+
+  EXPECT_EQ(output.rotated_files().size(), 1u);
+}
+
+TEST_F(TestAsyncLogWriter, LogMessagesWrittenInConfiguredFormat)
+{
+  TestLogOutput  output;
+  AsyncLogWriter writer(kCapacity);
+  ASSERT_TRUE(writer.Startup(output, settings_));
+
+  EtcPalLogTimestamp timestamp{};
+  timestamp.year = 2022;
+
+  EtcPalLogStrings strings{};
+  strings.human_readable = "2022-01-01 00:00:00.000Z [INFO] Text message";
+  strings.raw = "Binary message";
+  strings.log_timestamp = &timestamp;
+  strings.priority = ETCPAL_LOG_INFO;
+  EXPECT_TRUE(writer.PushLogMessage(strings));
+
+  settings_.format = AsyncLogWriter::Format::kBinary;
+  writer.SetSettings(settings_);
+  EXPECT_TRUE(writer.PushLogMessage(strings));
+  writer.Shutdown();
+
+  const std::string data = output.data();
+  const std::string text_line = std::string(strings.human_readable) + "\n";
+  ASSERT_EQ(data.compare(0, text_line.size(), text_line), 0);
+
+  BinaryLogRecord record;
+  size_t          consumed = 0;
+  ASSERT_EQ(BinaryLogRecord::Decode(&data[text_line.size()], data.size() - text_line.size(), record, consumed),
+            BinaryLogRecord::DecodeResult::kOk);
+  EXPECT_EQ(consumed, data.size() - text_line.size());
+  EXPECT_EQ(record.message, "Binary message");
+  EXPECT_EQ(record.priority, ETCPAL_LOG_INFO);
+}
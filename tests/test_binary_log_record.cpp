@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "binary_log_record.h"
+
+#include <string>
+#include "gtest/gtest.h"
+#include "nlohmann/json.hpp"
+
+class TestBinaryLogRecord : public testing::Test
+{
+protected:
+  EtcPalLogTimestamp timestamp_{};
+  char               buf_[256];
+
+  void SetUp() override
+  {
+    timestamp_.year = 2022;
+    timestamp_.month = 3;
+    timestamp_.day = 14;
+    timestamp_.hour = 15;
+    timestamp_.minute = 9;
+    timestamp_.second = 26;
+    timestamp_.msec = 535;
+    timestamp_.utc_offset = -300;
+  }
+};
+
+TEST_F(TestBinaryLogRecord, RoundTrip)
+{
+  const size_t size = BinaryLogRecord::Encode(&timestamp_, ETCPAL_LOG_WARNING, "Hello", buf_, sizeof(buf_));
+  ASSERT_EQ(size, BinaryLogRecord::kHeaderSize + 5);
+
+  BinaryLogRecord record;
+  size_t          consumed = 0;
+  ASSERT_EQ(BinaryLogRecord::Decode(buf_, size, record, consumed), BinaryLogRecord::DecodeResult::kOk);
+  EXPECT_EQ(consumed, size);
+  EXPECT_TRUE(record.has_timestamp);
+  EXPECT_EQ(record.timestamp.year, 2022u);
+  EXPECT_EQ(record.timestamp.msec, 535u);
+  EXPECT_EQ(record.timestamp.utc_offset, -300);
+  EXPECT_EQ(record.priority, ETCPAL_LOG_WARNING);
+  EXPECT_EQ(record.message, "Hello");
+}
+
+TEST_F(TestBinaryLogRecord, MessageWithoutTimestamp)
+{
+  const size_t size = BinaryLogRecord::Encode(nullptr, ETCPAL_LOG_INFO, "No time", buf_, sizeof(buf_));
+
+  BinaryLogRecord record;
+  size_t          consumed = 0;
+  ASSERT_EQ(BinaryLogRecord::Decode(buf_, size, record, consumed), BinaryLogRecord::DecodeResult::kOk);
+  EXPECT_FALSE(record.has_timestamp);
+  EXPECT_EQ(record.ToText(), "[INFO] No time");
+}
+
+TEST_F(TestBinaryLogRecord, LongMessageIsTruncated)
+{
+  const std::string message(1000, 'a');
+  const size_t      size = BinaryLogRecord::Encode(&timestamp_, ETCPAL_LOG_INFO, message.c_str(), buf_, sizeof(buf_));
+  EXPECT_EQ(size, sizeof(buf_));
+
+  BinaryLogRecord record;
+  size_t          consumed = 0;
+  ASSERT_EQ(BinaryLogRecord::Decode(buf_, size, record, consumed), BinaryLogRecord::DecodeResult::kOk);
+  EXPECT_EQ(record.message, std::string(sizeof(buf_) - BinaryLogRecord::kHeaderSize, 'a'));
+}
+
+TEST_F(TestBinaryLogRecord, EncodeFailsIfHeaderDoesNotFit)
+{
+  EXPECT_EQ(BinaryLogRecord::Encode(&timestamp_, ETCPAL_LOG_INFO, "Hello", buf_, BinaryLogRecord::kHeaderSize - 1), 0u);
+}
+
+TEST_F(TestBinaryLogRecord, PartialRecordNeedsMoreData)
+{
+  const size_t size = BinaryLogRecord::Encode(&timestamp_, ETCPAL_LOG_INFO, "Hello", buf_, sizeof(buf_));
+
+  BinaryLogRecord record;
+  size_t          consumed = 0;
+  EXPECT_EQ(BinaryLogRecord::Decode(buf_, 1, record, consumed), BinaryLogRecord::DecodeResult::kNeedMoreData);
+  EXPECT_EQ(BinaryLogRecord::Decode(buf_, BinaryLogRecord::kHeaderSize, record, consumed),
+            BinaryLogRecord::DecodeResult::kNeedMoreData);
+  EXPECT_EQ(BinaryLogRecord::Decode(buf_, size - 1, record, consumed), BinaryLogRecord::DecodeResult::kNeedMoreData);
+}
+
+TEST_F(TestBinaryLogRecord, TextIsNotARecord)
+{
+  const std::string text = "RDMnet Broker Log";
+
+  BinaryLogRecord record;
+  size_t          consumed = 0;
+  EXPECT_EQ(BinaryLogRecord::Decode(text.data(), text.size(), record, consumed),
+            BinaryLogRecord::DecodeResult::kInvalid);
+
+  // The right marker with an unknown version is not a record either.
+  const char unknown_version[] = {static_cast<char>(BinaryLogRecord::kMarker), 99, 0, 0};
+  EXPECT_EQ(BinaryLogRecord::Decode(unknown_version, sizeof(unknown_version), record, consumed),
+            BinaryLogRecord::DecodeResult::kInvalid);
+}
+
+TEST_F(TestBinaryLogRecord, ToTextMatchesHumanReadableFormat)
+{
+  const size_t size = BinaryLogRecord::Encode(&timestamp_, ETCPAL_LOG_ERR, "Something failed", buf_, sizeof(buf_));
+
+  BinaryLogRecord record;
+  size_t          consumed = 0;
+  ASSERT_EQ(BinaryLogRecord::Decode(buf_, size, record, consumed), BinaryLogRecord::DecodeResult::kOk);
+  EXPECT_EQ(record.ToText(), "2022-03-14 15:09:26.535-05:00 [ERR ] Something failed");
+}
+
+TEST_F(TestBinaryLogRecord, FormatTextMatchesToText)
+{
+  const size_t length = BinaryLogRecord::FormatText(&timestamp_, ETCPAL_LOG_ERR, "Something failed", 16, buf_,
+                                                    sizeof(buf_));
+  EXPECT_EQ(std::string(buf_), "2022-03-14 15:09:26.535-05:00 [ERR ] Something failed");
+  EXPECT_EQ(length, std::string(buf_).size());
+
+  BinaryLogRecord::FormatText(nullptr, ETCPAL_LOG_INFO, "No time", 7, buf_, sizeof(buf_));
+  EXPECT_EQ(std::string(buf_), "[INFO] No time");
+}
+
+TEST_F(TestBinaryLogRecord, FormatTextIsTruncatedToFit)
+{
+  const size_t length = BinaryLogRecord::FormatText(nullptr, ETCPAL_LOG_INFO, "Too long", 8, buf_, 10);
+  EXPECT_EQ(length, 9u);
+  EXPECT_EQ(std::string(buf_), "[INFO] To");
+}
+
+TEST_F(TestBinaryLogRecord, ToJson)
+{
+  const size_t size = BinaryLogRecord::Encode(&timestamp_, ETCPAL_LOG_DEBUG, "Details", buf_, sizeof(buf_));
+
+  BinaryLogRecord record;
+  size_t          consumed = 0;
+  ASSERT_EQ(BinaryLogRecord::Decode(buf_, size, record, consumed), BinaryLogRecord::DecodeResult::kOk);
+
+  const auto json = nlohmann::json::parse(record.ToJson());
+  EXPECT_EQ(json["timestamp"], "2022-03-14 15:09:26.535-05:00");
+  EXPECT_EQ(json["priority"], ETCPAL_LOG_DEBUG);
+  EXPECT_EQ(json["severity"], "debug");
+  EXPECT_EQ(json["message"], "Details");
+}
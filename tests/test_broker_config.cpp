@@ -20,10 +20,13 @@
 #include "broker_config.h"
 
 #include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <iomanip>
 #include <sstream>
 #include <utility>
 #include "gtest/gtest.h"
+#include "temp_dir_test.h"
 
 const std::string kTestUuid = "4958ac8f-cd5e-42cd-ab7e-9797b0efd3ac";
 
@@ -173,6 +176,53 @@ TEST_F(TestBrokerConfig, InvalidJsonRootTypeShouldFail)
   }
 }
 
+// A document that fails to parse partway through must not leave the settings read before the error.
+TEST_F(TestBrokerConfig, ParseErrorLeavesConfigUnchanged)
+{
+  config_.SetDefaults();
+  const auto old_config = config_;
+
+  std::istringstream test_stream(R"( { "scope": "partial", "max_devices": 20, "listen_port": } )");
+  EXPECT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kJsonParseErr);
+  EXPECT_TRUE(BrokerConfig::Compare(old_config, config_).Empty());
+}
+
+// Unknown keys are skipped whatever they contain, without matching settings at other paths.
+TEST_F(TestBrokerConfig, UnknownNestedValuesAreSkipped)
+{
+  std::istringstream test_stream(R"(
+    {
+      "extra": { "scope": "wrong", "list": [1, { "scope": "wrong" }, [true]] },
+      "dns_sd": { "model": "My Model", "unknown": { "model": [] } },
+      "uid": { "type": "static", "manufacturer_id": 25972, "device_id": 1234, "note": { "a": [1, 2] } },
+      "list": [ { "scope": "wrong" } ],
+      "scope": "right"
+    }
+  )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+
+  EXPECT_EQ(config_.settings.scope, "right");
+  EXPECT_EQ(config_.settings.dns.model, "My Model");
+  EXPECT_EQ(config_.settings.uid, rdm::Uid::Static(25972, 1234));
+}
+
+// A key containing '/' is just an unknown key, not a path to a nested setting.
+TEST_F(TestBrokerConfig, KeysWithSlashesDoNotMatchNestedSettings)
+{
+  std::istringstream test_stream(R"(
+    {
+      "dns_sd/manufacturer": "Wrong",
+      "dns_sd": { "model": "My Model", "~1model": "Wrong" }
+    }
+  )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+
+  BrokerConfig defaults;
+  defaults.SetDefaults();
+  EXPECT_EQ(config_.settings.dns.manufacturer, defaults.settings.dns.manufacturer);
+  EXPECT_EQ(config_.settings.dns.model, "My Model");
+}
+
 TEST_F(TestBrokerConfig, InvalidCidValueShouldFail)
 {
   // clang-format off
@@ -682,6 +732,270 @@ TEST_F(TestBrokerConfig, ValidMaxRejectConnectionsParsedCorrectly)
                                   [](const auto& settings) { return settings.limits.reject_connections; });
 }
 
+TEST_F(TestBrokerConfig, InvalidRestartModeShouldFail)
+{
+  // clang-format off
+  const std::vector<std::string> kInvalidStrings =
+  {
+    // Invalid types
+    R"( { "restart_mode": 0 } )",
+    R"( { "restart_mode": true } )",
+    R"( { "restart_mode": {} } )",
+    R"( { "restart_mode": [] } )",
+    // Invalid values
+    R"( { "restart_mode": "blah" } )",
+    R"( { "restart_mode": "" } )",
+  };
+  // clang-format on
+
+  for (const auto& invalid_input : kInvalidStrings)
+  {
+    std::istringstream test_stream(invalid_input);
+    EXPECT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kInvalidSetting)
+        << "Input tested: " << invalid_input;
+    EXPECT_EQ(config_.restart_mode, BrokerConfig::RestartMode::kStandard);
+  }
+}
+
+TEST_F(TestBrokerConfig, ValidRestartModeParsedCorrectly)
+{
+  std::istringstream test_stream(R"( { "restart_mode": "overlapped", "restart_drain_ms": 2500 } )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config_.restart_mode, BrokerConfig::RestartMode::kOverlapped);
+  EXPECT_EQ(config_.restart_drain_ms, 2500u);
+}
+
+TEST_F(TestBrokerConfig, InvalidRestartDrainMsValueShouldFail)
+{
+  TestInvalidUnsignedIntValueHelper("restart_drain_ms");
+}
+
+TEST_F(TestBrokerConfig, InvalidLogFlushIntervalShouldFail)
+{
+  TestInvalidUnsignedIntValueHelper("log_flush_interval_ms");
+
+  std::istringstream test_stream(R"( { "log_flush_interval_ms": 60001 } )");
+  EXPECT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kInvalidSetting);
+}
+
+TEST_F(TestBrokerConfig, InvalidLogOverflowPolicyShouldFail)
+{
+  // clang-format off
+  const std::vector<std::string> kInvalidStrings =
+  {
+    // Invalid types
+    R"( { "log_overflow_policy": 0 } )",
+    R"( { "log_overflow_policy": true } )",
+    R"( { "log_overflow_policy": {} } )",
+    R"( { "log_overflow_policy": [] } )",
+    // Invalid values
+    R"( { "log_overflow_policy": "blah" } )",
+    R"( { "log_overflow_policy": "" } )",
+  };
+  // clang-format on
+
+  for (const auto& invalid_input : kInvalidStrings)
+  {
+    std::istringstream test_stream(invalid_input);
+    EXPECT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kInvalidSetting)
+        << "Input tested: " << invalid_input;
+    EXPECT_EQ(config_.log_writer.overflow_policy, AsyncLogWriter::OverflowPolicy::kDrop);
+  }
+}
+
+TEST_F(TestBrokerConfig, InvalidLogFormatShouldFail)
+{
+  // clang-format off
+  const std::vector<std::string> kInvalidStrings =
+  {
+    // Invalid types
+    R"( { "log_format": 0 } )",
+    R"( { "log_format": true } )",
+    R"( { "log_format": {} } )",
+    R"( { "log_format": [] } )",
+    // Invalid values
+    R"( { "log_format": "json" } )",
+    R"( { "log_format": "" } )",
+  };
+  // clang-format on
+
+  for (const auto& invalid_input : kInvalidStrings)
+  {
+    std::istringstream test_stream(invalid_input);
+    EXPECT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kInvalidSetting)
+        << "Input tested: " << invalid_input;
+    EXPECT_EQ(config_.log_writer.format, AsyncLogWriter::Format::kText);
+  }
+}
+
+TEST_F(TestBrokerConfig, ValidLogWriterSettingsParsedCorrectly)
+{
+  std::istringstream test_stream(
+      R"( { "log_flush_interval_ms": 0, "log_overflow_policy": "block", "log_format": "binary" } )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config_.log_writer.flush_interval_ms, 0u);
+  EXPECT_EQ(config_.log_writer.overflow_policy, AsyncLogWriter::OverflowPolicy::kBlock);
+  EXPECT_EQ(config_.log_writer.format, AsyncLogWriter::Format::kBinary);
+}
+
+TEST_F(TestBrokerConfig, InvalidLogMaxSizeShouldFail)
+{
+  TestInvalidUnsignedIntValueHelper("log_max_size");
+}
+
+TEST_F(TestBrokerConfig, InvalidLogMaxFilesShouldFail)
+{
+  TestInvalidUnsignedIntValueHelper("log_max_files");
+
+  for (const auto& invalid_input : {R"( { "log_max_files": 0 } )", R"( { "log_max_files": 101 } )"})
+  {
+    std::istringstream test_stream(invalid_input);
+    EXPECT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kInvalidSetting)
+        << "Input tested: " << invalid_input;
+    EXPECT_EQ(config_.log_archive.max_files, LogArchiver::Settings{}.max_files);
+  }
+}
+
+TEST_F(TestBrokerConfig, ValidLogRotationSettingsParsedCorrectly)
+{
+  std::istringstream test_stream(R"( { "log_max_size": 0, "log_max_files": 20 } )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config_.log_writer.max_file_size, 0u);
+  EXPECT_EQ(config_.log_archive.max_files, 20u);
+}
+
+TEST_F(TestBrokerConfig, InvalidLogMaxTotalSizeShouldFail)
+{
+  TestInvalidUnsignedIntValueHelper("log_max_total_size");
+}
+
+TEST_F(TestBrokerConfig, InvalidLogCompressShouldFail)
+{
+  for (const auto& invalid_input : {R"( { "log_compress": 0 } )", R"( { "log_compress": "true" } )"})
+  {
+    std::istringstream test_stream(invalid_input);
+    EXPECT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kInvalidSetting)
+        << "Input tested: " << invalid_input;
+    EXPECT_EQ(config_.log_archive.compress, LogArchiver::Settings{}.compress);
+  }
+}
+
+TEST_F(TestBrokerConfig, ValidLogArchiveSettingsParsedCorrectly)
+{
+  std::istringstream test_stream(R"( { "log_max_total_size": 1000000, "log_compress": false } )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config_.log_archive.max_total_size, 1000000u);
+  EXPECT_FALSE(config_.log_archive.compress);
+}
+
+TEST_F(TestBrokerConfig, InvalidFlightRecorderSizeShouldFail)
+{
+  TestInvalidUnsignedIntValueHelper("flight_recorder_size");
+
+  std::istringstream test_stream(R"( { "flight_recorder_size": 100001 } )");
+  EXPECT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kInvalidSetting);
+  EXPECT_EQ(config_.flight_recorder_size, 1000u);
+}
+
+TEST_F(TestBrokerConfig, FlightRecorderSizeChangeDoesNotRequireRestart)
+{
+  config_.SetDefaults();
+  const auto old_config = config_;
+
+  std::istringstream test_stream(R"( { "flight_recorder_size": 0 } )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config_.flight_recorder_size, 0u);
+
+  auto diff = BrokerConfig::Compare(old_config, config_);
+  EXPECT_TRUE(diff.flight_recorder);
+  EXPECT_FALSE(diff.Empty());
+  EXPECT_FALSE(diff.RequiresRestart());
+}
+
+TEST_F(TestBrokerConfig, InvalidMetricsSettingsShouldFail)
+{
+  for (const auto& invalid_input : {R"( { "enable_metrics": 1 } )", R"( { "metrics_port": 80 } )",
+                                    R"( { "metrics_port": 65536 } )", R"( { "metrics_port": "9464" } )"})
+  {
+    std::istringstream test_stream(invalid_input);
+    EXPECT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kInvalidSetting)
+        << "Input tested: " << invalid_input;
+    EXPECT_FALSE(config_.metrics.enable);
+    EXPECT_EQ(config_.metrics.port, MetricsExporter::kDefaultPort);
+  }
+}
+
+TEST_F(TestBrokerConfig, InvalidStatsIntervalShouldFail)
+{
+  TestInvalidUnsignedIntValueHelper("stats_interval_s");
+
+  std::istringstream test_stream(R"( { "stats_interval_s": 86401 } )");
+  EXPECT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kInvalidSetting);
+  EXPECT_EQ(config_.stats_interval_s, 300u);
+}
+
+TEST_F(TestBrokerConfig, StatsIntervalChangeDoesNotRequireRestart)
+{
+  config_.SetDefaults();
+  const auto old_config = config_;
+
+  std::istringstream test_stream(R"( { "stats_interval_s": 0 } )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config_.stats_interval_s, 0u);
+
+  auto diff = BrokerConfig::Compare(old_config, config_);
+  EXPECT_TRUE(diff.stats);
+  EXPECT_FALSE(diff.RequiresRestart());
+}
+
+TEST_F(TestBrokerConfig, MetricsChangeDoesNotRequireRestart)
+{
+  config_.SetDefaults();
+  const auto old_config = config_;
+
+  std::istringstream test_stream(R"( { "enable_metrics": true, "metrics_port": 9000 } )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+  EXPECT_TRUE(config_.metrics.enable);
+  EXPECT_EQ(config_.metrics.port, 9000u);
+
+  auto diff = BrokerConfig::Compare(old_config, config_);
+  EXPECT_TRUE(diff.metrics);
+  EXPECT_EQ(diff.ToString(), "metrics");
+  EXPECT_FALSE(diff.RequiresRestart());
+}
+
+TEST_F(TestBrokerConfig, AdminSocketChangeDoesNotRequireRestart)
+{
+  config_.SetDefaults();
+  EXPECT_FALSE(config_.admin.enable);
+  const auto old_config = config_;
+
+  std::istringstream test_stream(R"( { "enable_admin_socket": true } )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+  EXPECT_TRUE(config_.admin.enable);
+
+  auto diff = BrokerConfig::Compare(old_config, config_);
+  EXPECT_TRUE(diff.admin);
+  EXPECT_EQ(diff.ToString(), "admin");
+  EXPECT_FALSE(diff.RequiresRestart());
+}
+
+TEST_F(TestBrokerConfig, TraceChangeDoesNotRequireRestart)
+{
+  config_.SetDefaults();
+  EXPECT_FALSE(config_.enable_trace);
+  const auto old_config = config_;
+
+  std::istringstream test_stream(R"( { "enable_trace": true } )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+  EXPECT_TRUE(config_.enable_trace);
+
+  auto diff = BrokerConfig::Compare(old_config, config_);
+  EXPECT_TRUE(diff.trace);
+  EXPECT_EQ(diff.ToString(), "trace");
+  EXPECT_FALSE(diff.RequiresRestart());
+}
+
 TEST_F(TestBrokerConfig, SetDefaultsRestoresDefaultsConsistently)
 {
   // Generate defaults to compare against later from a freshly-constructed config
@@ -703,6 +1017,15 @@ TEST_F(TestBrokerConfig, SetDefaultsRestoresDefaultsConsistently)
   config_.settings.scope = "test123";
   config_.settings.listen_port = 1234u;
   config_.settings.listen_interfaces.push_back("eth0");
+  config_.restart_mode = BrokerConfig::RestartMode::kOverlapped;
+  config_.restart_drain_ms = 1u;
+  config_.log_writer.flush_interval_ms = 2u;
+  config_.log_writer.overflow_policy = AsyncLogWriter::OverflowPolicy::kBlock;
+  config_.log_writer.max_file_size = 3u;
+  config_.log_archive.max_files = 4u;
+  config_.log_archive.max_total_size = 5u;
+  config_.log_archive.compress = false;
+  config_.flight_recorder_size = 6u;
 
   // Now try restoring defaults again and verify they're the same as the original defaults
   config_.SetDefaults();
@@ -721,4 +1044,399 @@ TEST_F(TestBrokerConfig, SetDefaultsRestoresDefaultsConsistently)
   EXPECT_EQ(config_.settings.listen_interfaces, initial_defaults.settings.listen_interfaces);
   EXPECT_EQ(config_.log_mask, initial_defaults.log_mask);
   EXPECT_EQ(config_.enable_broker, initial_defaults.enable_broker);
+  EXPECT_EQ(config_.restart_mode, initial_defaults.restart_mode);
+  EXPECT_EQ(config_.restart_drain_ms, initial_defaults.restart_drain_ms);
+  EXPECT_EQ(config_.log_writer.flush_interval_ms, initial_defaults.log_writer.flush_interval_ms);
+  EXPECT_EQ(config_.log_writer.overflow_policy, initial_defaults.log_writer.overflow_policy);
+  EXPECT_EQ(config_.log_writer.max_file_size, initial_defaults.log_writer.max_file_size);
+  EXPECT_EQ(config_.log_archive.max_files, initial_defaults.log_archive.max_files);
+  EXPECT_EQ(config_.log_archive.max_total_size, initial_defaults.log_archive.max_total_size);
+  EXPECT_EQ(config_.log_archive.compress, initial_defaults.log_archive.compress);
+  EXPECT_EQ(config_.flight_recorder_size, initial_defaults.flight_recorder_size);
+}
+
+TEST_F(TestBrokerConfig, CompareIdenticalConfigsIsEmpty)
+{
+  config_.SetDefaults();
+  auto other = config_;
+
+  auto diff = BrokerConfig::Compare(config_, other);
+  EXPECT_TRUE(diff.Empty());
+  EXPECT_FALSE(diff.RequiresRestart());
+}
+
+TEST_F(TestBrokerConfig, CompareDetectsEachChangedSetting)
+{
+  config_.SetDefaults();
+  const auto old_config = config_;
+
+  config_.settings.uid = rdm::Uid(0x1234u, 0x56789012u);
+  config_.settings.dns.model = "Test Model";
+  config_.settings.listen_port = 8888u;
+  config_.settings.limits.device_messages = 20u;
+
+  auto diff = BrokerConfig::Compare(old_config, config_);
+  EXPECT_FALSE(diff.Empty());
+  EXPECT_FALSE(diff.cid);
+  EXPECT_TRUE(diff.uid);
+  EXPECT_TRUE(diff.dns_sd);
+  EXPECT_FALSE(diff.scope);
+  EXPECT_TRUE(diff.listen_port);
+  EXPECT_FALSE(diff.listen_interfaces);
+  EXPECT_TRUE(diff.limits);
+  EXPECT_FALSE(diff.log_level);
+  EXPECT_FALSE(diff.enable_broker);
+}
+
+TEST_F(TestBrokerConfig, LogLevelChangeDoesNotRequireRestart)
+{
+  config_.SetDefaults();
+  const auto old_config = config_;
+
+  std::istringstream test_stream(R"( { "log_level": "debug" } )");
+  ASSERT_EQ(config_.Read(test_stream), BrokerConfig::ParseResult::kOk);
+
+  auto diff = BrokerConfig::Compare(old_config, config_);
+  EXPECT_TRUE(diff.log_level);
+  EXPECT_FALSE(diff.RequiresRestart());
+}
+
+TEST_F(TestBrokerConfig, ListenSettingChangesRequireRestart)
+{
+  config_.SetDefaults();
+  const auto old_config = config_;
+
+  config_.settings.listen_interfaces.push_back("eth0");
+
+  auto diff = BrokerConfig::Compare(old_config, config_);
+  EXPECT_TRUE(diff.listen_interfaces);
+  EXPECT_TRUE(diff.RequiresRestart());
+}
+
+// The RDMnet broker can move to a new scope while it runs.
+TEST_F(TestBrokerConfig, ScopeChangeDoesNotRequireRestart)
+{
+  config_.SetDefaults();
+  const auto old_config = config_;
+
+  config_.settings.scope = "new scope";
+
+  auto diff = BrokerConfig::Compare(old_config, config_);
+  EXPECT_TRUE(diff.scope);
+  EXPECT_FALSE(diff.RequiresRestart());
+}
+
+TEST_F(TestBrokerConfig, DocumentationDescribesEachSetting)
+{
+  const std::string doc = BrokerConfig::Documentation();
+
+  for (const char* pointer : {"/cid", "/uid", "/dns_sd/service_instance_name", "/scope", "/listen_port",
+                              "/listen_interfaces", "/log_level", "/log_max_files", "/flight_recorder_size",
+                              "/max_reject_connections", "/enable_broker", "/restart_mode", "/restart_drain_ms"})
+  {
+    EXPECT_NE(doc.find("\"" + std::string(pointer) + "\": "), std::string::npos) << pointer;
+  }
+
+  EXPECT_NE(doc.find("\"/log_max_files\": integer from 1 to 100, default 5."), std::string::npos);
+  EXPECT_NE(doc.find("\"/log_level\": {\"debug\", \"info\", \"notice\", \"warning\", \"err\", \"crit\", \"alert\", "
+                     "\"emerg\"}, default \"info\"."),
+            std::string::npos);
+  EXPECT_NE(doc.find("\"/enable_broker\": boolean, default true."), std::string::npos);
+}
+
+class TestBrokerConfigFile : public TempDirTest
+{
+protected:
+  std::filesystem::path path_;
+  std::string           snapshot_path_;
+
+  void SetUp() override
+  {
+    TempDirTest::SetUp();
+    std::filesystem::create_directories(dir_ / BrokerConfig::kFragmentDirectory);
+    path_ = dir_ / "broker.conf";
+    snapshot_path_ = path_.string() + BrokerConfig::kSnapshotExtension;
+  }
+
+  using TempDirTest::ReadFile;
+  using TempDirTest::WriteFile;
+
+  void WriteFile(const std::string& contents) { WriteFile(path_, contents); }
+
+  void WriteFragment(const std::string& name, const std::string& contents)
+  {
+    WriteFile(dir_ / BrokerConfig::kFragmentDirectory / name, contents);
+  }
+
+  BrokerConfig::ParseResult ReadFile(BrokerConfig& config)
+  {
+    std::ifstream file(path_);
+    return config.ReadFile(path_.string(), file);
+  }
+};
+
+// An unchanged file isn't read again; the stream is only read when the file may have changed.
+TEST_F(TestBrokerConfigFile, UnchangedFileIsNotReadAgain)
+{
+  WriteFile(R"({ "scope": "cached", "listen_port": 9000 })");
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "cached");
+
+  config.SetDefaults();
+  std::istringstream empty_stream;
+  ASSERT_EQ(config.ReadFile(path_.string(), empty_stream), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "cached");
+  EXPECT_EQ(config.settings.listen_port, 9000);
+}
+
+TEST_F(TestBrokerConfigFile, ChangedFileIsReadAgain)
+{
+  WriteFile(R"({ "scope": "first" })");
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "first");
+
+  WriteFile(R"({ "scope": "changed" })");
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "changed");
+}
+
+// A new BrokerConfig (as when the service starts) reads the settings from the snapshot, which has
+// to give the same result as reading the file.
+TEST_F(TestBrokerConfigFile, SnapshotMatchesFile)
+{
+  WriteFile(R"(
+    {
+      "cid": ")" + kTestUuid + R"(",
+      "uid": { "type": "static", "manufacturer_id": 25972, "device_id": 1234 },
+      "dns_sd": { "model": "My Model" },
+      "listen_interfaces": [ "eth0", "wlan0" ],
+      "log_level": "debug",
+      "log_compress": false,
+      "max_devices": 30
+    }
+  )");
+
+  BrokerConfig from_file;
+  from_file.SetDefaults();
+  ASSERT_EQ(ReadFile(from_file), BrokerConfig::ParseResult::kOk);
+  ASSERT_TRUE(std::filesystem::exists(snapshot_path_));
+
+  BrokerConfig from_snapshot;
+  from_snapshot.SetDefaults();
+  ASSERT_EQ(ReadFile(from_snapshot), BrokerConfig::ParseResult::kOk);
+  EXPECT_TRUE(BrokerConfig::Compare(from_file, from_snapshot).Empty());
+  EXPECT_EQ(from_snapshot.settings.uid, rdm::Uid::Static(25972, 1234));
+  EXPECT_EQ(from_snapshot.settings.listen_interfaces, std::vector<std::string>({"eth0", "wlan0"}));
+}
+
+TEST_F(TestBrokerConfigFile, SnapshotKeepsInvalidSettingResult)
+{
+  WriteFile(R"({ "scope": "snapshot", "listen_port": 80 })");
+
+  BrokerConfig from_file;
+  from_file.SetDefaults();
+  ASSERT_EQ(ReadFile(from_file), BrokerConfig::ParseResult::kInvalidSetting);
+
+  BrokerConfig from_snapshot;
+  from_snapshot.SetDefaults();
+  ASSERT_EQ(ReadFile(from_snapshot), BrokerConfig::ParseResult::kInvalidSetting);
+  EXPECT_EQ(from_snapshot.settings.scope, "snapshot");
+  EXPECT_EQ(from_snapshot.settings.listen_port, from_file.settings.listen_port);
+}
+
+TEST_F(TestBrokerConfigFile, UnreadableSnapshotIsIgnored)
+{
+  WriteFile(R"({ "scope": "original" })");
+  WriteFile(snapshot_path_, "not a snapshot");
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "original");
+}
+
+// A snapshot written by a binary with different settings is parsed again and replaced, so settings
+// that binary didn't know about aren't left out.
+TEST_F(TestBrokerConfigFile, SnapshotFromOtherSchemaIsReplaced)
+{
+  WriteFile(R"({ "scope": "original" })");
+
+  BrokerConfig from_file;
+  from_file.SetDefaults();
+  ASSERT_EQ(ReadFile(from_file), BrokerConfig::ParseResult::kOk);
+
+  std::string snapshot = ReadFile(snapshot_path_);
+  ASSERT_GE(snapshot.size(), 32u);
+  std::string other_schema = snapshot;
+  other_schema[24] = static_cast<char>(other_schema[24] ^ 0xff);
+  WriteFile(snapshot_path_, other_schema);
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "original");
+  EXPECT_EQ(ReadFile(snapshot_path_), snapshot);
+}
+
+// Fragments are merged over the file in lexical order; nested objects are merged key by key.
+TEST_F(TestBrokerConfigFile, FragmentsAreMergedInOrder)
+{
+  WriteFile(R"({ "scope": "base", "listen_port": 9000, "dns_sd": { "manufacturer": "ETC", "model": "Base" } })");
+  WriteFragment("20-scope.conf", R"({ "scope": "last" })");
+  WriteFragment("10-scope.conf", R"({ "scope": "first", "dns_sd": { "model": "Fragment" } })");
+  WriteFragment("30-ignored.conf.bak", R"({ "scope": "ignored" })");
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "last");
+  EXPECT_EQ(config.settings.listen_port, 9000);
+  EXPECT_EQ(config.settings.dns.manufacturer, "ETC");
+  EXPECT_EQ(config.settings.dns.model, "Fragment");
+}
+
+TEST_F(TestBrokerConfigFile, NullFragmentValueRestoresDefault)
+{
+  WriteFile(R"({ "scope": "base", "max_devices": 30 })");
+  WriteFragment("10-defaults.conf", R"({ "max_devices": null })");
+
+  BrokerConfig defaults;
+  defaults.SetDefaults();
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "base");
+  EXPECT_EQ(config.settings.limits.devices, defaults.settings.limits.devices);
+}
+
+TEST_F(TestBrokerConfigFile, MergedValuesAreValidated)
+{
+  WriteFile(R"({ "listen_port": 9000 })");
+  WriteFragment("10-port.conf", R"({ "listen_port": 80 })");
+
+  BrokerConfig defaults;
+  defaults.SetDefaults();
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kInvalidSetting);
+  EXPECT_EQ(config.settings.listen_port, defaults.settings.listen_port);
+}
+
+// When one fragment changes, the others are not read again.
+TEST_F(TestBrokerConfigFile, OnlyChangedFragmentsAreReadAgain)
+{
+  WriteFile(R"({ "scope": "base" })");
+  WriteFragment("10-model.conf", R"({ "dns_sd": { "model": "First" } })");
+  WriteFragment("20-scope.conf", R"({ "scope": "first" })");
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+
+  // Corrupt the first fragment without changing its size or modification time; the contents read
+  // before are still used.
+  const auto model_path = dir_ / BrokerConfig::kFragmentDirectory / "10-model.conf";
+  const auto model_time = std::filesystem::last_write_time(model_path);
+  WriteFragment("10-model.conf", R"({ "dns_sd": { "model": "First"    )");
+  std::filesystem::last_write_time(model_path, model_time);
+
+  WriteFragment("20-scope.conf", R"({ "scope": "second" })");
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "second");
+  EXPECT_EQ(config.settings.dns.model, "First");
+}
+
+TEST_F(TestBrokerConfigFile, InvalidFragmentFailsToParse)
+{
+  WriteFile(R"({ "scope": "base" })");
+  WriteFragment("10-broken.conf", R"({ "scope": )");
+
+  BrokerConfig config;
+  config.SetDefaults();
+  const auto old_config = config;
+  EXPECT_EQ(ReadFile(config), BrokerConfig::ParseResult::kJsonParseErr);
+  EXPECT_TRUE(BrokerConfig::Compare(old_config, config).Empty());
+}
+
+TEST_F(TestBrokerConfigFile, SaveSettingKeepsTheRestOfTheFile)
+{
+  WriteFile(R"({ "scope": "old", "listen_port": 9000, "dns_sd": { "model": "Test" } })");
+  ASSERT_TRUE(BrokerConfig::SaveSetting(path_.string(), "/scope", "new"));
+
+  std::ifstream file(path_);
+  const auto    document = nlohmann::ordered_json::parse(file);
+  EXPECT_EQ(document.dump(), R"({"scope":"new","listen_port":9000,"dns_sd":{"model":"Test"}})");
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "new");
+  EXPECT_FALSE(std::filesystem::exists(path_.string() + ".tmp"));
+}
+
+#ifndef _WIN32
+// Replacing the file mustn't change who can edit it, e.g. a group given write access to it.
+TEST_F(TestBrokerConfigFile, SaveSettingKeepsFilePermissions)
+{
+  namespace fs = std::filesystem;
+
+  WriteFile(R"({ "scope": "old" })");
+  const auto perms = fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read |
+                     fs::perms::group_write | fs::perms::others_read;
+  fs::permissions(path_, perms, fs::perm_options::replace);
+  ASSERT_TRUE(BrokerConfig::SaveSetting(path_.string(), "/scope", "new"));
+  EXPECT_EQ(fs::status(path_).permissions(), perms);
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(fs::status(snapshot_path_).permissions(), perms);
+}
+#endif
+
+TEST_F(TestBrokerConfigFile, SaveSettingCreatesMissingFile)
+{
+  ASSERT_TRUE(BrokerConfig::SaveSetting(path_.string(), "/scope", "new"));
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "new");
+}
+
+// The value is written where it takes effect: the last fragment that sets it.
+TEST_F(TestBrokerConfigFile, SaveSettingWritesTheFragmentThatSetsIt)
+{
+  WriteFile(R"({ "scope": "base" })");
+  WriteFragment("10-scope.conf", R"({ "scope": "first" })");
+  WriteFragment("20-scope.conf", R"({ "scope": "second" })");
+  WriteFragment("30-model.conf", R"({ "dns_sd": { "model": "Test" } })");
+  ASSERT_TRUE(BrokerConfig::SaveSetting(path_.string(), "/scope", "new"));
+
+  BrokerConfig config;
+  config.SetDefaults();
+  ASSERT_EQ(ReadFile(config), BrokerConfig::ParseResult::kOk);
+  EXPECT_EQ(config.settings.scope, "new");
+
+  std::ifstream base(path_);
+  EXPECT_EQ(nlohmann::json::parse(base)["scope"], "base");
+  std::ifstream first(dir_ / BrokerConfig::kFragmentDirectory / "10-scope.conf");
+  EXPECT_EQ(nlohmann::json::parse(first)["scope"], "first");
+}
+
+TEST_F(TestBrokerConfigFile, SaveSettingLeavesUnparseableFileAlone)
+{
+  const std::string contents = R"({ "scope": )";
+  WriteFile(contents);
+  EXPECT_FALSE(BrokerConfig::SaveSetting(path_.string(), "/scope", "new"));
+
+  EXPECT_EQ(ReadFile(path_), contents);
 }
@@ -19,8 +19,21 @@
 
 #include "broker_shell.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "etcpal/socket.h"
 #include "gmock/gmock.h"
 #include "broker_os_interface.h"
+#include "temp_dir_test.h"
 
 using testing::_;
 using testing::ByMove;
@@ -32,20 +45,108 @@ public:
   MOCK_METHOD(std::string, GetLogFilePath, (), (const override));
   MOCK_METHOD(bool, OpenLogFile, (), (override));
   MOCK_METHOD((std::pair<std::string, std::ifstream>), GetConfFile, (etcpal::Logger & log), (override));
+  MOCK_METHOD(void, SetLogWriterSettings, (const AsyncLogWriter::Settings& settings), (override));
+  MOCK_METHOD(void, SetLogArchiveSettings, (const LogArchiver::Settings& settings), (override));
+  MOCK_METHOD(ResourceUsage, GetResourceUsage, (), (const override));
+  MOCK_METHOD(std::unique_ptr<AdminServer>, CreateAdminServer, (AdminServer::Handler & handler), (override));
   MOCK_METHOD(etcpal::LogTimestamp, GetLogTimestamp, (), (override));
   MOCK_METHOD(void, HandleLogMessage, (const EtcPalLogStrings& strings), (override));
 };
 
-class TestBrokerShell : public testing::Test
+// The configuration file and the log file are in the test's directory; the log messages the shell
+// passes on are kept in log_messages_, and their human-readable strings in log_lines_.
+class TestBrokerShell : public TempDirTest
 {
 protected:
-  TestBrokerShell()
+  testing::NiceMock<MockBrokerOsInterface> os_interface_;
+  etcpal::Mutex                            log_lock_;
+  std::vector<std::string>                 log_messages_;
+  std::vector<std::string>                 log_lines_;  // Empty where there was no human-readable string
+  BrokerShell                              shell_{os_interface_};
+  std::thread                              run_thread_;
+  std::atomic<bool>                        started_{false};
+  std::atomic<bool>                        run_returned_{false};
+
+  void SetUp() override
   {
+    TempDirTest::SetUp();
+
     ON_CALL(os_interface_, OpenLogFile()).WillByDefault(Return(true));
-    // ON_CALL(os_interface_, GetConfFile(_)).WillByDefault(Return(true));
+    ON_CALL(os_interface_, GetLogFilePath()).WillByDefault(Return((dir_ / "broker.log").string()));
+    ON_CALL(os_interface_, GetConfFile(_)).WillByDefault([this](etcpal::Logger&) {
+      const auto path = dir_ / "broker.conf";
+      return std::make_pair(path.string(), std::ifstream(path));
+    });
+    ON_CALL(os_interface_, HandleLogMessage(_)).WillByDefault([this](const EtcPalLogStrings& strings) {
+      etcpal::MutexGuard guard(log_lock_);
+      log_messages_.push_back(strings.raw);
+      log_lines_.push_back(strings.human_readable ? strings.human_readable : "");
+    });
   }
 
-  testing::NiceMock<MockBrokerOsInterface> os_interface_;
+  void TearDown() override
+  {
+    if (run_thread_.joinable())
+    {
+      shell_.AsyncShutdown();
+      run_thread_.join();
+    }
+    shell_.Deinit();
+    TempDirTest::TearDown();
+  }
+
+  void WriteConfig(const std::string& contents) { WriteFile(dir_ / "broker.conf", contents); }
+
+  void StartShell()
+  {
+    ASSERT_TRUE(shell_.Init());
+    run_thread_ = std::thread([this]() {
+      shell_.Run([this]() { started_ = true; });
+      run_returned_ = true;
+    });
+  }
+
+  static bool WaitFor(const std::function<bool()>& condition, std::chrono::milliseconds timeout)
+  {
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition())
+    {
+      if (std::chrono::steady_clock::now() > deadline)
+        return false;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+  }
+
+  // The value of a series in the shell's metrics, named as it is rendered, or -1 if it isn't there.
+  double MetricValue(const std::string& series) const
+  {
+    std::istringstream rendered(shell_.metrics().RenderPrometheus());
+    for (std::string line; std::getline(rendered, line);)
+    {
+      if (line.compare(0, series.size() + 1, series + " ") == 0)
+        return std::stod(line.substr(series.size() + 1));
+    }
+    return -1.0;
+  }
+
+  // The human-readable string passed on with message.
+  std::string LogLine(const std::string& message)
+  {
+    etcpal::MutexGuard guard(log_lock_);
+    const auto         found = std::find(log_messages_.begin(), log_messages_.end(), message);
+    if (found == log_messages_.end())
+      return std::string{};
+    return log_lines_[static_cast<size_t>(found - log_messages_.begin())];
+  }
+
+  size_t CountLogMessages(const std::string& text)
+  {
+    etcpal::MutexGuard guard(log_lock_);
+    return static_cast<size_t>(std::count_if(log_messages_.begin(), log_messages_.end(), [&](const std::string& line) {
+      return line.find(text) != std::string::npos;
+    }));
+  }
 };
 
 // TODO - if these tests don't work as expected, we might start a real broker and enter an infinite
@@ -60,3 +161,80 @@ TEST_F(TestBrokerShell, DoesNotStartIfOpenLogFileFails)
   EXPECT_FALSE(shell.Init());
   EXPECT_FALSE(shell.Run());
 }
+
+// etcpal only builds the raw strings; the shell formats the messages that are written itself.
+TEST_F(TestBrokerShell, OnlyWrittenMessagesAreFormatted)
+{
+  WriteConfig(R"({ "log_level": "info", "flight_recorder_size": 100 })");
+  ASSERT_TRUE(shell_.Init());
+  EXPECT_EQ(shell_.log().log_action() & ETCPAL_LOG_CREATE_HUMAN_READABLE, 0);
+
+  shell_.log().Debug("A recorded message");
+  shell_.log().Info("A written message");
+  ASSERT_TRUE(WaitFor([this]() { return CountLogMessages("A written message") == 1u; }, std::chrono::seconds(5)));
+  EXPECT_EQ(CountLogMessages("A recorded message"), 0u);
+
+  const std::string line = LogLine("A written message");
+  EXPECT_EQ(line.substr(line.find('[')), "[INFO] A written message");
+}
+
+TEST_F(TestBrokerShell, BinaryFormatMessagesAreNotFormatted)
+{
+  WriteConfig(R"({ "log_format": "binary" })");
+  ASSERT_TRUE(shell_.Init());
+
+  shell_.log().Info("A written message");
+  ASSERT_TRUE(WaitFor([this]() { return CountLogMessages("A written message") == 1u; }, std::chrono::seconds(5)));
+  EXPECT_EQ(LogLine("A written message"), "");
+}
+
+// A restart whose startups fail is only reported once a broker is running again, and the downtime
+// covers every failed startup and retry since the old broker was shut down.
+TEST_F(TestBrokerShell, DowntimeCoversFailedStartups)
+{
+  // Hold a port so that a broker configured to listen on it can't start.
+  etcpal_socket_t blocker = ETCPAL_SOCKET_INVALID;
+  ASSERT_EQ(etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &blocker), kEtcPalErrOk);
+  EtcPalSockAddr addr{};
+  ETCPAL_IP_SET_V4_ADDRESS(&addr.ip, 0u);
+  ASSERT_EQ(etcpal_bind(blocker, &addr), kEtcPalErrOk);
+  ASSERT_EQ(etcpal_listen(blocker, 1), kEtcPalErrOk);
+  ASSERT_EQ(etcpal_getsockname(blocker, &addr), kEtcPalErrOk);
+
+  WriteConfig(R"({ "listen_port": 0 })");
+  StartShell();
+  ASSERT_TRUE(WaitFor([this]() { return started_ || run_returned_; }, std::chrono::seconds(10)));
+  if (run_returned_ || MetricValue("rdmnet_broker_up") != 1.0)
+  {
+    etcpal_close(blocker);
+    GTEST_SKIP() << "A broker can't be started here";
+  }
+
+  WriteConfig(R"({ "listen_port": )" + std::to_string(addr.port) + " }");
+  shell_.RequestRestart();
+
+  // The first startup and its first retry fail; the retry waits out the first backoff.
+  EXPECT_TRUE(
+      WaitFor([this]() { return shell_.GetRestartCounters().startup_failures >= 2u; }, std::chrono::seconds(10)));
+  EXPECT_EQ(MetricValue("rdmnet_broker_up"), 0.0);
+  EXPECT_EQ(MetricValue("rdmnet_broker_restart_downtime_seconds_count"), 0.0);
+  EXPECT_EQ(CountLogMessages("Broker restart complete"), 0u);
+
+  etcpal_close(blocker);
+  ASSERT_TRUE(WaitFor([this]() { return MetricValue("rdmnet_broker_up") == 1.0; }, std::chrono::seconds(10)));
+
+  EXPECT_EQ(MetricValue("rdmnet_broker_restart_downtime_seconds_count"), 1.0);
+  // At least the two backoffs, of 1 s and 2 s less up to 20% each.
+  EXPECT_GE(MetricValue("rdmnet_broker_restart_downtime_seconds_sum"), 2.4);
+  EXPECT_EQ(CountLogMessages("Broker restart complete"), 1u);
+
+  // The retries weren't restarts; only shutting down the first broker was.
+  EXPECT_EQ(shell_.GetRestartCounters().executed, 1u);
+  EXPECT_EQ(MetricValue("rdmnet_broker_restarts_total{mode=\"standard\"}"), 1.0);
+
+  const auto counters = shell_.GetRestartCounters();
+  EXPECT_EQ(counters.requested[static_cast<size_t>(RestartScheduler::Trigger::kStartupRetry)],
+            counters.startup_failures);
+  EXPECT_EQ(MetricValue("rdmnet_broker_restart_requests_total{trigger=\"startup_retry\"}"),
+            static_cast<double>(counters.startup_failures));
+}
@@ -0,0 +1,158 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "config_watcher.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "temp_dir_test.h"
+
+static constexpr uint32_t kDebounceMs = 100u;
+
+class TestConfigWatcher : public TempDirTest, public ConfigWatcher::NotifyHandler
+{
+protected:
+  std::filesystem::path path_;
+  BrokerConfig          config_;
+
+  uint64_t      now_ms_{1000};
+  ConfigWatcher watcher_{*this, kDebounceMs, [this]() { return now_ms_; }};
+
+  std::vector<BrokerConfig>       new_configs_;
+  std::vector<BrokerConfig::Diff> diffs_;
+
+  void HandleConfigChanged(const BrokerConfig& new_config, const BrokerConfig::Diff& diff) override
+  {
+    new_configs_.push_back(new_config);
+    diffs_.push_back(diff);
+  }
+
+  void SetUp() override
+  {
+    TempDirTest::SetUp();
+    std::filesystem::create_directories(dir_ / BrokerConfig::kFragmentDirectory);
+    path_ = dir_ / "broker.conf";
+
+    WriteFile(path_, R"({ "scope": "default", "listen_port": 9000 })");
+    config_.SetDefaults();
+    std::ifstream file(path_);
+    ASSERT_EQ(config_.ReadFile(path_.string(), file), BrokerConfig::ParseResult::kOk);
+    ASSERT_TRUE(watcher_.Start(path_.string(), config_));
+  }
+
+  // Report an event, then let the debounce window pass and make the check.
+  bool EventThenCheck()
+  {
+    watcher_.EventReceived();
+    now_ms_ += kDebounceMs;
+    return watcher_.CheckIfDue();
+  }
+};
+
+TEST_F(TestConfigWatcher, NoCheckIsPendingWithoutEvents)
+{
+  EXPECT_EQ(watcher_.TimeUntilCheck(), -1);
+  EXPECT_FALSE(watcher_.CheckIfDue());
+}
+
+// An editor saving in several writes produces several events; the files are only read once the
+// events stop.
+TEST_F(TestConfigWatcher, BurstOfEventsIsCoalesced)
+{
+  WriteFile(path_, R"({ "scope": "new", )");
+  watcher_.EventReceived();
+  EXPECT_EQ(watcher_.TimeUntilCheck(), static_cast<int>(kDebounceMs));
+
+  now_ms_ += kDebounceMs / 2;
+  WriteFile(path_, R"({ "scope": "new", "listen_port": 9000 })");
+  watcher_.EventReceived();
+
+  now_ms_ += kDebounceMs / 2;
+  EXPECT_EQ(watcher_.TimeUntilCheck(), static_cast<int>(kDebounceMs / 2));
+  EXPECT_FALSE(watcher_.CheckIfDue());
+  EXPECT_TRUE(new_configs_.empty());
+
+  now_ms_ += kDebounceMs / 2;
+  EXPECT_EQ(watcher_.TimeUntilCheck(), 0);
+  EXPECT_TRUE(watcher_.CheckIfDue());
+  EXPECT_EQ(watcher_.TimeUntilCheck(), -1);
+
+  ASSERT_EQ(new_configs_.size(), 1u);
+  EXPECT_EQ(new_configs_[0].settings.scope, "new");
+  EXPECT_TRUE(diffs_[0].scope);
+  EXPECT_FALSE(diffs_[0].listen_port);
+}
+
+TEST_F(TestConfigWatcher, RewriteWithSameContentsIsIgnored)
+{
+  WriteFile(path_, R"({ "scope": "default", "listen_port": 9000 })");
+  EXPECT_FALSE(EventThenCheck());
+  EXPECT_TRUE(new_configs_.empty());
+}
+
+TEST_F(TestConfigWatcher, ChangeThatLeavesSettingsAloneIsIgnored)
+{
+  WriteFile(path_, R"({ "listen_port": 9000, "scope": "default" })");
+  EXPECT_FALSE(EventThenCheck());
+  EXPECT_TRUE(new_configs_.empty());
+}
+
+TEST_F(TestConfigWatcher, ChangesAreRelativeToTheLastConfigRead)
+{
+  WriteFile(path_, R"({ "scope": "default", "listen_port": 9001 })");
+  ASSERT_TRUE(EventThenCheck());
+  EXPECT_TRUE(diffs_.back().listen_port);
+
+  WriteFile(path_, R"({ "scope": "other", "listen_port": 9001 })");
+  ASSERT_TRUE(EventThenCheck());
+  EXPECT_TRUE(diffs_.back().scope);
+  EXPECT_FALSE(diffs_.back().listen_port);
+}
+
+TEST_F(TestConfigWatcher, FragmentChangeIsReported)
+{
+  WriteFile(dir_ / BrokerConfig::kFragmentDirectory / "10-port.conf", R"({ "listen_port": 9100 })");
+  ASSERT_TRUE(EventThenCheck());
+  EXPECT_EQ(new_configs_[0].settings.listen_port, 9100);
+  EXPECT_EQ(diffs_[0].ToString(), "listen_port");
+}
+
+// A file caught in the middle of being written is skipped, and read once it is complete.
+TEST_F(TestConfigWatcher, UnreadableFileIsSkipped)
+{
+  WriteFile(path_, R"({ "scope": )");
+  EXPECT_FALSE(EventThenCheck());
+
+  WriteFile(path_, R"({ "scope": "fixed", "listen_port": 9000 })");
+  ASSERT_TRUE(EventThenCheck());
+  EXPECT_EQ(new_configs_[0].settings.scope, "fixed");
+}
+
+// Settings left at their defaults must not show up as changes just because a new configuration
+// was read.
+TEST_F(TestConfigWatcher, DefaultCidIsKept)
+{
+  WriteFile(path_, R"({ "scope": "default", "listen_port": 9001 })");
+  ASSERT_TRUE(EventThenCheck());
+  EXPECT_FALSE(diffs_[0].cid);
+  EXPECT_EQ(new_configs_[0].settings.cid, config_.settings.cid);
+}
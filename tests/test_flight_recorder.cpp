@@ -0,0 +1,185 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "flight_recorder.h"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+namespace fs = std::filesystem;
+
+class TestFlightRecorder : public testing::Test
+{
+protected:
+  fs::path dump_path_;
+
+  void SetUp() override
+  {
+    dump_path_ = fs::temp_directory_path() /
+                 ("test_flight_recorder_" +
+                  std::string(testing::UnitTest::GetInstance()->current_test_info()->name()) + ".log");
+  }
+
+  void TearDown() override
+  {
+    FlightRecorder::SetCrashDumpTarget(nullptr, std::string{});
+    std::error_code ec;
+    fs::remove(dump_path_, ec);
+  }
+
+  static void Record(FlightRecorder& recorder, const std::string& message, int priority = ETCPAL_LOG_DEBUG)
+  {
+    EtcPalLogStrings strings{};
+    strings.raw = message.c_str();
+    strings.priority = priority;
+    recorder.Record(strings);
+  }
+
+  std::vector<std::string> DumpLines()
+  {
+    std::vector<std::string> lines;
+    std::ifstream            file(dump_path_);
+    for (std::string line; std::getline(file, line);)
+      lines.push_back(line);
+    return lines;
+  }
+};
+
+TEST_F(TestFlightRecorder, DumpsMessagesInOrder)
+{
+  FlightRecorder recorder(10);
+  Record(recorder, "First", ETCPAL_LOG_DEBUG);
+  Record(recorder, "Second", ETCPAL_LOG_ERR);
+
+  ASSERT_TRUE(recorder.DumpToFile(dump_path_.string(), "test"));
+
+  const auto lines = DumpLines();
+  ASSERT_EQ(lines.size(), 3u);
+  EXPECT_EQ(lines[0], "RDMnet Broker flight recorder dump (test)");
+  EXPECT_EQ(lines[1], "[DBUG] First");
+  EXPECT_EQ(lines[2], "[ERR ] Second");
+}
+
+TEST_F(TestFlightRecorder, KeepsOnlyMostRecentMessages)
+{
+  FlightRecorder recorder(3);
+  for (int i = 0; i < 10; ++i)
+    Record(recorder, "Message " + std::to_string(i));
+
+  ASSERT_TRUE(recorder.DumpToFile(dump_path_.string(), "test"));
+
+  const auto lines = DumpLines();
+  ASSERT_EQ(lines.size(), 4u);
+  EXPECT_EQ(lines[1], "[DBUG] Message 7");
+  EXPECT_EQ(lines[2], "[DBUG] Message 8");
+  EXPECT_EQ(lines[3], "[DBUG] Message 9");
+}
+
+TEST_F(TestFlightRecorder, DumpToStringMatchesFileDump)
+{
+  FlightRecorder recorder(10);
+  EXPECT_EQ(recorder.DumpToString(), "");
+
+  Record(recorder, "First", ETCPAL_LOG_DEBUG);
+  Record(recorder, "Second", ETCPAL_LOG_ERR);
+
+  EXPECT_EQ(recorder.DumpToString(), "[DBUG] First\n[ERR ] Second\n");
+}
+
+TEST_F(TestFlightRecorder, TimestampIncludedWhenPresent)
+{
+  EtcPalLogTimestamp timestamp{};
+  timestamp.year = 2022;
+  timestamp.month = 6;
+  timestamp.day = 1;
+  timestamp.hour = 12;
+  timestamp.minute = 34;
+  timestamp.second = 56;
+  timestamp.msec = 789;
+  timestamp.utc_offset = -300;
+
+  EtcPalLogStrings strings{};
+  strings.raw = "Timed";
+  strings.priority = ETCPAL_LOG_INFO;
+  strings.log_timestamp = &timestamp;
+
+  FlightRecorder recorder(10);
+  recorder.Record(strings);
+  ASSERT_TRUE(recorder.DumpToFile(dump_path_.string(), "test"));
+
+  const auto lines = DumpLines();
+  ASSERT_EQ(lines.size(), 2u);
+  EXPECT_EQ(lines[1], "2022-06-01 12:34:56.789-05:00 [INFO] Timed");
+}
+
+TEST_F(TestFlightRecorder, LongMessagesAreTruncated)
+{
+  FlightRecorder recorder(10);
+  Record(recorder, std::string(FlightRecorder::kMaxMessageLength * 2, 'a'));
+  ASSERT_TRUE(recorder.DumpToFile(dump_path_.string(), "test"));
+
+  const auto lines = DumpLines();
+  ASSERT_EQ(lines.size(), 2u);
+  EXPECT_EQ(lines[1], "[DBUG] " + std::string(FlightRecorder::kMaxMessageLength, 'a'));
+}
+
+TEST_F(TestFlightRecorder, CrashDumpWritesTarget)
+{
+  FlightRecorder recorder(10);
+  Record(recorder, "Before the crash");
+
+  // Nothing happens without a target.
+  FlightRecorder::DumpForCrash("crash");
+  EXPECT_FALSE(fs::exists(dump_path_));
+
+  FlightRecorder::SetCrashDumpTarget(&recorder, dump_path_.string());
+  FlightRecorder::DumpForCrash("crash");
+
+  const auto lines = DumpLines();
+  ASSERT_EQ(lines.size(), 2u);
+  EXPECT_EQ(lines[0], "RDMnet Broker flight recorder dump (crash)");
+  EXPECT_EQ(lines[1], "[DBUG] Before the crash");
+}
+
+TEST_F(TestFlightRecorder, DumpWhileRecordingOnlyWritesWholeMessages)
+{
+  FlightRecorder recorder(64);
+
+  std::atomic<bool> done{false};
+  std::thread       writer([&]() {
+    const std::string message(100, 'x');
+    while (!done)
+      Record(recorder, message);
+  });
+
+  for (int i = 0; i < 20; ++i)
+  {
+    ASSERT_TRUE(recorder.DumpToFile(dump_path_.string(), "test"));
+    const auto lines = DumpLines();
+    for (size_t j = 1; j < lines.size(); ++j)
+      EXPECT_EQ(lines[j], "[DBUG] " + std::string(100, 'x'));
+  }
+
+  done = true;
+  writer.join();
+}
@@ -0,0 +1,112 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "inotify_config_watcher.h"
+
+#include <poll.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "gtest/gtest.h"
+#include "temp_dir_test.h"
+
+class TestInotifyConfigWatcher : public TempDirTest, public ConfigWatcher::NotifyHandler
+{
+protected:
+  std::filesystem::path path_;
+  InotifyConfigWatcher  watcher_{*this, 0u};  // Checks are due as soon as there is an event
+
+  void HandleConfigChanged(const BrokerConfig&, const BrokerConfig::Diff&) override {}
+
+  void SetUp() override
+  {
+    TempDirTest::SetUp();
+    path_ = dir_ / "broker.conf";
+    WriteFile(path_, "{}");
+
+    BrokerConfig config;
+    config.SetDefaults();
+    ASSERT_TRUE(watcher_.Start(path_.string(), config));
+  }
+
+  void TearDown() override
+  {
+    watcher_.Stop();
+    TempDirTest::TearDown();
+  }
+
+  // Wait for the kernel to queue whatever events the test caused, then process them.
+  void Receive()
+  {
+    struct pollfd pfd = {watcher_.fd(), POLLIN, 0};
+    poll(&pfd, 1, 100);
+    watcher_.Receive();
+  }
+};
+
+TEST_F(TestInotifyConfigWatcher, ConfigFileWriteIsAnEvent)
+{
+  WriteFile(path_, R"({ "scope": "new" })");
+  Receive();
+  EXPECT_EQ(watcher_.TimeUntilCheck(), 0);
+}
+
+TEST_F(TestInotifyConfigWatcher, OtherFilesAreNotEvents)
+{
+  WriteFile(path_.string() + BrokerConfig::kSnapshotExtension, "snapshot");
+  Receive();
+  EXPECT_EQ(watcher_.TimeUntilCheck(), -1);
+}
+
+// The fragment directory is watched from when it is created.
+TEST_F(TestInotifyConfigWatcher, FragmentInNewDirectoryIsAnEvent)
+{
+  std::filesystem::create_directory(dir_ / BrokerConfig::kFragmentDirectory);
+  Receive();
+  EXPECT_EQ(watcher_.TimeUntilCheck(), 0);
+  watcher_.CheckIfDue();
+  ASSERT_EQ(watcher_.TimeUntilCheck(), -1);
+
+  WriteFile(dir_ / BrokerConfig::kFragmentDirectory / "10-scope.conf", R"({ "scope": "new" })");
+  Receive();
+  EXPECT_EQ(watcher_.TimeUntilCheck(), 0);
+}
+
+// Once the kernel's queue overflows, events are lost, so the files are checked in case a change was
+// among them.
+TEST_F(TestInotifyConfigWatcher, QueueOverflowIsAnEvent)
+{
+  unsigned long max_queued_events = 0;
+  std::ifstream("/proc/sys/fs/inotify/max_queued_events") >> max_queued_events;
+  if (max_queued_events == 0 || max_queued_events > 100000)
+    GTEST_SKIP() << "Can't overflow the inotify queue in reasonable time";
+
+  // With the fragment directory watched too, so that the overflow can't be taken for an event on an
+  // unwatched directory.
+  std::filesystem::create_directory(dir_ / BrokerConfig::kFragmentDirectory);
+  Receive();
+  watcher_.CheckIfDue();
+  ASSERT_EQ(watcher_.TimeUntilCheck(), -1);
+
+  // Other files, alternating so that the kernel can't merge the events.
+  for (unsigned long i = 0; i <= max_queued_events; ++i)
+    WriteFile(dir_ / ((i % 2) ? "other_a" : "other_b"), "other");
+  Receive();
+  EXPECT_EQ(watcher_.TimeUntilCheck(), 0);
+}
@@ -0,0 +1,139 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "latency_histogram.h"
+
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+TEST(TestLatencyHistogram, SmallValuesHaveExactBuckets)
+{
+  for (uint64_t value = 0; value < LatencyHistogram::kSubBucketCount; ++value)
+  {
+    const size_t index = LatencyHistogram::BucketIndex(value);
+    EXPECT_EQ(LatencyHistogram::BucketLowerBound(index), value);
+    EXPECT_EQ(LatencyHistogram::BucketUpperBound(index), value);
+  }
+}
+
+TEST(TestLatencyHistogram, BucketsCoverEveryValueWithBoundedError)
+{
+  size_t previous_index = 0;
+  for (uint64_t value = 1; value < LatencyHistogram::kMaxValue; value += value / 7 + 1)
+  {
+    const size_t index = LatencyHistogram::BucketIndex(value);
+    ASSERT_LT(index, LatencyHistogram::kNumBuckets) << value;
+    EXPECT_GE(index, previous_index) << value;
+    EXPECT_LE(LatencyHistogram::BucketLowerBound(index), value);
+    EXPECT_GE(LatencyHistogram::BucketUpperBound(index), value);
+
+    const uint64_t width = LatencyHistogram::BucketUpperBound(index) - LatencyHistogram::BucketLowerBound(index) + 1;
+    EXPECT_LE(width * LatencyHistogram::kSubBucketCount, value + LatencyHistogram::kSubBucketCount) << value;
+    previous_index = index;
+  }
+  EXPECT_EQ(LatencyHistogram::BucketIndex(LatencyHistogram::kMaxValue), LatencyHistogram::kNumBuckets - 1);
+}
+
+TEST(TestLatencyHistogram, AdjacentBucketsMeet)
+{
+  for (size_t index = 1; index < LatencyHistogram::kNumBuckets; ++index)
+    EXPECT_EQ(LatencyHistogram::BucketLowerBound(index), LatencyHistogram::BucketUpperBound(index - 1) + 1) << index;
+}
+
+TEST(TestLatencyHistogram, EmptySnapshotReadsZero)
+{
+  LatencyHistogram histogram;
+  const auto       snapshot = histogram.Read();
+  EXPECT_EQ(snapshot.count, 0u);
+  EXPECT_EQ(snapshot.ValueAtQuantile(0.99), 0u);
+  EXPECT_EQ(snapshot.Max(), 0u);
+}
+
+TEST(TestLatencyHistogram, QuantilesAreWithinBucketPrecision)
+{
+  LatencyHistogram histogram;
+  for (uint64_t value = 1; value <= 10000; ++value)
+    histogram.Record(value);
+
+  const auto snapshot = histogram.Read();
+  EXPECT_EQ(snapshot.count, 10000u);
+  EXPECT_EQ(snapshot.sum, 10000u * 10001u / 2);
+
+  const auto expect_near = [&snapshot](double quantile, double expected) {
+    const double value = static_cast<double>(snapshot.ValueAtQuantile(quantile));
+    EXPECT_GE(value, expected) << quantile;
+    EXPECT_LE(value, expected * (1.0 + 1.0 / LatencyHistogram::kSubBucketCount)) << quantile;
+  };
+  expect_near(0.5, 5000.0);
+  expect_near(0.99, 9900.0);
+  expect_near(0.999, 9990.0);
+  expect_near(1.0, 10000.0);
+}
+
+TEST(TestLatencyHistogram, LargeValuesAreClamped)
+{
+  LatencyHistogram histogram;
+  histogram.Record(UINT64_MAX);
+  const auto snapshot = histogram.Read();
+  EXPECT_EQ(snapshot.count, 1u);
+  EXPECT_EQ(snapshot.Max(), LatencyHistogram::kMaxValue);
+}
+
+TEST(TestLatencyHistogram, SinceCoversOnlyTheInterval)
+{
+  LatencyHistogram histogram;
+  histogram.Record(1000);
+  const auto earlier = histogram.Read();
+
+  histogram.Record(10);
+  histogram.Record(20);
+  const auto interval = histogram.Read().Since(earlier);
+  EXPECT_EQ(interval.count, 2u);
+  EXPECT_EQ(interval.sum, 30u);
+  EXPECT_EQ(interval.Max(), 20u);
+}
+
+TEST(TestLatencyHistogram, ToStringShowsPercentilesWithUnits)
+{
+  LatencyHistogram histogram;
+  histogram.Record(5);
+  histogram.Record(2500000);
+  EXPECT_EQ(histogram.Read().ToString(), "p50=5us p99=2.62s p99.9=2.62s max=2.62s n=2");
+}
+
+TEST(TestLatencyHistogram, RecordsFromManyThreadsAreMerged)
+{
+  LatencyHistogram         histogram;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 16; ++t)
+  {
+    threads.emplace_back([&histogram]() {
+      for (int i = 0; i < 10000; ++i)
+        histogram.Record(100);
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  const auto snapshot = histogram.Read();
+  EXPECT_EQ(snapshot.count, 160000u);
+  EXPECT_EQ(snapshot.sum, 16000000u);
+  EXPECT_EQ(snapshot.ValueAtQuantile(0.5), LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketIndex(100)));
+}
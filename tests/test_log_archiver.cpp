@@ -0,0 +1,200 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "log_archiver.h"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include "gtest/gtest.h"
+#include "temp_dir_test.h"
+
+namespace fs = std::filesystem;
+
+class TestLogArchiver : public TempDirTest
+{
+protected:
+  fs::path              log_path_;
+  LogArchiver           archiver_;
+  LogArchiver::Settings settings_;
+  std::atomic<int>      error_count_{0};
+
+  void SetUp() override
+  {
+    TempDirTest::SetUp();
+    log_path_ = dir_ / "broker.log";
+
+    settings_.compress = false;
+  }
+
+  void TearDown() override
+  {
+    archiver_.Shutdown();
+    TempDirTest::TearDown();
+  }
+
+  void StartArchiver()
+  {
+    ASSERT_TRUE(archiver_.Startup(log_path_, settings_, [this](const std::string&) { ++error_count_; }));
+  }
+
+  fs::path Backup(unsigned int number, bool compressed = false)
+  {
+    return LogArchiver::BackupPath(log_path_, number, compressed);
+  }
+
+  // Rotate out the current log file and wait for the archiver to finish with it.
+  void RotateAndWait(const std::string& contents, bool compressed = false)
+  {
+    WriteFile(log_path_, contents);
+    ASSERT_FALSE(archiver_.RotateOut());
+
+    WaitUntil([&]() {
+      return fs::exists(Backup(1, compressed)) && !fs::exists(Backup(1, !compressed)) && ReadyForNextRotation();
+    });
+  }
+
+  template <typename Predicate>
+  static void WaitUntil(Predicate&& done)
+  {
+    for (int i = 0; i < 500 && !done(); ++i)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  bool ReadyForNextRotation()
+  {
+    for (const auto& entry : fs::directory_iterator(dir_))
+    {
+      if (entry.path().filename().string().find(".pending.") != std::string::npos)
+        return false;
+    }
+    return true;
+  }
+};
+
+TEST_F(TestLogArchiver, BackupPathsAreNumbered)
+{
+  EXPECT_EQ(LogArchiver::BackupPath("broker.log", 0), fs::path("broker.log"));
+  EXPECT_EQ(LogArchiver::BackupPath("broker.log", 1), fs::path("broker.log.1"));
+  EXPECT_EQ(LogArchiver::BackupPath("broker.log", 12, true), fs::path("broker.log.12.gz"));
+}
+
+TEST_F(TestLogArchiver, RotatedFileBecomesFirstBackup)
+{
+  StartArchiver();
+  RotateAndWait("first");
+
+  EXPECT_FALSE(fs::exists(log_path_));
+  EXPECT_EQ(ReadFile(Backup(1)), "first");
+  EXPECT_EQ(error_count_, 0);
+}
+
+TEST_F(TestLogArchiver, BackupsShiftUpOnEachRotation)
+{
+  StartArchiver();
+  RotateAndWait("first");
+  RotateAndWait("second");
+  RotateAndWait("third");
+
+  EXPECT_EQ(ReadFile(Backup(1)), "third");
+  EXPECT_EQ(ReadFile(Backup(2)), "second");
+  EXPECT_EQ(ReadFile(Backup(3)), "first");
+  EXPECT_EQ(error_count_, 0);
+}
+
+TEST_F(TestLogArchiver, OldestBackupsDeletedPastMaxFiles)
+{
+  settings_.max_files = 2;
+  StartArchiver();
+  RotateAndWait("first");
+  RotateAndWait("second");
+  RotateAndWait("third");
+  WaitUntil([&]() { return !fs::exists(Backup(3)); });
+
+  EXPECT_EQ(ReadFile(Backup(1)), "third");
+  EXPECT_EQ(ReadFile(Backup(2)), "second");
+  EXPECT_FALSE(fs::exists(Backup(3)));
+}
+
+TEST_F(TestLogArchiver, OldestBackupsDeletedPastMaxTotalSize)
+{
+  settings_.max_files = 100;
+  settings_.max_total_size = 25;
+  StartArchiver();
+  RotateAndWait(std::string(10, 'a'));
+  RotateAndWait(std::string(10, 'b'));
+  RotateAndWait(std::string(10, 'c'));
+  WaitUntil([&]() { return !fs::exists(Backup(3)); });
+
+  EXPECT_TRUE(fs::exists(Backup(1)));
+  EXPECT_TRUE(fs::exists(Backup(2)));
+  EXPECT_FALSE(fs::exists(Backup(3)));
+}
+
+TEST_F(TestLogArchiver, LoweringLimitsAppliesToExistingBackups)
+{
+  StartArchiver();
+  RotateAndWait("first");
+  RotateAndWait("second");
+  RotateAndWait("third");
+
+  settings_.max_files = 1;
+  archiver_.SetSettings(settings_);
+
+  WaitUntil([&]() { return !fs::exists(Backup(2)); });
+
+  EXPECT_TRUE(fs::exists(Backup(1)));
+  EXPECT_FALSE(fs::exists(Backup(2)));
+  EXPECT_FALSE(fs::exists(Backup(3)));
+}
+
+TEST_F(TestLogArchiver, LeftoverPendingFilesArchivedOnStartup)
+{
+  WriteFile(log_path_.string() + ".pending.3", "older");
+  WriteFile(log_path_.string() + ".pending.7", "newer");
+
+  StartArchiver();
+  WaitUntil([&]() { return fs::exists(Backup(2)) && ReadyForNextRotation(); });
+
+  EXPECT_EQ(ReadFile(Backup(1)), "newer");
+  EXPECT_EQ(ReadFile(Backup(2)), "older");
+}
+
+TEST_F(TestLogArchiver, RotatedFilesAreCompressed)
+{
+  if (!LogArchiver::CompressionSupported())
+    GTEST_SKIP() << "Built without zlib";
+
+  settings_.compress = true;
+  StartArchiver();
+  RotateAndWait(std::string(10000, 'a'), true);
+  RotateAndWait(std::string(10000, 'b'), true);
+
+  // Check for the gzip magic number, and that the repetitive contents got smaller.
+  const std::string compressed = ReadFile(Backup(1, true));
+  ASSERT_GE(compressed.size(), 2u);
+  EXPECT_EQ(static_cast<unsigned char>(compressed[0]), 0x1fu);
+  EXPECT_EQ(static_cast<unsigned char>(compressed[1]), 0x8bu);
+  EXPECT_LT(compressed.size(), 10000u);
+
+  EXPECT_TRUE(fs::exists(Backup(2, true)));
+  EXPECT_FALSE(fs::exists(Backup(1)));
+  EXPECT_EQ(error_count_, 0);
+}
@@ -0,0 +1,116 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "log_timestamp_provider.h"
+
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include "gtest/gtest.h"
+
+static void ExpectTimestamp(const etcpal::LogTimestamp& timestamp,
+                            unsigned int                year,
+                            unsigned int                month,
+                            unsigned int                day,
+                            unsigned int                hour,
+                            unsigned int                minute,
+                            unsigned int                second,
+                            unsigned int                msec)
+{
+  EXPECT_EQ(timestamp.get().year, year);
+  EXPECT_EQ(timestamp.get().month, month);
+  EXPECT_EQ(timestamp.get().day, day);
+  EXPECT_EQ(timestamp.get().hour, hour);
+  EXPECT_EQ(timestamp.get().minute, minute);
+  EXPECT_EQ(timestamp.get().second, second);
+  EXPECT_EQ(timestamp.get().msec, msec);
+}
+
+TEST(TestLogTimestampProvider, ConvertsToCalendarDates)
+{
+  ExpectTimestamp(LogTimestampProvider::ToLogTimestamp(0, 0), 1970, 1, 1, 0, 0, 0, 0);
+  ExpectTimestamp(LogTimestampProvider::ToLogTimestamp(951868799999, 0), 2000, 2, 29, 23, 59, 59, 999);
+  ExpectTimestamp(LogTimestampProvider::ToLogTimestamp(1678833000123, 0), 2023, 3, 14, 22, 30, 0, 123);
+  ExpectTimestamp(LogTimestampProvider::ToLogTimestamp(4107542400000, 0), 2100, 3, 1, 0, 0, 0, 0);
+  ExpectTimestamp(LogTimestampProvider::ToLogTimestamp(-500, 0), 1969, 12, 31, 23, 59, 59, 500);
+}
+
+TEST(TestLogTimestampProvider, UtcOffsetIsApplied)
+{
+  LogTimestampProvider provider([]() { return -300; });
+
+  const auto timestamp = provider.Now();
+  EXPECT_EQ(timestamp.get().utc_offset, -300);
+
+  // Compare the time of day against the C library's idea of UTC, shifted by the offset.
+  const std::time_t local_time = std::time(nullptr) - 300 * 60;
+  const std::tm*    expected = std::gmtime(&local_time);
+
+  const int expected_seconds = (expected->tm_hour * 60 + expected->tm_min) * 60 + expected->tm_sec;
+  const int actual_seconds = static_cast<int>((timestamp.get().hour * 60 + timestamp.get().minute) * 60 +
+                                              timestamp.get().second);
+  EXPECT_LE((expected_seconds - actual_seconds + 86400) % 86400, 2);
+}
+
+TEST(TestLogTimestampProvider, UtcOffsetOnlyQueriedOnRefresh)
+{
+  std::atomic<int>     query_count{0};
+  LogTimestampProvider provider(
+      [&]() {
+        ++query_count;
+        return 60;
+      },
+      60000);
+  EXPECT_EQ(query_count, 1);
+
+  for (int i = 0; i < 1000; ++i)
+    provider.Now();
+  EXPECT_EQ(query_count, 1);
+
+  provider.Invalidate();
+  EXPECT_EQ(provider.Now().get().utc_offset, 60);
+  EXPECT_EQ(query_count, 2);
+}
+
+TEST(TestLogTimestampProvider, RefreshesAfterInterval)
+{
+  std::atomic<int>     query_count{0};
+  LogTimestampProvider provider([&]() { return ++query_count; }, 10);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT_EQ(provider.Now().get().utc_offset, 2);
+}
+
+TEST(TestLogTimestampProvider, TimeAdvances)
+{
+  LogTimestampProvider provider([]() { return 0; }, 60000);
+
+  const auto first = provider.Now().get();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  const auto second = provider.Now().get();
+
+  const auto ms_of_day = [](const EtcPalLogTimestamp& t) {
+    return ((t.hour * 60 + t.minute) * 60 + t.second) * 1000 + t.msec;
+  };
+  if (first.day == second.day)
+  {
+    EXPECT_GE(ms_of_day(second) - ms_of_day(first), 50u);
+  }
+}
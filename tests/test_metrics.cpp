@@ -0,0 +1,164 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "metrics.h"
+
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+
+class TestMetricsRegistry : public testing::Test
+{
+protected:
+  MetricsRegistry registry_;
+
+  bool Rendered(const std::string& text) const { return registry_.RenderPrometheus().find(text) != std::string::npos; }
+};
+
+TEST_F(TestMetricsRegistry, CounterIsRendered)
+{
+  auto& counter = registry_.AddCounter("test_events_total", "Events seen.");
+  counter.Increment();
+  counter.Increment(2);
+
+  EXPECT_EQ(counter.value(), 3u);
+  EXPECT_EQ(registry_.RenderPrometheus(),
+            "# HELP test_events_total Events seen.\n"
+            "# TYPE test_events_total counter\n"
+            "test_events_total 3\n");
+}
+
+TEST_F(TestMetricsRegistry, GaugeGoesUpAndDown)
+{
+  auto& gauge = registry_.AddGauge("test_level", "A level.");
+  gauge.Set(10);
+  gauge.Add(-15);
+  EXPECT_EQ(gauge.value(), -5);
+  EXPECT_TRUE(Rendered("# TYPE test_level gauge\ntest_level -5\n"));
+}
+
+TEST_F(TestMetricsRegistry, GaugeSetMaxOnlyRaises)
+{
+  auto& gauge = registry_.AddGauge("test_high_water", "A high-water mark.");
+  gauge.SetMax(5);
+  gauge.SetMax(3);
+  EXPECT_EQ(gauge.value(), 5);
+  gauge.SetMax(8);
+  EXPECT_EQ(gauge.value(), 8);
+}
+
+TEST_F(TestMetricsRegistry, SameNameAndLabelsReturnsSameMetric)
+{
+  auto& first = registry_.AddCounter("test_total", "Help.", {{"kind", "a"}});
+  auto& again = registry_.AddCounter("test_total", "Help.", {{"kind", "a"}});
+  auto& other = registry_.AddCounter("test_total", "Help.", {{"kind", "b"}});
+
+  EXPECT_EQ(&first, &again);
+  EXPECT_NE(&first, &other);
+}
+
+TEST_F(TestMetricsRegistry, ReferencesStayValidAsMetricsAreAdded)
+{
+  auto& first = registry_.AddCounter("test_first_total", "Help.");
+  for (int i = 0; i < 100; ++i)
+    registry_.AddGauge("test_gauge_" + std::to_string(i), "Help.", {{"index", std::to_string(i)}});
+
+  first.Increment();
+  EXPECT_EQ(registry_.AddCounter("test_first_total", "Help.").value(), 1u);
+}
+
+TEST_F(TestMetricsRegistry, LabeledSeriesShareOneHeader)
+{
+  registry_.AddCounter("test_requests_total", "Requests.", {{"trigger", "manual"}}).Increment();
+  registry_.AddCounter("test_requests_total", "Requests.", {{"trigger", "network_change"}});
+
+  EXPECT_EQ(registry_.RenderPrometheus(),
+            "# HELP test_requests_total Requests.\n"
+            "# TYPE test_requests_total counter\n"
+            "test_requests_total{trigger=\"manual\"} 1\n"
+            "test_requests_total{trigger=\"network_change\"} 0\n");
+}
+
+TEST_F(TestMetricsRegistry, LabelValuesAndHelpAreEscaped)
+{
+  registry_.AddGauge("test_escaped", "Line one\nback\\slash \"quoted\"", {{"path", "C:\\dir\n\"x\""}});
+
+  EXPECT_TRUE(Rendered("# HELP test_escaped Line one\\nback\\\\slash \"quoted\"\n"));
+  EXPECT_TRUE(Rendered("test_escaped{path=\"C:\\\\dir\\n\\\"x\\\"\"} 0\n"));
+}
+
+TEST_F(TestMetricsRegistry, HistogramBucketsAreCumulative)
+{
+  auto& histogram = registry_.AddHistogram("test_duration_seconds", "Durations.", {0.1, 1.0}, {{"phase", "start"}});
+  histogram.Observe(0.05);
+  histogram.Observe(0.1);  // Bounds are inclusive
+  histogram.Observe(0.5);
+  histogram.Observe(2.0);
+
+  const auto snapshot = histogram.Read();
+  EXPECT_EQ(snapshot.counts, (std::vector<uint64_t>{2, 1, 1}));
+  EXPECT_EQ(snapshot.count, 4u);
+  EXPECT_DOUBLE_EQ(snapshot.sum, 2.65);
+
+  EXPECT_TRUE(Rendered("# TYPE test_duration_seconds histogram\n"
+                       "test_duration_seconds_bucket{phase=\"start\",le=\"0.1\"} 2\n"
+                       "test_duration_seconds_bucket{phase=\"start\",le=\"1\"} 3\n"
+                       "test_duration_seconds_bucket{phase=\"start\",le=\"+Inf\"} 4\n"
+                       "test_duration_seconds_sum{phase=\"start\"} 2.65\n"
+                       "test_duration_seconds_count{phase=\"start\"} 4\n"));
+}
+
+TEST_F(TestMetricsRegistry, ConcurrentUpdatesAreNotLost)
+{
+  auto& counter = registry_.AddCounter("test_concurrent_total", "Help.");
+  auto& histogram = registry_.AddHistogram("test_concurrent_seconds", "Help.", {1.0});
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t)
+  {
+    threads.emplace_back([&]() {
+      for (int i = 0; i < 10000; ++i)
+      {
+        counter.Increment();
+        histogram.Observe(0.5);
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  EXPECT_EQ(counter.value(), 40000u);
+  const auto snapshot = histogram.Read();
+  EXPECT_EQ(snapshot.count, 40000u);
+  EXPECT_DOUBLE_EQ(snapshot.sum, 20000.0);
+}
+
+TEST_F(TestMetricsRegistry, LatencyHistogramIsRenderedAsSummary)
+{
+  auto& latency = registry_.AddLatencyHistogram("test_operation_seconds", "Durations.", {{"operation", "start"}});
+  latency.Record(10);
+  latency.Record(4);
+
+  EXPECT_TRUE(Rendered("# TYPE test_operation_seconds summary\n"
+                       "test_operation_seconds{operation=\"start\",quantile=\"0.5\"} 4e-06\n"
+                       "test_operation_seconds{operation=\"start\",quantile=\"0.99\"} 1e-05\n"
+                       "test_operation_seconds{operation=\"start\",quantile=\"0.999\"} 1e-05\n"
+                       "test_operation_seconds_sum{operation=\"start\"} 1.4e-05\n"
+                       "test_operation_seconds_count{operation=\"start\"} 2\n"));
+}
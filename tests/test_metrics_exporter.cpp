@@ -0,0 +1,121 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "metrics_exporter.h"
+
+#include <string>
+#include "etcpal/common.h"
+#include "gtest/gtest.h"
+
+class TestMetricsExporter : public testing::Test
+{
+protected:
+  MetricsRegistry registry_;
+  MetricsExporter exporter_{registry_};
+
+  void SetUp() override
+  {
+    ASSERT_EQ(etcpal_init(ETCPAL_FEATURE_SOCKETS), kEtcPalErrOk);
+    registry_.AddCounter("test_scrapes_total", "Help.").Increment(7);
+  }
+
+  void TearDown() override
+  {
+    exporter_.Shutdown();
+    etcpal_deinit(ETCPAL_FEATURE_SOCKETS);
+  }
+
+  bool StartOnEphemeralPort()
+  {
+    MetricsExporter::Settings settings;
+    settings.enable = true;
+    settings.port = 0;
+    return exporter_.Startup(settings);
+  }
+
+  // Send a raw request to the exporter and return everything it sends back.
+  std::string Request(const std::string& request)
+  {
+    etcpal_socket_t sock = ETCPAL_SOCKET_INVALID;
+    if (etcpal_socket(ETCPAL_AF_INET, ETCPAL_SOCK_STREAM, &sock) != kEtcPalErrOk)
+      return std::string{};
+
+    EtcPalSockAddr addr;
+    ETCPAL_IP_SET_V4_ADDRESS(&addr.ip, 0x7f000001);
+    addr.port = exporter_.port();
+
+    std::string response;
+    if (etcpal_connect(sock, &addr) == kEtcPalErrOk &&
+        etcpal_send(sock, request.data(), request.size(), 0) == static_cast<int>(request.size()))
+    {
+      char buf[1024];
+      int  received;
+      while ((received = etcpal_recv(sock, buf, sizeof(buf), 0)) > 0)
+        response.append(buf, static_cast<size_t>(received));
+    }
+    etcpal_close(sock);
+    return response;
+  }
+};
+
+TEST_F(TestMetricsExporter, DisabledByDefault)
+{
+  EXPECT_TRUE(exporter_.Startup(MetricsExporter::Settings{}));
+  EXPECT_FALSE(exporter_.running());
+}
+
+TEST_F(TestMetricsExporter, ServesMetrics)
+{
+  ASSERT_TRUE(StartOnEphemeralPort());
+  ASSERT_TRUE(exporter_.running());
+  EXPECT_NE(exporter_.port(), 0u);
+
+  const std::string response = Request("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+  EXPECT_EQ(response.rfind("HTTP/1.1 200 OK\r\n", 0), 0u) << response;
+  EXPECT_NE(response.find("Content-Type: text/plain; version=0.0.4"), std::string::npos);
+  EXPECT_NE(response.find("\r\n\r\n# HELP test_scrapes_total Help.\n"), std::string::npos);
+  EXPECT_NE(response.find("test_scrapes_total 7\n"), std::string::npos);
+}
+
+TEST_F(TestMetricsExporter, ServesCurrentValues)
+{
+  ASSERT_TRUE(StartOnEphemeralPort());
+  registry_.AddCounter("test_scrapes_total", "Help.").Increment();
+
+  EXPECT_NE(Request("GET /metrics?format=text HTTP/1.0\r\n\r\n").find("test_scrapes_total 8\n"), std::string::npos);
+}
+
+TEST_F(TestMetricsExporter, RejectsOtherRequests)
+{
+  ASSERT_TRUE(StartOnEphemeralPort());
+
+  EXPECT_EQ(Request("GET / HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 404 ", 0), 0u);
+  EXPECT_EQ(Request("POST /metrics HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 405 ", 0), 0u);
+  EXPECT_EQ(Request("nonsense\r\n\r\n").rfind("HTTP/1.1 400 ", 0), 0u);
+}
+
+TEST_F(TestMetricsExporter, StopsAndStartsAgain)
+{
+  ASSERT_TRUE(StartOnEphemeralPort());
+  exporter_.Shutdown();
+  EXPECT_FALSE(exporter_.running());
+
+  ASSERT_TRUE(StartOnEphemeralPort());
+  EXPECT_EQ(Request("GET /metrics HTTP/1.1\r\n\r\n").rfind("HTTP/1.1 200 OK\r\n", 0), 0u);
+}
@@ -0,0 +1,252 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "netlink_network_monitor.h"
+
+#include <linux/if_addr.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+using Change = NetworkChangeMonitor::Change;
+using Message = std::vector<uint8_t>;
+
+// Synthetic rtnetlink messages, laid out the way the kernel sends them.
+static void AppendAttr(Message& msg, uint16_t type, const void* data, size_t size)
+{
+  struct rtattr attr;
+  attr.rta_len = static_cast<unsigned short>(RTA_LENGTH(size));
+  attr.rta_type = type;
+
+  const size_t offset = msg.size();
+  msg.resize(offset + RTA_SPACE(size));
+  memcpy(&msg[offset], &attr, sizeof(attr));
+  memcpy(&msg[offset + RTA_LENGTH(0)], data, size);
+}
+
+static Message NewMessage(uint16_t type, const void* body, size_t body_size)
+{
+  Message msg(NLMSG_SPACE(body_size));
+  memcpy(&msg[NLMSG_LENGTH(0)], body, body_size);
+
+  struct nlmsghdr header;
+  memset(&header, 0, sizeof(header));
+  header.nlmsg_type = type;
+  memcpy(msg.data(), &header, sizeof(header));
+  return msg;
+}
+
+static Message Finish(Message msg)
+{
+  const auto length = static_cast<uint32_t>(msg.size());
+  memcpy(msg.data() + offsetof(struct nlmsghdr, nlmsg_len), &length, sizeof(length));
+  return msg;
+}
+
+static Message LinkMessage(uint16_t type, int index, const std::string& name)
+{
+  struct ifinfomsg info;
+  memset(&info, 0, sizeof(info));
+  info.ifi_family = AF_UNSPEC;
+  info.ifi_index = index;
+
+  Message msg = NewMessage(type, &info, sizeof(info));
+  AppendAttr(msg, IFLA_IFNAME, name.c_str(), name.size() + 1);
+  return Finish(std::move(msg));
+}
+
+static Message AddressMessage(uint16_t                    type,
+                              int                         index,
+                              const std::vector<uint8_t>& address,
+                              uint8_t                     flags = 0,
+                              const std::vector<uint8_t>& peer = {})
+{
+  struct ifaddrmsg info;
+  memset(&info, 0, sizeof(info));
+  info.ifa_family = (address.size() == 4) ? AF_INET : AF_INET6;
+  info.ifa_index = static_cast<uint32_t>(index);
+  info.ifa_flags = flags;
+
+  Message msg = NewMessage(type, &info, sizeof(info));
+  if (peer.empty())
+  {
+    AppendAttr(msg, IFA_ADDRESS, address.data(), address.size());
+  }
+  else
+  {
+    AppendAttr(msg, IFA_LOCAL, address.data(), address.size());
+    AppendAttr(msg, IFA_ADDRESS, peer.data(), peer.size());
+  }
+  return Finish(std::move(msg));
+}
+
+static Message Concat(std::initializer_list<Message> messages)
+{
+  Message buf;
+  for (const auto& msg : messages)
+    buf.insert(buf.end(), msg.begin(), msg.end());
+  return buf;
+}
+
+static const std::vector<uint8_t> kV4Addr = {10, 0, 0, 1};
+static const std::vector<uint8_t> kV6Addr = {0xfe, 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+
+class TestNetlinkNetworkMonitor : public testing::Test
+{
+protected:
+  NetlinkNetworkMonitor monitor_;
+
+  void Process(const Message& buf) { monitor_.ProcessMessages(buf.data(), buf.size()); }
+
+  // eth0 (index 1) with kV4Addr and kV6Addr, and wlan0 (index 2) with no addresses, as the dump
+  // replies would report them.
+  void SetUp() override
+  {
+    monitor_.BeginResync();
+    Process(Concat({LinkMessage(RTM_NEWLINK, 1, "eth0"), LinkMessage(RTM_NEWLINK, 2, "wlan0"),
+                    AddressMessage(RTM_NEWADDR, 1, kV4Addr), AddressMessage(RTM_NEWADDR, 1, kV6Addr)}));
+    monitor_.EndResync();
+    ASSERT_TRUE(monitor_.TakeChanges().empty());
+  }
+};
+
+TEST_F(TestNetlinkNetworkMonitor, NewAddressIsAChange)
+{
+  Process(AddressMessage(RTM_NEWADDR, 2, {192, 168, 1, 5}));
+
+  const auto changes = monitor_.TakeChanges();
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_EQ(changes[0].type, Change::Type::kAddressAdded);
+  EXPECT_EQ(changes[0].interface_name, "wlan0");
+  EXPECT_EQ(changes[0].address, etcpal::IpAddr::FromV4(0xc0a80105));
+  EXPECT_TRUE(NetworkChangeMonitor::Affects(changes, {"wlan0"}));
+  EXPECT_FALSE(NetworkChangeMonitor::Affects(changes, {"eth0"}));
+}
+
+TEST_F(TestNetlinkNetworkMonitor, DeletedAddressIsAChange)
+{
+  Process(AddressMessage(RTM_DELADDR, 1, kV6Addr));
+
+  const auto changes = monitor_.TakeChanges();
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_EQ(changes[0].type, Change::Type::kAddressRemoved);
+  EXPECT_EQ(changes[0].interface_name, "eth0");
+  EXPECT_EQ(changes[0].address, etcpal::IpAddr::FromV6(kV6Addr.data()));
+}
+
+// The kernel sends RTM_NEWADDR again whenever an IPv6 address's lifetimes are refreshed, and
+// RTM_NEWLINK whenever a link's flags change.
+TEST_F(TestNetlinkNetworkMonitor, RepeatedNotificationsAreNotChanges)
+{
+  Process(Concat({AddressMessage(RTM_NEWADDR, 1, kV6Addr), AddressMessage(RTM_NEWADDR, 1, kV6Addr),
+                  LinkMessage(RTM_NEWLINK, 1, "eth0"), LinkMessage(RTM_NEWLINK, 2, "wlan0")}));
+  EXPECT_TRUE(monitor_.TakeChanges().empty());
+}
+
+TEST_F(TestNetlinkNetworkMonitor, TentativeAddressIsAddedAfterDad)
+{
+  const std::vector<uint8_t> new_addr = {0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2};
+
+  Process(AddressMessage(RTM_NEWADDR, 2, new_addr, IFA_F_TENTATIVE));
+  EXPECT_TRUE(monitor_.TakeChanges().empty());
+
+  Process(AddressMessage(RTM_NEWADDR, 2, new_addr));
+  const auto changes = monitor_.TakeChanges();
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_EQ(changes[0].type, Change::Type::kAddressAdded);
+}
+
+TEST_F(TestNetlinkNetworkMonitor, DeletedLinkRemovesItsAddresses)
+{
+  Process(LinkMessage(RTM_DELLINK, 1, "eth0"));
+
+  const auto changes = monitor_.TakeChanges();
+  ASSERT_EQ(changes.size(), 2u);
+  EXPECT_EQ(changes[0].type, Change::Type::kAddressRemoved);
+  EXPECT_EQ(changes[1].type, Change::Type::kAddressRemoved);
+  EXPECT_EQ(changes[0].interface_name, "eth0");
+  EXPECT_EQ(changes[1].interface_name, "eth0");
+}
+
+TEST_F(TestNetlinkNetworkMonitor, RenamedLinkIsAChange)
+{
+  Process(LinkMessage(RTM_NEWLINK, 2, "wlp2s0"));
+
+  const auto changes = monitor_.TakeChanges();
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_EQ(changes[0].type, Change::Type::kInterfaceRenamed);
+  EXPECT_EQ(changes[0].old_interface_name, "wlan0");
+  EXPECT_EQ(changes[0].interface_name, "wlp2s0");
+}
+
+// On a point-to-point link, IFA_ADDRESS is the peer's address and IFA_LOCAL is ours.
+TEST_F(TestNetlinkNetworkMonitor, LocalAddressIsUsedOnPointToPointLinks)
+{
+  Process(AddressMessage(RTM_NEWADDR, 2, {10, 8, 0, 2}, 0, {10, 8, 0, 1}));
+
+  const auto changes = monitor_.TakeChanges();
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_EQ(changes[0].address, etcpal::IpAddr::FromV4(0x0a080002));
+}
+
+TEST_F(TestNetlinkNetworkMonitor, TruncatedMessagesAreIgnored)
+{
+  Message buf = AddressMessage(RTM_NEWADDR, 2, {192, 168, 1, 5});
+  Process(Message(buf.begin(), buf.begin() + NLMSG_LENGTH(2)));
+  Process(Message(buf.begin(), buf.end() - 4));
+  EXPECT_TRUE(monitor_.TakeChanges().empty());
+}
+
+// Only the kernel's messages are believed; another process could otherwise forge changes by
+// sending to the monitor's socket.
+TEST(TestNetlinkNetworkMonitorSocket, MessagesFromOtherProcessesAreIgnored)
+{
+  NetlinkNetworkMonitor monitor;
+  if (!monitor.Open())
+    GTEST_SKIP() << "rtnetlink is not available";
+
+  // Let the initial dump finish.
+  struct pollfd pfd = {monitor.fd(), POLLIN, 0};
+  while (poll(&pfd, 1, 100) > 0)
+    monitor.Receive();
+  monitor.TakeChanges();
+
+  struct sockaddr_nl monitor_addr;
+  socklen_t          addr_len = sizeof(monitor_addr);
+  ASSERT_EQ(getsockname(monitor.fd(), reinterpret_cast<struct sockaddr*>(&monitor_addr), &addr_len), 0);
+
+  const int sender = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+  ASSERT_GE(sender, 0);
+  const Message forged = AddressMessage(RTM_NEWADDR, 1, {192, 0, 2, 55});
+  const auto    sent = sendto(sender, forged.data(), forged.size(), 0,
+                           reinterpret_cast<const struct sockaddr*>(&monitor_addr), sizeof(monitor_addr));
+  close(sender);
+  ASSERT_EQ(sent, static_cast<ssize_t>(forged.size()));
+
+  ASSERT_GT(poll(&pfd, 1, 1000), 0);
+  monitor.Receive();
+  EXPECT_TRUE(monitor.TakeChanges().empty());
+}
@@ -0,0 +1,146 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "network_change_monitor.h"
+
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+
+using Change = NetworkChangeMonitor::Change;
+
+class TestNetworkChangeMonitor : public testing::Test
+{
+protected:
+  const etcpal::IpAddr kAddr1 = etcpal::IpAddr::FromV4(0x0a000001);
+  const etcpal::IpAddr kAddr2 = etcpal::IpAddr::FromV4(0x0a000002);
+
+  NetworkChangeMonitor monitor_;
+
+  // eth0 (index 1) with kAddr1 and wlan0 (index 2) with no addresses.
+  void SetUp() override
+  {
+    monitor_.BeginResync();
+    monitor_.SetInterfaceName(1, "eth0");
+    monitor_.SetInterfaceName(2, "wlan0");
+    monitor_.AddAddress(1, kAddr1);
+    monitor_.EndResync();
+  }
+};
+
+TEST_F(TestNetworkChangeMonitor, InitialStateIsNotAChange)
+{
+  EXPECT_TRUE(monitor_.synchronized());
+  EXPECT_TRUE(monitor_.TakeChanges().empty());
+}
+
+TEST_F(TestNetworkChangeMonitor, NothingIsRecordedBeforeFirstResync)
+{
+  NetworkChangeMonitor monitor;
+  monitor.SetInterfaceName(1, "eth0");
+  monitor.AddAddress(1, kAddr1);
+  EXPECT_FALSE(monitor.synchronized());
+  EXPECT_TRUE(monitor.TakeChanges().empty());
+}
+
+TEST_F(TestNetworkChangeMonitor, AddressChangesAreRecorded)
+{
+  monitor_.AddAddress(2, kAddr2);
+  monitor_.RemoveAddress(1, kAddr1);
+
+  const auto changes = monitor_.TakeChanges();
+  ASSERT_EQ(changes.size(), 2u);
+  EXPECT_EQ(changes[0].type, Change::Type::kAddressAdded);
+  EXPECT_EQ(changes[0].interface_name, "wlan0");
+  EXPECT_EQ(changes[0].address, kAddr2);
+  EXPECT_EQ(changes[1].type, Change::Type::kAddressRemoved);
+  EXPECT_EQ(changes[1].interface_name, "eth0");
+  EXPECT_EQ(changes[1].address, kAddr1);
+
+  EXPECT_TRUE(monitor_.TakeChanges().empty());
+}
+
+// Repeated reports of the same state, like IPv6 lifetime refreshes, aren't changes.
+TEST_F(TestNetworkChangeMonitor, RepeatedReportsAreNotChanges)
+{
+  monitor_.AddAddress(1, kAddr1);
+  monitor_.SetInterfaceName(1, "eth0");
+  monitor_.RemoveAddress(2, kAddr1);
+  monitor_.RemoveInterface(3);
+  EXPECT_TRUE(monitor_.TakeChanges().empty());
+}
+
+TEST_F(TestNetworkChangeMonitor, RenameIsRecorded)
+{
+  monitor_.SetInterfaceName(1, "lan0");
+
+  const auto changes = monitor_.TakeChanges();
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_EQ(changes[0].type, Change::Type::kInterfaceRenamed);
+  EXPECT_EQ(changes[0].interface_name, "lan0");
+  EXPECT_EQ(changes[0].old_interface_name, "eth0");
+}
+
+TEST_F(TestNetworkChangeMonitor, RemovedInterfaceLosesItsAddresses)
+{
+  monitor_.RemoveInterface(1);
+
+  const auto changes = monitor_.TakeChanges();
+  ASSERT_EQ(changes.size(), 1u);
+  EXPECT_EQ(changes[0].type, Change::Type::kAddressRemoved);
+  EXPECT_EQ(changes[0].interface_name, "eth0");
+}
+
+// Whatever isn't reported again during a resync is gone.
+TEST_F(TestNetworkChangeMonitor, ResyncRemovesWhatWasNotReported)
+{
+  monitor_.BeginResync();
+  monitor_.SetInterfaceName(1, "eth0");
+  monitor_.SetInterfaceName(2, "wlan0");
+  monitor_.AddAddress(2, kAddr2);
+  monitor_.EndResync();
+
+  const auto changes = monitor_.TakeChanges();
+  ASSERT_EQ(changes.size(), 2u);
+  EXPECT_EQ(changes[0].type, Change::Type::kAddressAdded);
+  EXPECT_EQ(changes[0].interface_name, "wlan0");
+  EXPECT_EQ(changes[1].type, Change::Type::kAddressRemoved);
+  EXPECT_EQ(changes[1].interface_name, "eth0");
+}
+
+TEST_F(TestNetworkChangeMonitor, AffectsOnlyListenedInterfaces)
+{
+  monitor_.AddAddress(2, kAddr2);
+  const auto changes = monitor_.TakeChanges();
+
+  EXPECT_TRUE(NetworkChangeMonitor::Affects(changes, {}));
+  EXPECT_TRUE(NetworkChangeMonitor::Affects(changes, {"eth1", "wlan0"}));
+  EXPECT_FALSE(NetworkChangeMonitor::Affects(changes, {"eth0"}));
+  EXPECT_FALSE(NetworkChangeMonitor::Affects({}, {}));
+}
+
+TEST_F(TestNetworkChangeMonitor, RenameAffectsOldAndNewNames)
+{
+  monitor_.SetInterfaceName(1, "lan0");
+  const auto changes = monitor_.TakeChanges();
+
+  EXPECT_TRUE(NetworkChangeMonitor::Affects(changes, {"eth0"}));
+  EXPECT_TRUE(NetworkChangeMonitor::Affects(changes, {"lan0"}));
+  EXPECT_FALSE(NetworkChangeMonitor::Affects(changes, {"wlan0"}));
+}
@@ -0,0 +1,281 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "restart_scheduler.h"
+
+#include "gtest/gtest.h"
+
+using Trigger = RestartScheduler::Trigger;
+
+class TestRestartScheduler : public testing::Test
+{
+protected:
+  uint64_t now_ms_{1000};
+  double   random_{0.5};  // No jitter
+
+  RestartScheduler::Settings settings_;
+  RestartScheduler           scheduler_{settings_, [this]() { return now_ms_; }, [this]() { return random_; }};
+
+  // Advance the clock to when the pending restart is due, and take it.
+  bool RunToDue(bool& force_restart)
+  {
+    const int until_due = scheduler_.TimeUntilDue();
+    if (until_due < 0)
+      return false;
+    now_ms_ += static_cast<uint64_t>(until_due);
+    return scheduler_.TakeDue(force_restart);
+  }
+
+  const RestartScheduler::Counters& counters() const { return scheduler_.counters(); }
+};
+
+TEST_F(TestRestartScheduler, NothingIsDueWithoutRequests)
+{
+  bool force_restart = false;
+  EXPECT_EQ(scheduler_.TimeUntilDue(), -1);
+  EXPECT_FALSE(scheduler_.TakeDue(force_restart));
+}
+
+TEST_F(TestRestartScheduler, ManualRequestIsDueImmediately)
+{
+  EXPECT_TRUE(scheduler_.Request(Trigger::kManual));
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 0);
+
+  bool force_restart = false;
+  EXPECT_TRUE(scheduler_.TakeDue(force_restart));
+  EXPECT_TRUE(force_restart);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), -1);
+  EXPECT_EQ(counters().executed, 0u);
+
+  scheduler_.RestartExecuted();
+  EXPECT_EQ(counters().executed, 1u);
+}
+
+TEST_F(TestRestartScheduler, NetworkChangeWaitsForItsCooldown)
+{
+  scheduler_.Request(Trigger::kNetworkChange);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 5000);
+
+  bool force_restart = false;
+  now_ms_ += 4999;
+  EXPECT_FALSE(scheduler_.TakeDue(force_restart));
+  now_ms_ += 1;
+  EXPECT_TRUE(scheduler_.TakeDue(force_restart));
+}
+
+TEST_F(TestRestartScheduler, RequestsAreCoalesced)
+{
+  EXPECT_TRUE(scheduler_.Request(Trigger::kNetworkChange));
+  now_ms_ += 1000;
+  EXPECT_FALSE(scheduler_.Request(Trigger::kNetworkChange));
+  EXPECT_FALSE(scheduler_.Request(Trigger::kConfigChange, false));
+
+  // The second network change pushed the restart back; the config change brought it forward.
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 0);
+
+  bool force_restart = false;
+  EXPECT_TRUE(RunToDue(force_restart));
+  EXPECT_TRUE(force_restart);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), -1);
+  scheduler_.RestartExecuted();
+
+  EXPECT_EQ(counters().requested[static_cast<size_t>(Trigger::kNetworkChange)], 2u);
+  EXPECT_EQ(counters().requested[static_cast<size_t>(Trigger::kConfigChange)], 1u);
+  EXPECT_EQ(counters().coalesced, 2u);
+  EXPECT_EQ(counters().executed, 1u);
+}
+
+TEST_F(TestRestartScheduler, ReloadOnlyForcesRestartIfAnyRequestDoes)
+{
+  bool force_restart = true;
+  scheduler_.Request(Trigger::kConfigChange, false);
+  EXPECT_TRUE(RunToDue(force_restart));
+  EXPECT_FALSE(force_restart);
+
+  scheduler_.Request(Trigger::kConfigChange, false);
+  scheduler_.Request(Trigger::kScopeChange, true);
+  EXPECT_TRUE(RunToDue(force_restart));
+  EXPECT_TRUE(force_restart);
+}
+
+// A flapping interface can only restart the broker once per minimum interval.
+TEST_F(TestRestartScheduler, NetworkChangesAreRateLimited)
+{
+  bool force_restart = false;
+  scheduler_.Request(Trigger::kNetworkChange);
+  ASSERT_TRUE(RunToDue(force_restart));
+  scheduler_.RestartExecuted();
+
+  // Other triggers aren't held back by it.
+  now_ms_ += 1000;
+  scheduler_.Request(Trigger::kConfigChange);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 0);
+  ASSERT_TRUE(scheduler_.TakeDue(force_restart));
+
+  scheduler_.Request(Trigger::kNetworkChange);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 29000);
+}
+
+// Network changes can't keep pushing back a restart that was requested manually.
+TEST_F(TestRestartScheduler, ManualRequestIsNotPushedBack)
+{
+  scheduler_.Request(Trigger::kManual);
+  scheduler_.Request(Trigger::kNetworkChange);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 0);
+
+  bool force_restart = false;
+  ASSERT_TRUE(scheduler_.TakeDue(force_restart));
+
+  scheduler_.Request(Trigger::kNetworkChange);
+  now_ms_ += 4000;
+  scheduler_.Request(Trigger::kManual);
+  for (int i = 0; i < 5; ++i)
+  {
+    now_ms_ += 1000;
+    scheduler_.Request(Trigger::kNetworkChange);
+  }
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 0);
+}
+
+// A request without a cooldown only brings a pending restart forward as far as its own minimum
+// interval allows.
+TEST(TestRestartSchedulerSettings, RequestIsNotBroughtForwardPastItsMinInterval)
+{
+  uint64_t                   now_ms = 1000;
+  RestartScheduler::Settings settings;
+  settings.triggers[static_cast<size_t>(Trigger::kScopeChange)] = {0u, 10000u};
+  RestartScheduler scheduler(settings, [&]() { return now_ms; }, []() { return 0.5; });
+
+  bool force_restart = false;
+  scheduler.Request(Trigger::kScopeChange);
+  ASSERT_TRUE(scheduler.TakeDue(force_restart));
+  scheduler.RestartExecuted();
+
+  now_ms += 1000;
+  scheduler.Request(Trigger::kNetworkChange);
+  scheduler.Request(Trigger::kScopeChange);
+  EXPECT_EQ(scheduler.TimeUntilDue(), 9000);
+
+  now_ms += 1000;
+  scheduler.Request(Trigger::kNetworkChange);
+  EXPECT_EQ(scheduler.TimeUntilDue(), 8000);
+}
+
+// A request that was applied without restarting the broker isn't counted as a restart, and doesn't
+// hold back the trigger's next restart.
+TEST_F(TestRestartScheduler, RequestsAppliedInPlaceAreNotRestarts)
+{
+  bool force_restart = false;
+  scheduler_.Request(Trigger::kNetworkChange);
+  ASSERT_TRUE(RunToDue(force_restart));
+
+  now_ms_ += 1000;
+  scheduler_.Request(Trigger::kNetworkChange);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 5000);
+  ASSERT_TRUE(RunToDue(force_restart));
+  EXPECT_EQ(counters().executed, 0u);
+}
+
+TEST_F(TestRestartScheduler, FailedStartupsBackOffExponentially)
+{
+  EXPECT_EQ(scheduler_.StartupFailed(), 1000u);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 1000);
+
+  bool force_restart = false;
+  ASSERT_TRUE(RunToDue(force_restart));
+  EXPECT_TRUE(force_restart);
+
+  EXPECT_EQ(scheduler_.StartupFailed(), 2000u);
+  ASSERT_TRUE(RunToDue(force_restart));
+  EXPECT_EQ(scheduler_.StartupFailed(), 4000u);
+  ASSERT_TRUE(RunToDue(force_restart));
+
+  for (int i = 0; i < 10; ++i)
+  {
+    scheduler_.StartupFailed();
+    ASSERT_TRUE(RunToDue(force_restart));
+  }
+  EXPECT_EQ(scheduler_.StartupFailed(), settings_.max_backoff_ms);
+  EXPECT_EQ(counters().startup_failures, 14u);
+}
+
+TEST_F(TestRestartScheduler, SuccessfulStartupResetsBackoff)
+{
+  bool force_restart = false;
+  scheduler_.StartupFailed();
+  ASSERT_TRUE(RunToDue(force_restart));
+  scheduler_.StartupFailed();
+  ASSERT_TRUE(RunToDue(force_restart));
+
+  scheduler_.StartupSucceeded();
+  EXPECT_EQ(scheduler_.StartupFailed(), 1000u);
+}
+
+// A manual request or a configuration change doesn't wait for a pending retry, and starts the
+// backoff over.
+TEST_F(TestRestartScheduler, ManualRequestOrConfigChangeResetsBackoff)
+{
+  bool force_restart = false;
+  for (int i = 0; i < 5; ++i)
+  {
+    scheduler_.StartupFailed();
+    ASSERT_TRUE(RunToDue(force_restart));
+  }
+  EXPECT_EQ(scheduler_.StartupFailed(), 32000u);
+
+  scheduler_.Request(Trigger::kManual);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 0);
+  ASSERT_TRUE(scheduler_.TakeDue(force_restart));
+  EXPECT_EQ(scheduler_.StartupFailed(), 1000u);
+
+  ASSERT_TRUE(RunToDue(force_restart));
+  EXPECT_EQ(scheduler_.StartupFailed(), 2000u);
+  scheduler_.Request(Trigger::kConfigChange, false);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 0);
+  ASSERT_TRUE(scheduler_.TakeDue(force_restart));
+  EXPECT_TRUE(force_restart);
+  EXPECT_EQ(scheduler_.StartupFailed(), 1000u);
+
+  // A network change doesn't.
+  scheduler_.Request(Trigger::kNetworkChange);
+  EXPECT_EQ(scheduler_.TimeUntilDue(), 5000);
+  ASSERT_TRUE(RunToDue(force_restart));
+  EXPECT_EQ(scheduler_.StartupFailed(), 2000u);
+}
+
+TEST_F(TestRestartScheduler, BackoffIsJittered)
+{
+  random_ = 0.0;
+  EXPECT_EQ(scheduler_.StartupFailed(), 800u);
+
+  bool force_restart = false;
+  ASSERT_TRUE(RunToDue(force_restart));
+  random_ = 0.75;
+  EXPECT_EQ(scheduler_.StartupFailed(), 2200u);
+}
+
+TEST_F(TestRestartScheduler, DefaultRandomIsInRange)
+{
+  for (int i = 0; i < 100; ++i)
+  {
+    const double value = RestartScheduler::UniformRandom();
+    EXPECT_GE(value, 0.0);
+    EXPECT_LT(value, 1.0);
+  }
+}
@@ -0,0 +1,198 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "trace_recorder.h"
+
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "nlohmann/json.hpp"
+#include "gtest/gtest.h"
+#include "temp_dir_test.h"
+
+class TestTraceRecorder : public TempDirTest
+{
+protected:
+  void TearDown() override
+  {
+    TraceRecorder::Stop();
+    TempDirTest::TearDown();
+  }
+
+  // The complete ("X") events in the trace.
+  static std::vector<nlohmann::json> Spans()
+  {
+    const auto                  trace = nlohmann::json::parse(TraceRecorder::ChromeTrace());
+    std::vector<nlohmann::json> spans;
+    for (const auto& event : trace.at("traceEvents"))
+    {
+      if (event.at("ph") == "X")
+        spans.push_back(event);
+    }
+    return spans;
+  }
+};
+
+TEST_F(TestTraceRecorder, NothingIsRecordedWhenDisabled)
+{
+  TraceRecorder::Start();
+  TraceRecorder::Stop();
+  EXPECT_FALSE(TraceRecorder::enabled());
+
+  {
+    TraceRecorder::Span span("Disabled");
+  }
+  EXPECT_TRUE(Spans().empty());
+}
+
+TEST_F(TestTraceRecorder, NestedSpansAreRecorded)
+{
+  TraceRecorder::Start();
+  {
+    TraceRecorder::Span outer("Outer");
+    {
+      TraceRecorder::Span inner("Inner");
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+
+  const auto spans = Spans();
+  ASSERT_EQ(spans.size(), 2u);
+
+  // Spans are recorded as they end, so the inner one comes first.
+  EXPECT_EQ(spans[0].at("name"), "Inner");
+  EXPECT_EQ(spans[1].at("name"), "Outer");
+  EXPECT_GE(spans[0].at("dur").get<int64_t>(), 2000);
+  EXPECT_GE(spans[1].at("dur").get<int64_t>(), spans[0].at("dur").get<int64_t>());
+  EXPECT_LE(spans[1].at("ts").get<int64_t>(), spans[0].at("ts").get<int64_t>());
+  EXPECT_EQ(spans[0].at("tid"), spans[1].at("tid"));
+}
+
+TEST_F(TestTraceRecorder, StartDiscardsPreviousTrace)
+{
+  TraceRecorder::Start();
+  {
+    TraceRecorder::Span span("First");
+  }
+  TraceRecorder::Start();
+  {
+    TraceRecorder::Span span("Second");
+  }
+
+  const auto spans = Spans();
+  ASSERT_EQ(spans.size(), 1u);
+  EXPECT_EQ(spans[0].at("name"), "Second");
+}
+
+TEST_F(TestTraceRecorder, SpansOpenedBeforeStartAreLeftOut)
+{
+  TraceRecorder::Start();
+  {
+    TraceRecorder::Span span("Straddles");
+    TraceRecorder::Start();
+  }
+  EXPECT_TRUE(Spans().empty());
+}
+
+TEST_F(TestTraceRecorder, SpansStillOpenAtStopAreLeftOut)
+{
+  TraceRecorder::Start();
+  {
+    TraceRecorder::Span straddles("Straddles");
+    {
+      TraceRecorder::Span closed("Closed");
+    }
+    TraceRecorder::Stop();
+  }
+
+  const auto spans = Spans();
+  ASSERT_EQ(spans.size(), 1u);
+  EXPECT_EQ(spans[0].at("name"), "Closed");
+}
+
+TEST_F(TestTraceRecorder, CancelDiscardsTrace)
+{
+  TraceRecorder::Start();
+  {
+    TraceRecorder::Span span("Discarded");
+  }
+  TraceRecorder::Cancel();
+  EXPECT_FALSE(TraceRecorder::enabled());
+  EXPECT_TRUE(Spans().empty());
+}
+
+TEST_F(TestTraceRecorder, ThreadsAreRecordedSeparately)
+{
+  TraceRecorder::Start();
+  TraceRecorder::SetThreadName("main");
+  {
+    TraceRecorder::Span span("Main");
+  }
+  std::thread([]() {
+    TraceRecorder::SetThreadName("worker");
+    TraceRecorder::Span span("Worker");
+  }).join();
+
+  const auto trace = nlohmann::json::parse(TraceRecorder::ChromeTrace());
+  std::map<std::string, int> span_tids;
+  std::map<std::string, int> thread_tids;
+  for (const auto& event : trace.at("traceEvents"))
+  {
+    if (event.at("ph") == "X")
+      span_tids[event.at("name")] = event.at("tid");
+    else if (event.at("ph") == "M" && event.at("name") == "thread_name")
+      thread_tids[event.at("args").at("name")] = event.at("tid");
+  }
+
+  ASSERT_EQ(span_tids.size(), 2u);
+  EXPECT_NE(span_tids["Main"], span_tids["Worker"]);
+  EXPECT_EQ(thread_tids["main"], span_tids["Main"]);
+  EXPECT_EQ(thread_tids["worker"], span_tids["Worker"]);
+}
+
+TEST_F(TestTraceRecorder, FullBufferDropsSpans)
+{
+  TraceRecorder::Start();
+  for (size_t i = 0; i < TraceRecorder::kMaxEventsPerThread + 10; ++i)
+    TraceRecorder::Span span("Many");
+
+  EXPECT_EQ(Spans().size(), TraceRecorder::kMaxEventsPerThread);
+  const auto trace = nlohmann::json::parse(TraceRecorder::ChromeTrace());
+  EXPECT_EQ(trace.at("otherData").at("dropped_spans"), 10u);
+}
+
+TEST_F(TestTraceRecorder, WritesTraceFile)
+{
+  const auto path = dir_ / "trace.json";
+
+  TraceRecorder::Start();
+  {
+    TraceRecorder::Span span("Written");
+  }
+  ASSERT_TRUE(TraceRecorder::WriteChromeTrace(path.string()));
+
+  const auto trace = nlohmann::json::parse(ReadFile(path));
+  EXPECT_EQ(trace.at("displayTimeUnit"), "ms");
+  EXPECT_EQ(trace.at("traceEvents"), nlohmann::json::parse(TraceRecorder::ChromeTrace()).at("traceEvents"));
+
+  const auto spans = Spans();
+  ASSERT_EQ(spans.size(), 1u);
+  EXPECT_EQ(spans[0].at("name"), "Written");
+}
@@ -0,0 +1,173 @@
+/******************************************************************************
+ * Copyright 2022 ETC Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ ******************************************************************************
+ * This file is a part of RDMnetBroker. For more information, go to:
+ * https://github.com/ETCLabs/RDMnetBroker
+ *****************************************************************************/
+
+#include "unix_admin_server.h"
+
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "temp_dir_test.h"
+
+class TestUnixAdminServer : public TempDirTest, public AdminServer::Handler
+{
+protected:
+  std::unique_ptr<UnixAdminServer> server_;
+  std::atomic<int>                 restarts_{0};
+
+  std::string HandleStatusRequest() override { return "broker: up\n"; }
+  std::string HandleStatsRequest() override { return std::string(100000, 'x') + "\n"; }
+  bool        HandleRecentLogRequest(std::string&) override { return false; }
+  void        HandleLogLevelChange(int) override {}
+  void        HandleRestartRequest() override { ++restarts_; }
+  bool        HandleTraceRequest(AdminServer::TraceAction, std::string&) override { return true; }
+
+  void SetUp() override
+  {
+    TempDirTest::SetUp();
+    server_ = std::make_unique<UnixAdminServer>(*this, (dir_ / "admin.sock").string());
+
+    AdminServer::Settings settings;
+    settings.enable = true;
+    ASSERT_TRUE(server_->Startup(settings));
+  }
+
+  void TearDown() override
+  {
+    server_.reset();
+    TempDirTest::TearDown();
+  }
+
+  int Connect()
+  {
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, server_->path().c_str(), sizeof(addr.sun_path) - 1);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd != -1 && connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+    {
+      close(fd);
+      fd = -1;
+    }
+    return fd;
+  }
+
+  // Read until the server closes the connection, or nothing arrives for a second.
+  static std::string ReadAll(int fd)
+  {
+    std::string   received;
+    struct pollfd pfd = {fd, POLLIN, 0};
+    while (poll(&pfd, 1, 1000) > 0)
+    {
+      char          buf[4096];
+      const ssize_t result = recv(fd, buf, sizeof(buf), 0);
+      if (result <= 0)
+        break;
+      received.append(buf, static_cast<size_t>(result));
+    }
+    return received;
+  }
+
+  // Send commands ending in "quit" and return the whole response.
+  std::string Exchange(const std::string& commands)
+  {
+    const int fd = Connect();
+    if (fd == -1)
+      return "CONNECT FAILED";
+    send(fd, commands.data(), commands.size(), MSG_NOSIGNAL);
+    const std::string response = ReadAll(fd);
+    close(fd);
+    return response;
+  }
+};
+
+TEST_F(TestUnixAdminServer, AnswersCommands)
+{
+  EXPECT_EQ(Exchange("status\nrestart\nquit\n"), "broker: up\nOK\nOK\nOK\n");
+  EXPECT_EQ(restarts_, 1);
+}
+
+TEST_F(TestUnixAdminServer, SendsLargeResponsesWhole)
+{
+  const std::string response = Exchange("stats\nquit\n");
+  EXPECT_EQ(response.size(), 100001u + 3u + 3u);
+  EXPECT_EQ(response.substr(response.size() - 8), "x\nOK\nOK\n");
+}
+
+TEST_F(TestUnixAdminServer, SocketIsOnlyAccessibleToItsOwner)
+{
+  struct stat socket_stat;
+  ASSERT_EQ(stat(server_->path().c_str(), &socket_stat), 0);
+  EXPECT_TRUE(S_ISSOCK(socket_stat.st_mode));
+  EXPECT_EQ(socket_stat.st_mode & (S_IRWXG | S_IRWXO), 0u);
+}
+
+TEST_F(TestUnixAdminServer, ServesSeveralClientsAtOnce)
+{
+  const int idle_client = Connect();
+  ASSERT_NE(idle_client, -1);
+
+  // A client that is connected but says nothing doesn't hold up anyone else.
+  EXPECT_EQ(Exchange("status\nquit\n"), "broker: up\nOK\nOK\n");
+  close(idle_client);
+}
+
+TEST_F(TestUnixAdminServer, ShutdownIsPromptWithClientsConnected)
+{
+  const int client = Connect();
+  ASSERT_NE(client, -1);
+
+  // Make sure the server has accepted the connection.
+  send(client, "status\n", 7, MSG_NOSIGNAL);
+  char buf[64];
+  ASSERT_GT(recv(client, buf, sizeof(buf), 0), 0);
+
+  const auto start = std::chrono::steady_clock::now();
+  server_->Shutdown();
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+  EXPECT_FALSE(server_->running());
+  EXPECT_FALSE(std::filesystem::exists(server_->path()));
+
+  // The client sees the connection close.
+  EXPECT_EQ(recv(client, buf, sizeof(buf), 0), 0);
+  close(client);
+}
+
+TEST_F(TestUnixAdminServer, ReplacesStaleSocketFile)
+{
+  server_->Shutdown();
+  {
+    std::ofstream stale(server_->path());
+  }
+
+  AdminServer::Settings settings;
+  settings.enable = true;
+  ASSERT_TRUE(server_->Startup(settings));
+  EXPECT_EQ(Exchange("quit\n"), "OK\n");
+}
@@ -7,6 +7,13 @@ if(COMPILING_AS_OSS)
   if(RDMNETBROKER_BUILD_TESTS)
     add_oss_dependency(googletest GIT_REPOSITORY https://github.com/google/googletest.git)
   endif()
+
+  if(RDMNETBROKER_BUILD_BENCHMARKS)
+    add_oss_dependency(benchmark
+      GIT_REPOSITORY https://github.com/google/benchmark.git
+      OPTIONS "BENCHMARK_ENABLE_TESTING OFF" "BENCHMARK_ENABLE_INSTALL OFF"
+    )
+  endif()
 else()
   include(${CMAKE_TOOLS_MODULES}/DependencyManagement.cmake)
   add_project_dependencies()
@@ -14,4 +21,8 @@ else()
   if(RDMNETBROKER_BUILD_TESTS)
     add_project_dependency(googletest)
   endif()
+
+  if(RDMNETBROKER_BUILD_BENCHMARKS)
+    add_project_dependency(benchmark)
+  endif()
 endif()